@@ -0,0 +1,184 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 University of North Carolina at Chapel Hill
+ * Author: Ben Newton
+ */
+
+//
+// Beam hopping against static alignment.
+//
+// A hub sends to N peers, each flow offered the same share of the load.
+// The run is made twice: with static alignment, the hub has one terminal
+// per peer, each always aligned; with beam hopping, one terminal serves the
+// peers in turn, in slots of HoppingSlot of which the first HoppingGuard is
+// lost retargeting.  Throughput, latency (queueing included) and drops of
+// both runs are printed side by side.  Only the transmissions of the hub
+// are slotted; the peers send nothing and reception is never gated, so
+// the hopping figures are optimistic:
+//
+//   ./waf --run "wppp-beam-hopping --peers=4 --load=0.5 --slot=2ms --guard=100us"
+//
+
+#include <iomanip>
+#include <iostream>
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/wireless-point-to-point-module.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("WpppBeamHopping");
+
+namespace {
+
+uint64_t g_receivedBytes = 0; //!< Bytes received by the peers
+
+/**
+ * Results of one run
+ */
+struct HoppingResult
+{
+  double throughput;            //!< Received, in Mbps
+  WpppLatencyHistogram latency; //!< Queued at the hub to received, in ns
+  uint64_t drops;               //!< Frames dropped at the hub
+  uint64_t slots;               //!< Slots run
+};
+
+} // anonymous namespace
+
+static bool
+Sink (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from)
+{
+  g_receivedBytes += packet->GetSize ();
+  return true;
+}
+
+static void
+Generate (Ptr<WpppMultiBeamNetDevice> hub, Address peer, uint32_t size, Time interval)
+{
+  hub->Send (Create<Packet> (size), peer, 0x0800);
+  Simulator::Schedule (interval, &Generate, hub, peer, size, interval);
+}
+
+static Ptr<WpppMultiBeamNetDevice>
+CreateDevice (Ptr<WirelessPointToPointChannel> channel, uint32_t beams,
+              ObjectFactory &beamFactory)
+{
+  Ptr<WpppMultiBeamNetDevice> device = CreateObject<WpppMultiBeamNetDevice> ();
+  device->SetAddress (Mac48Address::Allocate ());
+  for (uint32_t i = 0; i < beams; i++)
+    {
+      Ptr<WirelessPointToPointNetDevice> beam = beamFactory.Create<WirelessPointToPointNetDevice> ();
+      beam->SetQueue (CreateObject<DropTailQueue> ());
+      beam->Attach (channel);
+      device->AddBeam (beam);
+    }
+  CreateObject<Node> ()->AddDevice (device);
+  return device;
+}
+
+static HoppingResult
+RunScenario (bool hopping, uint32_t nPeers, std::string dataRate, double load,
+             uint32_t packetSize, Time slot, Time guard, double duration)
+{
+  g_receivedBytes = 0;
+  ObjectFactory beamFactory;
+  beamFactory.SetTypeId ("ns3::WirelessPointToPointNetDevice");
+  beamFactory.Set ("DataRate", StringValue (dataRate));
+  beamFactory.Set ("LatencyStats", BooleanValue (true));
+
+  Ptr<WirelessPointToPointChannel> channel = CreateObject<WirelessPointToPointChannel> ();
+  Ptr<WpppMultiBeamNetDevice> hub = CreateDevice (channel, nPeers, beamFactory);
+  if (hopping)
+    {
+      hub->SetAttribute ("HoppingSlot", TimeValue (slot));
+      hub->SetAttribute ("HoppingGuard", TimeValue (guard));
+    }
+
+  //offer each peer an equal share of load times the rate of one terminal
+  double bps = DataRate (dataRate).GetBitRate () * load / nPeers;
+  Time interval = Seconds (packetSize * 8 / bps);
+  std::vector<Ptr<WpppMultiBeamNetDevice> > peers;
+  for (uint32_t i = 0; i < nPeers; i++)
+    {
+      Ptr<WpppMultiBeamNetDevice> peer = CreateDevice (channel, 1, beamFactory);
+      peer->SetReceiveCallback (MakeCallback (&Sink));
+      hub->Connect (i, peer->GetNode ());
+      peer->Connect (0, hub->GetNode ());
+      Simulator::Schedule (NanoSeconds (interval.GetNanoSeconds () * (i + 1) / nPeers), &Generate, hub,
+                           peer->GetAddress (), packetSize, interval);
+      peers.push_back (peer);
+    }
+
+  Simulator::Stop (Seconds (duration));
+  Simulator::Run ();
+
+  HoppingResult result;
+  result.throughput = g_receivedBytes * 8 / duration / 1e6;
+  result.drops = 0;
+  result.slots = hub->GetNSlots ();
+  for (uint32_t i = 0; i < nPeers; i++)
+    {
+      const WpppDeviceStats &stats = hub->GetBeam (i)->GetStats ();
+      for (uint32_t reason = 0; reason < WpppDeviceStats::DROP_REASONS; reason++)
+        {
+          result.drops += stats.drops[reason];
+        }
+      std::vector<WpppLinkLatency> links;
+      peers[i]->GetBeam (0)->GetLatencyStats (links);
+      for (uint32_t j = 0; j < links.size (); j++)
+        {
+          result.latency.Merge (links[j].total);
+        }
+    }
+  Simulator::Destroy ();
+  return result;
+}
+
+static void
+PrintResult (std::string mode, const HoppingResult &r)
+{
+  std::cout << std::left << std::setw (8) << mode << std::right << std::fixed
+            << std::setw (12) << std::setprecision (2) << r.throughput
+            << std::setw (12) << std::setprecision (1) << r.latency.GetMean () / 1e3
+            << std::setw (12) << r.latency.GetPercentile (0.5) / 1e3
+            << std::setw (12) << r.latency.GetPercentile (0.99) / 1e3
+            << std::setw (10) << r.drops
+            << std::setw (10) << r.slots << std::endl;
+}
+
+int
+main (int argc, char *argv[])
+{
+  uint32_t nPeers = 4;
+  std::string dataRate = "100Mbps";
+  double load = 0.5;
+  uint32_t packetSize = 1000;
+  std::string slot = "2ms";
+  std::string guard = "100us";
+  double duration = 10.0;
+
+  CommandLine cmd;
+  cmd.AddValue ("peers", "Number of peers of the hub", nPeers);
+  cmd.AddValue ("dataRate", "Data rate of every terminal", dataRate);
+  cmd.AddValue ("load", "Offered load, as a fraction of the rate of one terminal", load);
+  cmd.AddValue ("packetSize", "Frame payload in bytes", packetSize);
+  cmd.AddValue ("slot", "Hopping slot, guard included", slot);
+  cmd.AddValue ("guard", "Retargeting guard time at the start of each slot", guard);
+  cmd.AddValue ("duration", "Simulated time in seconds", duration);
+  cmd.Parse (argc, argv);
+
+  HoppingResult aligned = RunScenario (false, nPeers, dataRate, load, packetSize,
+                                       Time (slot), Time (guard), duration);
+  HoppingResult hopping = RunScenario (true, nPeers, dataRate, load, packetSize,
+                                       Time (slot), Time (guard), duration);
+
+  std::cout << std::left << std::setw (8) << "mode" << std::right
+            << std::setw (12) << "Mbps" << std::setw (12) << "mean(us)"
+            << std::setw (12) << "p50(us)" << std::setw (12) << "p99(us)"
+            << std::setw (10) << "drops" << std::setw (10) << "slots" << std::endl;
+  PrintResult ("static", aligned);
+  PrintResult ("hopping", hopping);
+  return 0;
+}
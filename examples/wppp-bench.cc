@@ -0,0 +1,395 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 University of North Carolina at Chapel Hill
+ * Author: Ben Newton
+ */
+
+//
+// Packet rate and topology churn benchmark for the wireless point to point
+// module.
+//
+// N nodes with D devices each are attached to one channel and the devices
+// are paired up at random.  Every device is kept saturated with frames sent
+// straight to the device (IP is installed, because alignment notifies the
+// routing protocol, but frames are delivered to a counting sink rather than
+// up the stack).  At a configurable rate two random links are broken and
+// their ends cross connected, exercising Connect and Disconnect.
+//
+// One line of results is printed as CSV (with a header) or JSON, so runs of
+// different versions and sizes can be collected and compared:
+//
+//   ./waf --run "wppp-bench --nodes=1000 --devices=4 --churnRate=100 --format=json"
+//
+
+#include <sys/resource.h>
+#include <time.h>
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/propagation-module.h"
+#include "ns3/wireless-point-to-point-module.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("WpppBench");
+
+namespace {
+
+double
+WallSeconds (void)
+{
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+uint64_t g_generated = 0;     //!< Frames handed to the devices
+uint64_t g_backlogged = 0;    //!< Send attempts skipped on a full queue
+uint64_t g_received = 0;      //!< Frames received
+uint64_t g_receivedBytes = 0; //!< Bytes received
+uint64_t g_churnEvents = 0;   //!< Churn events run
+uint64_t g_events = 0;        //!< Events taken off the scheduler
+uint64_t g_connects = 0;      //!< Connect calls
+uint64_t g_disconnects = 0;   //!< Disconnect calls
+double g_connectTime = 0;     //!< Wall time in Connect
+double g_disconnectTime = 0;  //!< Wall time in Disconnect
+
+} // anonymous namespace
+
+/**
+ * Channel that measures the wall time spent in TransmitStart
+ */
+class BenchChannel : public WirelessPointToPointChannel
+{
+public:
+  BenchChannel ()
+    : m_calls (0),
+      m_time (0)
+  {
+  }
+
+  virtual bool TransmitStart (Ptr<Packet> p, Ptr<WirelessPointToPointNetDevice> src, Time txTime)
+  {
+    double start = WallSeconds ();
+    bool result = WirelessPointToPointChannel::TransmitStart (p, src, txTime);
+    m_time += WallSeconds () - start;
+    m_calls++;
+    return result;
+  }
+
+  uint64_t m_calls; //!< TransmitStart calls
+  double m_time;    //!< Wall time in TransmitStart
+};
+
+/**
+ * The default scheduler, counting the events the simulator takes off it
+ */
+class BenchScheduler : public MapScheduler
+{
+public:
+  static TypeId GetTypeId (void)
+  {
+    static TypeId tid = TypeId ("ns3::WpppBenchScheduler")
+      .SetParent<MapScheduler> ()
+      .AddConstructor<BenchScheduler> ()
+    ;
+    return tid;
+  }
+
+  virtual Scheduler::Event RemoveNext (void)
+  {
+    g_events++;
+    return MapScheduler::RemoveNext ();
+  }
+};
+
+/**
+ * A link between two devices and the nodes they sit on
+ */
+struct BenchEndpoint
+{
+  Ptr<Node> node;
+  Ptr<WirelessPointToPointNetDevice> dev;
+};
+
+static void
+TimedConnect (const BenchEndpoint &local, const BenchEndpoint &remote)
+{
+  double start = WallSeconds ();
+  local.dev->Connect (local.node, local.dev, remote.node);
+  g_connectTime += WallSeconds () - start;
+  g_connects++;
+}
+
+static void
+TimedDisconnect (const BenchEndpoint &local, const BenchEndpoint &remote)
+{
+  double start = WallSeconds ();
+  local.dev->Disconnect (local.node, local.dev, remote.node);
+  g_disconnectTime += WallSeconds () - start;
+  g_disconnects++;
+}
+
+static bool
+Sink (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from)
+{
+  g_received++;
+  g_receivedBytes += packet->GetSize ();
+  return true;
+}
+
+/**
+ * Keep one device saturated: send a frame every frame time, as long as the
+ * device queue has room (the queue must never fill, or the upper layer queue
+ * would be stopped underneath us).
+ */
+static void
+Generate (Ptr<WirelessPointToPointNetDevice> dev, uint32_t size, Time interval)
+{
+  Ptr<Queue> queue = dev->GetQueue ();
+  if (queue->GetNPackets () + 1 < queue->GetMaxPackets ())
+    {
+      dev->Send (Create<Packet> (size), dev->GetBroadcast (), 0x0800);
+      g_generated++;
+    }
+  else
+    {
+      g_backlogged++;
+    }
+  Simulator::Schedule (interval, &Generate, dev, size, interval);
+}
+
+/**
+ * Break two random links (a1,b1), (a2,b2) and align (a1,b2), (a2,b1)
+ */
+static void
+Churn (std::vector<std::pair<BenchEndpoint, BenchEndpoint> > *links,
+       Ptr<UniformRandomVariable> rng, Time interval)
+{
+  if (links->size () >= 2)
+    {
+      uint32_t i = rng->GetInteger (0, links->size () - 1);
+      uint32_t j = rng->GetInteger (0, links->size () - 2);
+      j = j >= i ? j + 1 : j;
+      std::pair<BenchEndpoint, BenchEndpoint> &l1 = (*links)[i];
+      std::pair<BenchEndpoint, BenchEndpoint> &l2 = (*links)[j];
+      if (l1.first.node != l2.second.node && l2.first.node != l1.second.node)
+        {
+          TimedDisconnect (l1.first, l1.second);
+          TimedDisconnect (l1.second, l1.first);
+          TimedDisconnect (l2.first, l2.second);
+          TimedDisconnect (l2.second, l2.first);
+          std::swap (l1.second, l2.second);
+          TimedConnect (l1.first, l1.second);
+          TimedConnect (l1.second, l1.first);
+          TimedConnect (l2.first, l2.second);
+          TimedConnect (l2.second, l2.first);
+        }
+      g_churnEvents++;
+    }
+  Simulator::Schedule (interval, &Churn, links, rng, interval);
+}
+
+static uint64_t
+PeakRssKb (void)
+{
+  struct rusage usage;
+  getrusage (RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+int
+main (int argc, char *argv[])
+{
+  uint32_t nNodes = 100;
+  uint32_t nDevices = 4;
+  double duration = 10.0;
+  std::string dataRate = "100Mbps";
+  uint32_t packetSize = 1000;
+  double churnRate = 10.0;
+  std::string format = "csv";
+  uint32_t seed = 1;
+  bool memory = false;
+
+  CommandLine cmd;
+  cmd.AddValue ("nodes", "Number of nodes", nNodes);
+  cmd.AddValue ("devices", "Number of devices per node", nDevices);
+  cmd.AddValue ("duration", "Simulated time in seconds", duration);
+  cmd.AddValue ("dataRate", "Data rate of every device", dataRate);
+  cmd.AddValue ("packetSize", "Size of the generated frames in bytes", packetSize);
+  cmd.AddValue ("churnRate", "Link swaps per simulated second (0 disables)", churnRate);
+  cmd.AddValue ("format", "Output format, csv or json", format);
+  cmd.AddValue ("seed", "Run number of the random streams", seed);
+  cmd.AddValue ("memory", "Print the estimated memory of the module to stderr", memory);
+  cmd.Parse (argc, argv);
+
+  if (nNodes < 2 || nDevices == 0)
+    {
+      std::cerr << "Need at least 2 nodes and 1 device per node" << std::endl;
+      return 1;
+    }
+  RngSeedManager::SetRun (seed);
+  Time::SetResolution (Time::NS);
+  ObjectFactory schedulerFactory;
+  schedulerFactory.SetTypeId (BenchScheduler::GetTypeId ());
+  Simulator::SetScheduler (schedulerFactory);
+
+  double setupStart = WallSeconds ();
+
+  NodeContainer nodes;
+  nodes.Create (nNodes);
+
+  MobilityHelper mobility;
+  mobility.SetPositionAllocator ("ns3::RandomBoxPositionAllocator",
+                                 "X", StringValue ("ns3::UniformRandomVariable[Min=0|Max=1000000]"),
+                                 "Y", StringValue ("ns3::UniformRandomVariable[Min=0|Max=1000000]"),
+                                 "Z", StringValue ("ns3::UniformRandomVariable[Min=0|Max=1000000]"));
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  mobility.Install (nodes);
+
+  //built by hand rather than through WirelessPointToPointHelper::Install so
+  //the channel can time TransmitStart
+  Ptr<BenchChannel> channel = CreateObject<BenchChannel> ();
+  channel->SetPropagationDelayModel (CreateObject<ConstantSpeedPropagationDelayModel> ());
+  ObjectFactory deviceFactory;
+  deviceFactory.SetTypeId ("ns3::WirelessPointToPointNetDevice");
+  deviceFactory.Set ("DataRate", StringValue (dataRate));
+  NetDeviceContainer devices;
+  std::vector<BenchEndpoint> endpoints;
+  for (uint32_t i = 0; i < nNodes; i++)
+    {
+      for (uint32_t j = 0; j < nDevices; j++)
+        {
+          Ptr<WirelessPointToPointNetDevice> dev = deviceFactory.Create<WirelessPointToPointNetDevice> ();
+          dev->SetAddress (Mac48Address::Allocate ());
+          nodes.Get (i)->AddDevice (dev);
+          dev->SetQueue (CreateObject<DropTailQueue> ());
+          dev->Attach (channel);
+          devices.Add (dev);
+          BenchEndpoint e;
+          e.node = nodes.Get (i);
+          e.dev = dev;
+          endpoints.push_back (e);
+        }
+    }
+
+  InternetStackHelper stack;
+  stack.Install (nodes);
+  Ipv4AddressHelper address;
+  address.SetBase ("10.0.0.0", "255.0.0.0");
+  address.Assign (devices);
+
+  //frames go to the counting sink instead of IP
+  for (uint32_t i = 0; i < devices.GetN (); i++)
+    {
+      devices.Get (i)->SetReceiveCallback (MakeCallback (&Sink));
+    }
+
+  //pair the devices up at random, avoiding links within a node
+  Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable> ();
+  for (uint32_t i = endpoints.size () - 1; i > 0; i--)
+    {
+      std::swap (endpoints[i], endpoints[rng->GetInteger (0, i)]);
+    }
+  std::vector<std::pair<BenchEndpoint, BenchEndpoint> > links;
+  for (uint32_t i = 0; i + 1 < endpoints.size (); i += 2)
+    {
+      if (endpoints[i].node == endpoints[i + 1].node)
+        {
+          continue;
+        }
+      links.push_back (std::make_pair (endpoints[i], endpoints[i + 1]));
+      TimedConnect (endpoints[i], endpoints[i + 1]);
+      TimedConnect (endpoints[i + 1], endpoints[i]);
+    }
+
+  //slightly faster than the line rate so the queues never drain
+  Time frameTime = DataRate (dataRate).CalculateBytesTxTime (packetSize + 14);
+  Time interval = NanoSeconds (frameTime.GetNanoSeconds () * 95 / 100 + 1);
+  for (uint32_t i = 0; i < endpoints.size (); i++)
+    {
+      Simulator::Schedule (NanoSeconds (rng->GetInteger (0, interval.GetNanoSeconds ())),
+                           &Generate, endpoints[i].dev, packetSize, interval);
+    }
+  if (churnRate > 0)
+    {
+      Simulator::Schedule (Seconds (1.0 / churnRate), &Churn, &links, rng,
+                           Seconds (1.0 / churnRate));
+    }
+
+  double setupTime = WallSeconds () - setupStart;
+  //setup alignment is reported as part of setup, not of the run
+  g_connects = g_disconnects = 0;
+  g_connectTime = g_disconnectTime = 0;
+
+  Simulator::Stop (Seconds (duration));
+  g_events = 0;
+  double runStart = WallSeconds ();
+  Simulator::Run ();
+  double wallTime = WallSeconds () - runStart;
+
+  //generator, transmit complete, receive and churn events: what the model
+  //does, whatever events the simulator and the module need to do it
+  uint64_t modelEvents = g_generated + g_backlogged + channel->m_calls + g_received + g_churnEvents;
+
+  if (format == "json")
+    {
+      std::cout << "{\"nodes\": " << nNodes
+                << ", \"devices\": " << nDevices
+                << ", \"links\": " << links.size ()
+                << ", \"duration\": " << duration
+                << ", \"dataRate\": \"" << dataRate << "\""
+                << ", \"packetSize\": " << packetSize
+                << ", \"churnRate\": " << churnRate
+                << ", \"setupSeconds\": " << setupTime
+                << ", \"wallSeconds\": " << wallTime
+                << ", \"events\": " << g_events
+                << ", \"eventsPerSecond\": " << g_events / wallTime
+                << ", \"modelEvents\": " << modelEvents
+                << ", \"packetsSent\": " << g_generated
+                << ", \"packetsReceived\": " << g_received
+                << ", \"bytesReceived\": " << g_receivedBytes
+                << ", \"packetsPerSecond\": " << g_received / wallTime
+                << ", \"peakRssKb\": " << PeakRssKb ()
+                << ", \"connectCalls\": " << g_connects
+                << ", \"connectSeconds\": " << g_connectTime
+                << ", \"disconnectCalls\": " << g_disconnects
+                << ", \"disconnectSeconds\": " << g_disconnectTime
+                << ", \"transmitStartCalls\": " << channel->m_calls
+                << ", \"transmitStartSeconds\": " << channel->m_time
+                << "}" << std::endl;
+    }
+  else
+    {
+      std::cout << "nodes,devices,links,duration,dataRate,packetSize,churnRate,"
+                << "setupSeconds,wallSeconds,events,eventsPerSecond,modelEvents,packetsSent,"
+                << "packetsReceived,bytesReceived,packetsPerSecond,peakRssKb,"
+                << "connectCalls,connectSeconds,disconnectCalls,disconnectSeconds,"
+                << "transmitStartCalls,transmitStartSeconds" << std::endl;
+      std::cout << nNodes << "," << nDevices << "," << links.size () << ","
+                << duration << "," << dataRate << "," << packetSize << ","
+                << churnRate << "," << setupTime << "," << wallTime << ","
+                << g_events << "," << g_events / wallTime << "," << modelEvents << ","
+                << g_generated << ","
+                << g_received << "," << g_receivedBytes << ","
+                << g_received / wallTime << "," << PeakRssKb () << ","
+                << g_connects << "," << g_connectTime << ","
+                << g_disconnects << "," << g_disconnectTime << ","
+                << channel->m_calls << "," << channel->m_time << std::endl;
+    }
+
+  if (memory)
+    {
+      WpppMemoryUsage usage;
+      channel->AddMemoryUsage (usage);
+      usage.Print (std::cerr);
+    }
+
+  Simulator::Destroy ();
+  return 0;
+}
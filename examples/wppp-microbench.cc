@@ -0,0 +1,487 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 University of North Carolina at Chapel Hill
+ * Author: Ben Newton
+ */
+
+//
+// Microbenchmarks of the wireless point to point hot paths.
+//
+// Each benchmark repeats one operation until at least --minTime seconds of
+// wall time have been spent and reports the time and the number of heap
+// allocations per operation.  The channel benchmarks are swept over the
+// number of nodes on the channel (--sizes), so the cost of the connection
+// maps shows up as a curve:
+//
+//   connect-disconnect  align and break one extra pair of devices (two
+//                       Connect and two Disconnect calls) with 'size'
+//                       devices already aligned
+//   is-one-way          IsOneWayConnection for a pair that is not connected,
+//                       with size/2 one way connections present
+//   transmit-start      TransmitStart of a copied frame on an aligned device
+//   header-serialize    WpppHeader Serialize and Deserialize into a buffer
+//   header-add-remove   Packet AddHeader and RemoveHeader of a WpppHeader
+//   packet-copy         Packet Copy, the baseline included in transmit-start
+//                       and receive
+//   receive             Receive of a copied frame, size 0 without trace
+//                       sinks and size 1 with a sink on every receive trace
+//
+//   ./waf --run "wppp-microbench --sizes=10,100,1000,10000 --format=csv"
+//
+// Connect notifies the IPv4 routing protocol, so its numbers include the
+// static routing interface up/down handling.
+//
+
+#include <stdlib.h>
+#include <time.h>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <vector>
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/propagation-module.h"
+#include "ns3/wireless-point-to-point-module.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("WpppMicrobench");
+
+//
+// Every heap allocation of the process, including those made inside the ns-3
+// libraries, goes through these.
+//
+static uint64_t g_allocations = 0;
+
+#if __cplusplus >= 201103L
+#define WPPP_THROW_BAD_ALLOC
+#define WPPP_NOTHROW noexcept
+#else
+#define WPPP_THROW_BAD_ALLOC throw (std::bad_alloc)
+#define WPPP_NOTHROW throw ()
+#endif
+
+void *
+operator new (size_t size) WPPP_THROW_BAD_ALLOC
+{
+  g_allocations++;
+  void *p = malloc (size ? size : 1);
+  if (p == 0)
+    {
+      throw std::bad_alloc ();
+    }
+  return p;
+}
+
+void *
+operator new[] (size_t size) WPPP_THROW_BAD_ALLOC
+{
+  return operator new (size);
+}
+
+void
+operator delete (void *p) WPPP_NOTHROW
+{
+  free (p);
+}
+
+void
+operator delete[] (void *p) WPPP_NOTHROW
+{
+  free (p);
+}
+
+namespace {
+
+double
+WallSeconds (void)
+{
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+bool
+Sink (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from)
+{
+  return true;
+}
+
+void
+TraceSink (Ptr<const Packet> packet)
+{
+}
+
+/**
+ * One operation to measure
+ */
+class MicroBench
+{
+public:
+  virtual ~MicroBench ()
+  {
+  }
+  /// Run the operation once
+  virtual void Op (void) = 0;
+  /// Undo the side effects of a batch of operations, not timed
+  virtual void Drain (void)
+  {
+  }
+};
+
+/**
+ * Nodes with one device each, attached to one channel, with IPv4 so that
+ * aligning devices can notify routing.  Devices 2k and 2k+1 are aligned,
+ * or only connected one way from 2k to 2k+1.  Two extra nodes are left
+ * unconnected for the benchmarks to use.
+ */
+struct Topology
+{
+  Topology (uint32_t n, bool aligned)
+  {
+    nodes.Create (n + 2);
+    MobilityHelper mobility;
+    mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+    mobility.Install (nodes);
+    channel = CreateObject<WirelessPointToPointChannel> ();
+    channel->SetPropagationDelayModel (CreateObject<ConstantSpeedPropagationDelayModel> ());
+    NetDeviceContainer container;
+    for (uint32_t i = 0; i < nodes.GetN (); i++)
+      {
+        Ptr<WirelessPointToPointNetDevice> dev = CreateObject<WirelessPointToPointNetDevice> ();
+        dev->SetAddress (Mac48Address::Allocate ());
+        nodes.Get (i)->AddDevice (dev);
+        dev->SetQueue (CreateObject<DropTailQueue> ());
+        dev->Attach (channel);
+        devices.push_back (dev);
+        container.Add (dev);
+      }
+    InternetStackHelper stack;
+    stack.Install (nodes);
+    Ipv4AddressHelper address;
+    address.SetBase ("10.0.0.0", "255.0.0.0");
+    address.Assign (container);
+    for (uint32_t i = 0; i < devices.size (); i++)
+      {
+        devices[i]->SetReceiveCallback (MakeCallback (&Sink));
+      }
+    for (uint32_t i = 0; i + 1 < n; i += 2)
+      {
+        devices[i]->Connect (nodes.Get (i), devices[i], nodes.Get (i + 1));
+        if (aligned)
+          {
+            devices[i + 1]->Connect (nodes.Get (i + 1), devices[i + 1], nodes.Get (i));
+          }
+      }
+  }
+
+  NodeContainer nodes;
+  Ptr<WirelessPointToPointChannel> channel;
+  std::vector<Ptr<WirelessPointToPointNetDevice> > devices;
+};
+
+class ConnectBench : public MicroBench
+{
+public:
+  ConnectBench (Topology &t)
+    : m_t (t),
+      m_a (t.nodes.GetN () - 2),
+      m_b (t.nodes.GetN () - 1)
+  {
+  }
+  virtual void Op (void)
+  {
+    Ptr<Node> a = m_t.nodes.Get (m_a);
+    Ptr<Node> b = m_t.nodes.Get (m_b);
+    m_t.devices[m_a]->Connect (a, m_t.devices[m_a], b);
+    m_t.devices[m_b]->Connect (b, m_t.devices[m_b], a);
+    m_t.devices[m_a]->Disconnect (a, m_t.devices[m_a], b);
+    m_t.devices[m_b]->Disconnect (b, m_t.devices[m_b], a);
+  }
+private:
+  Topology &m_t;
+  uint32_t m_a;
+  uint32_t m_b;
+};
+
+class OneWayBench : public MicroBench
+{
+public:
+  OneWayBench (Topology &t)
+    : m_t (t),
+      m_a (t.nodes.Get (t.nodes.GetN () - 2)->GetId ()),
+      m_b (t.nodes.Get (t.nodes.GetN () - 1)->GetId ()),
+      m_found (0)
+  {
+  }
+  virtual void Op (void)
+  {
+    m_found += m_t.channel->IsOneWayConnection (m_a, m_b);
+  }
+private:
+  Topology &m_t;
+  uint32_t m_a;
+  uint32_t m_b;
+  uint32_t m_found; //!< Keeps the call from being optimized away
+};
+
+class TransmitBench : public MicroBench
+{
+public:
+  TransmitBench (Topology &t)
+    : m_t (t),
+      m_packet (Create<Packet> (1000))
+  {
+    WpppHeader header;
+    header.SetProtocol (0x0021);
+    m_packet->AddHeader (header);
+  }
+  virtual void Op (void)
+  {
+    //each reception strips the header, so every frame is a copy
+    m_t.channel->TransmitStart (m_packet->Copy (), m_t.devices[0], MicroSeconds (1));
+  }
+  virtual void Drain (void)
+  {
+    //deliver the scheduled receptions
+    Simulator::Run ();
+  }
+private:
+  Topology &m_t;
+  Ptr<Packet> m_packet;
+};
+
+class SerializeBench : public MicroBench
+{
+public:
+  SerializeBench ()
+  {
+    m_header.SetProtocol (0x0021);
+    m_buffer.AddAtStart (m_header.GetSerializedSize ());
+  }
+  virtual void Op (void)
+  {
+    m_header.Serialize (m_buffer.Begin ());
+    m_header.Deserialize (m_buffer.Begin ());
+  }
+private:
+  WpppHeader m_header;
+  Buffer m_buffer;
+};
+
+class AddRemoveBench : public MicroBench
+{
+public:
+  AddRemoveBench ()
+    : m_packet (Create<Packet> (1000))
+  {
+    m_header.SetProtocol (0x0021);
+  }
+  virtual void Op (void)
+  {
+    m_packet->AddHeader (m_header);
+    m_packet->RemoveHeader (m_header);
+  }
+private:
+  WpppHeader m_header;
+  Ptr<Packet> m_packet;
+};
+
+class CopyBench : public MicroBench
+{
+public:
+  CopyBench ()
+    : m_packet (Create<Packet> (1000))
+  {
+  }
+  virtual void Op (void)
+  {
+    m_packet->Copy ();
+  }
+private:
+  Ptr<Packet> m_packet;
+};
+
+class ReceiveBench : public MicroBench
+{
+public:
+  ReceiveBench (Topology &t, bool sinks)
+    : m_t (t),
+      m_packet (Create<Packet> (1000))
+  {
+    WpppHeader header;
+    header.SetProtocol (0x0021);
+    m_packet->AddHeader (header);
+    if (sinks)
+      {
+        const char *sources[] = { "Sniffer", "PromiscSniffer", "PhyRxEnd", "MacRx" };
+        for (uint32_t i = 0; i < 4; i++)
+          {
+            t.devices[0]->TraceConnectWithoutContext (sources[i], MakeCallback (&TraceSink));
+          }
+      }
+  }
+  virtual void Op (void)
+  {
+    m_t.devices[0]->Receive (m_packet->Copy ());
+  }
+private:
+  Topology &m_t;
+  Ptr<Packet> m_packet;
+};
+
+/**
+ * Results of one benchmark run
+ */
+struct Result
+{
+  std::string name;   //!< Benchmark name
+  uint32_t size;      //!< Sweep parameter
+  uint64_t iterations; //!< Operations timed
+  double nsPerOp;     //!< Wall time per operation
+  double allocsPerOp; //!< Heap allocations per operation
+};
+
+std::vector<Result> g_results;
+
+/**
+ * Run batches of doubling size until one takes at least minTime
+ */
+void
+Measure (std::string name, uint32_t size, MicroBench &bench, double minTime)
+{
+  uint64_t iterations = 1;
+  while (true)
+    {
+      uint64_t allocations = g_allocations;
+      double start = WallSeconds ();
+      for (uint64_t i = 0; i < iterations; i++)
+        {
+          bench.Op ();
+        }
+      double elapsed = WallSeconds () - start;
+      allocations = g_allocations - allocations;
+      bench.Drain ();
+      if (elapsed >= minTime || iterations >= (uint64_t (1) << 40))
+        {
+          Result r;
+          r.name = name;
+          r.size = size;
+          r.iterations = iterations;
+          r.nsPerOp = elapsed * 1e9 / iterations;
+          r.allocsPerOp = double (allocations) / iterations;
+          g_results.push_back (r);
+          std::cerr << name << " size=" << size << " " << r.nsPerOp << " ns/op" << std::endl;
+          return;
+        }
+      iterations *= 2;
+    }
+}
+
+} // anonymous namespace
+
+int
+main (int argc, char *argv[])
+{
+  std::string sizes = "10,100,1000,10000";
+  double minTime = 0.2;
+  std::string format = "csv";
+  std::string filter = "";
+
+  CommandLine cmd;
+  cmd.AddValue ("sizes", "Comma separated node counts for the channel benchmarks", sizes);
+  cmd.AddValue ("minTime", "Minimum wall time in seconds per measurement", minTime);
+  cmd.AddValue ("format", "Output format, csv or json", format);
+  cmd.AddValue ("filter", "Only run benchmarks whose name contains this", filter);
+  cmd.Parse (argc, argv);
+
+  std::vector<uint32_t> sweep;
+  std::istringstream sizeStream (sizes);
+  std::string token;
+  while (std::getline (sizeStream, token, ','))
+    {
+      sweep.push_back (atoi (token.c_str ()) & ~1u);
+    }
+
+  for (uint32_t i = 0; i < sweep.size (); i++)
+    {
+      uint32_t n = sweep[i];
+      if (std::string ("connect-disconnect transmit-start").find (filter) != std::string::npos)
+        {
+          Topology t (n, true);
+          if (std::string ("connect-disconnect").find (filter) != std::string::npos)
+            {
+              ConnectBench connect (t);
+              Measure ("connect-disconnect", n, connect, minTime);
+            }
+          if (n > 0 && std::string ("transmit-start").find (filter) != std::string::npos)
+            {
+              TransmitBench transmit (t);
+              Measure ("transmit-start", n, transmit, minTime);
+            }
+        }
+      Simulator::Destroy ();
+      if (std::string ("is-one-way").find (filter) != std::string::npos)
+        {
+          Topology t (n, false);
+          OneWayBench oneWay (t);
+          Measure ("is-one-way", n, oneWay, minTime);
+        }
+      Simulator::Destroy ();
+    }
+
+  if (std::string ("header-serialize").find (filter) != std::string::npos)
+    {
+      SerializeBench serialize;
+      Measure ("header-serialize", 0, serialize, minTime);
+    }
+  if (std::string ("header-add-remove").find (filter) != std::string::npos)
+    {
+      AddRemoveBench addRemove;
+      Measure ("header-add-remove", 0, addRemove, minTime);
+    }
+  if (std::string ("packet-copy").find (filter) != std::string::npos)
+    {
+      CopyBench copy;
+      Measure ("packet-copy", 0, copy, minTime);
+    }
+  if (std::string ("receive").find (filter) != std::string::npos)
+    {
+      for (uint32_t sinks = 0; sinks < 2; sinks++)
+        {
+          Topology t (0, false);
+          ReceiveBench receive (t, sinks);
+          Measure ("receive", sinks, receive, minTime);
+          Simulator::Destroy ();
+        }
+    }
+
+  if (format == "json")
+    {
+      std::cout << "[" << std::endl;
+      for (uint32_t i = 0; i < g_results.size (); i++)
+        {
+          const Result &r = g_results[i];
+          std::cout << "  {\"benchmark\": \"" << r.name << "\", \"size\": " << r.size
+                    << ", \"iterations\": " << r.iterations
+                    << ", \"nsPerOp\": " << r.nsPerOp
+                    << ", \"allocsPerOp\": " << r.allocsPerOp << "}"
+                    << (i + 1 < g_results.size () ? "," : "") << std::endl;
+        }
+      std::cout << "]" << std::endl;
+    }
+  else
+    {
+      std::cout << "benchmark,size,iterations,nsPerOp,allocsPerOp" << std::endl;
+      for (uint32_t i = 0; i < g_results.size (); i++)
+        {
+          const Result &r = g_results[i];
+          std::cout << r.name << "," << r.size << "," << r.iterations << ","
+                    << r.nsPerOp << "," << r.allocsPerOp << std::endl;
+        }
+    }
+  return 0;
+}
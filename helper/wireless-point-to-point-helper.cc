@@ -4,18 +4,23 @@
  * Author: Ben Newton (adapted from point-to-point-helper.cc)
  */
 
+#include <fstream>
 #include "ns3/abort.h"
 #include "ns3/log.h"
 #include "ns3/simulator.h"
 #include "ns3/wireless-point-to-point-net-device.h"
 #include "ns3/wireless-point-to-point-channel.h"
+#include "ns3/wppp-multi-beam-net-device.h"
 #include "ns3/queue.h"
 #include "ns3/config.h"
 #include "ns3/packet.h"
 #include "ns3/names.h"
+#include "ns3/boolean.h"
 #include "ns3/mpi-module.h"
 
 #include "ns3/trace-helper.h"
+#include "ns3/wppp-pcap-writer.h"
+#include "ns3/wppp-buffered-stream.h"
 #include "wireless-point-to-point-helper.h"
 
 #include "ns3/mobility-model.h"
@@ -24,7 +29,154 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("WirelessPointToPointHelper");
 
+/**
+ * \brief Trace sink copying the frames of one device to a WpppPcapWriter
+ */
+class WpppPcapTap : public SimpleRefCount<WpppPcapTap>
+{
+public:
+  WpppPcapTap (Ptr<WpppPcapWriter> writer, uint32_t interface)
+    : m_writer (writer),
+      m_interface (interface)
+  {
+  }
+
+  void Capture (Ptr<const Packet> p)
+  {
+    m_writer->Write (m_interface, Simulator::Now (), p);
+  }
+
+private:
+  Ptr<WpppPcapWriter> m_writer;  //!< File the frames go to
+  uint32_t m_interface;          //!< Interface id of the device in the file
+};
+
+/**
+ * \brief Trace sink forwarding the frames a WpppCaptureFilter accepts
+ */
+class WpppFilterTap : public SimpleRefCount<WpppFilterTap>
+{
+public:
+  WpppFilterTap (const WpppCaptureFilter &filter, Ptr<WirelessPointToPointNetDevice> device)
+    : m_filter (filter),
+      m_device (PeekPointer (device))
+  {
+  }
+
+  void SetSink (Callback<void, Ptr<const Packet> > sink)
+  {
+    m_sink = sink;
+  }
+
+  void SetSink (Callback<void, std::string, Ptr<const Packet> > sink, std::string context)
+  {
+    m_contextSink = sink;
+    m_context = context;
+  }
+
+  void Capture (Ptr<const Packet> p)
+  {
+    if (!m_filter.Accept (m_device, p))
+      {
+        return;
+      }
+    if (!m_sink.IsNull ())
+      {
+        m_sink (p);
+      }
+    else
+      {
+        m_contextSink (m_context, p);
+      }
+  }
+
+private:
+  WpppCaptureFilter m_filter;                 //!< Filter of this device
+  //a Ptr would make a cycle with the trace source holding this tap
+  WirelessPointToPointNetDevice *m_device;    //!< Device the frames are seen on
+  Callback<void, Ptr<const Packet> > m_sink;  //!< Sink without context
+  Callback<void, std::string, Ptr<const Packet> > m_contextSink;  //!< Sink with context
+  std::string m_context;                      //!< Context for m_contextSink
+};
+
+/**
+ * \brief Writes the latency histograms of a set of devices at
+ * Simulator::Destroy
+ */
+class WpppLatencyDump : public SimpleRefCount<WpppLatencyDump>
+{
+public:
+  explicit WpppLatencyDump (std::string filename)
+    : m_filename (filename)
+  {
+  }
+
+  void Add (Ptr<WirelessPointToPointNetDevice> device)
+  {
+    //the node of a device is gone once the nodes are disposed
+    Entry entry;
+    entry.device = device;
+    entry.node = device->GetNode ()->GetId ();
+    m_entries.push_back (entry);
+  }
+
+  void Write (void)
+  {
+    std::ofstream os (m_filename.c_str ());
+    if (!os)
+      {
+        NS_LOG_ERROR ("Unable to open " << m_filename);
+        return;
+      }
+    os << "# node ifIndex srcNode srcIfIndex part p50 p99 p99.9 histogram" << std::endl;
+    std::vector<WpppLinkLatency> links;
+    for (uint32_t i = 0; i < m_entries.size (); i++)
+      {
+        m_entries[i].device->GetLatencyStats (links);
+        for (uint32_t j = 0; j < links.size (); j++)
+          {
+            std::ostringstream link;
+            link << m_entries[i].node << " " << m_entries[i].device->GetIfIndex () << " "
+                 << links[j].srcNode << " " << links[j].srcIfIndex << " ";
+            WriteLine (os, link.str () + "queueing", links[j].queueing);
+            WriteLine (os, link.str () + "transmission", links[j].transmission);
+            WriteLine (os, link.str () + "propagation", links[j].propagation);
+            WriteLine (os, link.str () + "total", links[j].total);
+          }
+      }
+    m_entries.clear ();
+  }
+
+private:
+  static void WriteLine (std::ostream &os, std::string prefix, const WpppLatencyHistogram &h)
+  {
+    os << prefix << " " << h.GetPercentile (0.5) << " " << h.GetPercentile (0.99)
+       << " " << h.GetPercentile (0.999) << " ";
+    h.Write (os);
+    os << std::endl;
+  }
+
+  struct Entry
+  {
+    Ptr<WirelessPointToPointNetDevice> device;  //!< Receiving device
+    uint32_t node;                              //!< Node id of the device
+  };
+
+  std::string m_filename;          //!< File to write
+  std::vector<Entry> m_entries;    //!< Devices to write
+};
+
+static void
+WpppPcapSink (Ptr<PcapFileWrapper> file, Ptr<const Packet> p)
+{
+  file->Write (Simulator::Now (), p);
+}
+
 WirelessPointToPointHelper::WirelessPointToPointHelper ()
+  : m_pcapBufferSize (0),
+    m_pcapSnapLen (65535),
+    m_asciiBufferSize (0),
+    m_asciiCompress (false)
 {
   m_queueFactory.SetTypeId ("ns3::DropTailQueue");
   m_deviceFactory.SetTypeId ("ns3::WirelessPointToPointNetDevice");
@@ -125,11 +277,79 @@ WirelessPointToPointHelper::EnablePcapInternal (std::string prefix,
       filename = pcapHelper.GetFilenameFromDevice (prefix, device);
     }
 
+  if (m_pcapBufferSize > 0)
+    {
+      Ptr<WpppPcapWriter> writer = Create<WpppPcapWriter> ();
+      if (!writer->Open (filename, WpppPcapWriter::PCAP, m_pcapSnapLen, m_pcapBufferSize))
+        {
+          NS_FATAL_ERROR ("WirelessPointToPointHelper::EnablePcapInternal(): Unable to open " << filename);
+        }
+      Ptr<WpppPcapTap> tap = Create<WpppPcapTap> (writer, 0);
+      Hook (device, "PromiscSniffer", device, MakeCallback (&WpppPcapTap::Capture, tap));
+      Simulator::ScheduleDestroy (&WpppPcapWriter::Close, writer);
+      return;
+    }
+
   Ptr<PcapFileWrapper> file = pcapHelper.CreateFile (filename, std::ios::out, 
-                                                     PcapHelper::DLT_PPP);
-  pcapHelper.HookDefaultSink<WirelessPointToPointNetDevice> (device, 
-                                                             "PromiscSniffer", 
-                                                             file);
+                                                     PcapHelper::DLT_PPP,
+                                                     m_pcapSnapLen);
+  Hook (device, "PromiscSniffer", device, MakeBoundCallback (&WpppPcapSink, file));
+}
+
+void
+WirelessPointToPointHelper::SetPcapBuffering (uint32_t bufferSize, uint32_t snapLen)
+{
+  m_pcapBufferSize = bufferSize;
+  m_pcapSnapLen = snapLen;
+}
+
+void
+WirelessPointToPointHelper::EnablePcapMerged (std::string filename, NetDeviceContainer devices)
+{
+  NS_LOG_FUNCTION (this << filename);
+  Ptr<WpppPcapWriter> writer = Create<WpppPcapWriter> ();
+  uint32_t bufferSize = m_pcapBufferSize > 0 ? m_pcapBufferSize : (1 << 20);
+  if (!writer->Open (filename, WpppPcapWriter::PCAPNG, m_pcapSnapLen, bufferSize))
+    {
+      NS_FATAL_ERROR ("WirelessPointToPointHelper::EnablePcapMerged(): Unable to open " << filename);
+    }
+  for (NetDeviceContainer::Iterator i = devices.Begin (); i != devices.End (); ++i)
+    {
+      Ptr<WirelessPointToPointNetDevice> device = (*i)->GetObject<WirelessPointToPointNetDevice> ();
+      if (device == 0)
+        {
+          continue;
+        }
+      std::ostringstream name;
+      name << "node" << device->GetNode ()->GetId () << "-dev" << device->GetIfIndex ();
+      Ptr<WpppPcapTap> tap = Create<WpppPcapTap> (writer, writer->AddInterface (name.str ()));
+      Hook (device, "PromiscSniffer", device, MakeCallback (&WpppPcapTap::Capture, tap));
+    }
+  Simulator::ScheduleDestroy (&WpppPcapWriter::Close, writer);
+}
+
+void
+WirelessPointToPointHelper::EnableLatencyStats (std::string filename, NetDeviceContainer devices)
+{
+  NS_LOG_FUNCTION (this << filename);
+  if (MpiInterface::IsEnabled ())
+    {
+      std::ostringstream oss;
+      oss << filename << "-" << MpiInterface::GetSystemId ();
+      filename = oss.str ();
+    }
+  Ptr<WpppLatencyDump> dump = Create<WpppLatencyDump> (filename);
+  for (NetDeviceContainer::Iterator i = devices.Begin (); i != devices.End (); ++i)
+    {
+      Ptr<WirelessPointToPointNetDevice> device = (*i)->GetObject<WirelessPointToPointNetDevice> ();
+      if (device == 0)
+        {
+          continue;
+        }
+      device->SetAttribute ("LatencyStats", BooleanValue (true));
+      dump->Add (device);
+    }
+  Simulator::ScheduleDestroy (&WpppLatencyDump::Write, dump);
 }
 
 void 
@@ -186,73 +406,132 @@ WirelessPointToPointHelper::EnableAsciiInternal (
           filename = asciiTraceHelper.GetFilenameFromDevice (prefix, device);
         }
 
-      Ptr<OutputStreamWrapper> theStream = 
-        asciiTraceHelper.CreateFileStream (filename);
+      Ptr<OutputStreamWrapper> theStream = CreateAsciiStream (filename);
 
       //
       // The MacRx trace source provides our "r" event.
       //
-      asciiTraceHelper.HookDefaultReceiveSinkWithoutContext<WirelessPointToPointNetDevice> (device, "MacRx", theStream);
+      Hook (device, "MacRx", device,
+            MakeBoundCallback (&AsciiTraceHelper::DefaultReceiveSinkWithoutContext, theStream));
 
       //
       // The "+", '-', and 'd' events are driven by trace sources actually in 
       // the transmit queue.
       //
       Ptr<Queue> queue = device->GetQueue ();
-      asciiTraceHelper.HookDefaultEnqueueSinkWithoutContext<Queue> (queue, 
-                                                                    "Enqueue", 
-                                                                    theStream);
-      asciiTraceHelper.HookDefaultDropSinkWithoutContext<Queue> (queue, "Drop",
-                                                                 theStream);
-      asciiTraceHelper.HookDefaultDequeueSinkWithoutContext<Queue> (queue, 
-                                                                    "Dequeue", 
-                                                                    theStream);
+      Hook (queue, "Enqueue", device,
+            MakeBoundCallback (&AsciiTraceHelper::DefaultEnqueueSinkWithoutContext, theStream));
+      Hook (queue, "Drop", device,
+            MakeBoundCallback (&AsciiTraceHelper::DefaultDropSinkWithoutContext, theStream));
+      Hook (queue, "Dequeue", device,
+            MakeBoundCallback (&AsciiTraceHelper::DefaultDequeueSinkWithoutContext, theStream));
 
       // PhyRxDrop trace source for "d" event
-      asciiTraceHelper.HookDefaultDropSinkWithoutContext<WirelessPointToPointNetDevice> (device, "PhyRxDrop", theStream);
+      Hook (device, "PhyRxDrop", device,
+            MakeBoundCallback (&AsciiTraceHelper::DefaultDropSinkWithoutContext, theStream));
 
       return;
     }
 
   //
   // If we are provided an OutputStreamWrapper, we are expected to use it, and
-  // to providd a context.  We are free to come up with our own context if we
-  // want, and use the AsciiTraceHelper Hook*WithContext functions, but for 
-  // compatibility and simplicity, we just use Config::Connect and let it deal
-  // with the context.
+  // to provide a context.  The context is the same path Config::Connect would
+  // report, but the trace sources are hooked directly on the device and its
+  // queue: resolving the path costs O(nodes) per source, which made setup
+  // quadratic in the size of the topology.
   //
   // Note that we are going to use the default trace sinks provided by the 
   // ascii trace helper.  There is actually no AsciiTraceHelper in sight here,
   // but the default trace sinks are actually publicly available static 
   // functions that are always there waiting for just such a case.
   //
-  uint32_t nodeid = nd->GetNode ()->GetId ();
-  uint32_t deviceid = nd->GetIfIndex ();
   std::ostringstream oss;
+  oss << "/NodeList/" << nd->GetNode ()->GetId () << "/DeviceList/" << nd->GetIfIndex ()
+      << "/$ns3::WirelessPointToPointNetDevice/";
+  std::string devicePath = oss.str ();
+  std::string queuePath = devicePath + "TxQueue/";
+
+  Hook (device, "MacRx", devicePath + "MacRx", device,
+        MakeBoundCallback (&AsciiTraceHelper::DefaultReceiveSinkWithContext, stream));
+
+  Ptr<Queue> queue = device->GetQueue ();
+  Hook (queue, "Enqueue", queuePath + "Enqueue", device,
+        MakeBoundCallback (&AsciiTraceHelper::DefaultEnqueueSinkWithContext, stream));
+  Hook (queue, "Dequeue", queuePath + "Dequeue", device,
+        MakeBoundCallback (&AsciiTraceHelper::DefaultDequeueSinkWithContext, stream));
+  Hook (queue, "Drop", queuePath + "Drop", device,
+        MakeBoundCallback (&AsciiTraceHelper::DefaultDropSinkWithContext, stream));
+
+  Hook (device, "PhyRxDrop", devicePath + "PhyRxDrop", device,
+        MakeBoundCallback (&AsciiTraceHelper::DefaultDropSinkWithContext, stream));
+}
 
-  oss << "/NodeList/" << nd->GetNode ()->GetId () << "/DeviceList/" << deviceid 
-      << "/$ns3::WirelessPointToPointNetDevice/MacRx";
-  Config::Connect (oss.str (), MakeBoundCallback (&AsciiTraceHelper::DefaultReceiveSinkWithContext, stream));
-
-  oss.str ("");
-  oss << "/NodeList/" << nodeid << "/DeviceList/" << deviceid 
-      << "/$ns3::WirelessPointToPointNetDevice/TxQueue/Enqueue";
-  Config::Connect (oss.str (), MakeBoundCallback (&AsciiTraceHelper::DefaultEnqueueSinkWithContext, stream));
-
-  oss.str ("");
-  oss << "/NodeList/" << nodeid << "/DeviceList/" << deviceid 
-      << "/$ns3::WirelessPointToPointNetDevice/TxQueue/Dequeue";
-  Config::Connect (oss.str (), MakeBoundCallback (&AsciiTraceHelper::DefaultDequeueSinkWithContext, stream));
-
-  oss.str ("");
-  oss << "/NodeList/" << nodeid << "/DeviceList/" << deviceid 
-      << "/$ns3::WirelessPointToPointNetDevice/TxQueue/Drop";
-  Config::Connect (oss.str (), MakeBoundCallback (&AsciiTraceHelper::DefaultDropSinkWithContext, stream));
-
-  oss.str ("");
-  oss << "/NodeList/" << nodeid << "/DeviceList/" << deviceid 
-      << "/$ns3::WirelessPointToPointNetDevice/PhyRxDrop";
-  Config::Connect (oss.str (), MakeBoundCallback (&AsciiTraceHelper::DefaultDropSinkWithContext, stream));
+void
+WirelessPointToPointHelper::SetCaptureFilter (const WpppCaptureFilter &filter)
+{
+  m_captureFilter = filter;
+}
+
+void
+WirelessPointToPointHelper::Hook (Ptr<Object> source, std::string name,
+                                  Ptr<WirelessPointToPointNetDevice> device,
+                                  Callback<void, Ptr<const Packet> > sink)
+{
+  if (m_captureFilter.IsEmpty ())
+    {
+      source->TraceConnectWithoutContext (name, sink);
+      return;
+    }
+  Ptr<WpppFilterTap> tap = Create<WpppFilterTap> (m_captureFilter, device);
+  tap->SetSink (sink);
+  source->TraceConnectWithoutContext (name, MakeCallback (&WpppFilterTap::Capture, tap));
+}
+
+void
+WirelessPointToPointHelper::Hook (Ptr<Object> source, std::string name, std::string context,
+                                  Ptr<WirelessPointToPointNetDevice> device,
+                                  Callback<void, std::string, Ptr<const Packet> > sink)
+{
+  if (m_captureFilter.IsEmpty ())
+    {
+      source->TraceConnect (name, context, sink);
+      return;
+    }
+  Ptr<WpppFilterTap> tap = Create<WpppFilterTap> (m_captureFilter, device);
+  tap->SetSink (sink, context);
+  source->TraceConnectWithoutContext (name, MakeCallback (&WpppFilterTap::Capture, tap));
+}
+
+void
+WirelessPointToPointHelper::SetAsciiBuffering (uint32_t bufferSize, bool compress)
+{
+  m_asciiBufferSize = bufferSize;
+  m_asciiCompress = compress;
+}
+
+Ptr<OutputStreamWrapper>
+WirelessPointToPointHelper::CreateAsciiStream (std::string filename)
+{
+  NS_LOG_FUNCTION (this << filename);
+  if (m_asciiBufferSize == 0)
+    {
+      AsciiTraceHelper asciiTraceHelper;
+      return asciiTraceHelper.CreateFileStream (filename);
+    }
+
+  if (m_asciiCompress)
+    {
+      filename += ".gz";
+    }
+  Ptr<WpppBufferedStream> buffered = Create<WpppBufferedStream> ();
+  if (!buffered->Open (filename, m_asciiCompress, m_asciiBufferSize))
+    {
+      NS_FATAL_ERROR ("WirelessPointToPointHelper::CreateAsciiStream(): Unable to open " << filename
+                      << (m_asciiCompress ? " (compression needs zlib)" : ""));
+    }
+  //the destroy event keeps the buffered stream alive until the end
+  Simulator::ScheduleDestroy (&WpppBufferedStream::Close, buffered);
+  return Create<OutputStreamWrapper> (buffered->GetStream ());
 }
 
 NetDeviceContainer 
@@ -295,4 +574,42 @@ WirelessPointToPointHelper::Install (NodeContainer c, int devicesPerNode)
   return container;
 }
 
+NetDeviceContainer
+WirelessPointToPointHelper::InstallMultiBeam (NodeContainer c, uint32_t beamsPerNode)
+{
+  NetDeviceContainer container;
+
+  Ptr<WirelessPointToPointChannel> channel =
+    m_channelFactory.Create<WirelessPointToPointChannel> ();
+  Ptr<PropagationDelayModel> delay =
+    m_propagationDelay.Create<PropagationDelayModel> ();
+  channel->SetPropagationDelayModel (delay);
+
+  for (NodeContainer::Iterator i = c.Begin (); i != c.End (); ++i)
+    {
+      Ptr<Node> node = *i;
+      Ptr<WpppMultiBeamNetDevice> device = CreateObject<WpppMultiBeamNetDevice> ();
+      device->SetAddress (Mac48Address::Allocate ());
+      for (uint32_t j = 0; j < beamsPerNode; j++)
+        {
+          Ptr<WirelessPointToPointNetDevice> beam =
+            m_deviceFactory.Create<WirelessPointToPointNetDevice> ();
+          beam->SetQueue (m_queueFactory.Create<Queue> ());
+          beam->Attach (channel);
+          device->AddBeam (beam);
+        }
+
+      if (MpiInterface::IsEnabled ())
+        {
+          Ptr<MpiReceiver> mpiRec = CreateObject<MpiReceiver> ();
+          mpiRec->SetReceiveCallback (MakeCallback (&WpppMultiBeamNetDevice::Receive, device));
+          device->AggregateObject (mpiRec);
+        }
+
+      node->AddDevice (device);
+      container.Add (device);
+    }
+  return container;
+}
+
 } // namespace ns3
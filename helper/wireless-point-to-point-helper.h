@@ -13,12 +13,14 @@
 #include "ns3/node-container.h"
 
 #include "ns3/trace-helper.h"
+#include "ns3/wppp-capture-filter.h"
 
 namespace ns3 {
 
 class Queue;
 class NetDevice;
 class Node;
+class WirelessPointToPointNetDevice;
 
 /**
  * \brief Build a set of WirelessPointToPointNetDevice objects
@@ -143,7 +145,126 @@ public:
    */
   NetDeviceContainer Install (NodeContainer c, int devicesPerNode);
 
+  /**
+   * \brief Give each node one device with several beams
+   * \param c a set of nodes
+   * \param beamsPerNode number of beams of each device
+   * \return the ns3::WpppMultiBeamNetDevice of each node
+   *
+   * Like Install, with one channel for all the nodes, but the devices
+   * created with the device attributes become the beams of one
+   * ns3::WpppMultiBeamNetDevice per node; only that device is added to
+   * the node.
+   */
+  NetDeviceContainer InstallMultiBeam (NodeContainer c, uint32_t beamsPerNode);
+
+  /**
+   * \brief Configure how EnablePcap writes capture files
+   *
+   * One background thread writes the buffers of every file, but each file
+   * keeps its own buffer, so capturing thousands of devices costs that many
+   * buffers; EnablePcapMerged needs only one.
+   *
+   * \param bufferSize if non zero, frames are collected into buffers of this
+   *        many bytes that the background thread writes out, instead of
+   *        being written synchronously as they are captured
+   * \param snapLen maximum number of bytes captured of each frame
+   */
+  void SetPcapBuffering (uint32_t bufferSize, uint32_t snapLen = 65535);
+
+  /**
+   * \brief Capture a set of devices into one pcapng file
+   *
+   * Every device gets its own interface block, named after its node id and
+   * interface index, and all frames go to one file through a background
+   * writer thread.  The buffer size and snap length are those of
+   * SetPcapBuffering (1 MB buffers if buffering is off).
+   *
+   * \param filename name of the pcapng file
+   * \param devices devices to capture; others than
+   *        WirelessPointToPointNetDevices are ignored
+   */
+  void EnablePcapMerged (std::string filename, NetDeviceContainer devices);
+
+  /**
+   * \brief Configure the files created for ASCII tracing
+   *
+   * \param bufferSize if non zero, trace text is collected into buffers of
+   *        this many bytes that a background thread writes out
+   *        (WpppBufferedStream); the files are complete after
+   *        Simulator::Destroy
+   * \param compress gzip the buffered files, which get a ".gz" suffix;
+   *        requires zlib
+   */
+  void SetAsciiBuffering (uint32_t bufferSize, bool compress = false);
+
+  /**
+   * \brief Create a stream for EnableAscii following SetAsciiBuffering
+   *
+   * \param filename name of the trace file
+   * \return the stream to pass to EnableAscii or EnableAsciiAll
+   */
+  Ptr<OutputStreamWrapper> CreateAsciiStream (std::string filename);
+
+  /**
+   * \brief Restrict the pcap and ASCII traces enabled from now on
+   *
+   * Traces enabled afterwards apply a copy of the filter; later changes to
+   * it have no effect on them.  Frames the filter rejects are not copied or
+   * printed.
+   *
+   * \param filter the frames to trace; a default WpppCaptureFilter traces
+   *        everything
+   */
+  void SetCaptureFilter (const WpppCaptureFilter &filter);
+
+  /**
+   * \brief Record per link latency histograms and write them out at
+   * Simulator::Destroy
+   *
+   * Sets the LatencyStats attribute of the devices, so the frames they send
+   * are stamped, and writes the histograms of the frames they receive to
+   * filename (suffixed with "-<rank>" when MPI is enabled).  Each line holds
+   * the receiving node and interface, the sending node and interface, the
+   * part (queueing, transmission, propagation or total), the 50th, 99th and
+   * 99.9th percentiles in ns, and the histogram as written by
+   * WpppLatencyHistogram::Write, so the files of several ranks or runs can
+   * be merged.
+   *
+   * \param filename name of the file
+   * \param devices devices to record; others than
+   *        WirelessPointToPointNetDevices are ignored
+   */
+  void EnableLatencyStats (std::string filename, NetDeviceContainer devices);
+
 private:
+  /**
+   * \brief Connect a sink to a trace source of a device or its queue,
+   * through the capture filter if one is set
+   *
+   * \param source object owning the trace source
+   * \param name name of the trace source
+   * \param device device the frames are seen on
+   * \param sink the trace sink
+   */
+  void Hook (Ptr<Object> source, std::string name,
+             Ptr<WirelessPointToPointNetDevice> device,
+             Callback<void, Ptr<const Packet> > sink);
+
+  /**
+   * \brief Connect a sink expecting a context to a trace source of a device
+   * or its queue, through the capture filter if one is set
+   *
+   * \param source object owning the trace source
+   * \param name name of the trace source
+   * \param context context passed to the sink
+   * \param device device the frames are seen on
+   * \param sink the trace sink
+   */
+  void Hook (Ptr<Object> source, std::string name, std::string context,
+             Ptr<WirelessPointToPointNetDevice> device,
+             Callback<void, std::string, Ptr<const Packet> > sink);
+
   /**
    * \brief Enable pcap output the indicated net device.
    *
@@ -181,6 +302,11 @@ private:
   ObjectFactory m_remoteChannelFactory; //!< Remote Channel Factory
   ObjectFactory m_deviceFactory;        //!< Device Factory
   ObjectFactory m_propagationDelay;     //!< Propagation Delay Factory
+  uint32_t m_pcapBufferSize;            //!< Buffered pcap buffer size, 0 if off
+  uint32_t m_pcapSnapLen;               //!< Bytes captured of each frame
+  uint32_t m_asciiBufferSize;           //!< Buffered ASCII buffer size, 0 if off
+  bool m_asciiCompress;                 //!< Compress buffered ASCII files
+  WpppCaptureFilter m_captureFilter;    //!< Filter of the traces enabled next
 };
 
 } // namespace ns3
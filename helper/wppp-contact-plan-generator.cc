@@ -0,0 +1,420 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 University of North Carolina at Chapel Hill
+ * Author: Ben Newton
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <set>
+#include <vector>
+#include "ns3/abort.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/mobility-model.h"
+#include "ns3/wireless-point-to-point-net-device.h"
+#include "ns3/wppp-contact-plan.h"
+#include "ns3/wppp-parallel.h"
+#include "wppp-contact-plan-generator.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("WirelessPointToPointContactPlanGenerator");
+
+/**
+ * \brief Samples the nodes of one Install call and writes their contacts
+ */
+class WpppContactPlanSampler : public SimpleRefCount<WpppContactPlanSampler>
+{
+public:
+  WpppContactPlanSampler (NodeContainer nodes, double range, double occlusionRadius,
+                          uint32_t threads, Ptr<WpppContactPlanWriter> writer);
+
+  /**
+   * \brief Take one sample and schedule the next one
+   * \param stop time after which no more samples are taken
+   * \param step time between samples
+   */
+  void Sample (Time stop, Time step);
+
+  /**
+   * \return number of contacts not made for lack of a free device
+   */
+  uint64_t GetUnservedContacts (void) const;
+
+private:
+  /**
+   * \brief Find the visible pairs (i, j), i < j, for the nodes of a range of
+   * blocks.  Runs on the worker threads.
+   */
+  void FindVisible (uint32_t beginBlock, uint32_t endBlock);
+
+  /**
+   * \return true if nodes i and j are in range and in line of sight
+   */
+  bool IsVisible (uint32_t i, uint32_t j) const;
+
+  /**
+   * \return the grid key of a cell
+   */
+  static uint64_t CellKey (int64_t cx, int64_t cy, int64_t cz);
+
+  /**
+   * \brief Write the plan entry for one pair
+   */
+  void WriteEntry (uint8_t action, uint32_t i, uint32_t devI, uint32_t j, uint32_t devJ);
+
+  /**
+   * \brief Give a visible pair a free device on each node and write the
+   * connection
+   * \return false if either node has no free device
+   */
+  bool Connect (uint64_t pair);
+
+  std::vector<Ptr<MobilityModel> > m_mobility;          //!< Mobility of each node
+  std::vector<uint32_t> m_nodeIds;                      //!< Node id of each node
+  std::vector<std::vector<uint32_t> > m_freeDevices;    //!< Free device indices per node
+  std::vector<double> m_x;                              //!< Sampled x positions
+  std::vector<double> m_y;                              //!< Sampled y positions
+  std::vector<double> m_z;                              //!< Sampled z positions
+  std::vector<int64_t> m_cx;                            //!< Grid cell x of each node
+  std::vector<int64_t> m_cy;                            //!< Grid cell y of each node
+  std::vector<int64_t> m_cz;                            //!< Grid cell z of each node
+  std::vector<std::pair<uint64_t, uint32_t> > m_cells;  //!< (cell key, node) sorted
+  std::vector<std::vector<uint64_t> > m_blockPairs;     //!< Visible pairs per block
+  uint32_t m_blockSize;                                 //!< Nodes per block
+  std::vector<uint64_t> m_visible;                      //!< Visible pairs, sorted
+  std::map<uint64_t, std::pair<uint32_t, uint32_t> > m_open; //!< Pair -> devices
+  std::set<uint64_t> m_waiting;                         //!< Visible pairs left without devices
+  double m_range;                                       //!< Maximum link distance
+  double m_occlusionRadius;                             //!< Occluding sphere radius
+  bool m_useGrid;                                       //!< False for an infinite range
+  uint32_t m_threads;                                   //!< Threads per sample
+  Ptr<WpppContactPlanWriter> m_writer;                  //!< Plan being written
+  uint64_t m_unserved;                                  //!< Contacts not made
+};
+
+WpppContactPlanSampler::WpppContactPlanSampler (NodeContainer nodes, double range,
+                                                double occlusionRadius, uint32_t threads,
+                                                Ptr<WpppContactPlanWriter> writer)
+  : m_range (range),
+    m_occlusionRadius (occlusionRadius),
+    m_threads (threads),
+    m_writer (writer),
+    m_unserved (0)
+{
+  m_useGrid = range > 0 && range < std::numeric_limits<double>::infinity ();
+  for (NodeContainer::Iterator i = nodes.Begin (); i != nodes.End (); ++i)
+    {
+      Ptr<Node> node = *i;
+      Ptr<MobilityModel> mobility = node->GetObject<MobilityModel> ();
+      NS_ABORT_MSG_IF (mobility == 0, "Node " << node->GetId () << " has no MobilityModel");
+      m_mobility.push_back (mobility);
+      m_nodeIds.push_back (node->GetId ());
+
+      std::vector<uint32_t> devices;
+      for (uint32_t d = 0; d < node->GetNDevices (); d++)
+        {
+          if (DynamicCast<WirelessPointToPointNetDevice> (node->GetDevice (d)) != 0)
+            {
+              devices.push_back (d);
+            }
+        }
+      //hand out the lowest index first
+      std::reverse (devices.begin (), devices.end ());
+      m_freeDevices.push_back (devices);
+    }
+
+  uint32_t n = m_mobility.size ();
+  m_x.resize (n);
+  m_y.resize (n);
+  m_z.resize (n);
+  m_cx.resize (n);
+  m_cy.resize (n);
+  m_cz.resize (n);
+  uint32_t workers = m_threads ? m_threads : WpppParallel::GetDefaultThreads ();
+  m_blockSize = std::max<uint32_t> (64, n / (workers * 16) + 1);
+  m_blockPairs.resize ((n + m_blockSize - 1) / m_blockSize);
+}
+
+uint64_t
+WpppContactPlanSampler::CellKey (int64_t cx, int64_t cy, int64_t cz)
+{
+  //21 bits per axis; cells that alias only add candidates, which are then
+  //rejected by the distance check
+  const uint64_t mask = (1 << 21) - 1;
+  return ((uint64_t (cx) & mask) << 42) | ((uint64_t (cy) & mask) << 21) | (uint64_t (cz) & mask);
+}
+
+bool
+WpppContactPlanSampler::IsVisible (uint32_t i, uint32_t j) const
+{
+  double dx = m_x[j] - m_x[i];
+  double dy = m_y[j] - m_y[i];
+  double dz = m_z[j] - m_z[i];
+  double d2 = dx * dx + dy * dy + dz * dz;
+  if (m_useGrid && d2 > m_range * m_range)
+    {
+      return false;
+    }
+  if (m_occlusionRadius <= 0 || d2 == 0)
+    {
+      return true;
+    }
+  //closest point of the segment i->j to the center of the occluding sphere
+  double t = -(m_x[i] * dx + m_y[i] * dy + m_z[i] * dz) / d2;
+  t = std::max (0.0, std::min (1.0, t));
+  double px = m_x[i] + t * dx;
+  double py = m_y[i] + t * dy;
+  double pz = m_z[i] + t * dz;
+  return px * px + py * py + pz * pz >= m_occlusionRadius * m_occlusionRadius;
+}
+
+void
+WpppContactPlanSampler::FindVisible (uint32_t beginBlock, uint32_t endBlock)
+{
+  uint32_t n = m_x.size ();
+  for (uint32_t b = beginBlock; b < endBlock; b++)
+    {
+      std::vector<uint64_t> &pairs = m_blockPairs[b];
+      pairs.clear ();
+      uint32_t last = std::min (n, (b + 1) * m_blockSize);
+      for (uint32_t i = b * m_blockSize; i < last; i++)
+        {
+          int span = m_useGrid ? 1 : 0;
+          for (int dx = -span; dx <= span; dx++)
+            {
+              for (int dy = -span; dy <= span; dy++)
+                {
+                  for (int dz = -span; dz <= span; dz++)
+                    {
+                      uint64_t key = CellKey (m_cx[i] + dx, m_cy[i] + dy, m_cz[i] + dz);
+                      std::vector<std::pair<uint64_t, uint32_t> >::const_iterator it =
+                        std::lower_bound (m_cells.begin (), m_cells.end (),
+                                          std::make_pair (key, uint32_t (i + 1)));
+                      for (; it != m_cells.end () && it->first == key; ++it)
+                        {
+                          if (IsVisible (i, it->second))
+                            {
+                              pairs.push_back ((uint64_t (i) << 32) | it->second);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+      std::sort (pairs.begin (), pairs.end ());
+      pairs.erase (std::unique (pairs.begin (), pairs.end ()), pairs.end ());
+    }
+}
+
+void
+WpppContactPlanSampler::WriteEntry (uint8_t action, uint32_t i, uint32_t devI,
+                                    uint32_t j, uint32_t devJ)
+{
+  WpppContactPlanEntry entry;
+  entry.time = Simulator::Now ().GetNanoSeconds ();
+  entry.action = action;
+  entry.nodeA = m_nodeIds[i];
+  entry.devA = devI;
+  entry.nodeB = m_nodeIds[j];
+  entry.devB = devJ;
+  m_writer->Write (entry);
+}
+
+bool
+WpppContactPlanSampler::Connect (uint64_t pair)
+{
+  uint32_t i = pair >> 32;
+  uint32_t j = pair & 0xffffffff;
+  if (m_freeDevices[i].empty () || m_freeDevices[j].empty ())
+    {
+      return false;
+    }
+  uint32_t devI = m_freeDevices[i].back ();
+  uint32_t devJ = m_freeDevices[j].back ();
+  m_freeDevices[i].pop_back ();
+  m_freeDevices[j].pop_back ();
+  m_open[pair] = std::make_pair (devI, devJ);
+  WriteEntry (WpppContactPlanEntry::CONNECT, i, devI, j, devJ);
+  return true;
+}
+
+void
+WpppContactPlanSampler::Sample (Time stop, Time step)
+{
+  NS_LOG_FUNCTION (this << stop << step);
+  uint32_t n = m_mobility.size ();
+
+  //mobility models are not thread safe, so positions are gathered here
+  m_cells.resize (n);
+  double cell = m_useGrid ? m_range : 1;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Vector pos = m_mobility[i]->GetPosition ();
+      m_x[i] = pos.x;
+      m_y[i] = pos.y;
+      m_z[i] = pos.z;
+      m_cx[i] = m_useGrid ? static_cast<int64_t> (std::floor (pos.x / cell)) : 0;
+      m_cy[i] = m_useGrid ? static_cast<int64_t> (std::floor (pos.y / cell)) : 0;
+      m_cz[i] = m_useGrid ? static_cast<int64_t> (std::floor (pos.z / cell)) : 0;
+      m_cells[i] = std::make_pair (CellKey (m_cx[i], m_cy[i], m_cz[i]), i);
+    }
+  std::sort (m_cells.begin (), m_cells.end ());
+
+  WpppParallel::For (m_blockPairs.size (), m_threads,
+                     MakeCallback (&WpppContactPlanSampler::FindVisible, this));
+
+  //blocks cover increasing node ranges, so concatenating keeps the order
+  std::vector<uint64_t> visible;
+  for (uint32_t b = 0; b < m_blockPairs.size (); b++)
+    {
+      visible.insert (visible.end (), m_blockPairs[b].begin (), m_blockPairs[b].end ());
+    }
+
+  std::vector<uint64_t> added;
+  bool released = false;
+  std::vector<uint64_t>::const_iterator o = m_visible.begin ();
+  std::vector<uint64_t>::const_iterator c = visible.begin ();
+  while (o != m_visible.end () || c != visible.end ())
+    {
+      if (c == visible.end () || (o != m_visible.end () && *o < *c))
+        {
+          //lost visibility, break the contact if it was made
+          std::map<uint64_t, std::pair<uint32_t, uint32_t> >::iterator it = m_open.find (*o);
+          if (it != m_open.end ())
+            {
+              uint32_t i = *o >> 32;
+              uint32_t j = *o & 0xffffffff;
+              WriteEntry (WpppContactPlanEntry::DISCONNECT, i, it->second.first,
+                          j, it->second.second);
+              m_freeDevices[i].push_back (it->second.first);
+              m_freeDevices[j].push_back (it->second.second);
+              m_open.erase (it);
+              released = true;
+            }
+          else
+            {
+              m_waiting.erase (*o);
+            }
+          ++o;
+        }
+      else if (o == m_visible.end () || *c < *o)
+        {
+          added.push_back (*c);
+          ++c;
+        }
+      else
+        {
+          ++o;
+          ++c;
+        }
+    }
+
+  //connections after disconnections so freed devices can be reused, first
+  //by the pairs that were already waiting for them
+  if (released)
+    {
+      std::set<uint64_t>::iterator w = m_waiting.begin ();
+      while (w != m_waiting.end ())
+        {
+          if (Connect (*w))
+            {
+              m_waiting.erase (w++);
+            }
+          else
+            {
+              ++w;
+            }
+        }
+    }
+  for (uint32_t k = 0; k < added.size (); k++)
+    {
+      if (!Connect (added[k]))
+        {
+          m_unserved++;
+          m_waiting.insert (added[k]);
+        }
+    }
+  m_visible.swap (visible);
+
+  if (Simulator::Now () + step <= stop)
+    {
+      Simulator::Schedule (step, &WpppContactPlanSampler::Sample,
+                           Ptr<WpppContactPlanSampler> (this), stop, step);
+    }
+  else
+    {
+      m_writer->Close ();
+    }
+}
+
+uint64_t
+WpppContactPlanSampler::GetUnservedContacts (void) const
+{
+  return m_unserved;
+}
+
+WirelessPointToPointContactPlanGenerator::WirelessPointToPointContactPlanGenerator ()
+  : m_range (std::numeric_limits<double>::infinity ()),
+    m_occlusionRadius (0),
+    m_threads (0)
+{
+}
+
+WirelessPointToPointContactPlanGenerator::~WirelessPointToPointContactPlanGenerator ()
+{
+}
+
+void
+WirelessPointToPointContactPlanGenerator::SetRange (double range)
+{
+  m_range = range;
+}
+
+void
+WirelessPointToPointContactPlanGenerator::SetOcclusionRadius (double radius)
+{
+  m_occlusionRadius = radius;
+}
+
+void
+WirelessPointToPointContactPlanGenerator::SetThreads (uint32_t threads)
+{
+  m_threads = threads;
+}
+
+void
+WirelessPointToPointContactPlanGenerator::Install (NodeContainer nodes, Time start,
+                                                   Time stop, Time step,
+                                                   std::string filename, bool binary)
+{
+  NS_LOG_FUNCTION (this << start << stop << step << filename << binary);
+  NS_ABORT_MSG_IF (!step.IsStrictlyPositive (), "Sampling step must be positive");
+  Ptr<WpppContactPlanWriter> writer = Create<WpppContactPlanWriter> ();
+  if (!writer->Open (filename, binary))
+    {
+      NS_FATAL_ERROR ("Unable to create contact plan " << filename);
+    }
+  Ptr<WpppContactPlanSampler> sampler =
+    Create<WpppContactPlanSampler> (nodes, m_range, m_occlusionRadius, m_threads, writer);
+  m_samplers.push_back (sampler);
+  Time delay = start - Simulator::Now ();
+  Simulator::Schedule (delay.IsNegative () ? Seconds (0) : delay,
+                       &WpppContactPlanSampler::Sample, sampler, stop, step);
+}
+
+uint64_t
+WirelessPointToPointContactPlanGenerator::GetUnservedContacts (void) const
+{
+  uint64_t total = 0;
+  for (uint32_t i = 0; i < m_samplers.size (); i++)
+    {
+      total += m_samplers[i]->GetUnservedContacts ();
+    }
+  return total;
+}
+
+} // namespace ns3
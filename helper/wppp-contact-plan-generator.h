@@ -0,0 +1,105 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 University of North Carolina at Chapel Hill
+ * Author: Ben Newton
+ */
+#ifndef WPPP_CONTACT_PLAN_GENERATOR_H
+#define WPPP_CONTACT_PLAN_GENERATOR_H
+
+#include <string>
+#include <vector>
+
+#include "ns3/ptr.h"
+#include "ns3/nstime.h"
+#include "ns3/node-container.h"
+
+namespace ns3 {
+
+class WpppContactPlanSampler;
+
+/**
+ * \brief Generate a contact plan from the mobility models of a set of nodes
+ *
+ * The positions of the nodes are sampled every step between start and stop
+ * while the simulator runs.  At each sample the pairs of nodes within range
+ * whose line of sight does not cross the occluding sphere (centered at the
+ * origin, e.g. the Earth) are found using a uniform grid with a cell size
+ * equal to the range, spread over a pool of threads.  Changes in visibility
+ * are written as plan entries that WirelessPointToPointContactPlanHelper can
+ * replay.
+ *
+ * When a pair becomes visible it is given the first free
+ * WirelessPointToPointNetDevice on each node; if either node has no free
+ * device the contact waits, and is made at the first sample that frees
+ * devices on both nodes while the pair is still visible.  The plan is written as the samples are
+ * taken, so nothing but the current visibility set is held in memory.
+ *
+ * Typical use is a separate short run with only the nodes, their mobility
+ * models and their wireless point to point devices installed:
+ *
+ * \code
+ *   WirelessPointToPointContactPlanGenerator generator;
+ *   generator.SetRange (5000e3);
+ *   generator.SetOcclusionRadius (6371e3);
+ *   generator.Install (nodes, Seconds (0), Seconds (86400), Seconds (10), "plan.bin", true);
+ *   Simulator::Run ();
+ *   Simulator::Destroy ();
+ * \endcode
+ */
+class WirelessPointToPointContactPlanGenerator
+{
+public:
+  /**
+   * Create a generator with an infinite range, no occlusion and one thread
+   * per processor.
+   */
+  WirelessPointToPointContactPlanGenerator ();
+  ~WirelessPointToPointContactPlanGenerator ();
+
+  /**
+   * \param range maximum distance in meters between two aligned nodes
+   */
+  void SetRange (double range);
+
+  /**
+   * \param radius radius in meters of the sphere centered at the origin that
+   *        blocks line of sight, 0 to disable
+   */
+  void SetOcclusionRadius (double radius);
+
+  /**
+   * \param threads number of threads used per sample, 0 for one per
+   *        processor
+   */
+  void SetThreads (uint32_t threads);
+
+  /**
+   * \brief Schedule the sampling of the nodes
+   *
+   * \param nodes nodes to consider; each must have a MobilityModel
+   * \param start time of the first sample
+   * \param stop time after which no more samples are taken
+   * \param step time between samples
+   * \param filename contact plan to create
+   * \param binary write the binary plan format if true, CSV otherwise
+   */
+  void Install (NodeContainer nodes, Time start, Time stop, Time step,
+                std::string filename, bool binary);
+
+  /**
+   * \return number of contacts that could not be made when their pair
+   *         became visible because one of the nodes had no free device, over
+   *         all Install calls; some of them may have been made later
+   */
+  uint64_t GetUnservedContacts (void) const;
+
+private:
+  double m_range;                       //!< Maximum link distance
+  double m_occlusionRadius;             //!< Radius of the occluding sphere
+  uint32_t m_threads;                   //!< Threads used per sample
+  std::vector<Ptr<WpppContactPlanSampler> > m_samplers; //!< Installed samplers
+};
+
+} // namespace ns3
+
+#endif /* WPPP_CONTACT_PLAN_GENERATOR_H */
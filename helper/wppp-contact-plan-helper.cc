@@ -0,0 +1,162 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 University of North Carolina at Chapel Hill
+ * Author: Ben Newton
+ */
+
+#include "ns3/abort.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/node-list.h"
+#include "ns3/wireless-point-to-point-net-device.h"
+#include "ns3/wppp-contact-plan.h"
+#include "wppp-contact-plan-helper.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("WirelessPointToPointContactPlanHelper");
+
+/**
+ * \brief Keeps a window of contact plan entries scheduled
+ *
+ * Owned by the events it schedules, so it lives exactly as long as there is
+ * something left to replay.
+ */
+class WpppContactPlanPlayer : public SimpleRefCount<WpppContactPlanPlayer>
+{
+public:
+  WpppContactPlanPlayer (Ptr<WpppContactPlanReader> reader, uint32_t window);
+
+  /**
+   * \brief Read and schedule entries until the window is full
+   */
+  void Refill (void);
+
+private:
+  /**
+   * \brief Apply one entry and pull the next one from the plan
+   * \param entry the entry due now
+   */
+  void Fire (WpppContactPlanEntry entry);
+
+  /**
+   * \brief Look up the wireless point to point device of a plan entry
+   */
+  static Ptr<WirelessPointToPointNetDevice> GetDevice (Ptr<Node> node, uint32_t index);
+
+  Ptr<WpppContactPlanReader> m_reader;  //!< Plan being replayed
+  uint32_t m_window;                    //!< Entries to keep scheduled
+  uint32_t m_pending;                   //!< Entries currently scheduled
+  int64_t m_lastTime;                   //!< Time of the last entry read
+  bool m_done;                          //!< End of the plan reached
+};
+
+WpppContactPlanPlayer::WpppContactPlanPlayer (Ptr<WpppContactPlanReader> reader,
+                                              uint32_t window)
+  : m_reader (reader),
+    m_window (window),
+    m_pending (0),
+    m_lastTime (0),
+    m_done (false)
+{
+}
+
+void
+WpppContactPlanPlayer::Refill (void)
+{
+  WpppContactPlanEntry entry;
+  while (!m_done && m_pending < m_window)
+    {
+      if (!m_reader->Next (entry))
+        {
+          NS_LOG_LOGIC ("End of contact plan");
+          m_done = true;
+          m_reader->Close ();
+          break;
+        }
+      NS_ABORT_MSG_IF (entry.time < m_lastTime, "Contact plan is not ordered by time");
+      m_lastTime = entry.time;
+
+      Time delay = NanoSeconds (entry.time) - Simulator::Now ();
+      if (delay.IsNegative ())
+        {
+          delay = Seconds (0);
+        }
+      m_pending++;
+      Simulator::Schedule (delay, &WpppContactPlanPlayer::Fire, Ptr<WpppContactPlanPlayer> (this), entry);
+    }
+}
+
+Ptr<WirelessPointToPointNetDevice>
+WpppContactPlanPlayer::GetDevice (Ptr<Node> node, uint32_t index)
+{
+  NS_ABORT_MSG_IF (index >= node->GetNDevices (),
+                   "Contact plan refers to device " << index << " of node " << node->GetId ());
+  Ptr<WirelessPointToPointNetDevice> dev =
+    DynamicCast<WirelessPointToPointNetDevice> (node->GetDevice (index));
+  NS_ABORT_MSG_IF (dev == 0, "Device " << index << " of node " << node->GetId ()
+                   << " is not a WirelessPointToPointNetDevice");
+  return dev;
+}
+
+void
+WpppContactPlanPlayer::Fire (WpppContactPlanEntry entry)
+{
+  NS_LOG_FUNCTION (this << entry.nodeA << entry.devA << entry.nodeB << entry.devB);
+  m_pending--;
+
+  Ptr<Node> nodeA = NodeList::GetNode (entry.nodeA);
+  Ptr<Node> nodeB = NodeList::GetNode (entry.nodeB);
+  Ptr<WirelessPointToPointNetDevice> devA = GetDevice (nodeA, entry.devA);
+  Ptr<WirelessPointToPointNetDevice> devB;
+  if (entry.devB != WpppContactPlanEntry::NO_DEVICE)
+    {
+      devB = GetDevice (nodeB, entry.devB);
+    }
+
+  if (entry.action == WpppContactPlanEntry::CONNECT)
+    {
+      devA->Connect (nodeA, devA, nodeB);
+      if (devB)
+        {
+          devB->Connect (nodeB, devB, nodeA);
+        }
+    }
+  else
+    {
+      devA->Disconnect (nodeA, devA, nodeB);
+      if (devB)
+        {
+          devB->Disconnect (nodeB, devB, nodeA);
+        }
+    }
+
+  Refill ();
+}
+
+WirelessPointToPointContactPlanHelper::WirelessPointToPointContactPlanHelper ()
+  : m_window (16)
+{
+}
+
+void
+WirelessPointToPointContactPlanHelper::SetWindow (uint32_t window)
+{
+  NS_ABORT_MSG_IF (window == 0, "Contact plan window must hold at least one entry");
+  m_window = window;
+}
+
+void
+WirelessPointToPointContactPlanHelper::Install (std::string filename) const
+{
+  NS_LOG_FUNCTION (this << filename);
+  Ptr<WpppContactPlanReader> reader = Create<WpppContactPlanReader> ();
+  if (!reader->Open (filename))
+    {
+      NS_FATAL_ERROR ("Unable to open contact plan " << filename);
+    }
+  Ptr<WpppContactPlanPlayer> player = Create<WpppContactPlanPlayer> (reader, m_window);
+  player->Refill ();
+}
+
+} // namespace ns3
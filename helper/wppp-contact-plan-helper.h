@@ -0,0 +1,54 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 University of North Carolina at Chapel Hill
+ * Author: Ben Newton
+ */
+#ifndef WPPP_CONTACT_PLAN_HELPER_H
+#define WPPP_CONTACT_PLAN_HELPER_H
+
+#include <stdint.h>
+#include <string>
+
+namespace ns3 {
+
+/**
+ * \brief Drive Connect/Disconnect of WirelessPointToPointNetDevices from a
+ * contact plan file
+ *
+ * Instead of scheduling every entry of the plan up front, the plan is
+ * streamed from disk and only a window of the next entries is kept in the
+ * event list.  Each time one of them fires the next entry of the file is read
+ * and scheduled, so the memory used is proportional to the window and not to
+ * the plan.  See WpppContactPlanReader for the file formats.
+ */
+class WirelessPointToPointContactPlanHelper
+{
+public:
+  /**
+   * Create a WirelessPointToPointContactPlanHelper with a window of 16
+   * scheduled contacts.
+   */
+  WirelessPointToPointContactPlanHelper ();
+
+  /**
+   * \brief Set the number of plan entries kept in the event list
+   * \param window number of entries scheduled ahead of the current time
+   */
+  void SetWindow (uint32_t window);
+
+  /**
+   * \brief Start replaying a contact plan
+   * \param filename path of the contact plan
+   *
+   * The plan must be ordered by time.  Entries in the past are applied
+   * immediately.  May be called before or during Simulator::Run.
+   */
+  void Install (std::string filename) const;
+
+private:
+  uint32_t m_window; //!< Number of entries scheduled ahead
+};
+
+} // namespace ns3
+
+#endif /* WPPP_CONTACT_PLAN_HELPER_H */
@@ -0,0 +1,131 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 University of North Carolina at Chapel Hill
+ * Author: Ben Newton
+ */
+
+#include <algorithm>
+#include "ns3/abort.h"
+#include "ns3/log.h"
+#include "wppp-link-assigner.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("WirelessPointToPointLinkAssigner");
+
+WirelessPointToPointLinkAssigner::WirelessPointToPointLinkAssigner ()
+{
+}
+
+void
+WirelessPointToPointLinkAssigner::SetThreads (uint32_t threads)
+{
+  m_matching.SetThreads (threads);
+}
+
+void
+WirelessPointToPointLinkAssigner::Install (NodeContainer nodes)
+{
+  for (NodeContainer::Iterator i = nodes.Begin (); i != nodes.End (); ++i)
+    {
+      Ptr<Node> node = *i;
+      if (m_index.find (node->GetId ()) != m_index.end ())
+        {
+          continue;
+        }
+      std::vector<Ptr<WirelessPointToPointNetDevice> > devices;
+      for (uint32_t d = node->GetNDevices (); d > 0; d--)
+        {
+          //stored in reverse so the lowest index is handed out first
+          Ptr<WirelessPointToPointNetDevice> dev =
+            DynamicCast<WirelessPointToPointNetDevice> (node->GetDevice (d - 1));
+          if (dev != 0)
+            {
+              devices.push_back (dev);
+            }
+        }
+      uint32_t index = m_nodes.size ();
+      m_index[node->GetId ()] = index;
+      m_nodes.push_back (node);
+      m_matching.SetCapacity (index, devices.size ());
+      m_freeDevices.push_back (devices);
+    }
+}
+
+uint32_t
+WirelessPointToPointLinkAssigner::GetIndex (Ptr<Node> node) const
+{
+  std::map<uint32_t, uint32_t>::const_iterator i = m_index.find (node->GetId ());
+  NS_ABORT_MSG_IF (i == m_index.end (), "Node " << node->GetId () << " not installed in the link assigner");
+  return i->second;
+}
+
+void
+WirelessPointToPointLinkAssigner::SetCandidate (Ptr<Node> a, Ptr<Node> b, double weight)
+{
+  m_matching.SetLink (GetIndex (a), GetIndex (b), weight);
+}
+
+void
+WirelessPointToPointLinkAssigner::RemoveCandidate (Ptr<Node> a, Ptr<Node> b)
+{
+  m_matching.RemoveLink (GetIndex (a), GetIndex (b));
+}
+
+void
+WirelessPointToPointLinkAssigner::Apply (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_matching.Solve ();
+
+  std::vector<std::pair<uint32_t, uint32_t> > added;
+  std::vector<std::pair<uint32_t, uint32_t> > removed;
+  m_matching.TakeChanges (added, removed);
+
+  //break links first so their terminals can be reused
+  for (uint32_t k = 0; k < removed.size (); k++)
+    {
+      uint32_t a = removed[k].first;
+      uint32_t b = removed[k].second;
+      uint64_t key = (uint64_t (a) << 32) | b;
+      std::map<uint64_t, DevicePair>::iterator it = m_links.find (key);
+      NS_ASSERT (it != m_links.end ());
+      Ptr<WirelessPointToPointNetDevice> devA = it->second.first;
+      Ptr<WirelessPointToPointNetDevice> devB = it->second.second;
+      devA->Disconnect (m_nodes[a], devA, m_nodes[b]);
+      devB->Disconnect (m_nodes[b], devB, m_nodes[a]);
+      m_freeDevices[a].push_back (devA);
+      m_freeDevices[b].push_back (devB);
+      m_links.erase (it);
+    }
+
+  for (uint32_t k = 0; k < added.size (); k++)
+    {
+      uint32_t a = added[k].first;
+      uint32_t b = added[k].second;
+      NS_ASSERT_MSG (!m_freeDevices[a].empty () && !m_freeDevices[b].empty (),
+                     "Matching exceeded the terminals of a node");
+      Ptr<WirelessPointToPointNetDevice> devA = m_freeDevices[a].back ();
+      Ptr<WirelessPointToPointNetDevice> devB = m_freeDevices[b].back ();
+      m_freeDevices[a].pop_back ();
+      m_freeDevices[b].pop_back ();
+      devA->Connect (m_nodes[a], devA, m_nodes[b]);
+      devB->Connect (m_nodes[b], devB, m_nodes[a]);
+      m_links[(uint64_t (a) << 32) | b] = DevicePair (devA, devB);
+    }
+  NS_LOG_LOGIC (removed.size () << " links broken, " << added.size () << " links aligned");
+}
+
+uint32_t
+WirelessPointToPointLinkAssigner::GetNLinks (void) const
+{
+  return m_links.size ();
+}
+
+uint32_t
+WirelessPointToPointLinkAssigner::GetLastSolveSize (void) const
+{
+  return m_matching.GetLastSolveSize ();
+}
+
+} // namespace ns3
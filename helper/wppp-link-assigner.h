@@ -0,0 +1,97 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 University of North Carolina at Chapel Hill
+ * Author: Ben Newton
+ */
+#ifndef WPPP_LINK_ASSIGNER_H
+#define WPPP_LINK_ASSIGNER_H
+
+#include <map>
+#include <vector>
+
+#include "ns3/ptr.h"
+#include "ns3/node-container.h"
+#include "ns3/wireless-point-to-point-net-device.h"
+#include "ns3/wppp-link-matching.h"
+
+namespace ns3 {
+
+/**
+ * \brief Choose which visible neighbors the directional devices point at
+ *
+ * Every node is given as many terminals as it has
+ * WirelessPointToPointNetDevices.  Candidate links between nodes are given a
+ * weight (for example range or expected capacity) and Apply computes a
+ * degree-constrained matching of the candidates with WpppLinkMatching, then
+ * Connects and Disconnects devices so the alignment follows the matching.
+ *
+ * Candidates can be changed between calls to Apply; only the links touched
+ * by the changes, and the nodes around them, are revisited.  Devices
+ * connected by other means are not known to the assigner and should not be
+ * mixed with it on the same nodes.
+ */
+class WirelessPointToPointLinkAssigner
+{
+public:
+  WirelessPointToPointLinkAssigner ();
+
+  /**
+   * \param threads number of threads used to solve, 0 for one per processor
+   */
+  void SetThreads (uint32_t threads);
+
+  /**
+   * \brief Register nodes whose devices the assigner manages
+   * \param nodes nodes holding WirelessPointToPointNetDevices
+   */
+  void Install (NodeContainer nodes);
+
+  /**
+   * \brief Add or reweight a candidate link between two installed nodes
+   * \param a one end of the link
+   * \param b the other end of the link
+   * \param weight value of the link, larger is better
+   */
+  void SetCandidate (Ptr<Node> a, Ptr<Node> b, double weight);
+
+  /**
+   * \brief Remove a candidate link, e.g. when the nodes lose line of sight
+   * \param a one end of the link
+   * \param b the other end of the link
+   */
+  void RemoveCandidate (Ptr<Node> a, Ptr<Node> b);
+
+  /**
+   * \brief Solve and Connect/Disconnect devices to follow the new matching
+   */
+  void Apply (void);
+
+  /**
+   * \return number of links currently aligned by the assigner
+   */
+  uint32_t GetNLinks (void) const;
+
+  /**
+   * \return number of nodes visited by the last Apply
+   */
+  uint32_t GetLastSolveSize (void) const;
+
+private:
+  /**
+   * \return the solver index of an installed node
+   */
+  uint32_t GetIndex (Ptr<Node> node) const;
+
+  /// Aligned device pair of a matched link
+  typedef std::pair<Ptr<WirelessPointToPointNetDevice>, Ptr<WirelessPointToPointNetDevice> > DevicePair;
+
+  WpppLinkMatching m_matching;                    //!< Solver
+  std::vector<Ptr<Node> > m_nodes;                //!< Nodes by solver index
+  std::map<uint32_t, uint32_t> m_index;           //!< Node id -> solver index
+  std::vector<std::vector<Ptr<WirelessPointToPointNetDevice> > > m_freeDevices; //!< Unused terminals
+  std::map<uint64_t, DevicePair> m_links;         //!< Links aligned by the assigner
+};
+
+} // namespace ns3
+
+#endif /* WPPP_LINK_ASSIGNER_H */
@@ -0,0 +1,47 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 University of North Carolina at Chapel Hill
+ * Author: Ben Newton
+ */
+
+#include "ns3/log.h"
+#include "wppp-spf-routing-helper.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("WpppSpfRoutingHelper");
+
+WpppSpfRoutingHelper::WpppSpfRoutingHelper ()
+  : m_topology (CreateObject<WpppSpfTopology> ())
+{
+}
+
+WpppSpfRoutingHelper *
+WpppSpfRoutingHelper::Copy (void) const
+{
+  return new WpppSpfRoutingHelper (*this);
+}
+
+Ptr<Ipv4RoutingProtocol>
+WpppSpfRoutingHelper::Create (Ptr<Node> node) const
+{
+  NS_LOG_FUNCTION (this << node);
+  Ptr<WpppSpfRouting> routing = CreateObject<WpppSpfRouting> ();
+  routing->SetTopology (m_topology);
+  return routing;
+}
+
+void
+WpppSpfRoutingHelper::Monitor (Ptr<WirelessPointToPointChannel> channel)
+{
+  NS_LOG_FUNCTION (this << channel);
+  channel->SetSpfTopology (m_topology);
+}
+
+Ptr<WpppSpfTopology>
+WpppSpfRoutingHelper::GetTopology (void) const
+{
+  return m_topology;
+}
+
+} // namespace ns3
@@ -0,0 +1,52 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 University of North Carolina at Chapel Hill
+ * Author: Ben Newton
+ */
+#ifndef WPPP_SPF_ROUTING_HELPER_H
+#define WPPP_SPF_ROUTING_HELPER_H
+
+#include "ns3/ptr.h"
+#include "ns3/node.h"
+#include "ns3/ipv4-routing-helper.h"
+#include "ns3/wireless-point-to-point-channel.h"
+#include "ns3/wppp-spf-routing.h"
+
+namespace ns3 {
+
+/**
+ * \brief Install WpppSpfRouting on nodes
+ *
+ * Every protocol created by the helper, or by its copies, shares the
+ * helper's WpppSpfTopology.  Pass the helper to
+ * InternetStackHelper::SetRoutingHelper, alone or in an
+ * Ipv4ListRoutingHelper, and call Monitor for each channel whose links the
+ * nodes route over.
+ */
+class WpppSpfRoutingHelper : public Ipv4RoutingHelper
+{
+public:
+  WpppSpfRoutingHelper ();
+
+  // Inherited from Ipv4RoutingHelper
+  virtual WpppSpfRoutingHelper *Copy (void) const;
+  virtual Ptr<Ipv4RoutingProtocol> Create (Ptr<Node> node) const;
+
+  /**
+   * \brief Feed the alignments of a channel to the topology
+   * \param channel the channel
+   */
+  void Monitor (Ptr<WirelessPointToPointChannel> channel);
+
+  /**
+   * \return the topology shared by the protocols created
+   */
+  Ptr<WpppSpfTopology> GetTopology (void) const;
+
+private:
+  Ptr<WpppSpfTopology> m_topology;  //!< Links and addresses of every node
+};
+
+} // namespace ns3
+
+#endif /* WPPP_SPF_ROUTING_HELPER_H */
@@ -0,0 +1,272 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 University of North Carolina at Chapel Hill
+ * Author: Ben Newton
+ */
+
+#include <cstring>
+#include <vector>
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/pointer.h"
+#include "ns3/nstime.h"
+#include "ns3/queue.h"
+#include "ns3/node-list.h"
+#include "ns3/mobility-model.h"
+#include "ns3/propagation-delay-model.h"
+#include "ns3/wireless-point-to-point-net-device.h"
+#include "ns3/wppp-background-writer.h"
+#include "wppp-telemetry-sampler.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("WirelessPointToPointTelemetrySampler");
+
+namespace {
+
+const char WPPP_TELEMETRY_MAGIC[8] = { 'W', 'P', 'P', 'P', 'T', 'S', '1', '\n' };
+const uint32_t WPPP_TELEMETRY_NAME_SIZE = 16;
+
+const char *const WPPP_TELEMETRY_DEVICE_COLUMNS[] = {
+  "node", "ifIndex", "txPackets", "txBytes", "rxPackets", "rxBytes",
+  "drops", "busyTime", "queuePackets", "queueBytes"
+};
+const char *const WPPP_TELEMETRY_LINK_COLUMNS[] = {
+  "srcNode", "srcIfIndex", "dstNode", "dstIfIndex", "alignedSince",
+  "txPackets", "txBytes", "busyTime", "delay"
+};
+const uint32_t WPPP_TELEMETRY_N_DEVICE_COLUMNS =
+  sizeof (WPPP_TELEMETRY_DEVICE_COLUMNS) / sizeof (WPPP_TELEMETRY_DEVICE_COLUMNS[0]);
+const uint32_t WPPP_TELEMETRY_N_LINK_COLUMNS =
+  sizeof (WPPP_TELEMETRY_LINK_COLUMNS) / sizeof (WPPP_TELEMETRY_LINK_COLUMNS[0]);
+
+void
+PutU32 (uint8_t *buf, uint32_t v)
+{
+  buf[0] = v & 0xff;
+  buf[1] = (v >> 8) & 0xff;
+  buf[2] = (v >> 16) & 0xff;
+  buf[3] = (v >> 24) & 0xff;
+}
+
+void
+PutU64 (uint8_t *buf, uint64_t v)
+{
+  PutU32 (buf, v & 0xffffffff);
+  PutU32 (buf + 4, v >> 32);
+}
+
+} // anonymous namespace
+
+/**
+ * \brief Samples one channel and hands the blocks to a background writer
+ */
+class WpppTelemetryRecorder : public SimpleRefCount<WpppTelemetryRecorder>
+{
+public:
+  WpppTelemetryRecorder (Ptr<WirelessPointToPointChannel> channel,
+                         Ptr<WpppBackgroundWriter> writer);
+
+  /**
+   * \brief Take one sample and schedule the next one, or close the file
+   * \param stop time after which no more samples are taken
+   * \param interval time between samples
+   */
+  void Sample (Time stop, Time interval);
+
+  /**
+   * \brief Flush the file
+   */
+  void Close (void);
+
+private:
+  /**
+   * \return the propagation delay in ns from node src to node dst
+   */
+  int64_t GetDelay (uint32_t src, uint32_t dst);
+
+  Ptr<WirelessPointToPointChannel> m_channel;     //!< Sampled channel
+  Ptr<WpppBackgroundWriter> m_writer;             //!< Writer of the file
+  Ptr<PropagationDelayModel> m_delayModel;        //!< Delay model of the channel
+  int64_t m_fixedDelay;                           //!< Delay of every pair without a model, in ns
+  std::vector<Ptr<MobilityModel> > m_mobility;    //!< Mobility models by node id
+  std::vector<WpppDeviceStats> m_devices;         //!< Device snapshot
+  std::vector<WpppLinkStats> m_links;             //!< Link snapshot
+  std::vector<uint8_t> m_block;                   //!< Block being built
+};
+
+WpppTelemetryRecorder::WpppTelemetryRecorder (Ptr<WirelessPointToPointChannel> channel,
+                                              Ptr<WpppBackgroundWriter> writer)
+  : m_channel (channel),
+    m_writer (writer)
+{
+  PointerValue delayModel;
+  channel->GetAttribute ("PropagationDelayModel", delayModel);
+  m_delayModel = delayModel.Get<PropagationDelayModel> ();
+  TimeValue delay;
+  channel->GetAttribute ("Delay", delay);
+  m_fixedDelay = delay.Get ().GetNanoSeconds ();
+
+  std::vector<uint8_t> header (16 + WPPP_TELEMETRY_NAME_SIZE *
+                               (WPPP_TELEMETRY_N_DEVICE_COLUMNS + WPPP_TELEMETRY_N_LINK_COLUMNS), 0);
+  std::memcpy (&header[0], WPPP_TELEMETRY_MAGIC, sizeof (WPPP_TELEMETRY_MAGIC));
+  PutU32 (&header[8], WPPP_TELEMETRY_N_DEVICE_COLUMNS);
+  PutU32 (&header[12], WPPP_TELEMETRY_N_LINK_COLUMNS);
+  uint8_t *name = &header[16];
+  for (uint32_t i = 0; i < WPPP_TELEMETRY_N_DEVICE_COLUMNS; i++, name += WPPP_TELEMETRY_NAME_SIZE)
+    {
+      std::strncpy (reinterpret_cast<char *> (name), WPPP_TELEMETRY_DEVICE_COLUMNS[i],
+                    WPPP_TELEMETRY_NAME_SIZE - 1);
+    }
+  for (uint32_t i = 0; i < WPPP_TELEMETRY_N_LINK_COLUMNS; i++, name += WPPP_TELEMETRY_NAME_SIZE)
+    {
+      std::strncpy (reinterpret_cast<char *> (name), WPPP_TELEMETRY_LINK_COLUMNS[i],
+                    WPPP_TELEMETRY_NAME_SIZE - 1);
+    }
+  m_writer->Write (header);
+}
+
+int64_t
+WpppTelemetryRecorder::GetDelay (uint32_t src, uint32_t dst)
+{
+  if (m_delayModel == 0)
+    {
+      return m_fixedDelay;
+    }
+  uint32_t ids[2] = { src, dst };
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      if (ids[i] >= m_mobility.size ())
+        {
+          m_mobility.resize (NodeList::GetNNodes ());
+        }
+      if (m_mobility[ids[i]] == 0)
+        {
+          m_mobility[ids[i]] = NodeList::GetNode (ids[i])->GetObject<MobilityModel> ();
+        }
+    }
+  return m_delayModel->GetDelay (m_mobility[src], m_mobility[dst]).GetNanoSeconds ();
+}
+
+void
+WpppTelemetryRecorder::Sample (Time stop, Time interval)
+{
+  NS_LOG_FUNCTION (this);
+  m_channel->GetDeviceStats (m_devices);
+  m_channel->GetLinkStats (m_links);
+  uint32_t nDevices = m_devices.size ();
+  uint32_t nLinks = m_links.size ();
+
+  uint64_t size = 24 + 8 * (uint64_t (nDevices) * WPPP_TELEMETRY_N_DEVICE_COLUMNS +
+                            uint64_t (nLinks) * WPPP_TELEMETRY_N_LINK_COLUMNS);
+  m_block.resize (size);
+  uint8_t *p = &m_block[0];
+  PutU64 (p, size);
+  PutU64 (p + 8, Simulator::Now ().GetNanoSeconds ());
+  PutU32 (p + 16, nDevices);
+  PutU32 (p + 20, nLinks);
+  p += 24;
+
+  //column by column, so each column is contiguous in the file
+  uint8_t *column[WPPP_TELEMETRY_N_DEVICE_COLUMNS];
+  for (uint32_t c = 0; c < WPPP_TELEMETRY_N_DEVICE_COLUMNS; c++, p += 8 * nDevices)
+    {
+      column[c] = p;
+    }
+  for (uint32_t i = 0; i < nDevices; i++)
+    {
+      Ptr<WirelessPointToPointNetDevice> dev = m_channel->GetWirelessPointToPointDevice (i);
+      const WpppDeviceStats &s = m_devices[i];
+      uint64_t drops = 0;
+      for (uint32_t r = 0; r < WpppDeviceStats::DROP_REASONS; r++)
+        {
+          drops += s.drops[r];
+        }
+      Ptr<Queue> queue = dev->GetQueue ();
+      uint64_t values[WPPP_TELEMETRY_N_DEVICE_COLUMNS] = {
+        dev->GetNode ()->GetId (), dev->GetIfIndex (), s.txPackets, s.txBytes,
+        s.rxPackets, s.rxBytes, drops, uint64_t (s.busyTime),
+        queue ? queue->GetNPackets () : 0, queue ? queue->GetNBytes () : 0
+      };
+      for (uint32_t c = 0; c < WPPP_TELEMETRY_N_DEVICE_COLUMNS; c++)
+        {
+          PutU64 (column[c] + 8 * i, values[c]);
+        }
+    }
+
+  uint8_t *linkColumn[WPPP_TELEMETRY_N_LINK_COLUMNS];
+  for (uint32_t c = 0; c < WPPP_TELEMETRY_N_LINK_COLUMNS; c++, p += 8 * nLinks)
+    {
+      linkColumn[c] = p;
+    }
+  for (uint32_t i = 0; i < nLinks; i++)
+    {
+      const WpppLinkStats &s = m_links[i];
+      uint64_t values[WPPP_TELEMETRY_N_LINK_COLUMNS] = {
+        s.srcNode, s.srcIfIndex, s.dstNode, s.dstIfIndex, uint64_t (s.alignedSince),
+        s.txPackets, s.txBytes, uint64_t (s.busyTime),
+        uint64_t (GetDelay (s.srcNode, s.dstNode))
+      };
+      for (uint32_t c = 0; c < WPPP_TELEMETRY_N_LINK_COLUMNS; c++)
+        {
+          PutU64 (linkColumn[c] + 8 * i, values[c]);
+        }
+    }
+
+  m_writer->Write (m_block);
+
+  if (Simulator::Now () + interval <= stop)
+    {
+      Simulator::Schedule (interval, &WpppTelemetryRecorder::Sample, Ptr<WpppTelemetryRecorder> (this),
+                           stop, interval);
+    }
+  else
+    {
+      Close ();
+    }
+}
+
+void
+WpppTelemetryRecorder::Close (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_writer->Close ();
+}
+
+WirelessPointToPointTelemetrySampler::WirelessPointToPointTelemetrySampler ()
+  : m_interval (Seconds (1))
+{
+}
+
+WirelessPointToPointTelemetrySampler::~WirelessPointToPointTelemetrySampler ()
+{
+}
+
+void
+WirelessPointToPointTelemetrySampler::SetInterval (Time interval)
+{
+  NS_ASSERT_MSG (interval.IsStrictlyPositive (), "The sampling interval must be positive");
+  m_interval = interval;
+}
+
+bool
+WirelessPointToPointTelemetrySampler::Install (Ptr<WirelessPointToPointChannel> channel,
+                                               std::string filename, Time start, Time stop)
+{
+  NS_LOG_FUNCTION (this << channel << filename << start << stop);
+  Ptr<WpppBackgroundWriter> writer = Create<WpppBackgroundWriter> ();
+  if (!writer->Open (filename))
+    {
+      NS_LOG_ERROR ("cannot create " << filename);
+      return false;
+    }
+  Ptr<WpppTelemetryRecorder> recorder = Create<WpppTelemetryRecorder> (channel, writer);
+  m_recorders.push_back (recorder);
+  Simulator::Schedule (start - Simulator::Now (), &WpppTelemetryRecorder::Sample, recorder,
+                       stop, m_interval);
+  //a simulation stopped before 'stop' still gets a complete file
+  Simulator::ScheduleDestroy (&WpppTelemetryRecorder::Close, recorder);
+  return true;
+}
+
+} // namespace ns3
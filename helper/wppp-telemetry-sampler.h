@@ -0,0 +1,84 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 University of North Carolina at Chapel Hill
+ * Author: Ben Newton
+ */
+#ifndef WPPP_TELEMETRY_SAMPLER_H
+#define WPPP_TELEMETRY_SAMPLER_H
+
+#include <string>
+#include <vector>
+
+#include "ns3/ptr.h"
+#include "ns3/nstime.h"
+#include "ns3/wireless-point-to-point-channel.h"
+
+namespace ns3 {
+
+class WpppTelemetryRecorder;
+
+/**
+ * \brief Periodically record the counters of a channel to a binary file
+ *
+ * Every interval the WpppDeviceStats of each device on the channel, the
+ * current depth of its queue, and the WpppLinkStats and propagation delay of
+ * each aligned direction are appended to a columnar file.  The file is
+ * written by a background thread, so sampling only costs copying the
+ * counters.
+ *
+ * All values are little endian and every column starts on an eight byte
+ * boundary, so the file can be mapped and read in place.  The file starts
+ * with the eight byte magic "WPPPTS1\n", the number of device columns and of
+ * link columns (uint32 each), then the name of every device column followed
+ * by the name of every link column, each NUL padded to 16 bytes.  Each
+ * sample follows as a block:
+ *
+ *   uint64 size of the block in bytes, this field included
+ *   int64  simulation time in ns
+ *   uint32 number of devices D, uint32 number of links L
+ *   one column of D 64 bit values per device column, in header order
+ *   one column of L 64 bit values per link column, in header order
+ *
+ * Counters are cumulative; utilization over an interval is the difference
+ * of busyTime between two samples divided by the interval.
+ *
+ * \code
+ *   WirelessPointToPointTelemetrySampler sampler;
+ *   sampler.SetInterval (Seconds (10));
+ *   sampler.Install (channel, "telemetry.bin", Seconds (0), Seconds (86400));
+ * \endcode
+ */
+class WirelessPointToPointTelemetrySampler
+{
+public:
+  /**
+   * Create a sampler with an interval of one second
+   */
+  WirelessPointToPointTelemetrySampler ();
+  ~WirelessPointToPointTelemetrySampler ();
+
+  /**
+   * \param interval simulation time between samples
+   */
+  void SetInterval (Time interval);
+
+  /**
+   * \brief Schedule the sampling of a channel
+   *
+   * \param channel channel whose devices and aligned pairs are sampled
+   * \param filename file to create
+   * \param start time of the first sample
+   * \param stop time after which no more samples are taken
+   * \return false if the file could not be created
+   */
+  bool Install (Ptr<WirelessPointToPointChannel> channel, std::string filename,
+                Time start, Time stop);
+
+private:
+  Time m_interval;                                       //!< Time between samples
+  std::vector<Ptr<WpppTelemetryRecorder> > m_recorders;  //!< Installed recorders
+};
+
+} // namespace ns3
+
+#endif /* WPPP_TELEMETRY_SAMPLER_H */
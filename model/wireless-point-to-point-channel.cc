@@ -6,13 +6,17 @@
 
 #include "wireless-point-to-point-channel.h"
 #include "wireless-point-to-point-net-device.h"
+#include "wppp-profiler.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/packet.h"
 #include "ns3/simulator.h"
 #include "ns3/log.h"
+#include "ns3/double.h"
+#include "ns3/boolean.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 
-#include "ns3/ipv4.h"
-#include "ns3/ipv4-routing-protocol.h"
 #include "ns3/mobility-model.h"
 
 #include "ns3/mpi-module.h"
@@ -31,7 +35,8 @@ WirelessPointToPointChannel::GetTypeId (void)
     .SetGroupName ("WirelessPointToPoint")
     .AddConstructor<WirelessPointToPointChannel> ()
     .AddAttribute ("PropagationDelayModel", "A pointer to the propagation delay"
-                   " model attached to this channel.",
+                   " model attached to this channel; without one every pair"
+                   " is Delay apart.",
                    PointerValue (),
                    MakePointerAccessor (&WirelessPointToPointChannel::m_delayModel),
                    MakePointerChecker<PropagationDelayModel> ())
@@ -39,6 +44,54 @@ WirelessPointToPointChannel::GetTypeId (void)
                    TimeValue (Seconds (0)),
                    MakeTimeAccessor (&WirelessPointToPointChannel::m_delay),
                    MakeTimeChecker ())
+    .AddAttribute ("Ipv4Notifications",
+                   "Whether the IPv4 routing protocol of a node is told when "
+                   "its interfaces on this channel go up and down.  Turn off "
+                   "for nodes without IPv4, to skip the lookups.",
+                   BooleanValue (true),
+                   MakeBooleanAccessor (&WirelessPointToPointChannel::m_ipv4Notifications),
+                   MakeBooleanChecker ())
+    .AddAttribute ("HoldDown",
+                   "Time an interface change must hold before the routing "
+                   "protocol is told of it; a change back within it cancels "
+                   "both.  0 passes changes on at once.",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&WirelessPointToPointChannel::m_holdDown),
+                   MakeTimeChecker ())
+    .AddAttribute ("DampingHalfLife",
+                   "Half-life of the flap penalty of an interface.  0 never "
+                   "suppresses an interface.",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&WirelessPointToPointChannel::m_halfLife),
+                   MakeTimeChecker ())
+    .AddAttribute ("DampingSuppress",
+                   "Flap penalty at which the changes of an interface are held; "
+                   "each down change adds one.",
+                   DoubleValue (3.0),
+                   MakeDoubleAccessor (&WirelessPointToPointChannel::m_suppressThreshold),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("DampingReuse",
+                   "Flap penalty a suppressed interface must decay to before "
+                   "its changes are passed on again.",
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&WirelessPointToPointChannel::m_reuseThreshold),
+                   MakeDoubleChecker<double> (0))
+    .AddTraceSource ("LinkHalfOpen",
+                     "A device connected to a node that is not connected back: "
+                     "nodeA and devA point at nodeB, devB is 0",
+                     MakeTraceSourceAccessor (&WirelessPointToPointChannel::m_linkHalfOpenTrace),
+                     "ns3::WirelessPointToPointChannel::LinkEventCallback")
+    .AddTraceSource ("LinkAligned",
+                     "Two devices are connected to each other and aligned: "
+                     "devA of nodeA just connected, devB of nodeB was waiting",
+                     MakeTraceSourceAccessor (&WirelessPointToPointChannel::m_linkAlignedTrace),
+                     "ns3::WirelessPointToPointChannel::LinkEventCallback")
+    .AddTraceSource ("LinkBroken",
+                     "A device disconnected from a node: devA of nodeA no "
+                     "longer points at nodeB.  devB is the device it was "
+                     "aligned with, now half open, or 0 if it was not aligned",
+                     MakeTraceSourceAccessor (&WirelessPointToPointChannel::m_linkBrokenTrace),
+                     "ns3::WirelessPointToPointChannel::LinkEventCallback")
     /*.AddTraceSource ("TxRxWirelessPointToPoint",
                      "Trace source indicating transmission of packet "
                      "from the WirelessPointToPointChannel, used by the Animation "
@@ -54,11 +107,28 @@ WirelessPointToPointChannel::GetTypeId (void)
 // has an "infitely" fast transmission speed and zero delay.
 WirelessPointToPointChannel::WirelessPointToPointChannel()
   :
-    Channel ()
+    Channel (),
+    m_topologyVersion (0),
+    m_ipv4Listener (CreateObject<WpppIpv4AlignmentListener> ())
 {
   NS_LOG_FUNCTION_NOARGS ();
 }
 
+void
+WirelessPointToPointChannel::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  for (std::map<Ptr<NetDevice>, Damping>::iterator i = m_damping.begin (); i != m_damping.end (); ++i)
+    {
+      Simulator::Cancel (i->second.release);
+    }
+  m_damping.clear ();
+  m_adjacency.clear ();
+  m_alignmentListeners.clear ();
+  m_ipv4Listener = 0;
+  Channel::DoDispose ();
+}
+
 void
 WirelessPointToPointChannel::Attach (Ptr<WirelessPointToPointNetDevice> device)
 {
@@ -74,16 +144,23 @@ WirelessPointToPointChannel::TransmitStart (
   Ptr<WirelessPointToPointNetDevice> src,
   Time txTime)
 {
+  WPPP_PROFILE_SCOPE (CHANNEL_TRANSMIT_START);
   NS_LOG_FUNCTION (this <<" ifIndex=" << src->GetIfIndex()+1 << "src=" << src );
   NS_LOG_LOGIC ("UID is " << p->GetUid () << ")");
 
-  if(m_alignmentMap.find(src) != m_alignmentMap.end())
+  std::map<Ptr<WirelessPointToPointNetDevice>, Alignment>::iterator alignment = m_alignmentMap.find (src);
+  if(alignment != m_alignmentMap.end())
     {
       //get device currently aligned with 
-      Ptr<WirelessPointToPointNetDevice> dst = m_alignmentMap[src]; 
+      Ptr<WirelessPointToPointNetDevice> dst = alignment->second.peer; 
+      WpppLinkStats &stats = alignment->second.stats;
+      stats.txPackets++;
+      stats.txBytes += p->GetSize ();
+      stats.busyTime += txTime.GetNanoSeconds ();
       Ptr<MobilityModel> srcMob = src->GetNode()->GetObject<MobilityModel> ();
       Ptr<MobilityModel> dstMob = dst->GetNode()->GetObject<MobilityModel> ();
-      Time delay = m_delayModel->GetDelay (srcMob, dstMob);
+      //without a delay model every pair is the Delay attribute apart
+      Time delay = m_delayModel != 0 ? m_delayModel->GetDelay (srcMob, dstMob) : m_delay;
            
       uint32_t dstNode = dst->GetObject<NetDevice>()->GetNode()->GetId();
       uint32_t n1SystemId = 0;
@@ -173,6 +250,7 @@ WirelessPointToPointChannel::Connect(Ptr<Node> localNode,
                                      Ptr<WirelessPointToPointNetDevice> dev, 
                                      Ptr<Node> remoteNode) 
 {
+  WPPP_PROFILE_SCOPE (CHANNEL_CONNECT);
   NS_LOG_FUNCTION(this << localNode << dev << remoteNode);
   //this is where the simulation seconds could be displayed!!!
   //std::cout << Simulator::Now ().GetSeconds() << std::endl;
@@ -189,22 +267,23 @@ WirelessPointToPointChannel::Connect(Ptr<Node> localNode,
       if(i->first.first == remoteNode && i->second == localNode)
         {
           //other side of connection already exists, add to alignment map
-          m_alignmentMap[i->first.second] = dev;
-          m_alignmentMap[dev] = i->first.second;
+          Align (i->first.second, dev);
+          Align (dev, i->first.second);
+          AddAdjacency (dev, i->first.second);
+          if (m_spfTopology != 0)
+            {
+              m_spfTopology->LinkUp (dev, i->first.second);
+            }
 
           //update neighbors for pyvis
           //dev->GetObject<Neighbor>()->SetDevice((Ptr<NetDevice>)i->first.second);
           //i->first.second->GetObject<Neighbor>()->SetDevice((Ptr<NetDevice>)dev);
           //could do something to display half connected?? todo
-          localNode->GetObject<Ipv4>()->GetRoutingProtocol()->
-            NotifyInterfaceUp(localNode->GetObject<Ipv4>()->
-                              GetInterfaceForDevice(dev));
+          NotifyInterface (dev, true);
 
           //can we just use RemoteNode below instead? 
           Ptr<Node> remNode = i->first.second->GetNode();
-          remNode->GetObject<Ipv4>()->GetRoutingProtocol()->
-            NotifyInterfaceUp(remNode->GetObject<Ipv4>()->
-                              GetInterfaceForDevice(i->first.second));
+          NotifyInterface (i->first.second, true);
 
           //above is not realistic, and will need to be re-implemented!!!!! 
           //todo ??   
@@ -212,11 +291,14 @@ WirelessPointToPointChannel::Connect(Ptr<Node> localNode,
           
           //remove the one way connection
           m_oneWayConnectionMap.erase(std::make_pair(remNode, i->first.second));
+          m_linkAlignedTrace (localNode->GetId (), dev, remoteNode->GetId (), i->first.second,
+                              Simulator::Now ());
           return;
         }
     }
   //if not found this is a one way connection currently
   m_oneWayConnectionMap[std::make_pair(localNode, dev)] = remoteNode;
+  m_linkHalfOpenTrace (localNode->GetId (), dev, remoteNode->GetId (), 0, Simulator::Now ());
 }
 
 void 
@@ -224,9 +306,14 @@ WirelessPointToPointChannel::Disconnect(Ptr<Node> localNode,
                                         Ptr<WirelessPointToPointNetDevice> dev,
                                         Ptr<Node> remoteNode)
 {
+  WPPP_PROFILE_SCOPE (CHANNEL_DISCONNECT);
   //std::cout << "Disconnect " << localNode->GetId() << remoteNode->GetId() 
   //<< std::endl;
-  m_connectionMap.erase(std::make_pair(localNode, dev));
+  if (m_connectionMap.erase (std::make_pair (localNode, dev)) == 0)
+    {
+      //never connected, or already disconnected: no link to break
+      return;
+    }
   
   //see if the other side is still in connection map
   typedef std::map<std::pair<Ptr<Node>, Ptr<WirelessPointToPointNetDevice> >, 
@@ -238,27 +325,368 @@ WirelessPointToPointChannel::Disconnect(Ptr<Node> localNode,
           //if other side of connection still exists, notify down.  
           m_alignmentMap.erase(dev);
           m_alignmentMap.erase(i->first.second);
+          RemoveAdjacency (dev);
+          RemoveAdjacency (i->first.second);
+          if (m_spfTopology != 0)
+            {
+              m_spfTopology->LinkDown (dev, i->first.second);
+            }
           //update neighbors for PyVis
           //dev->GetObject<Neighbor>()->SetDevice(NULL);
           //i->first.second->GetObject<Neighbor>()->SetDevice(NULL);
-          localNode->GetObject<Ipv4>()->GetRoutingProtocol()->
-            NotifyInterfaceDown(localNode->GetObject<Ipv4>()->
-                                GetInterfaceForDevice(dev));
+          NotifyInterface (dev, false);
           //can we just use remoteNode below? todo
           Ptr<Node> remNode = i->first.second->GetNode(); 
-          remNode->GetObject<Ipv4>()->GetRoutingProtocol()->
-            NotifyInterfaceDown(remNode->GetObject<Ipv4>()->
-                                GetInterfaceForDevice(i->first.second));
+          NotifyInterface (i->first.second, false);
           //above is not realistic, and will need to be re-implemented!!!!! 
           //todo ?? 
           
           m_oneWayConnectionMap[std::make_pair(remNode, i->first.second)] = 
             localNode;
+          m_linkBrokenTrace (localNode->GetId (), dev, remoteNode->GetId (), i->first.second,
+                             Simulator::Now ());
+          m_linkHalfOpenTrace (remNode->GetId (), i->first.second, localNode->GetId (), 0,
+                               Simulator::Now ());
           return;
         }
     }
   //if not found this is a one way connection currently, so erase.  
   m_oneWayConnectionMap.erase(std::make_pair(localNode, dev)); 
+  m_linkBrokenTrace (localNode->GetId (), dev, remoteNode->GetId (), 0, Simulator::Now ());
+}
+
+void
+WirelessPointToPointChannel::Align (Ptr<WirelessPointToPointNetDevice> src,
+                                    Ptr<WirelessPointToPointNetDevice> dst)
+{
+  Alignment &alignment = m_alignmentMap[src];
+  alignment.peer = dst;
+  std::memset (&alignment.stats, 0, sizeof (alignment.stats));
+  alignment.stats.srcNode = src->GetNode ()->GetId ();
+  alignment.stats.srcIfIndex = src->GetIfIndex ();
+  alignment.stats.dstNode = dst->GetNode ()->GetId ();
+  alignment.stats.dstIfIndex = dst->GetIfIndex ();
+  alignment.stats.alignedSince = Simulator::Now ().GetNanoSeconds ();
+}
+
+void
+WirelessPointToPointChannel::AddAdjacency (Ptr<WirelessPointToPointNetDevice> a,
+                                           Ptr<WirelessPointToPointNetDevice> b)
+{
+  Ptr<WirelessPointToPointNetDevice> ends[2] = { a, b };
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      Ptr<WirelessPointToPointNetDevice> old = RemoveAdjacency (ends[i]);
+      if (old != 0 && old != ends[1 - i])
+        {
+          RemoveAdjacency (old);
+        }
+    }
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      uint32_t node = ends[i]->GetNode ()->GetId ();
+      if (node >= m_adjacency.size ())
+        {
+          m_adjacency.resize (node + 1);
+        }
+      Adjacency adjacency;
+      adjacency.device = ends[i];
+      adjacency.peer = ends[1 - i];
+      adjacency.peerNode = ends[1 - i]->GetNode ()->GetId ();
+      m_adjacency[node].push_back (adjacency);
+    }
+  m_topologyVersion++;
+}
+
+Ptr<WirelessPointToPointNetDevice>
+WirelessPointToPointChannel::RemoveAdjacency (Ptr<WirelessPointToPointNetDevice> device)
+{
+  uint32_t node = device->GetNode ()->GetId ();
+  if (node >= m_adjacency.size ())
+    {
+      return 0;
+    }
+  std::vector<Adjacency> &neighbors = m_adjacency[node];
+  for (uint32_t i = 0; i < neighbors.size (); i++)
+    {
+      if (neighbors[i].device == device)
+        {
+          Ptr<WirelessPointToPointNetDevice> peer = neighbors[i].peer;
+          neighbors[i] = neighbors.back ();
+          neighbors.pop_back ();
+          m_topologyVersion++;
+          return peer;
+        }
+    }
+  return 0;
+}
+
+const std::vector<WirelessPointToPointChannel::Adjacency> &
+WirelessPointToPointChannel::GetNeighbors (uint32_t node) const
+{
+  static const std::vector<Adjacency> none;
+  return node < m_adjacency.size () ? m_adjacency[node] : none;
+}
+
+void
+WirelessPointToPointChannel::GetAdjacencySnapshot (std::vector<uint32_t> &offsets,
+                                                   std::vector<uint32_t> &neighbors) const
+{
+  offsets.resize (m_adjacency.size () + 1);
+  neighbors.clear ();
+  for (uint32_t node = 0; node < m_adjacency.size (); node++)
+    {
+      offsets[node] = neighbors.size ();
+      for (uint32_t i = 0; i < m_adjacency[node].size (); i++)
+        {
+          neighbors.push_back (m_adjacency[node][i].peerNode);
+        }
+    }
+  offsets[m_adjacency.size ()] = neighbors.size ();
+}
+
+uint64_t
+WirelessPointToPointChannel::GetTopologyVersion (void) const
+{
+  return m_topologyVersion;
+}
+
+void
+WirelessPointToPointChannel::NotifyInterface (Ptr<WirelessPointToPointNetDevice> dev, bool up)
+{
+  if (dev->NotifyBeamAlignment (up))
+    {
+      //the owner of the beam notifies the listeners of its interface
+      return;
+    }
+  NotifyAlignment (dev, up);
+}
+
+void
+WirelessPointToPointChannel::DeliverNotification (Ptr<NetDevice> device, bool up)
+{
+  if (m_ipv4Notifications)
+    {
+      m_ipv4Listener->NotifyAlignment (device, up);
+    }
+  for (uint32_t i = 0; i < m_alignmentListeners.size (); i++)
+    {
+      m_alignmentListeners[i]->NotifyAlignment (device, up);
+    }
+}
+
+void
+WirelessPointToPointChannel::AddAlignmentListener (Ptr<WpppAlignmentListener> listener)
+{
+  NS_LOG_FUNCTION (this << listener);
+  m_alignmentListeners.push_back (listener);
+}
+
+void
+WirelessPointToPointChannel::RemoveAlignmentListener (Ptr<WpppAlignmentListener> listener)
+{
+  NS_LOG_FUNCTION (this << listener);
+  m_alignmentListeners.erase (std::remove (m_alignmentListeners.begin (), m_alignmentListeners.end (), listener),
+                              m_alignmentListeners.end ());
+}
+
+void
+WirelessPointToPointChannel::NotifyAlignment (Ptr<NetDevice> device, bool up)
+{
+  NS_LOG_FUNCTION (this << device << up);
+  if (m_holdDown.IsZero () && m_halfLife.IsZero ())
+    {
+      m_dampingStats.changes++;
+      m_dampingStats.notified++;
+      DeliverNotification (device, up);
+      return;
+    }
+
+  Damping &damping = m_damping[device];
+  if (up == damping.current)
+    {
+      return;
+    }
+  m_dampingStats.changes++;
+  if (damping.current != damping.reported)
+    {
+      //back to the state routing knows, neither change is passed on
+      m_dampingStats.suppressed += 2;
+    }
+  damping.current = up;
+
+  if (!m_halfLife.IsZero ())
+    {
+      damping.penalty = GetPenalty (damping);
+      damping.penaltyTime = Simulator::Now ().GetNanoSeconds ();
+      if (damping.suppressed && damping.penalty <= m_reuseThreshold)
+        {
+          damping.suppressed = false;
+        }
+      if (!up)
+        {
+          damping.penalty += 1;
+          if (!damping.suppressed && damping.penalty >= m_suppressThreshold)
+            {
+              NS_LOG_LOGIC ("Suppressing " << device << " with penalty " << damping.penalty);
+              damping.suppressed = true;
+              m_dampingStats.suppressions++;
+            }
+        }
+    }
+
+  Simulator::Cancel (damping.release);
+  if (damping.current == damping.reported)
+    {
+      return;
+    }
+  int64_t delay = m_holdDown.GetNanoSeconds ();
+  if (damping.suppressed)
+    {
+      delay = std::max (delay, GetReuseDelay (damping));
+    }
+  damping.release = Simulator::Schedule (NanoSeconds (delay),
+                                         &WirelessPointToPointChannel::ReleaseNotification,
+                                         this, device);
+}
+
+void
+WirelessPointToPointChannel::ReleaseNotification (Ptr<NetDevice> device)
+{
+  NS_LOG_FUNCTION (this << device);
+  Damping &damping = m_damping[device];
+  if (damping.suppressed)
+    {
+      int64_t delay = GetReuseDelay (damping);
+      if (delay > 0)
+        {
+          damping.release = Simulator::Schedule (NanoSeconds (delay),
+                                                 &WirelessPointToPointChannel::ReleaseNotification,
+                                                 this, device);
+          return;
+        }
+      NS_LOG_LOGIC ("Releasing " << device);
+      damping.suppressed = false;
+    }
+  if (damping.current != damping.reported)
+    {
+      damping.reported = damping.current;
+      m_dampingStats.notified++;
+      DeliverNotification (device, damping.current);
+    }
+}
+
+double
+WirelessPointToPointChannel::GetPenalty (const Damping &damping) const
+{
+  if (damping.penalty == 0)
+    {
+      return 0;
+    }
+  double halfLives = double (Simulator::Now ().GetNanoSeconds () - damping.penaltyTime) /
+    m_halfLife.GetNanoSeconds ();
+  return damping.penalty * std::pow (0.5, halfLives);
+}
+
+int64_t
+WirelessPointToPointChannel::GetReuseDelay (const Damping &damping) const
+{
+  double penalty = GetPenalty (damping);
+  if (penalty <= m_reuseThreshold || m_reuseThreshold <= 0)
+    {
+      return 0;
+    }
+  return int64_t (std::ceil (std::log (penalty / m_reuseThreshold) / std::log (2.0) *
+                             m_halfLife.GetNanoSeconds ()));
+}
+
+const WpppDampingStats &
+WirelessPointToPointChannel::GetDampingStats (void) const
+{
+  return m_dampingStats;
+}
+
+bool
+WirelessPointToPointChannel::IsSuppressed (Ptr<NetDevice> device) const
+{
+  std::map<Ptr<NetDevice>, Damping>::const_iterator i = m_damping.find (device);
+  return i != m_damping.end () && i->second.suppressed && GetReuseDelay (i->second) > 0;
+}
+
+Ptr<WirelessPointToPointNetDevice>
+WirelessPointToPointChannel::GetAlignedPeer (Ptr<WirelessPointToPointNetDevice> device) const
+{
+  std::map<Ptr<WirelessPointToPointNetDevice>, Alignment>::const_iterator i = m_alignmentMap.find (device);
+  if (i == m_alignmentMap.end ())
+    {
+      return 0;
+    }
+  return i->second.peer;
+}
+
+void
+WirelessPointToPointChannel::SetSpfTopology (Ptr<WpppSpfTopology> topology)
+{
+  NS_LOG_FUNCTION (this << topology);
+  m_spfTopology = topology;
+}
+
+void
+WirelessPointToPointChannel::AddMemoryUsage (WpppMemoryUsage &usage) const
+{
+  usage.channels++;
+  usage.channelObjects += sizeof (*this);
+  usage.channelMaps += m_deviceList.capacity () * sizeof (Ptr<WirelessPointToPointNetDevice>);
+  usage.channelMaps += m_alignmentMap.size () *
+    (WpppMemoryUsage::TREE_NODE_OVERHEAD + sizeof (std::pair<Ptr<WirelessPointToPointNetDevice>, Alignment>));
+  uint64_t connectionEntry = WpppMemoryUsage::TREE_NODE_OVERHEAD +
+    sizeof (std::pair<std::pair<Ptr<Node>, Ptr<WirelessPointToPointNetDevice> >, Ptr<Node> >);
+  usage.channelMaps += (m_connectionMap.size () + m_oneWayConnectionMap.size ()) * connectionEntry;
+  usage.channelMaps += m_adjacency.capacity () * sizeof (std::vector<Adjacency>);
+  for (uint32_t i = 0; i < m_adjacency.size (); i++)
+    {
+      usage.channelMaps += m_adjacency[i].capacity () * sizeof (Adjacency);
+    }
+  usage.channelMaps += m_damping.size () *
+    (WpppMemoryUsage::TREE_NODE_OVERHEAD + sizeof (std::pair<Ptr<NetDevice>, Damping>));
+  if (m_delayModel != 0)
+    {
+      //a subclass may hold anything, so only the exact type is counted
+      if (m_delayModel->GetInstanceTypeId () == ConstantSpeedPropagationDelayModel::GetTypeId ())
+        {
+          usage.delayState += sizeof (ConstantSpeedPropagationDelayModel);
+        }
+      else
+        {
+          usage.uncountedDelayModels++;
+        }
+    }
+  for (std::vector<Ptr<WirelessPointToPointNetDevice> >::const_iterator i = m_deviceList.begin (); i != m_deviceList.end (); ++i)
+    {
+      (*i)->AddMemoryUsage (usage);
+    }
+}
+
+void
+WirelessPointToPointChannel::GetDeviceStats (std::vector<WpppDeviceStats> &stats) const
+{
+  stats.resize (m_deviceList.size ());
+  for (uint32_t i = 0; i < m_deviceList.size (); i++)
+    {
+      stats[i] = m_deviceList[i]->GetStats ();
+    }
+}
+
+void
+WirelessPointToPointChannel::GetLinkStats (std::vector<WpppLinkStats> &stats) const
+{
+  stats.clear ();
+  stats.reserve (m_alignmentMap.size ());
+  for (std::map<Ptr<WirelessPointToPointNetDevice>, Alignment>::const_iterator i = m_alignmentMap.begin ();
+       i != m_alignmentMap.end (); ++i)
+    {
+      stats.push_back (i->second.stats);
+    }
 }
 
   //This is actually the minimum delay of any wp2p connection.  
@@ -14,11 +14,16 @@
 #include "ns3/nstime.h"
 #include "ns3/data-rate.h"
 #include "ns3/traced-callback.h"
+#include "ns3/event-id.h"
 
 #include "ns3/pointer.h"
 #include <map>
 #include "ns3/propagation-delay-model.h" 
 #include "ns3/node.h"
+#include "wppp-stats.h"
+#include "wppp-memory-usage.h"
+#include "wppp-spf-routing.h"
+#include "wppp-alignment-listener.h"
 
 namespace ns3 {
 
@@ -96,7 +101,131 @@ public:
   void Connect(Ptr<Node> localNode, Ptr<WirelessPointToPointNetDevice> dev, Ptr<Node> remoteNode);
   void Disconnect(Ptr<Node> localNode, Ptr<WirelessPointToPointNetDevice> dev, Ptr<Node> remoteNode);
   bool IsOneWayConnection(long unsigned int nodeId1, long unsigned int nodeId2);
+
+  /**
+   * \brief Get the device a device is aligned with
+   * \param device a device attached to this channel
+   * \returns the aligned device, or 0 if device is not aligned
+   */
+  Ptr<WirelessPointToPointNetDevice> GetAlignedPeer (Ptr<WirelessPointToPointNetDevice> device) const;
+
+  /**
+   * A device of a node aligned with a device of another node
+   */
+  struct Adjacency
+  {
+    Ptr<WirelessPointToPointNetDevice> device; //!< Device of the node
+    Ptr<WirelessPointToPointNetDevice> peer;   //!< Device it is aligned with
+    uint32_t peerNode;                         //!< Node id of peer
+  };
+
+  /**
+   * \brief Get the current neighbors of a node, in no particular order
+   *
+   * The list is kept as devices are aligned and broken, so this costs
+   * nothing; a node aligned twice with the same neighbor lists it twice.
+   *
+   * \param node a node id
+   * \returns one entry per aligned device of the node
+   */
+  const std::vector<Adjacency> &GetNeighbors (uint32_t node) const;
+
+  /**
+   * \brief Take a snapshot of the aligned graph in compressed sparse rows
+   *
+   * The neighbors of node n are neighbors[offsets[n]] to
+   * neighbors[offsets[n + 1] - 1]; nodes from offsets.size () - 1 on have
+   * none.  Costs time proportional to the number of aligned pairs.
+   *
+   * \param offsets filled with the start of the neighbors of each node, and
+   *        the end of the last
+   * \param neighbors filled with the node ids of the neighbors
+   */
+  void GetAdjacencySnapshot (std::vector<uint32_t> &offsets, std::vector<uint32_t> &neighbors) const;
+
+  /**
+   * \return a counter bumped on every change to the neighbors of any node,
+   *         to tell whether state derived from them is stale
+   */
+  uint64_t GetTopologyVersion (void) const;
+
+  /**
+   * \brief Keep a WpppSpfRouting topology up to date with the alignments
+   *
+   * The topology is told of every pair of devices aligned or broken from
+   * then on, before the alignment listeners are notified.
+   *
+   * \param topology the topology, or 0 to stop
+   */
+  void SetSpfTopology (Ptr<WpppSpfTopology> topology);
+
+  /**
+   * \brief Tell the alignment listeners that the interface of a device
+   * went up or down, subject to damping
+   *
+   * With the HoldDown attribute set, a change is passed on once it has
+   * held for that long; a change back within it cancels both.  With
+   * DampingHalfLife set, every down change adds one to a penalty of the
+   * interface that halves every half-life; once the penalty reaches
+   * DampingSuppress the interface is suppressed and its changes are held
+   * until the penalty decays to DampingReuse.  Alignments, and so the
+   * forwarding of frames, are not damped.
+   *
+   * \param device the device of the interface
+   * \param up true if the interface went up
+   */
+  void NotifyAlignment (Ptr<NetDevice> device, bool up);
+
+  /**
+   * \brief Notify a listener of every interface of this channel going up
+   * or down
+   *
+   * The IPv4 routing protocols are notified apart from these, as long as
+   * the Ipv4Notifications attribute is true.
+   *
+   * \param listener the listener
+   */
+  void AddAlignmentListener (Ptr<WpppAlignmentListener> listener);
+
+  /**
+   * \brief Stop notifying a listener added by AddAlignmentListener
+   * \param listener the listener
+   */
+  void RemoveAlignmentListener (Ptr<WpppAlignmentListener> listener);
+
+  /**
+   * \return the counters of the interface notifications damped so far
+   */
+  const WpppDampingStats &GetDampingStats (void) const;
+
+  /**
+   * \param device the device of an interface
+   * \return true if the changes of the interface are held for flapping
+   */
+  bool IsSuppressed (Ptr<NetDevice> device) const;
+
+  /**
+   * \brief Add the estimated memory held by this channel and its devices
+   * \param usage the totals to add to
+   */
+  void AddMemoryUsage (WpppMemoryUsage &usage) const;
+
+  /**
+   * \brief Take a snapshot of the counters of every attached device
+   * \param stats filled with the counters of device i at index i, in the
+   *        order of GetWirelessPointToPointDevice
+   */
+  void GetDeviceStats (std::vector<WpppDeviceStats> &stats) const;
+
+  /**
+   * \brief Take a snapshot of the counters of every aligned pair
+   * \param stats filled with one entry per direction of each aligned pair
+   */
+  void GetLinkStats (std::vector<WpppLinkStats> &stats) const;
+
 protected:
+  virtual void DoDispose (void);
+
   /**
    * \brief Get the delay associated with this channel
    * \returns Time delay
@@ -124,13 +253,102 @@ protected:
     (Ptr<const Packet> packet,
      Ptr<NetDevice> txDevice, Ptr<NetDevice> rxDevice,
      Time duration, Time lastBitTime);
+
+  /**
+   * TracedCallback signature for link events.
+   *
+   * \param [in] nodeA Node id of the device that connected or disconnected.
+   * \param [in] devA That device.
+   * \param [in] nodeB Node id of the node it points at.
+   * \param [in] devB The device of nodeB pointing back, or 0 if there is none.
+   * \param [in] time The time of the event.
+   */
+  typedef void (* LinkEventCallback)
+    (uint32_t nodeA, Ptr<NetDevice> devA, uint32_t nodeB, Ptr<NetDevice> devB, Time time);
     
   //for now assume only two interfaces can be alligned.  May need to do different later to consider interference  todo ??
   Ptr<PropagationDelayModel> m_delayModel;
-  std::map<Ptr<WirelessPointToPointNetDevice>, Ptr<WirelessPointToPointNetDevice> > m_alignmentMap; 
+
+  /**
+   * The device a device is aligned with and the counters of that direction
+   */
+  struct Alignment
+  {
+    Ptr<WirelessPointToPointNetDevice> peer; //!< Aligned device
+    WpppLinkStats stats;                     //!< Counters from the device to peer
+  };
+  std::map<Ptr<WirelessPointToPointNetDevice>, Alignment> m_alignmentMap; 
                     
 private:
 
+  /**
+   * \brief Record that src now transmits to dst
+   */
+  void Align (Ptr<WirelessPointToPointNetDevice> src, Ptr<WirelessPointToPointNetDevice> dst);
+
+  /**
+   * \brief Record that two devices are neighbors, unlinking any previous
+   * neighbor of either
+   */
+  void AddAdjacency (Ptr<WirelessPointToPointNetDevice> a, Ptr<WirelessPointToPointNetDevice> b);
+
+  /**
+   * \brief Remove a device from the neighbors of its node
+   * \returns the neighbor it had, or 0
+   */
+  Ptr<WirelessPointToPointNetDevice> RemoveAdjacency (Ptr<WirelessPointToPointNetDevice> device);
+
+  /**
+   * \brief Tell the alignment listeners that a device gained or lost its
+   * peer, through the owner of the device if it is a beam
+   */
+  void NotifyInterface (Ptr<WirelessPointToPointNetDevice> dev, bool up);
+
+  /**
+   * Interface state as seen by routing, and the flap penalty of the
+   * interface
+   */
+  struct Damping
+  {
+    Damping ()
+      : reported (false),
+        current (false),
+        suppressed (false),
+        penalty (0),
+        penaltyTime (0)
+    {
+    }
+
+    bool reported;       //!< State last passed on to routing
+    bool current;        //!< State to pass on
+    bool suppressed;     //!< Held until the penalty decays
+    double penalty;      //!< Flap penalty as of penaltyTime
+    int64_t penaltyTime; //!< Time of the last update of the penalty, in nanoseconds
+    EventId release;     //!< Pending ReleaseNotification
+  };
+
+  /**
+   * \return the penalty of an interface decayed to now
+   */
+  double GetPenalty (const Damping &damping) const;
+
+  /**
+   * \return the nanoseconds until the penalty of an interface decays to
+   *          DampingReuse, or 0
+   */
+  int64_t GetReuseDelay (const Damping &damping) const;
+
+  /**
+   * \brief Pass the held change of an interface on to routing, or hold it
+   * longer if the interface is still suppressed
+   */
+  void ReleaseNotification (Ptr<NetDevice> device);
+
+  /**
+   * \brief Pass the change of an interface on to the listeners
+   */
+  void DeliverNotification (Ptr<NetDevice> device, bool up);
+
   /**
    * The trace source for the packet transmission animation events that the 
    * device can fire.
@@ -149,12 +367,35 @@ private:
                  Time                   // Last bit receive time (relative to now)
                  > m_txrxWirelessPointToPoint;*/
 
+  /// A device points at a node that does not point back
+  TracedCallback<uint32_t, Ptr<NetDevice>, uint32_t, Ptr<NetDevice>, Time> m_linkHalfOpenTrace;
+  /// Two devices point at each other and are aligned
+  TracedCallback<uint32_t, Ptr<NetDevice>, uint32_t, Ptr<NetDevice>, Time> m_linkAlignedTrace;
+  /// A device stopped pointing at a node
+  TracedCallback<uint32_t, Ptr<NetDevice>, uint32_t, Ptr<NetDevice>, Time> m_linkBrokenTrace;
+
   std::vector<Ptr<WirelessPointToPointNetDevice> > m_deviceList;
 
   std::map<std::pair<Ptr<Node>, Ptr<WirelessPointToPointNetDevice> >, Ptr<Node> > m_connectionMap; //for tracking  //overcomes potential issues with alignment processing when using distributed alg.  
   std::map<std::pair<Ptr<Node>, Ptr<WirelessPointToPointNetDevice> >, Ptr<Node> > m_oneWayConnectionMap; 
 
   Time          m_delay;    //!< Propagation delay  
+
+  Ptr<WpppSpfTopology> m_spfTopology;  //!< Topology fed with the alignments, or 0
+
+  std::vector<std::vector<Adjacency> > m_adjacency; //!< Neighbors of each node id
+  uint64_t m_topologyVersion;                      //!< Changes to m_adjacency so far
+
+  Time m_holdDown;                            //!< Time a change must hold before routing hears of it
+  Time m_halfLife;                            //!< Half-life of the flap penalty, 0 for no suppression
+  double m_suppressThreshold;                 //!< Penalty at which an interface is suppressed
+  double m_reuseThreshold;                    //!< Penalty at which a suppressed interface is released
+  std::map<Ptr<NetDevice>, Damping> m_damping; //!< Damping state of each interface notified
+  WpppDampingStats m_dampingStats;            //!< Counters of the damped notifications
+
+  bool m_ipv4Notifications;                   //!< Whether m_ipv4Listener is notified
+  Ptr<WpppIpv4AlignmentListener> m_ipv4Listener;                //!< Notifies IPv4 routing
+  std::vector<Ptr<WpppAlignmentListener> > m_alignmentListeners; //!< Listeners added
 };
 
 } // namespace ns3
@@ -4,8 +4,12 @@
  * Author: Ben Newton (Adapted from point-to-point-net-device.cc)
  */
 
+#include <algorithm>
+#include <cmath>
+#include "ns3/abort.h"
 #include "ns3/log.h"
 #include "ns3/queue.h"
+#include "ns3/drop-tail-queue.h"
 #include "ns3/simulator.h"
 #include "ns3/mac48-address.h"
 #include "ns3/llc-snap-header.h"
@@ -13,9 +17,15 @@
 #include "ns3/trace-source-accessor.h"
 #include "ns3/uinteger.h"
 #include "ns3/pointer.h"
+#include "ns3/boolean.h"
+#include "ns3/enum.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/tcp-header.h"
 #include "wireless-point-to-point-net-device.h"
 #include "wireless-point-to-point-channel.h"
 #include "wppp-header.h"
+#include "wppp-label-table.h"
+#include "wppp-profiler.h"
 
 namespace ns3 {
 
@@ -23,6 +33,173 @@ NS_LOG_COMPONENT_DEFINE ("WirelessPointToPointNetDevice");
 
 NS_OBJECT_ENSURE_REGISTERED (WirelessPointToPointNetDevice);
 
+/**
+ * \brief The trace sources of a WirelessPointToPointNetDevice that few
+ * simulations connect
+ *
+ * Allocated when the first sink is connected to any of them, which saves
+ * their storage in every device that is never traced this way.
+ */
+struct WpppRareTraces
+{
+  /// Packets dropped before being queued for transmission
+  TracedCallback<Ptr<const Packet> > macTxDrop;
+  /// Packets received and forwarded up, promiscuous
+  TracedCallback<Ptr<const Packet> > macPromiscRx;
+  /// Packets received but not forwarded up (not fired)
+  TracedCallback<Ptr<const Packet> > macRxDrop;
+  /// Start of a transmission
+  TracedCallback<Ptr<const Packet> > phyTxBegin;
+  /// End of a transmission
+  TracedCallback<Ptr<const Packet> > phyTxEnd;
+  /// Packets transmitted while not aligned
+  TracedCallback<Ptr<const Packet> > phyTxDrop;
+  /// Start of a reception (not fired)
+  TracedCallback<Ptr<const Packet> > phyRxBegin;
+  /// End of a reception
+  TracedCallback<Ptr<const Packet> > phyRxEnd;
+  /// Non-promiscuous sniffer
+  TracedCallback<Ptr<const Packet> > sniffer;
+  /// Time each transmitted frame spent in the queue
+  TracedCallback<Time> sojourn;
+};
+
+/**
+ * \brief The TCP segments a WirelessPointToPointNetDevice holds back to hand
+ * them up as one
+ *
+ * Allocated on the first segment received with RxCoalesceWindow set.
+ */
+struct WpppRxAggregate
+{
+  Ptr<Packet> payload;        //!< Payloads of the segments held, or 0
+  Ipv4Header ip;              //!< IPv4 header of the first segment
+  TcpHeader tcp;              //!< TCP header of the first segment, acknowledgment of the last
+  SequenceNumber32 next;      //!< Sequence number of the segment that may follow
+  Mac48Address from;          //!< Sender of the segments
+  EventId flush;              //!< Hands the segments up at the end of the window
+};
+
+/**
+ * \brief Queue item carrying the time its frame was queued
+ *
+ * The time travels with the frame, so sojourn times stay right whatever
+ * order the queue releases its frames in.
+ */
+class WpppQueueItem : public QueueItem
+{
+public:
+  /**
+   * \param p the frame
+   * \param enqueueTime when the frame is queued, in ns
+   */
+  WpppQueueItem (Ptr<Packet> p, int64_t enqueueTime)
+    : QueueItem (p),
+      m_enqueueTime (enqueueTime)
+  {
+  }
+
+  /**
+   * \returns when the frame was queued, in ns
+   */
+  int64_t GetEnqueueTime (void) const
+  {
+    return m_enqueueTime;
+  }
+
+private:
+  int64_t m_enqueueTime;  //!< When the frame was queued, in ns
+};
+
+/**
+ * \brief Accessor of a trace source in WpppRareTraces, allocating the
+ * rare trace sources of the device on the first connection
+ */
+template <typename T>
+class WpppRareTraceAccessor : public TraceSourceAccessor
+{
+public:
+  /**
+   * \param member the trace source
+   */
+  explicit WpppRareTraceAccessor (T WpppRareTraces::*member)
+    : m_member (member)
+  {
+  }
+
+  virtual bool ConnectWithoutContext (ObjectBase *obj, const CallbackBase &cb) const
+  {
+    T *trace = Get (obj, true);
+    if (trace == 0)
+      {
+        return false;
+      }
+    trace->ConnectWithoutContext (cb);
+    return true;
+  }
+
+  virtual bool Connect (ObjectBase *obj, std::string context, const CallbackBase &cb) const
+  {
+    T *trace = Get (obj, true);
+    if (trace == 0)
+      {
+        return false;
+      }
+    trace->Connect (cb, context);
+    return true;
+  }
+
+  virtual bool DisconnectWithoutContext (ObjectBase *obj, const CallbackBase &cb) const
+  {
+    T *trace = Get (obj, false);
+    if (trace != 0)
+      {
+        trace->DisconnectWithoutContext (cb);
+      }
+    return true;
+  }
+
+  virtual bool Disconnect (ObjectBase *obj, std::string context, const CallbackBase &cb) const
+  {
+    T *trace = Get (obj, false);
+    if (trace != 0)
+      {
+        trace->Disconnect (cb, context);
+      }
+    return true;
+  }
+
+private:
+  /**
+   * \param obj the device
+   * \param create allocate the rare trace sources if the device has none
+   * \return the trace source, or 0
+   */
+  T *Get (ObjectBase *obj, bool create) const
+  {
+    WirelessPointToPointNetDevice *device = dynamic_cast<WirelessPointToPointNetDevice *> (obj);
+    if (device == 0 || (!create && device->m_rareTraces == 0))
+      {
+        return 0;
+      }
+    return &(device->GetRareTraces ()->*m_member);
+  }
+
+  T WpppRareTraces::*m_member;  //!< The trace source
+};
+
+/**
+ * \brief Create the accessor of a rarely used trace source
+ * \param member the trace source
+ * \return the accessor
+ */
+template <typename T>
+static Ptr<const TraceSourceAccessor>
+MakeWpppRareTraceAccessor (T WpppRareTraces::*member)
+{
+  return Ptr<const TraceSourceAccessor> (new WpppRareTraceAccessor<T> (member), false);
+}
+
 TypeId 
 WirelessPointToPointNetDevice::GetTypeId (void)
 {
@@ -33,7 +210,16 @@ WirelessPointToPointNetDevice::GetTypeId (void)
     .AddAttribute ("Mtu", "The MAC-level Maximum Transmission Unit",
                    UintegerValue (DEFAULT_MTU),
                    MakeUintegerAccessor (&WirelessPointToPointNetDevice::SetMtu,
-                                         &WirelessPointToPointNetDevice::GetMtu),
+                                         &WirelessPointToPointNetDevice::GetFrameMtu),
+                   MakeUintegerChecker<uint16_t> ())
+    .AddAttribute ("LargeSendMtu",
+                   "MTU advertised to the stack, when larger than Mtu; packets "
+                   "up to this size are carried as one super-segment taking the "
+                   "airtime of the Mtu sized frames it stands for.  0 disables "
+                   "large send.  A queue in byte mode must hold at least this "
+                   "many bytes",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&WirelessPointToPointNetDevice::m_largeSendMtu),
                    MakeUintegerChecker<uint16_t> ())
     .AddAttribute ("Address", 
                    "The MAC address of this device.",
@@ -55,6 +241,50 @@ WirelessPointToPointNetDevice::GetTypeId (void)
                    TimeValue (Seconds (0.0)),
                    MakeTimeAccessor (&WirelessPointToPointNetDevice::m_tInterframeGap),
                    MakeTimeChecker ())
+    .AddAttribute ("LatencyStats",
+                   "Stamp sent frames so that the receiving device records "
+                   "their queueing, transmission and propagation latency",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&WirelessPointToPointNetDevice::m_latencyStats),
+                   MakeBooleanChecker ())
+    .AddAttribute ("Aqm",
+                   "Active queue management applied to the frames leaving the "
+                   "device queue",
+                   EnumValue (AQM_NONE),
+                   MakeEnumAccessor (&WirelessPointToPointNetDevice::m_aqm),
+                   MakeEnumChecker (AQM_NONE, "None",
+                                    AQM_CODEL, "CoDel"))
+    .AddAttribute ("CoDelTarget",
+                   "Standing queue delay CoDel tolerates; lower trades "
+                   "throughput for latency",
+                   TimeValue (MilliSeconds (5)),
+                   MakeTimeAccessor (&WirelessPointToPointNetDevice::m_codelTarget),
+                   MakeTimeChecker ())
+    .AddAttribute ("CoDelInterval",
+                   "Time the queue delay must stay above CoDelTarget before "
+                   "CoDel drops; should be about the round trip time of the "
+                   "flows over the link",
+                   TimeValue (MilliSeconds (100)),
+                   MakeTimeAccessor (&WirelessPointToPointNetDevice::m_codelInterval),
+                   MakeTimeChecker ())
+    .AddAttribute ("RxCoalesceWindow",
+                   "Time in-order TCP segments of one flow are held back, from "
+                   "the first, to be handed up as one packet; 0 hands every "
+                   "frame up on its own",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&WirelessPointToPointNetDevice::m_rxCoalesceWindow),
+                   MakeTimeChecker ())
+    .AddAttribute ("RxCoalesceMaxBytes",
+                   "Largest IPv4 packet coalesced segments are merged into",
+                   UintegerValue (65535),
+                   MakeUintegerAccessor (&WirelessPointToPointNetDevice::m_rxCoalesceMaxBytes),
+                   MakeUintegerChecker<uint16_t> ())
+    .AddAttribute ("SourceRouting",
+                   "Send on the source routed frames received with hops left "
+                   "instead of handing them up",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&WirelessPointToPointNetDevice::m_sourceRouting),
+                   MakeBooleanChecker ())
 
     //
     // Transmit queueing discipline for the device which includes its own set
@@ -78,14 +308,14 @@ WirelessPointToPointNetDevice::GetTypeId (void)
     .AddTraceSource ("MacTxDrop", 
                      "Trace source indicating a packet has been dropped "
                      "by the device before transmission",
-                     MakeTraceSourceAccessor (&WirelessPointToPointNetDevice::m_macTxDropTrace),
+                     MakeWpppRareTraceAccessor (&WpppRareTraces::macTxDrop),
                      "ns3::Packet::TracedCallback")
     .AddTraceSource ("MacPromiscRx", 
                      "A packet has been received by this device, "
                      "has been passed up from the physical layer "
                      "and is being forwarded up the local protocol stack.  "
                      "This is a promiscuous trace,",
-                     MakeTraceSourceAccessor (&WirelessPointToPointNetDevice::m_macPromiscRxTrace),
+                     MakeWpppRareTraceAccessor (&WpppRareTraces::macPromiscRx),
                      "ns3::Packet::TracedCallback")
     .AddTraceSource ("MacRx", 
                      "A packet has been received by this device, "
@@ -94,12 +324,17 @@ WirelessPointToPointNetDevice::GetTypeId (void)
                      "This is a non-promiscuous trace,",
                      MakeTraceSourceAccessor (&WirelessPointToPointNetDevice::m_macRxTrace),
                      "ns3::Packet::TracedCallback")
+    .AddTraceSource ("Sojourn",
+                     "Time a frame spent in the device queue, reported when "
+                     "its transmission starts",
+                     MakeWpppRareTraceAccessor (&WpppRareTraces::sojourn),
+                     "ns3::Time::TracedCallback")
 #if 0
     // Not currently implemented for this device
     .AddTraceSource ("MacRxDrop", 
                      "Trace source indicating a packet was dropped "
                      "before being forwarded up the stack",
-                     MakeTraceSourceAccessor (&WirelessPointToPointNetDevice::m_macRxDropTrace),
+                     MakeWpppRareTraceAccessor (&WpppRareTraces::macRxDrop),
                      "ns3::Packet::TracedCallback")
 #endif
     //
@@ -109,30 +344,30 @@ WirelessPointToPointNetDevice::GetTypeId (void)
     .AddTraceSource ("PhyTxBegin", 
                      "Trace source indicating a packet has begun "
                      "transmitting over the channel",
-                     MakeTraceSourceAccessor (&WirelessPointToPointNetDevice::m_phyTxBeginTrace),
+                     MakeWpppRareTraceAccessor (&WpppRareTraces::phyTxBegin),
                      "ns3::Packet::TracedCallback")
     .AddTraceSource ("PhyTxEnd", 
                      "Trace source indicating a packet has been "
                      "completely transmitted over the channel",
-                     MakeTraceSourceAccessor (&WirelessPointToPointNetDevice::m_phyTxEndTrace),
+                     MakeWpppRareTraceAccessor (&WpppRareTraces::phyTxEnd),
                      "ns3::Packet::TracedCallback")
     .AddTraceSource ("PhyTxDrop", 
                      "Trace source indicating a packet has been "
                      "dropped by the device during transmission",
-                     MakeTraceSourceAccessor (&WirelessPointToPointNetDevice::m_phyTxDropTrace),
+                     MakeWpppRareTraceAccessor (&WpppRareTraces::phyTxDrop),
                      "ns3::Packet::TracedCallback")
 #if 0
     // Not currently implemented for this device
     .AddTraceSource ("PhyRxBegin", 
                      "Trace source indicating a packet has begun "
                      "being received by the device",
-                     MakeTraceSourceAccessor (&WirelessPointToPointNetDevice::m_phyRxBeginTrace),
+                     MakeWpppRareTraceAccessor (&WpppRareTraces::phyRxBegin),
                      "ns3::Packet::TracedCallback")
 #endif
     .AddTraceSource ("PhyRxEnd", 
                      "Trace source indicating a packet has been "
                      "completely received by the device",
-                     MakeTraceSourceAccessor (&WirelessPointToPointNetDevice::m_phyRxEndTrace),
+                     MakeWpppRareTraceAccessor (&WpppRareTraces::phyRxEnd),
                      "ns3::Packet::TracedCallback")
     .AddTraceSource ("PhyRxDrop", 
                      "Trace source indicating a packet has been "
@@ -148,7 +383,7 @@ WirelessPointToPointNetDevice::GetTypeId (void)
     .AddTraceSource ("Sniffer", 
                     "Trace source simulating a non-promiscuous packet sniffer "
                      "attached to the device",
-                     MakeTraceSourceAccessor (&WirelessPointToPointNetDevice::m_snifferTrace),
+                     MakeWpppRareTraceAccessor (&WpppRareTraces::sniffer),
                      "ns3::Packet::TracedCallback")
     .AddTraceSource ("PromiscSniffer", 
                      "Trace source simulating a promiscuous packet sniffer "
@@ -164,8 +399,24 @@ WirelessPointToPointNetDevice::WirelessPointToPointNetDevice ()
   :
     m_txMachineState (READY),
     m_channel (0),
+    m_rareTraces (0),
+    m_txQueue (0),
     m_linkUp (false),
-    m_currentPkt (0)
+    m_beamOwner (0),
+    m_sourceRouting (false),
+    m_largeSendMtu (0),
+    m_rxAggregate (0),
+    m_rxCoalesceMaxBytes (65535),
+    m_currentPkt (0),
+    m_latencyStats (false),
+    m_txWindowEnd (-1),
+    m_txWindowLength (0),
+    m_aqm (AQM_NONE),
+    m_codelDropping (false),
+    m_codelFirstAbove (0),
+    m_codelDropNext (0),
+    m_codelCount (0),
+    m_codelLastCount (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -173,14 +424,29 @@ WirelessPointToPointNetDevice::WirelessPointToPointNetDevice ()
 WirelessPointToPointNetDevice::~WirelessPointToPointNetDevice ()
 {
   NS_LOG_FUNCTION (this);
+  delete m_rareTraces;
+  delete m_rxAggregate;
+}
+
+WpppRareTraces *
+WirelessPointToPointNetDevice::GetRareTraces (void)
+{
+  if (m_rareTraces == 0)
+    {
+      m_rareTraces = new WpppRareTraces;
+    }
+  return m_rareTraces;
 }
 
 void
-WirelessPointToPointNetDevice::AddHeader (Ptr<Packet> p, uint16_t protocolNumber)
+WirelessPointToPointNetDevice::AddHeader (Ptr<Packet> p, Mac48Address dest,
+                                          uint16_t protocolNumber)
 {
-  NS_LOG_FUNCTION (this << p << protocolNumber);
+  NS_LOG_FUNCTION (this << p << dest << protocolNumber);
   WpppHeader ppp;
   ppp.SetProtocol (EtherToPpp (protocolNumber));
+  ppp.SetAddr1 (dest);
+  ppp.SetAddr2 (m_address);
   p->AddHeader (ppp);
 }
 
@@ -192,7 +458,7 @@ WirelessPointToPointNetDevice::ProcessHeader (Ptr<Packet> p, uint16_t& param,
   NS_LOG_FUNCTION (this << p << param);
   WpppHeader ppp;
   p->RemoveHeader (ppp);
-  param = PppToEther (ppp.GetProtocol ());
+  param = PppToEther (ppp.GetPayloadProtocol ());
   to = ppp.GetAddr1();
   from = ppp.GetAddr2();
   return true;
@@ -225,6 +491,14 @@ WirelessPointToPointNetDevice::DoDispose ()
   m_currentPkt = 0;
   m_queue = 0;
   m_queueInterface = 0;
+  m_beamOwner = 0;
+  m_beamAlignmentCallback = MakeNullCallback<void, Ptr<WirelessPointToPointNetDevice>, bool> ();
+  m_labelTable = 0;
+  if (m_rxAggregate != 0)
+    {
+      m_rxAggregate->flush.Cancel ();
+      m_rxAggregate->payload = 0;
+    }
   NetDevice::DoDispose ();
 }
 
@@ -245,6 +519,7 @@ WirelessPointToPointNetDevice::SetInterframeGap (Time t)
 bool
 WirelessPointToPointNetDevice::TransmitStart (Ptr<Packet> p)
 {
+  WPPP_PROFILE_SCOPE (DEVICE_TRANSMIT_START);
   NS_LOG_FUNCTION (this << p);
   NS_LOG_LOGIC ("UID is " << p->GetUid () << ")");
 
@@ -256,18 +531,46 @@ WirelessPointToPointNetDevice::TransmitStart (Ptr<Packet> p)
   NS_ASSERT_MSG (m_txMachineState == READY, "Must be READY to transmit");
   m_txMachineState = BUSY;
   m_currentPkt = p;
-  m_phyTxBeginTrace (m_currentPkt);
+  if (m_rareTraces != 0)
+    {
+      m_rareTraces->phyTxBegin (m_currentPkt);
+    }
 
-  Time txTime = m_bps.CalculateBytesTxTime (p->GetSize ());
+  uint32_t frames;
+  Time txTime = GetTxTime (p, frames);
+  if (frames > 1)
+    {
+      m_stats.largeSendFrames += frames;
+    }
   Time txCompleteTime = txTime + m_tInterframeGap;
 
   NS_LOG_LOGIC ("Schedule TransmitCompleteEvent in " << txCompleteTime.GetSeconds () << "sec");
   Simulator::Schedule (txCompleteTime, &WirelessPointToPointNetDevice::TransmitComplete, this);
 
+  m_stats.busyTime += txTime.GetNanoSeconds ();
+  if (m_latencyStats)
+    {
+      WpppTimestampTag tag;
+      if (p->PeekPacketTag (tag))
+        {
+          tag.txStartTime = Simulator::Now ().GetNanoSeconds ();
+          tag.txTime = txTime.GetNanoSeconds ();
+          p->ReplacePacketTag (tag);
+        }
+    }
   bool result = m_channel->TransmitStart (p, this, txTime);
   if (result == false)
     {
-      m_phyTxDropTrace (p);
+      m_stats.drops[WpppDeviceStats::DROP_NOT_ALIGNED]++;
+      if (m_rareTraces != 0)
+        {
+          m_rareTraces->phyTxDrop (p);
+        }
+    }
+  else
+    {
+      m_stats.txPackets++;
+      m_stats.txBytes += p->GetSize ();
     }
   return result;
 }
@@ -275,6 +578,7 @@ WirelessPointToPointNetDevice::TransmitStart (Ptr<Packet> p)
 void
 WirelessPointToPointNetDevice::TransmitComplete (void)
 {
+  WPPP_PROFILE_SCOPE (DEVICE_TRANSMIT_COMPLETE);
   NS_LOG_FUNCTION (this);
 
   //
@@ -288,17 +592,33 @@ WirelessPointToPointNetDevice::TransmitComplete (void)
 
   NS_ASSERT_MSG (m_currentPkt != 0, "WirelessPointToPointNetDevice::TransmitComplete(): m_currentPkt zero");
 
-  m_phyTxEndTrace (m_currentPkt);
+  if (m_rareTraces != 0)
+    {
+      m_rareTraces->phyTxEnd (m_currentPkt);
+    }
   m_currentPkt = 0;
 
+  StartNextTransmission ();
+}
+
+void
+WirelessPointToPointNetDevice::StartNextTransmission (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (!CanStartTransmission ())
+    {
+      NS_LOG_LOGIC ("The next frame does not fit in the transmit window");
+      return;
+    }
+
   Ptr<NetDeviceQueue> txq;
   if (m_queueInterface)
   {
-    txq = m_queueInterface->GetTxQueue (0);
+    txq = m_queueInterface->GetTxQueue (m_txQueue);
   }
 
-  Ptr<QueueItem> item = m_queue->Dequeue ();
-  if (item == 0)
+  Ptr<Packet> p = DequeuePacket ();
+  if (p == 0)
     {
       NS_LOG_LOGIC ("No pending packets in device queue after tx complete");
       if (txq)
@@ -315,22 +635,25 @@ WirelessPointToPointNetDevice::TransmitComplete (void)
   // If the queue was stopped, start it again if there is room for another packet.
   // Note that we cannot wake the upper layers because otherwise a packet is sent
   // to the device while the machine state is busy, thus causing the assert in
-  // TransmitStart to fail.
+  // TransmitStart to fail.  Room is counted in GetMtu (), the largest
+  // packet that can be sent, a super-segment with large send.
   //
   if (txq && txq->IsStopped ())
     {
       if ((m_queue->GetMode () == Queue::QUEUE_MODE_PACKETS &&
            m_queue->GetNPackets () < m_queue->GetMaxPackets ()) ||
           (m_queue->GetMode () == Queue::QUEUE_MODE_BYTES &&
-           m_queue->GetNBytes () + m_mtu <= m_queue->GetMaxBytes ()))
+           m_queue->GetNBytes () + GetMtu () <= m_queue->GetMaxBytes ()))
         {
           NS_LOG_DEBUG ("The device queue is being started (" << m_queue->GetNPackets () <<
                         " packets and " << m_queue->GetNBytes () << " bytes inside)");
           txq->Start ();
         }
     }
-  Ptr<Packet> p = item->GetPacket ();
-  m_snifferTrace (p);
+  if (m_rareTraces != 0)
+    {
+      m_rareTraces->sniffer (p);
+    }
   m_promiscSnifferTrace (p);
   TransmitStart (p);
   if (txq)
@@ -340,6 +663,214 @@ WirelessPointToPointNetDevice::TransmitComplete (void)
     }
 }
 
+Time
+WirelessPointToPointNetDevice::GetTxTime (Ptr<const Packet> p, uint32_t &frames) const
+{
+  //
+  // A super-segment takes the airtime of the frames it stands for, each with
+  // its own header and all but the last followed by an interframe gap.
+  //
+  uint32_t size = p->GetSize ();
+  frames = 1;
+  if (m_largeSendMtu != 0 && size > m_mtu)
+    {
+      WpppHeader ppp;
+      uint32_t header = p->PeekHeader (ppp);
+      frames = (size - header + m_mtu - 1) / m_mtu;
+      size += (frames - 1) * header;
+    }
+  Time txTime = m_bps.CalculateBytesTxTime (size);
+  if (frames > 1)
+    {
+      txTime += TimeStep (m_tInterframeGap.GetTimeStep () * (frames - 1));
+    }
+  return txTime;
+}
+
+bool
+WirelessPointToPointNetDevice::CanStartTransmission (void)
+{
+  if (m_txWindowEnd < 0)
+    {
+      return true;
+    }
+  DropFramesLongerThanWindow ();
+  Ptr<const QueueItem> item = m_queue->Peek ();
+  if (item == 0)
+    {
+      return true;
+    }
+  //the device is busy until the interframe gap after the frame is over
+  uint32_t frames;
+  Time txTime = GetTxTime (item->GetPacket (), frames) + m_tInterframeGap;
+  return Simulator::Now ().GetNanoSeconds () + txTime.GetNanoSeconds () <= m_txWindowEnd;
+}
+
+void
+WirelessPointToPointNetDevice::DropFramesLongerThanWindow (void)
+{
+  if (m_txWindowLength <= 0)
+    {
+      return;
+    }
+  while (true)
+    {
+      Ptr<const QueueItem> item = m_queue->Peek ();
+      if (item == 0)
+        {
+          return;
+        }
+      uint32_t frames;
+      Time txTime = GetTxTime (item->GetPacket (), frames) + m_tInterframeGap;
+      if (txTime.GetNanoSeconds () <= m_txWindowLength)
+        {
+          return;
+        }
+      Ptr<Packet> p = m_queue->Dequeue ()->GetPacket ();
+      NS_LOG_LOGIC ("Dropping a frame of " << txTime.GetNanoSeconds () <<
+                    "ns, longer than a transmit window of " << m_txWindowLength << "ns");
+      m_stats.drops[WpppDeviceStats::DROP_TOO_LONG]++;
+      if (m_rareTraces != 0)
+        {
+          m_rareTraces->macTxDrop (p);
+        }
+      if (m_queueInterface)
+        {
+          // Inform BQL
+          m_queueInterface->GetTxQueue (m_txQueue)->NotifyTransmittedBytes (p->GetSize ());
+        }
+    }
+}
+
+void
+WirelessPointToPointNetDevice::SetTransmitWindow (Time end)
+{
+  NS_LOG_FUNCTION (this << end);
+  m_txWindowEnd = end.GetNanoSeconds ();
+  int64_t now = Simulator::Now ().GetNanoSeconds ();
+  if (m_txWindowEnd < 0)
+    {
+      m_txWindowLength = 0;
+    }
+  else if (m_txWindowEnd > now)
+    {
+      m_txWindowLength = m_txWindowEnd - now;
+    }
+  if (m_txMachineState == READY && m_queue != 0 && !m_queue->IsEmpty ())
+    {
+      StartNextTransmission ();
+    }
+}
+
+void
+WirelessPointToPointNetDevice::ClearTransmitWindow (void)
+{
+  NS_LOG_FUNCTION (this);
+  SetTransmitWindow (NanoSeconds (-1));
+}
+
+Ptr<Packet>
+WirelessPointToPointNetDevice::DequeuePacket (void)
+{
+  int64_t now = Simulator::Now ().GetNanoSeconds ();
+  while (true)
+    {
+      Ptr<QueueItem> item = m_queue->Dequeue ();
+      if (item == 0)
+        {
+          //an empty queue ends any standing queue, as in CoDel's dequeue
+          m_codelDropping = false;
+          m_codelFirstAbove = 0;
+          return 0;
+        }
+      //frames queued by someone else than Send carry no time
+      Ptr<WpppQueueItem> stamped = DynamicCast<WpppQueueItem> (item);
+      int64_t sojourn = stamped != 0 ? now - stamped->GetEnqueueTime () : 0;
+      Ptr<Packet> p = item->GetPacket ();
+
+      bool drop = false;
+      if (m_aqm == AQM_CODEL)
+        {
+          bool okToDrop = CoDelShouldDrop (sojourn, now);
+          if (m_codelDropping)
+            {
+              if (!okToDrop)
+                {
+                  m_codelDropping = false;
+                }
+              else if (now >= m_codelDropNext)
+                {
+                  drop = true;
+                  m_codelCount++;
+                  m_codelDropNext = CoDelControlLaw (m_codelDropNext);
+                }
+            }
+          else if (okToDrop)
+            {
+              //drop one frame and enter the dropping state, resuming the
+              //previous drop rate if it was left recently
+              drop = true;
+              m_codelDropping = true;
+              uint32_t delta = m_codelCount - m_codelLastCount;
+              if (delta > 1 && now - m_codelDropNext < 16 * m_codelInterval.GetNanoSeconds ())
+                {
+                  m_codelCount = delta;
+                }
+              else
+                {
+                  m_codelCount = 1;
+                }
+              m_codelDropNext = CoDelControlLaw (now);
+              m_codelLastCount = m_codelCount;
+            }
+        }
+
+      if (!drop)
+        {
+          m_sojourn.Record (sojourn);
+          if (m_rareTraces != 0)
+            {
+              m_rareTraces->sojourn (NanoSeconds (sojourn));
+            }
+          return p;
+        }
+
+      NS_LOG_LOGIC ("CoDel drops a frame after " << sojourn << "ns in the queue");
+      m_stats.drops[WpppDeviceStats::DROP_AQM]++;
+      if (m_rareTraces != 0)
+        {
+          m_rareTraces->macTxDrop (p);
+        }
+      if (m_queueInterface)
+        {
+          // Inform BQL
+          m_queueInterface->GetTxQueue (m_txQueue)->NotifyTransmittedBytes (p->GetSize ());
+        }
+    }
+}
+
+bool
+WirelessPointToPointNetDevice::CoDelShouldDrop (int64_t sojourn, int64_t now)
+{
+  if (sojourn < m_codelTarget.GetNanoSeconds () || m_queue->GetNBytes () <= m_mtu)
+    {
+      m_codelFirstAbove = 0;
+      return false;
+    }
+  if (m_codelFirstAbove == 0)
+    {
+      m_codelFirstAbove = now + m_codelInterval.GetNanoSeconds ();
+      return false;
+    }
+  return now >= m_codelFirstAbove;
+}
+
+int64_t
+WirelessPointToPointNetDevice::CoDelControlLaw (int64_t t) const
+{
+  return t + int64_t (m_codelInterval.GetNanoSeconds () / std::sqrt (double (m_codelCount)));
+}
+
 bool
 WirelessPointToPointNetDevice::Attach (Ptr<WirelessPointToPointChannel> ch)
 {
@@ -362,6 +893,8 @@ void
 WirelessPointToPointNetDevice::SetQueue (Ptr<Queue> q)
 {
   NS_LOG_FUNCTION (this << q);
+  NS_ABORT_MSG_IF (q->GetMode () == Queue::QUEUE_MODE_BYTES && q->GetMaxBytes () < GetMtu (),
+                   "The device queue must hold at least one packet of GetMtu () bytes");
   m_queue = q;
 }
 
@@ -375,6 +908,7 @@ WirelessPointToPointNetDevice::SetReceiveErrorModel (Ptr<ErrorModel> em)
 void
 WirelessPointToPointNetDevice::Receive (Ptr<Packet> packet)
 {
+  WPPP_PROFILE_SCOPE (DEVICE_RECEIVE);
   NS_LOG_FUNCTION (this << packet);
   uint16_t protocol = 0;
 
@@ -384,6 +918,7 @@ WirelessPointToPointNetDevice::Receive (Ptr<Packet> packet)
       // If we have an error model and it indicates that it is time to lose a
       // corrupted packet, don't forward this packet up, let it go.
       //
+      m_stats.drops[WpppDeviceStats::DROP_RX_ERROR]++;
       m_phyRxDropTrace (packet);
     }
   else 
@@ -393,9 +928,32 @@ WirelessPointToPointNetDevice::Receive (Ptr<Packet> packet)
       // device because it is so simple, but this is not usually the case in
       // more complicated devices.
       //
-      m_snifferTrace (packet);
+      m_stats.rxPackets++;
+      m_stats.rxBytes += packet->GetSize ();
+      //looking for the tag costs a walk of the tag list, so only
+      //devices keeping latency stats do it
+      if (m_latencyStats)
+        {
+          WpppTimestampTag tag;
+          if (packet->RemovePacketTag (tag))
+            {
+              RecordLatency (tag);
+            }
+        }
+      if (m_rareTraces != 0)
+        {
+          m_rareTraces->sniffer (packet);
+        }
       m_promiscSnifferTrace (packet);
-      m_phyRxEndTrace (packet);
+      if (m_rareTraces != 0)
+        {
+          m_rareTraces->phyRxEnd (packet);
+        }
+
+      if ((m_labelTable != 0 || m_sourceRouting) && ForwardFrame (packet))
+        {
+          return;
+        }
 
       //
       // Trace sinks will expect complete packets, not packets without some of the
@@ -413,17 +971,172 @@ WirelessPointToPointNetDevice::Receive (Ptr<Packet> packet)
       Mac48Address to;
       ProcessHeader (packet, protocol, from, to);
 
+      WPPP_PROFILE_SCOPE (DEVICE_RECEIVE_UP);
       if (!m_promiscCallback.IsNull ())
         {
-          m_macPromiscRxTrace (originalPacket);
+          if (m_rareTraces != 0)
+            {
+              m_rareTraces->macPromiscRx (originalPacket);
+            }
           m_promiscCallback (this, packet, protocol, from , GetAddress (), NetDevice::PACKET_HOST);
         }
 
       m_macRxTrace (originalPacket);
+      if (m_rxCoalesceWindow.IsStrictlyPositive () && protocol == 0x0800)
+        {
+          Coalesce (packet, from);
+          return;
+        }
       m_rxCallback (this, packet, protocol, from);
     }
 }
 
+void
+WirelessPointToPointNetDevice::Coalesce (Ptr<Packet> packet, Mac48Address from)
+{
+  if (m_rxAggregate == 0)
+    {
+      m_rxAggregate = new WpppRxAggregate;
+    }
+  WpppRxAggregate &agg = *m_rxAggregate;
+
+  //
+  // Only whole TCP segments carrying data with nothing but ACK set are
+  // merged, and only without checksums, which merging would invalidate.
+  // Anything else flushes the segments held so that the stack still sees
+  // the frames of the link in order.
+  //
+  Ptr<Packet> segment = packet->Copy ();
+  Ipv4Header ip;
+  TcpHeader tcp;
+  segment->RemoveHeader (ip);
+  bool mergeable = !Node::ChecksumEnabled () && ip.GetProtocol () == 6 &&
+    ip.IsLastFragment () && ip.GetFragmentOffset () == 0;
+  if (mergeable)
+    {
+      segment->RemoveHeader (tcp);
+      mergeable = tcp.GetFlags () == TcpHeader::ACK && segment->GetSize () > 0;
+    }
+  if (!mergeable)
+    {
+      FlushCoalesced ();
+      m_rxCallback (this, packet, 0x0800, from);
+      return;
+    }
+
+  if (agg.payload != 0 && from == agg.from &&
+      ip.GetSource () == agg.ip.GetSource () && ip.GetDestination () == agg.ip.GetDestination () &&
+      tcp.GetSourcePort () == agg.tcp.GetSourcePort () &&
+      tcp.GetDestinationPort () == agg.tcp.GetDestinationPort () &&
+      tcp.GetSequenceNumber () == agg.next &&
+      ip.GetSerializedSize () + agg.tcp.GetSerializedSize () + agg.payload->GetSize () +
+      segment->GetSize () <= m_rxCoalesceMaxBytes)
+    {
+      agg.payload->AddAtEnd (segment);
+      agg.next += segment->GetSize ();
+      agg.tcp.SetAckNumber (tcp.GetAckNumber ());
+      agg.tcp.SetWindowSize (tcp.GetWindowSize ());
+      m_stats.coalescedSegments++;
+      return;
+    }
+
+  FlushCoalesced ();
+  agg.payload = segment;
+  agg.ip = ip;
+  agg.tcp = tcp;
+  agg.next = tcp.GetSequenceNumber () + segment->GetSize ();
+  agg.from = from;
+  agg.flush = Simulator::Schedule (m_rxCoalesceWindow, &WirelessPointToPointNetDevice::FlushCoalesced, this);
+}
+
+void
+WirelessPointToPointNetDevice::FlushCoalesced (void)
+{
+  WpppRxAggregate &agg = *m_rxAggregate;
+  if (agg.payload == 0)
+    {
+      return;
+    }
+  agg.flush.Cancel ();
+  Ptr<Packet> packet = agg.payload;
+  agg.payload = 0;
+  agg.ip.SetPayloadSize (agg.tcp.GetSerializedSize () + packet->GetSize ());
+  packet->AddHeader (agg.tcp);
+  packet->AddHeader (agg.ip);
+  m_rxCallback (this, packet, 0x0800, agg.from);
+}
+
+bool
+WirelessPointToPointNetDevice::ForwardFrame (Ptr<Packet> packet)
+{
+  WpppHeader ppp;
+  packet->PeekHeader (ppp);
+  Ptr<WirelessPointToPointNetDevice> out;
+  if (ppp.IsLabeled () && m_labelTable != 0)
+    {
+      uint32_t label;
+      if (!m_labelTable->Lookup (ppp.GetLabel (), out, label))
+        {
+          NS_LOG_LOGIC ("No entry for label " << ppp.GetLabel ());
+          m_stats.drops[WpppDeviceStats::DROP_NO_ROUTE]++;
+          return true;
+        }
+      if (out == 0)
+        {
+          //end of the path, hand the frame up
+          return false;
+        }
+      if (ppp.GetLabelTtl () <= 1)
+        {
+          NS_LOG_LOGIC ("TTL of label " << ppp.GetLabel () << " expired");
+          m_stats.drops[WpppDeviceStats::DROP_NO_ROUTE]++;
+          return true;
+        }
+      packet->RemoveHeader (ppp);
+      ppp.SetLabel (label, ppp.GetLabelTtl () - 1, ppp.GetPayloadProtocol ());
+    }
+  else if (ppp.IsSourceRouted () && m_sourceRouting)
+    {
+      if (ppp.GetSourceRoute ().empty ())
+        {
+          return false;
+        }
+      packet->RemoveHeader (ppp);
+      uint8_t hop = ppp.PopHop ();
+      if (hop < m_node->GetNDevices ())
+        {
+          out = DynamicCast<WirelessPointToPointNetDevice> (m_node->GetDevice (hop));
+        }
+      if (out == 0)
+        {
+          NS_LOG_LOGIC ("No wppp device at hop " << uint32_t (hop));
+          m_stats.drops[WpppDeviceStats::DROP_NO_ROUTE]++;
+          return true;
+        }
+    }
+  else
+    {
+      return false;
+    }
+  ppp.SetAddr2 (out->m_address);
+  packet->AddHeader (ppp);
+  m_stats.forwardedPackets++;
+  if (!out->IsLinkUp ())
+    {
+      out->m_stats.drops[WpppDeviceStats::DROP_LINK_DOWN]++;
+      return true;
+    }
+  out->SendFrame (packet);
+  return true;
+}
+
+void
+WirelessPointToPointNetDevice::SetLabelTable (Ptr<WpppLabelTable> table)
+{
+  NS_LOG_FUNCTION (this << table);
+  m_labelTable = table;
+}
+
 Ptr<Queue>
 WirelessPointToPointNetDevice::GetQueue (void) const
 { 
@@ -431,6 +1144,144 @@ WirelessPointToPointNetDevice::GetQueue (void) const
   return m_queue;
 }
 
+const WpppDeviceStats &
+WirelessPointToPointNetDevice::GetStats (void) const
+{
+  return m_stats;
+}
+
+void
+WirelessPointToPointNetDevice::ResetStats (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_stats.Reset ();
+  m_sojourn.Reset ();
+}
+
+Ptr<WirelessPointToPointNetDevice>
+WirelessPointToPointNetDevice::GetAlignedPeer (void) const
+{
+  if (m_channel == 0)
+    {
+      return 0;
+    }
+  return m_channel->GetAlignedPeer (const_cast<WirelessPointToPointNetDevice *> (this));
+}
+
+void
+WirelessPointToPointNetDevice::SetBeamOwner (Ptr<NetDevice> owner,
+                                             Callback<void, Ptr<WirelessPointToPointNetDevice>, bool> alignmentChanged)
+{
+  NS_LOG_FUNCTION (this << owner);
+  m_beamOwner = PeekPointer (owner);
+  m_beamAlignmentCallback = alignmentChanged;
+}
+
+void
+WirelessPointToPointNetDevice::SetQueueInterface (Ptr<NetDeviceQueueInterface> queueInterface,
+                                                  uint8_t txQueue)
+{
+  NS_LOG_FUNCTION (this << queueInterface << uint32_t (txQueue));
+  m_queueInterface = queueInterface;
+  m_txQueue = txQueue;
+}
+
+Ptr<NetDevice>
+WirelessPointToPointNetDevice::GetBeamOwner (void) const
+{
+  return m_beamOwner;
+}
+
+bool
+WirelessPointToPointNetDevice::NotifyBeamAlignment (bool aligned)
+{
+  NS_LOG_FUNCTION (this << aligned);
+  if (m_beamOwner == 0)
+    {
+      return false;
+    }
+  m_beamAlignmentCallback (this, aligned);
+  return true;
+}
+
+void
+WirelessPointToPointNetDevice::GetLatencyStats (std::vector<WpppLinkLatency> &links) const
+{
+  links.clear ();
+  links.reserve (m_latency.size ());
+  for (std::map<uint64_t, WpppLinkLatency>::const_iterator i = m_latency.begin (); i != m_latency.end (); ++i)
+    {
+      links.push_back (i->second);
+    }
+}
+
+void
+WirelessPointToPointNetDevice::ResetLatencyStats (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_latency.clear ();
+}
+
+const WpppLatencyHistogram &
+WirelessPointToPointNetDevice::GetSojournStats (void) const
+{
+  return m_sojourn;
+}
+
+void
+WirelessPointToPointNetDevice::AddMemoryUsage (WpppMemoryUsage &usage) const
+{
+  usage.devices++;
+  usage.deviceObjects += sizeof (*this);
+  if (m_rareTraces != 0)
+    {
+      usage.traceSources += sizeof (WpppRareTraces);
+    }
+  if (m_queue != 0)
+    {
+      if (m_queue->GetInstanceTypeId () == DropTailQueue::GetTypeId ())
+        {
+          usage.queues += sizeof (DropTailQueue);
+        }
+      else
+        {
+          usage.uncountedQueues++;
+        }
+      usage.queuedPackets += m_queue->GetNBytes () +
+        uint64_t (m_queue->GetNPackets ()) * WpppMemoryUsage::PACKET_OVERHEAD;
+    }
+  usage.latencyStats += m_sojourn.GetMemoryUsage ();
+  for (std::map<uint64_t, WpppLinkLatency>::const_iterator i = m_latency.begin (); i != m_latency.end (); ++i)
+    {
+      usage.latencyStats += WpppMemoryUsage::TREE_NODE_OVERHEAD + sizeof (*i) +
+        i->second.queueing.GetMemoryUsage () + i->second.transmission.GetMemoryUsage () +
+        i->second.propagation.GetMemoryUsage () + i->second.total.GetMemoryUsage ();
+    }
+  if (GetObject<MpiReceiver> () != 0)
+    {
+      usage.mpiReceivers += sizeof (MpiReceiver);
+    }
+}
+
+void
+WirelessPointToPointNetDevice::RecordLatency (const WpppTimestampTag &tag)
+{
+  uint64_t key = (uint64_t (tag.srcNode) << 32) | tag.srcIfIndex;
+  std::map<uint64_t, WpppLinkLatency>::iterator i = m_latency.find (key);
+  if (i == m_latency.end ())
+    {
+      WpppLinkLatency link;
+      link.srcNode = tag.srcNode;
+      link.srcIfIndex = tag.srcIfIndex;
+      i = m_latency.insert (std::make_pair (key, link)).first;
+    }
+  int64_t now = Simulator::Now ().GetNanoSeconds ();
+  i->second.queueing.Record (tag.txStartTime - tag.enqueueTime);
+  i->second.transmission.Record (tag.txTime);
+  i->second.propagation.Record (now - tag.txStartTime - tag.txTime);
+  i->second.total.Record (now - tag.enqueueTime);
+}
+
 void
 WirelessPointToPointNetDevice::NotifyLinkUp (void)
 {
@@ -555,10 +1406,11 @@ WirelessPointToPointNetDevice::Send (
   const Address &dest, 
   uint16_t protocolNumber)
 {
+  WPPP_PROFILE_SCOPE (DEVICE_SEND);
   Ptr<NetDeviceQueue> txq;
   if (m_queueInterface)
   {
-    txq = m_queueInterface->GetTxQueue (0);
+    txq = m_queueInterface->GetTxQueue (m_txQueue);
   }
 
   NS_ASSERT_MSG (!txq || !txq->IsStopped (), "Send should not be called when the device is stopped");
@@ -573,7 +1425,11 @@ WirelessPointToPointNetDevice::Send (
   //
   if (IsLinkUp () == false)
     {
-      m_macTxDropTrace (packet);
+      m_stats.drops[WpppDeviceStats::DROP_LINK_DOWN]++;
+      if (m_rareTraces != 0)
+        {
+          m_rareTraces->macTxDrop (packet);
+        }
       return false;
     }
 
@@ -581,15 +1437,86 @@ WirelessPointToPointNetDevice::Send (
   // Stick a point to point protocol header on the packet in preparation for
   // shoving it out the door.
   //
-  AddHeader (packet, protocolNumber);
+  AddHeader (packet, Mac48Address::IsMatchingType (dest) ? Mac48Address::ConvertFrom (dest) :
+             Mac48Address::GetBroadcast (), protocolNumber);
+  return SendFrame (packet);
+}
+
+bool
+WirelessPointToPointNetDevice::SendLabeled (Ptr<Packet> packet, uint32_t label, uint8_t ttl,
+                                            uint16_t protocolNumber)
+{
+  NS_LOG_FUNCTION (this << packet << label << uint32_t (ttl) << protocolNumber);
+  if (IsLinkUp () == false)
+    {
+      m_stats.drops[WpppDeviceStats::DROP_LINK_DOWN]++;
+      if (m_rareTraces != 0)
+        {
+          m_rareTraces->macTxDrop (packet);
+        }
+      return false;
+    }
+  WpppHeader ppp;
+  ppp.SetLabel (label, ttl, EtherToPpp (protocolNumber));
+  ppp.SetAddr1 (Mac48Address::GetBroadcast ());
+  ppp.SetAddr2 (m_address);
+  packet->AddHeader (ppp);
+  return SendFrame (packet);
+}
+
+bool
+WirelessPointToPointNetDevice::SendSourceRouted (Ptr<Packet> packet, const std::vector<uint8_t> &hops,
+                                                 uint16_t protocolNumber)
+{
+  NS_LOG_FUNCTION (this << packet << hops.size () << protocolNumber);
+  if (IsLinkUp () == false)
+    {
+      m_stats.drops[WpppDeviceStats::DROP_LINK_DOWN]++;
+      if (m_rareTraces != 0)
+        {
+          m_rareTraces->macTxDrop (packet);
+        }
+      return false;
+    }
+  WpppHeader ppp;
+  ppp.SetSourceRoute (hops, EtherToPpp (protocolNumber));
+  ppp.SetAddr1 (Mac48Address::GetBroadcast ());
+  ppp.SetAddr2 (m_address);
+  packet->AddHeader (ppp);
+  return SendFrame (packet);
+}
+
+bool
+WirelessPointToPointNetDevice::SendFrame (Ptr<Packet> packet)
+{
+  Ptr<NetDeviceQueue> txq;
+  if (m_queueInterface)
+  {
+    txq = m_queueInterface->GetTxQueue (m_txQueue);
+  }
+
+  if (m_latencyStats)
+    {
+      WpppTimestampTag tag;
+      tag.srcNode = m_node->GetId ();
+      tag.srcIfIndex = m_ifIndex;
+      tag.enqueueTime = Simulator::Now ().GetNanoSeconds ();
+      packet->AddPacketTag (tag);
+    }
 
   m_macTxTrace (packet);
 
+  //LargeSendMtu may have been set after the queue
+  NS_ASSERT_MSG (m_queue->GetMode () != Queue::QUEUE_MODE_BYTES || m_queue->GetMaxBytes () >= GetMtu (),
+                 "The device queue must hold at least one packet of GetMtu () bytes");
+
   //
   // We should enqueue and dequeue the packet to hit the tracing hooks.
   //
-  if (m_queue->Enqueue (Create<QueueItem> (packet)))
+  if (m_queue->Enqueue (Create<WpppQueueItem> (packet, Simulator::Now ().GetNanoSeconds ())))
     {
+      m_stats.queueHighWaterPackets = std::max (m_stats.queueHighWaterPackets, m_queue->GetNPackets ());
+      m_stats.queueHighWaterBytes = std::max (m_stats.queueHighWaterBytes, m_queue->GetNBytes ());
       // Inform BQL
       if (txq)
         {
@@ -598,9 +1525,15 @@ WirelessPointToPointNetDevice::Send (
       //
       // If the channel is ready for transition we send the packet right now
       // 
-      if (m_txMachineState == READY)
+      if (m_txMachineState == READY && CanStartTransmission ())
         {
-          packet = m_queue->Dequeue ()->GetPacket ();
+          packet = DequeuePacket ();
+          if (packet == 0)
+            {
+              // The active queue management or the transmit window dropped
+              // every queued frame
+              return true;
+            }
           // We have enqueued a packet and dequeued a (possibly different) packet. We
           // need to check if there is still room for another packet only if the queue
           // is in byte mode (the enqueued packet might be larger than the dequeued
@@ -608,14 +1541,17 @@ WirelessPointToPointNetDevice::Send (
           if (txq)
             {
               if (m_queue->GetMode () == Queue::QUEUE_MODE_BYTES &&
-                  m_queue->GetNBytes () + m_mtu > m_queue->GetMaxBytes ())
+                  m_queue->GetNBytes () + GetMtu () > m_queue->GetMaxBytes ())
                 {
                   NS_LOG_DEBUG ("The device queue is being stopped (" << m_queue->GetNPackets () <<
                                 " packets and " << m_queue->GetNBytes () << " bytes inside)");
                   txq->Stop ();
                 }
             }
-          m_snifferTrace (packet);
+          if (m_rareTraces != 0)
+            {
+              m_rareTraces->sniffer (packet);
+            }
           m_promiscSnifferTrace (packet);
           bool ret = TransmitStart (packet);
           if (txq)
@@ -633,7 +1569,7 @@ WirelessPointToPointNetDevice::Send (
           if ((m_queue->GetMode () == Queue::QUEUE_MODE_PACKETS &&
                m_queue->GetNPackets () >= m_queue->GetMaxPackets ()) ||
               (m_queue->GetMode () == Queue::QUEUE_MODE_BYTES &&
-               m_queue->GetNBytes () + m_mtu > m_queue->GetMaxBytes ()))
+               m_queue->GetNBytes () + GetMtu () > m_queue->GetMaxBytes ()))
             {
               NS_LOG_DEBUG ("The device queue is being stopped (" << m_queue->GetNPackets () <<
                             " packets and " << m_queue->GetNBytes () << " bytes inside)");
@@ -646,7 +1582,11 @@ WirelessPointToPointNetDevice::Send (
   // Enqueue may fail (overflow). This should not happen if the traffic control
   // module has been installed. Anyway, stop the tx queue, so that the upper layers
   // do not send packets until there is room in the queue again.
-  m_macTxDropTrace (packet);
+  m_stats.drops[WpppDeviceStats::DROP_QUEUE_FULL]++;
+  if (m_rareTraces != 0)
+    {
+      m_rareTraces->macTxDrop (packet);
+    }
   if (txq)
   {
     NS_LOG_ERROR ("BUG! Device queue full when the queue is not stopped! (" << m_queue->GetNPackets () <<
@@ -724,6 +1664,12 @@ uint16_t
 WirelessPointToPointNetDevice::GetMtu (void) const
 {
   NS_LOG_FUNCTION (this);
+  return m_largeSendMtu > m_mtu ? m_largeSendMtu : m_mtu;
+}
+
+uint16_t
+WirelessPointToPointNetDevice::GetFrameMtu (void) const
+{
   return m_mtu;
 }
 
@@ -735,6 +1681,7 @@ WirelessPointToPointNetDevice::PppToEther (uint16_t proto)
     {
     case 0x0021: return 0x0800;   //IPv4
     case 0x0057: return 0x86DD;   //IPv6
+    case WpppHeader::ARP_PROTOCOL: return 0x0806;
     default: NS_ASSERT_MSG (false, "PPP Protocol number not defined!");
     }
   return 0;
@@ -748,6 +1695,7 @@ WirelessPointToPointNetDevice::EtherToPpp (uint16_t proto)
     {
     case 0x0800: return 0x0021;   //IPv4
     case 0x86DD: return 0x0057;   //IPv6
+    case 0x0806: return WpppHeader::ARP_PROTOCOL;
     default: NS_ASSERT_MSG (false, "PPP Protocol number not defined!");
     }
   return 0;
@@ -8,6 +8,8 @@
 #define WIRELESS_POINT_TO_POINT_NET_DEVICE_H
 
 #include <cstring>
+#include <map>
+#include <vector>
 #include "ns3/address.h"
 #include "ns3/node.h"
 #include "ns3/net-device.h"
@@ -18,6 +20,9 @@
 #include "ns3/data-rate.h"
 #include "ns3/ptr.h"
 #include "ns3/mac48-address.h"
+#include "wppp-stats.h"
+#include "wppp-latency.h"
+#include "wppp-memory-usage.h"
 
 #include "ns3/mpi-module.h"
 
@@ -26,6 +31,10 @@ namespace ns3 {
 class Queue;
 class WirelessPointToPointChannel;
 class ErrorModel;
+class WpppLabelTable;
+struct WpppRareTraces;
+struct WpppRxAggregate;
+template <typename T> class WpppRareTraceAccessor;
 
 /**
  * \defgroup point-to-point Point-To-Point Network Device
@@ -52,6 +61,15 @@ class ErrorModel;
 class WirelessPointToPointNetDevice : public NetDevice
 {
 public:
+  /**
+   * Active queue management applied when frames leave the device queue
+   */
+  enum AqmMode
+  {
+    AQM_NONE,    /**< Transmit every queued frame */
+    AQM_CODEL    /**< Drop frames whose sojourn time stays above CoDelTarget */
+  };
+
   /**
    * \brief Get the TypeId
    *
@@ -117,6 +135,149 @@ public:
    */
   Ptr<Queue> GetQueue (void) const;
 
+  /**
+   * \brief Get the counters of this device
+   * \returns the counters, updated as packets go through the device
+   */
+  const WpppDeviceStats &GetStats (void) const;
+
+  /**
+   * \brief Set the counters of this device to zero
+   */
+  void ResetStats (void);
+
+  /**
+   * \brief Get the device this device is currently aligned with
+   * \returns the aligned device, or 0 if not aligned
+   */
+  Ptr<WirelessPointToPointNetDevice> GetAlignedPeer (void) const;
+
+  /**
+   * \brief Make this device a beam of a device with several beams
+   *
+   * A beam is not added to its node; it shares the address, node and
+   * interface index of its owner, which takes over the routing
+   * notifications the channel sends when the beam gains or loses its peer.
+   *
+   * \param owner the device the beam belongs to
+   * \param alignmentChanged called with this device and true when it
+   *        becomes aligned, false when it stops being aligned
+   */
+  void SetBeamOwner (Ptr<NetDevice> owner,
+                     Callback<void, Ptr<WirelessPointToPointNetDevice>, bool> alignmentChanged);
+
+  /**
+   * \returns the device this device is a beam of, or 0
+   */
+  Ptr<NetDevice> GetBeamOwner (void) const;
+
+  /**
+   * \brief Stop and wake a transmission queue of another device
+   *
+   * A beam is not seen by the upper layers, so it stops and wakes the
+   * transmission queue its owner gives the frames to the beam's peer
+   * instead of a queue interface of its own.
+   *
+   * \param queueInterface the queue interface of the owner
+   * \param txQueue index of the transmission queue of this beam
+   */
+  void SetQueueInterface (Ptr<NetDeviceQueueInterface> queueInterface, uint8_t txQueue);
+
+  /**
+   * \brief Tell the owner of a beam that the beam gained or lost its peer
+   * \param aligned true if the beam is now aligned
+   * \returns false if this device is not a beam, in which case the caller
+   *          notifies the alignment listeners of the device itself
+   */
+  bool NotifyBeamAlignment (bool aligned);
+
+  /**
+   * \brief Switch labeled frames through a label table
+   *
+   * Labeled frames this device receives are looked up in the table and
+   * sent on by the device it names, or handed up if the label is local.
+   * Set by WpppLabelTable::Install.
+   *
+   * \param table the label table of the node, or 0 to hand every frame up
+   */
+  void SetLabelTable (Ptr<WpppLabelTable> table);
+
+  /**
+   * \brief Send a labeled frame
+   * \param packet the packet
+   * \param label the label the frame leaves with
+   * \param ttl hops the frame may still be switched
+   * \param protocolNumber Ethernet protocol number of the packet
+   * \returns true if the frame was queued
+   */
+  bool SendLabeled (Ptr<Packet> packet, uint32_t label, uint8_t ttl, uint16_t protocolNumber);
+
+  /**
+   * \brief Send a frame along a route fixed by the sender
+   *
+   * Each relay sends the frame on its device whose interface index is the
+   * next hop of the route, without looking it up anywhere, and the node the
+   * route ends at hands it up.  Relays must have SourceRouting set.  A hop
+   * naming a device that is not a WirelessPointToPointNetDevice, such as a
+   * WpppMultiBeamNetDevice, drops the frame as DROP_NO_ROUTE.
+   *
+   * \param packet the packet
+   * \param hops interface index of the device each relay sends the frame
+   *        on, the first relay first; at most 255
+   * \param protocolNumber Ethernet protocol number of the packet
+   * \returns true if the frame was queued
+   */
+  bool SendSourceRouted (Ptr<Packet> packet, const std::vector<uint8_t> &hops, uint16_t protocolNumber);
+
+  /**
+   * \brief Only start transmissions that end by a given time
+   *
+   * Used to share one terminal between several peers in time.  Frames stay
+   * queued until a window they fit in is set; if the device is idle, the
+   * next frame starts at once.  A frame, interframe gap included, longer
+   * than the last window opened would never fit and is dropped as
+   * DROP_TOO_LONG.  Reception is not limited.
+   *
+   * \param end the time the last transmission must end by
+   */
+  void SetTransmitWindow (Time end);
+
+  /**
+   * \brief Transmit whenever a frame is queued, the default
+   */
+  void ClearTransmitWindow (void);
+
+  /**
+   * \brief Get the latency of the frames received by this device
+   *
+   * Only frames sent by devices whose LatencyStats attribute is true are
+   * recorded.
+   *
+   * \param links filled with one entry per sending device, ordered by node
+   *        id and interface index of the sender
+   */
+  void GetLatencyStats (std::vector<WpppLinkLatency> &links) const;
+
+  /**
+   * \brief Forget the latencies recorded by this device
+   */
+  void ResetLatencyStats (void);
+
+  /**
+   * \brief Get the time the frames transmitted by this device spent in its
+   * queue
+   * \returns the sojourn times, from Send to TransmitStart; cleared by
+   *          ResetStats
+   */
+  const WpppLatencyHistogram &GetSojournStats (void) const;
+
+  /**
+   * \brief Add the estimated memory held by this device, its queue and
+   * its statistics
+   * \param usage the totals to add to
+   */
+  void AddMemoryUsage (WpppMemoryUsage &usage) const;
+
   /**
    * Attach a receive ErrorModel to the WirelessPointToPointNetDevice.
    *
@@ -152,6 +313,15 @@ public:
   virtual bool SetMtu (const uint16_t mtu);
   virtual uint16_t GetMtu (void) const;
 
+  /**
+   * \brief Get the MTU of the frames on the wire
+   *
+   * GetMtu advertises LargeSendMtu instead when it is larger.
+   *
+   * \return the MTU set by SetMtu
+   */
+  uint16_t GetFrameMtu (void) const;
+
   virtual bool IsLinkUp (void) const;
 
   virtual void AddLinkChangeCallback (Callback<void> callback);
@@ -233,9 +403,10 @@ private:
    * Adds the necessary headers and trailers to a packet of data in order to
    * respect the protocol implemented by the agent.
    * \param p packet
+   * \param dest next-hop address, carried in addr1
    * \param protocolNumber protocol number
    */
-  void AddHeader (Ptr<Packet> p, uint16_t protocolNumber);
+  void AddHeader (Ptr<Packet> p, Mac48Address dest, uint16_t protocolNumber);
 
   /**
    * Removes, from a packet of data, all headers and trailers that
@@ -248,6 +419,36 @@ private:
   bool ProcessHeader (Ptr<Packet> p, uint16_t& param, Mac48Address& from, 
                       Mac48Address& to);
 
+  /**
+   * \brief Queue a frame, header included, and start transmitting if the
+   * device is idle
+   * \param packet the frame
+   * \returns false if the queue is full
+   */
+  bool SendFrame (Ptr<Packet> packet);
+
+  /**
+   * \brief Send on a received frame that is labeled or source routed and
+   * not for this node
+   * \param packet the frame, header included
+   * \returns true if the frame was sent on or dropped, false if it is to be
+   *          handed up
+   */
+  bool ForwardFrame (Ptr<Packet> packet);
+
+  /**
+   * \brief Hand a received IPv4 packet up, merged with the in-order TCP
+   * segments of its flow received just before or after it
+   * \param packet the packet, frame header removed
+   * \param from the sender of the frame
+   */
+  void Coalesce (Ptr<Packet> packet, Mac48Address from);
+
+  /**
+   * \brief Hand up the segments held by Coalesce, as one packet
+   */
+  void FlushCoalesced (void);
+
   /**
    * Start Sending a Packet Down the Wire.
    *
@@ -273,6 +474,63 @@ private:
    */
   void TransmitComplete (void);
 
+  /**
+   * \brief Take the next frame off the queue and start transmitting it, if
+   * there is one and it fits in the transmit window
+   */
+  void StartNextTransmission (void);
+
+  /**
+   * \brief Drop the frames at the head of the queue that would not fit in the
+   * transmit window, then check the next one
+   *
+   * \returns true unless the frame at the head of the queue would end after
+   *          the transmit window
+   */
+  bool CanStartTransmission (void);
+
+  /**
+   * \brief Drop the frames at the head of the queue that take longer than
+   * the last transmit window opened, which no window would ever fit
+   */
+  void DropFramesLongerThanWindow (void);
+
+  /**
+   * \brief Time a frame takes on the channel
+   *
+   * A large-send super-segment takes the time of the frames it stands for,
+   * with their headers and the interframe gaps between them, but not the
+   * gap after the last one.
+   *
+   * \param p the frame, with its WpppHeader
+   * \param frames set to the number of frames it stands for
+   * \returns the transmission time
+   */
+  Time GetTxTime (Ptr<const Packet> p, uint32_t &frames) const;
+
+  /**
+   * \brief Take the next frame to transmit off the queue
+   *
+   * Records the sojourn time of the frame and, with CoDel enabled, drops
+   * frames that stayed too long.
+   *
+   * \returns the frame, or 0 if the queue is empty
+   */
+  Ptr<Packet> DequeuePacket (void);
+
+  /**
+   * \brief CoDel test of the frame just taken off the queue
+   * \param sojourn time the frame spent in the queue, in ns
+   * \param now current time, in ns
+   * \returns true if the sojourn time has been above target for an interval
+   */
+  bool CoDelShouldDrop (int64_t sojourn, int64_t now);
+
+  /**
+   * \returns the time of the next CoDel drop after one at t, in ns
+   */
+  int64_t CoDelControlLaw (int64_t t) const;
+
   /**
    * \brief Make the link up and running
    *
@@ -324,26 +582,18 @@ private:
    */
   Ptr<ErrorModel> m_receiveErrorModel;
 
+  //
+  // The trace sources below are the ones the helpers connect.  The others,
+  // which few simulations use, are allocated on first connection; see
+  // WpppRareTraces.
+  //
+
   /**
    * The trace source fired when packets come into the "top" of the device
    * at the L3/L2 transition, before being queued for transmission.
    */
   TracedCallback<Ptr<const Packet> > m_macTxTrace;
 
-  /**
-   * The trace source fired when packets coming into the "top" of the device
-   * at the L3/L2 transition are dropped before being queued for transmission.
-   */
-  TracedCallback<Ptr<const Packet> > m_macTxDropTrace;
-
-  /**
-   * The trace source fired for packets successfully received by the device
-   * immediately before being forwarded up to higher layers (at the L2/L3 
-   * transition).  This is a promiscuous trace (which doesn't mean a lot here
-   * in the point-to-point device).
-   */
-  TracedCallback<Ptr<const Packet> > m_macPromiscRxTrace;
-
   /**
    * The trace source fired for packets successfully received by the device
    * immediately before being forwarded up to higher layers (at the L2/L3 
@@ -352,43 +602,6 @@ private:
    */
   TracedCallback<Ptr<const Packet> > m_macRxTrace;
 
-  /**
-   * The trace source fired for packets successfully received by the device
-   * but are dropped before being forwarded up to higher layers (at the L2/L3 
-   * transition).
-   */
-  TracedCallback<Ptr<const Packet> > m_macRxDropTrace;
-
-  /**
-   * The trace source fired when a packet begins the transmission process on
-   * the medium.
-   */
-  TracedCallback<Ptr<const Packet> > m_phyTxBeginTrace;
-
-  /**
-   * The trace source fired when a packet ends the transmission process on
-   * the medium.
-   */
-  TracedCallback<Ptr<const Packet> > m_phyTxEndTrace;
-
-  /**
-   * The trace source fired when the phy layer drops a packet before it tries
-   * to transmit it.
-   */
-  TracedCallback<Ptr<const Packet> > m_phyTxDropTrace;
-
-  /**
-   * The trace source fired when a packet begins the reception process from
-   * the medium -- when the simulated first bit(s) arrive.
-   */
-  TracedCallback<Ptr<const Packet> > m_phyRxBeginTrace;
-
-  /**
-   * The trace source fired when a packet ends the reception process from
-   * the medium.
-   */
-  TracedCallback<Ptr<const Packet> > m_phyRxEndTrace;
-
   /**
    * The trace source fired when the phy layer drops a packet it has received.
    * This happens if the receiver is not enabled or the error model is active
@@ -396,24 +609,6 @@ private:
    */
   TracedCallback<Ptr<const Packet> > m_phyRxDropTrace;
 
-  /**
-   * A trace source that emulates a non-promiscuous protocol sniffer connected 
-   * to the device.  Unlike your average everyday sniffer, this trace source 
-   * will not fire on PACKET_OTHERHOST events.
-   *
-   * On the transmit size, this trace hook will fire after a packet is dequeued
-   * from the device queue for transmission.  In Linux, for example, this would
-   * correspond to the point just before a device \c hard_start_xmit where 
-   * \c dev_queue_xmit_nit is called to dispatch the packet to the PF_PACKET 
-   * ETH_P_ALL handlers.
-   *
-   * On the receive side, this trace hook will fire when a packet is received,
-   * just before the receive callback is executed.  In Linux, for example, 
-   * this would correspond to the point at which the packet is dispatched to 
-   * packet sniffers in \c netif_receive_skb.
-   */
-  TracedCallback<Ptr<const Packet> > m_snifferTrace;
-
   /**
    * A trace source that emulates a promiscuous mode protocol sniffer connected
    * to the device.  This trace source fire on packets destined for any host
@@ -432,8 +627,20 @@ private:
    */
   TracedCallback<Ptr<const Packet> > m_promiscSnifferTrace;
 
+  /**
+   * \brief Get the rarely used trace sources, allocating them if needed
+   * \returns the trace sources of this device
+   */
+  WpppRareTraces *GetRareTraces (void);
+
+  /// The accessors of the rarely used trace sources allocate them
+  template <typename T> friend class WpppRareTraceAccessor;
+
+  WpppRareTraces *m_rareTraces;  //!< Rarely used trace sources, or 0
+
   Ptr<Node> m_node;         //!< Node owning this NetDevice
   Ptr<NetDeviceQueueInterface> m_queueInterface;  //!< NetDevice queue interface
+  uint8_t m_txQueue;        //!< Transmission queue of m_queueInterface this device uses
   Mac48Address m_address;   //!< Mac48Address of this NetDevice
   NetDevice::ReceiveCallback m_rxCallback;   //!< Receive callback
   NetDevice::PromiscReceiveCallback m_promiscCallback;  //!< Receive callback
@@ -442,6 +649,13 @@ private:
   bool m_linkUp;      //!< Identify if the link is up or not
   TracedCallback<> m_linkChangeCallbacks;//!< Callback for the link change event
 
+  NetDevice *m_beamOwner;   //!< Device this device is a beam of, or 0; not a Ptr, the owner holds its beams
+  /// Tells the owner of this beam about alignment changes
+  Callback<void, Ptr<WirelessPointToPointNetDevice>, bool> m_beamAlignmentCallback;
+
+  Ptr<WpppLabelTable> m_labelTable;  //!< Label table of the node, or 0
+  bool m_sourceRouting;              //!< Send on source routed frames with hops left
+
   static const uint16_t DEFAULT_MTU = 1500; //!< Default MTU
 
   /**
@@ -454,8 +668,45 @@ private:
    */
   uint32_t m_mtu;
 
+  /**
+   * \brief MTU advertised to the stack in large-send mode, or 0
+   *
+   * Packets up to this size are sent as one super-segment, which takes the
+   * airtime of the MTU sized frames it stands for.
+   */
+  uint16_t m_largeSendMtu;
+
+  WpppRxAggregate *m_rxAggregate;  //!< Segments held back by Coalesce, or 0
+  Time m_rxCoalesceWindow;         //!< Time segments are held back, or 0
+  uint16_t m_rxCoalesceMaxBytes;   //!< Largest packet segments are merged into
+
   Ptr<Packet> m_currentPkt; //!< Current packet processed
 
+  WpppDeviceStats m_stats;  //!< Counters of this device
+
+  /**
+   * \brief Add the latency of a received frame to the histograms of its link
+   * \param tag the timestamps the sender put on the frame
+   */
+  void RecordLatency (const WpppTimestampTag &tag);
+
+  bool m_latencyStats;      //!< Stamp sent frames with a WpppTimestampTag
+
+  WpppLatencyHistogram m_sojourn;      //!< Sojourn times of the transmitted frames
+
+  int64_t m_txWindowEnd;        //!< Transmissions must end by this time, in ns; -1 if not limited
+  int64_t m_txWindowLength;     //!< Length of the last transmit window opened, in ns; 0 if none
+
+  AqmMode m_aqm;                //!< Active queue management in use
+  Time m_codelTarget;           //!< Acceptable standing sojourn time
+  Time m_codelInterval;         //!< Time above target before dropping starts
+  bool m_codelDropping;         //!< CoDel is in the dropping state
+  int64_t m_codelFirstAbove;    //!< When the sojourn time may be judged too long, or 0
+  int64_t m_codelDropNext;      //!< Time of the next drop in the dropping state
+  uint32_t m_codelCount;        //!< Drops since entering the dropping state
+  uint32_t m_codelLastCount;    //!< m_codelCount when the dropping state was last left
+  std::map<uint64_t, WpppLinkLatency> m_latency;  //!< Received latency by sender
+
   /**
    * \brief PPP to Ethernet protocol number mapping
    * \param protocol A PPP protocol number
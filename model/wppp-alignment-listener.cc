@@ -0,0 +1,107 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 University of North Carolina at Chapel Hill
+ * Author: Ben Newton
+ */
+
+#include "ns3/log.h"
+#include "ns3/node.h"
+#include "ns3/ipv4.h"
+#include "ns3/ipv4-routing-protocol.h"
+#include "ns3/ipv6.h"
+#include "ns3/ipv6-routing-protocol.h"
+#include "wppp-alignment-listener.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("WpppAlignmentListener");
+
+NS_OBJECT_ENSURE_REGISTERED (WpppAlignmentListener);
+NS_OBJECT_ENSURE_REGISTERED (WpppIpv4AlignmentListener);
+NS_OBJECT_ENSURE_REGISTERED (WpppIpv6AlignmentListener);
+
+TypeId
+WpppAlignmentListener::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::WpppAlignmentListener")
+    .SetParent<Object> ()
+    .SetGroupName ("WirelessPointToPoint")
+  ;
+  return tid;
+}
+
+WpppAlignmentListener::~WpppAlignmentListener ()
+{
+}
+
+TypeId
+WpppIpv4AlignmentListener::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::WpppIpv4AlignmentListener")
+    .SetParent<WpppAlignmentListener> ()
+    .SetGroupName ("WirelessPointToPoint")
+    .AddConstructor<WpppIpv4AlignmentListener> ()
+  ;
+  return tid;
+}
+
+void
+WpppIpv4AlignmentListener::NotifyAlignment (Ptr<NetDevice> device, bool up)
+{
+  NS_LOG_FUNCTION (this << device << up);
+  Ptr<Ipv4> ipv4 = device->GetNode ()->GetObject<Ipv4> ();
+  if (ipv4 == 0 || ipv4->GetRoutingProtocol () == 0)
+    {
+      return;
+    }
+  int32_t interface = ipv4->GetInterfaceForDevice (device);
+  if (interface < 0)
+    {
+      return;
+    }
+  if (up)
+    {
+      ipv4->GetRoutingProtocol ()->NotifyInterfaceUp (interface);
+    }
+  else
+    {
+      ipv4->GetRoutingProtocol ()->NotifyInterfaceDown (interface);
+    }
+}
+
+TypeId
+WpppIpv6AlignmentListener::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::WpppIpv6AlignmentListener")
+    .SetParent<WpppAlignmentListener> ()
+    .SetGroupName ("WirelessPointToPoint")
+    .AddConstructor<WpppIpv6AlignmentListener> ()
+  ;
+  return tid;
+}
+
+void
+WpppIpv6AlignmentListener::NotifyAlignment (Ptr<NetDevice> device, bool up)
+{
+  NS_LOG_FUNCTION (this << device << up);
+  Ptr<Ipv6> ipv6 = device->GetNode ()->GetObject<Ipv6> ();
+  if (ipv6 == 0 || ipv6->GetRoutingProtocol () == 0)
+    {
+      return;
+    }
+  int32_t interface = ipv6->GetInterfaceForDevice (device);
+  if (interface < 0)
+    {
+      return;
+    }
+  if (up)
+    {
+      ipv6->GetRoutingProtocol ()->NotifyInterfaceUp (interface);
+    }
+  else
+    {
+      ipv6->GetRoutingProtocol ()->NotifyInterfaceDown (interface);
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,92 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 University of North Carolina at Chapel Hill
+ * Author: Ben Newton
+ */
+
+#ifndef WPPP_ALIGNMENT_LISTENER_H
+#define WPPP_ALIGNMENT_LISTENER_H
+
+#include "ns3/object.h"
+#include "ns3/ptr.h"
+#include "ns3/net-device.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup wireless-point-to-point
+ * \brief Told by a WirelessPointToPointChannel when an interface gains or
+ * loses its last peer
+ *
+ * Add one to a channel with WirelessPointToPointChannel::AddAlignmentListener
+ * to react to alignments in anything above the device: a routing protocol,
+ * a custom forwarding layer, statistics.  Notifications come after damping
+ * and are per interface: a multi-beam device is one interface, up while
+ * any of its beams is aligned.
+ */
+class WpppAlignmentListener : public Object
+{
+public:
+  /**
+   * \brief Get the TypeId
+   *
+   * \return The TypeId for this class
+   */
+  static TypeId GetTypeId (void);
+
+  virtual ~WpppAlignmentListener ();
+
+  /**
+   * \brief An interface went up or down
+   * \param device the device of the interface; its node may have no
+   *        internet stack at all
+   * \param up true if the interface went up
+   */
+  virtual void NotifyAlignment (Ptr<NetDevice> device, bool up) = 0;
+};
+
+/**
+ * \ingroup wireless-point-to-point
+ * \brief Passes alignments on to the IPv4 routing protocol of the node
+ *
+ * Calls Ipv4RoutingProtocol::NotifyInterfaceUp or NotifyInterfaceDown for
+ * the interface of the device; nodes without IPv4, and devices that are
+ * not an IPv4 interface, are skipped.  Every channel has one unless its
+ * Ipv4Notifications attribute is false.
+ */
+class WpppIpv4AlignmentListener : public WpppAlignmentListener
+{
+public:
+  /**
+   * \brief Get the TypeId
+   *
+   * \return The TypeId for this class
+   */
+  static TypeId GetTypeId (void);
+
+  virtual void NotifyAlignment (Ptr<NetDevice> device, bool up);
+};
+
+/**
+ * \ingroup wireless-point-to-point
+ * \brief Passes alignments on to the IPv6 routing protocol of the node
+ *
+ * Like WpppIpv4AlignmentListener, for Ipv6RoutingProtocol.  Not installed
+ * by default.
+ */
+class WpppIpv6AlignmentListener : public WpppAlignmentListener
+{
+public:
+  /**
+   * \brief Get the TypeId
+   *
+   * \return The TypeId for this class
+   */
+  static TypeId GetTypeId (void);
+
+  virtual void NotifyAlignment (Ptr<NetDevice> device, bool up);
+};
+
+} // namespace ns3
+
+#endif /* WPPP_ALIGNMENT_LISTENER_H */
@@ -0,0 +1,332 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 University of North Carolina at Chapel Hill
+ * Author: Ben Newton
+ */
+
+#include <cstring>
+#include <deque>
+#include "ns3/log.h"
+#include "ns3/assert.h"
+#include "wppp-background-writer.h"
+
+#ifdef WPPP_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#ifndef WPPP_NO_THREADS
+#include "ns3/system-thread.h"
+#include "ns3/system-mutex.h"
+#include "ns3/system-condition.h"
+#endif
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("WpppBackgroundWriter");
+
+#ifndef WPPP_NO_THREADS
+namespace {
+
+//a condition is reset under the mutex before the state it stands for is
+//checked, and set after the state changes, so TimedWait returns at once on
+//a change made after the check and sleeps otherwise; the bound on the wait
+//is only a safety net
+const uint64_t WPPP_WRITER_POLL_NS = 100000000;
+
+} // anonymous namespace
+
+/**
+ * The thread writing the buffers of every open WpppBackgroundWriter, in
+ * the order they were handed over
+ */
+class WpppWriterThread
+{
+public:
+  WpppWriterThread ()
+    : m_stopping (false)
+  {
+    m_thread = Create<SystemThread> (MakeCallback (&WpppWriterThread::Run, this));
+    m_thread->Start ();
+  }
+
+  ~WpppWriterThread ()
+  {
+    {
+      CriticalSection cs (m_mutex);
+      m_stopping = true;
+    }
+    m_wake.SetCondition (true);
+    m_wake.Signal ();
+    m_thread->Join ();
+  }
+
+  /**
+   * \brief Queue a buffer of a writer, waiting while the writer has too
+   *        many buffers queued
+   */
+  void Write (WpppBackgroundWriter *writer, std::vector<uint8_t> &buffer)
+  {
+    while (true)
+      {
+        {
+          CriticalSection cs (m_mutex);
+          writer->m_drained->SetCondition (false);
+          if (writer->m_pending < writer->m_maxPending)
+            {
+              writer->m_pending++;
+              m_queue.push_back (Job ());
+              m_queue.back ().writer = writer;
+              m_queue.back ().buffer.swap (buffer);
+              break;
+            }
+        }
+        NS_LOG_LOGIC ("writer thread behind, waiting");
+        writer->m_drained->TimedWait (WPPP_WRITER_POLL_NS);
+      }
+    m_wake.SetCondition (true);
+    m_wake.Signal ();
+  }
+
+  /**
+   * \brief Wait until every buffer queued by a writer is written
+   */
+  void Drain (WpppBackgroundWriter *writer)
+  {
+    while (true)
+      {
+        {
+          CriticalSection cs (m_mutex);
+          writer->m_drained->SetCondition (false);
+          if (writer->m_pending == 0)
+            {
+              return;
+            }
+        }
+        writer->m_drained->TimedWait (WPPP_WRITER_POLL_NS);
+      }
+  }
+
+private:
+  /**
+   * A buffer waiting to be written
+   */
+  struct Job
+  {
+    WpppBackgroundWriter *writer;  //!< Writer of the file
+    std::vector<uint8_t> buffer;   //!< Data to append
+  };
+
+  /**
+   * \brief Main loop of the thread
+   */
+  void Run (void)
+  {
+    Job job;
+    while (true)
+      {
+        bool stop = false;
+        {
+          CriticalSection cs (m_mutex);
+          m_wake.SetCondition (false);
+          if (!m_queue.empty ())
+            {
+              job.writer = m_queue.front ().writer;
+              job.buffer.swap (m_queue.front ().buffer);
+              m_queue.pop_front ();
+            }
+          else
+            {
+              stop = m_stopping;
+            }
+        }
+        if (!job.buffer.empty ())
+          {
+            job.writer->Output (job.buffer, false);
+            job.buffer.clear ();
+            //signalled under the mutex: once Drain sees the count at 0
+            //the writer may be closed and its condition deleted
+            CriticalSection cs (m_mutex);
+            job.writer->m_pending--;
+            job.writer->m_drained->SetCondition (true);
+            job.writer->m_drained->Signal ();
+          }
+        else if (stop)
+          {
+            return;
+          }
+        else
+          {
+            m_wake.TimedWait (WPPP_WRITER_POLL_NS);
+          }
+      }
+  }
+
+  SystemMutex m_mutex;          //!< Protects the queue, m_stopping and the writers' counts
+  SystemCondition m_wake;       //!< Set when a buffer is queued or the thread stops
+  std::deque<Job> m_queue;      //!< Buffers not yet written
+  bool m_stopping;              //!< Set when the process exits
+  Ptr<SystemThread> m_thread;   //!< The thread
+};
+
+namespace {
+
+/**
+ * \returns the writer thread, started on first use and stopped when the
+ *          process exits
+ */
+WpppWriterThread &
+GetWriterThread (void)
+{
+  static WpppWriterThread thread;
+  return thread;
+}
+
+} // anonymous namespace
+#endif
+
+WpppBackgroundWriter::WpppBackgroundWriter ()
+  : m_file (0),
+    m_zstream (0),
+    m_maxPending (64),
+    m_pending (0),
+    m_drained (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+WpppBackgroundWriter::~WpppBackgroundWriter ()
+{
+  NS_LOG_FUNCTION (this);
+  Close ();
+}
+
+bool
+WpppBackgroundWriter::IsCompressionSupported (void)
+{
+#ifdef WPPP_HAVE_ZLIB
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool
+WpppBackgroundWriter::Open (std::string filename, bool compress)
+{
+  NS_LOG_FUNCTION (this << filename << compress);
+  Close ();
+  if (compress && !IsCompressionSupported ())
+    {
+      NS_LOG_WARN ("compression requested but zlib is not available");
+      return false;
+    }
+  m_file = std::fopen (filename.c_str (), "wb");
+  if (m_file == 0)
+    {
+      return false;
+    }
+#ifdef WPPP_HAVE_ZLIB
+  if (compress)
+    {
+      m_zstream = new z_stream;
+      std::memset (m_zstream, 0, sizeof (z_stream));
+      //15 bits of window plus 16 selects the gzip format
+      if (deflateInit2 (m_zstream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8,
+                        Z_DEFAULT_STRATEGY) != Z_OK)
+        {
+          delete m_zstream;
+          m_zstream = 0;
+          std::fclose (m_file);
+          m_file = 0;
+          return false;
+        }
+    }
+#endif
+#ifndef WPPP_NO_THREADS
+  m_drained = new SystemCondition;
+  GetWriterThread ();
+#endif
+  return true;
+}
+
+void
+WpppBackgroundWriter::SetMaxPending (uint32_t pending)
+{
+  m_maxPending = pending > 0 ? pending : 1;
+}
+
+bool
+WpppBackgroundWriter::IsOpen (void) const
+{
+  return m_file != 0;
+}
+
+void
+WpppBackgroundWriter::Write (std::vector<uint8_t> &buffer)
+{
+  NS_ASSERT_MSG (m_file != 0, "Background writer is not open");
+  if (buffer.empty ())
+    {
+      return;
+    }
+#ifndef WPPP_NO_THREADS
+  GetWriterThread ().Write (this, buffer);
+#else
+  Output (buffer, false);
+  buffer.clear ();
+#endif
+}
+
+void
+WpppBackgroundWriter::Output (const std::vector<uint8_t> &buffer, bool finish)
+{
+  if (m_zstream == 0)
+    {
+      if (!buffer.empty ())
+        {
+          std::fwrite (&buffer[0], 1, buffer.size (), m_file);
+        }
+      return;
+    }
+#ifdef WPPP_HAVE_ZLIB
+  m_compressed.resize (1 << 16);
+  m_zstream->next_in = buffer.empty () ? Z_NULL : const_cast<Bytef *> (&buffer[0]);
+  m_zstream->avail_in = buffer.size ();
+  do
+    {
+      m_zstream->next_out = &m_compressed[0];
+      m_zstream->avail_out = m_compressed.size ();
+      deflate (m_zstream, finish ? Z_FINISH : Z_NO_FLUSH);
+      std::fwrite (&m_compressed[0], 1, m_compressed.size () - m_zstream->avail_out, m_file);
+    }
+  while (m_zstream->avail_out == 0);
+#endif
+}
+
+void
+WpppBackgroundWriter::Close (void)
+{
+  if (m_file == 0)
+    {
+      return;
+    }
+  NS_LOG_FUNCTION (this);
+#ifndef WPPP_NO_THREADS
+  GetWriterThread ().Drain (this);
+  delete m_drained;
+  m_drained = 0;
+#endif
+#ifdef WPPP_HAVE_ZLIB
+  if (m_zstream != 0)
+    {
+      Output (std::vector<uint8_t> (), true);
+      deflateEnd (m_zstream);
+      delete m_zstream;
+      m_zstream = 0;
+    }
+#endif
+  std::fclose (m_file);
+  m_file = 0;
+}
+
+} // namespace ns3
@@ -0,0 +1,99 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 University of North Carolina at Chapel Hill
+ * Author: Ben Newton
+ */
+
+#ifndef WPPP_BACKGROUND_WRITER_H
+#define WPPP_BACKGROUND_WRITER_H
+
+#include <stdint.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "ns3/simple-ref-count.h"
+
+struct z_stream_s;
+
+namespace ns3 {
+
+class SystemCondition;
+class WpppWriterThread;
+
+/**
+ * \ingroup wireless-point-to-point
+ * \brief Appends buffers to a file from a background thread
+ *
+ * The simulation thread fills a buffer and hands it over with Write; a
+ * writer thread performs the file I/O, so a slow disk only stalls the
+ * simulation when more than the maximum number of buffers are pending.
+ * One writer thread, started with the first file, serves every file of the
+ * process, so tracing thousands of devices does not start thousands of
+ * threads.  Without threading support in the ns-3 build the buffers are
+ * written synchronously.
+ *
+ * The file can be gzip compressed on the writer thread when the module is
+ * built with zlib.
+ */
+class WpppBackgroundWriter : public SimpleRefCount<WpppBackgroundWriter>
+{
+public:
+  WpppBackgroundWriter ();
+  ~WpppBackgroundWriter ();
+
+  /**
+   * \brief Create (truncate) a file, starting the writer thread if needed
+   * \param filename path of the file
+   * \param compress gzip the file
+   * \return true if the file could be opened, false also if compression is
+   *         requested but the module was built without zlib
+   */
+  bool Open (std::string filename, bool compress = false);
+
+  /**
+   * \return true if the module was built with zlib
+   */
+  static bool IsCompressionSupported (void);
+
+  /**
+   * \param pending number of buffers that may wait for the writer thread
+   *        before Write blocks, 64 by default
+   */
+  void SetMaxPending (uint32_t pending);
+
+  /**
+   * \brief Queue a buffer to be appended to the file
+   * \param buffer data to write; its contents are taken and it is left empty
+   */
+  void Write (std::vector<uint8_t> &buffer);
+
+  /**
+   * \brief Wait for the pending buffers to be written and close the file
+   */
+  void Close (void);
+
+  /**
+   * \return true between a successful Open and Close
+   */
+  bool IsOpen (void) const;
+
+private:
+  friend class WpppWriterThread;
+
+  /**
+   * \brief Write a buffer to the file, compressing it if needed
+   * \param finish end the compressed stream
+   */
+  void Output (const std::vector<uint8_t> &buffer, bool finish);
+
+  std::FILE *m_file;                  //!< File being written
+  struct z_stream_s *m_zstream;       //!< Compressor, 0 if not compressing
+  std::vector<uint8_t> m_compressed;  //!< Output of the compressor
+  uint32_t m_maxPending;              //!< Buffers allowed to wait for the writer thread
+  uint32_t m_pending;                 //!< Buffers not yet written, protected by the thread mutex
+  SystemCondition *m_drained;         //!< Set when one of this file's buffers is written
+};
+
+} // namespace ns3
+
+#endif /* WPPP_BACKGROUND_WRITER_H */
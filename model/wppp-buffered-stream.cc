@@ -0,0 +1,138 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 University of North Carolina at Chapel Hill
+ * Author: Ben Newton
+ */
+
+#include <algorithm>
+#include <cstring>
+#include "ns3/log.h"
+#include "wppp-buffered-stream.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("WpppBufferedStream");
+
+WpppBufferedStream::Buffer::Buffer ()
+  : m_size (0)
+{
+}
+
+void
+WpppBufferedStream::Buffer::Start (Ptr<WpppBackgroundWriter> writer, uint32_t size)
+{
+  m_writer = writer;
+  if (m_writer == 0)
+    {
+      m_data.clear ();
+      setp (0, 0);
+      return;
+    }
+  m_size = std::max<uint32_t> (size, 4096);
+  m_data.resize (m_size);
+  char *begin = reinterpret_cast<char *> (&m_data[0]);
+  setp (begin, begin + m_size);
+}
+
+void
+WpppBufferedStream::Buffer::Drain (void)
+{
+  if (m_writer == 0)
+    {
+      return;
+    }
+  m_data.resize (pptr () - pbase ());
+  //takes the contents of m_data
+  m_writer->Write (m_data);
+  m_data.resize (m_size);
+  char *begin = reinterpret_cast<char *> (&m_data[0]);
+  setp (begin, begin + m_size);
+}
+
+WpppBufferedStream::Buffer::int_type
+WpppBufferedStream::Buffer::overflow (int_type c)
+{
+  if (m_writer == 0)
+    {
+      return traits_type::eof ();
+    }
+  Drain ();
+  if (!traits_type::eq_int_type (c, traits_type::eof ()))
+    {
+      *pptr () = traits_type::to_char_type (c);
+      pbump (1);
+    }
+  return traits_type::not_eof (c);
+}
+
+std::streamsize
+WpppBufferedStream::Buffer::xsputn (const char *s, std::streamsize n)
+{
+  if (m_writer == 0)
+    {
+      return 0;
+    }
+  std::streamsize done = 0;
+  while (done < n)
+    {
+      if (pptr () == epptr ())
+        {
+          Drain ();
+        }
+      std::streamsize chunk = std::min<std::streamsize> (n - done, epptr () - pptr ());
+      std::memcpy (pptr (), s + done, chunk);
+      pbump (chunk);
+      done += chunk;
+    }
+  return done;
+}
+
+WpppBufferedStream::WpppBufferedStream ()
+  : m_stream (&m_buffer)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+WpppBufferedStream::~WpppBufferedStream ()
+{
+  NS_LOG_FUNCTION (this);
+  Close ();
+}
+
+bool
+WpppBufferedStream::Open (std::string filename, bool compress, uint32_t bufferSize)
+{
+  NS_LOG_FUNCTION (this << filename << compress << bufferSize);
+  Close ();
+  Ptr<WpppBackgroundWriter> writer = Create<WpppBackgroundWriter> ();
+  if (!writer->Open (filename, compress))
+    {
+      return false;
+    }
+  m_writer = writer;
+  m_buffer.Start (m_writer, bufferSize);
+  m_stream.clear ();
+  return true;
+}
+
+std::ostream *
+WpppBufferedStream::GetStream (void)
+{
+  return &m_stream;
+}
+
+void
+WpppBufferedStream::Close (void)
+{
+  if (m_writer == 0)
+    {
+      return;
+    }
+  NS_LOG_FUNCTION (this);
+  m_buffer.Drain ();
+  m_buffer.Start (0, 0);
+  m_writer->Close ();
+  m_writer = 0;
+}
+
+} // namespace ns3
@@ -0,0 +1,89 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 University of North Carolina at Chapel Hill
+ * Author: Ben Newton
+ */
+
+#ifndef WPPP_BUFFERED_STREAM_H
+#define WPPP_BUFFERED_STREAM_H
+
+#include <stdint.h>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include "ns3/simple-ref-count.h"
+#include "ns3/ptr.h"
+#include "wppp-background-writer.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup wireless-point-to-point
+ * \brief Output stream that writes a file in large blocks from a background
+ * thread, optionally gzip compressed
+ *
+ * Text written to GetStream () is collected in a buffer of the configured
+ * size; full buffers are handed to a WpppBackgroundWriter.  Flushes, such as
+ * the std::endl at the end of each ASCII trace line, do not write anything,
+ * so the file is only complete after Close.  The stream can be wrapped in an
+ * OutputStreamWrapper for the AsciiTraceHelper sinks.
+ */
+class WpppBufferedStream : public SimpleRefCount<WpppBufferedStream>
+{
+public:
+  WpppBufferedStream ();
+  ~WpppBufferedStream ();
+
+  /**
+   * \brief Create (truncate) the file
+   * \param filename path of the file
+   * \param compress gzip the file, see WpppBackgroundWriter
+   * \param bufferSize bytes collected before they are handed to the writer
+   * \return true if the file could be opened
+   */
+  bool Open (std::string filename, bool compress, uint32_t bufferSize);
+
+  /**
+   * \return the stream to write to; owned by this object
+   */
+  std::ostream *GetStream (void);
+
+  /**
+   * \brief Write out the buffered text and close the file
+   */
+  void Close (void);
+
+private:
+  /**
+   * \brief Stream buffer that hands full buffers to the writer
+   */
+  class Buffer : public std::streambuf
+  {
+  public:
+    Buffer ();
+    /**
+     * \brief Start collecting into buffers of the given size
+     */
+    void Start (Ptr<WpppBackgroundWriter> writer, uint32_t size);
+    /**
+     * \brief Hand the collected text to the writer
+     */
+    void Drain (void);
+  protected:
+    virtual int_type overflow (int_type c);
+    virtual std::streamsize xsputn (const char *s, std::streamsize n);
+  private:
+    Ptr<WpppBackgroundWriter> m_writer;  //!< Writer of the file
+    std::vector<uint8_t> m_data;         //!< Storage of the put area
+    uint32_t m_size;                     //!< Size of the put area
+  };
+
+  Ptr<WpppBackgroundWriter> m_writer;    //!< Writer of the file
+  Buffer m_buffer;                       //!< Buffer behind m_stream
+  std::ostream m_stream;                 //!< Stream given to the user
+};
+
+} // namespace ns3
+
+#endif /* WPPP_BUFFERED_STREAM_H */
@@ -0,0 +1,107 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 University of North Carolina at Chapel Hill
+ * Author: Ben Newton
+ */
+
+#include <algorithm>
+#include <limits>
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "wppp-capture-filter.h"
+#include "wireless-point-to-point-net-device.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("WpppCaptureFilter");
+
+namespace {
+
+uint64_t
+PairKey (uint32_t a, uint32_t b)
+{
+  return (uint64_t (std::min (a, b)) << 32) | std::max (a, b);
+}
+
+} // anonymous namespace
+
+WpppCaptureFilter::WpppCaptureFilter ()
+  : m_start (std::numeric_limits<int64_t>::min ()),
+    m_stop (std::numeric_limits<int64_t>::max ()),
+    m_sampling (1)
+{
+}
+
+void
+WpppCaptureFilter::AddPeerPair (uint32_t nodeA, uint32_t nodeB)
+{
+  uint64_t key = PairKey (nodeA, nodeB);
+  m_pairs.insert (std::lower_bound (m_pairs.begin (), m_pairs.end (), key), key);
+}
+
+void
+WpppCaptureFilter::AddProtocol (uint16_t protocol)
+{
+  m_protocols.push_back (protocol);
+}
+
+void
+WpppCaptureFilter::SetTimeWindow (Time start, Time stop)
+{
+  m_start = start.GetNanoSeconds ();
+  m_stop = stop.GetNanoSeconds ();
+}
+
+void
+WpppCaptureFilter::SetSampling (uint32_t n)
+{
+  m_sampling = n > 0 ? n : 1;
+}
+
+bool
+WpppCaptureFilter::IsEmpty (void) const
+{
+  return m_pairs.empty () && m_protocols.empty () && m_sampling == 1 &&
+         m_start == std::numeric_limits<int64_t>::min () &&
+         m_stop == std::numeric_limits<int64_t>::max ();
+}
+
+bool
+WpppCaptureFilter::Accept (Ptr<const WirelessPointToPointNetDevice> device, Ptr<const Packet> p) const
+{
+  int64_t now = Simulator::Now ().GetNanoSeconds ();
+  if (now < m_start || now >= m_stop)
+    {
+      return false;
+    }
+  if (!m_pairs.empty ())
+    {
+      Ptr<WirelessPointToPointNetDevice> peer = device->GetAlignedPeer ();
+      if (peer == 0)
+        {
+          return false;
+        }
+      uint64_t key = PairKey (device->GetNode ()->GetId (), peer->GetNode ()->GetId ());
+      if (!std::binary_search (m_pairs.begin (), m_pairs.end (), key))
+        {
+          return false;
+        }
+    }
+  if (!m_protocols.empty ())
+    {
+      uint8_t buf[2];
+      if (p->CopyData (buf, 2) < 2)
+        {
+          return false;
+        }
+      uint16_t protocol = (buf[0] << 8) | buf[1];
+      if (std::find (m_protocols.begin (), m_protocols.end (), protocol) == m_protocols.end ())
+        {
+          return false;
+        }
+    }
+  //copies of a packet keep its uid, across devices and links
+  return p->GetUid () % m_sampling == 0;
+}
+
+} // namespace ns3
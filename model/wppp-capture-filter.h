@@ -0,0 +1,93 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 University of North Carolina at Chapel Hill
+ * Author: Ben Newton
+ */
+
+#ifndef WPPP_CAPTURE_FILTER_H
+#define WPPP_CAPTURE_FILTER_H
+
+#include <stdint.h>
+#include <vector>
+#include "ns3/ptr.h"
+#include "ns3/nstime.h"
+#include "ns3/packet.h"
+
+namespace ns3 {
+
+class WirelessPointToPointNetDevice;
+
+/**
+ * \ingroup wireless-point-to-point
+ * \brief Selects the frames of a device that are traced
+ *
+ * A frame passes if it is inside the time window, the device is aligned
+ * with one of the listed peer nodes, and its WpppHeader protocol is one of
+ * the listed protocols; criteria left unset accept everything.  Of the
+ * frames that pass, those of the packets whose uid is a multiple of N are
+ * kept, about one in N.  The choice depends on the packet alone, so a kept
+ * packet is kept at every trace point of every device it crosses and can
+ * be followed end to end, and the same packets are kept on every run.
+ *
+ * The filter only reads the two protocol bytes at the start of the frame,
+ * so rejected frames are neither copied nor serialized.
+ */
+class WpppCaptureFilter
+{
+public:
+  /**
+   * Create a filter that accepts every frame
+   */
+  WpppCaptureFilter ();
+
+  /**
+   * \brief Only trace while the device is aligned with a device of the
+   * other node of one of the added pairs.  The order of the nodes does not
+   * matter.
+   * \param nodeA id of one node of the pair
+   * \param nodeB id of the other node of the pair
+   */
+  void AddPeerPair (uint32_t nodeA, uint32_t nodeB);
+
+  /**
+   * \brief Only trace frames carrying one of the added protocols
+   * \param protocol PPP protocol number, as in WpppHeader (e.g. 0x0021 for
+   *        IPv4)
+   */
+  void AddProtocol (uint16_t protocol);
+
+  /**
+   * \brief Only trace frames in [start, stop)
+   */
+  void SetTimeWindow (Time start, Time stop);
+
+  /**
+   * \brief Keep the frames of one in n packets among those that pass the
+   * other criteria, chosen by packet uid
+   */
+  void SetSampling (uint32_t n);
+
+  /**
+   * \return true if the filter accepts every frame
+   */
+  bool IsEmpty (void) const;
+
+  /**
+   * \brief Decide whether to trace a frame
+   * \param device device the frame is seen on
+   * \param p the frame, starting with its WpppHeader
+   * \return true if the frame is to be traced
+   */
+  bool Accept (Ptr<const WirelessPointToPointNetDevice> device, Ptr<const Packet> p) const;
+
+private:
+  std::vector<uint64_t> m_pairs;      //!< Sorted peer pair keys
+  std::vector<uint16_t> m_protocols;  //!< Accepted protocols
+  int64_t m_start;                    //!< Start of the window in ns
+  int64_t m_stop;                     //!< End of the window in ns
+  uint32_t m_sampling;                //!< Keep one in m_sampling packets
+};
+
+} // namespace ns3
+
+#endif /* WPPP_CAPTURE_FILTER_H */
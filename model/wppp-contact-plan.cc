@@ -0,0 +1,275 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 University of North Carolina at Chapel Hill
+ * Author: Ben Newton
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/assert.h"
+#include "wppp-contact-plan.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("WpppContactPlan");
+
+const uint32_t WpppContactPlanEntry::NO_DEVICE;
+
+namespace {
+
+const char WPPP_CONTACT_PLAN_MAGIC[8] = { 'W', 'P', 'P', 'P', 'C', 'P', '1', '\n' };
+const uint32_t WPPP_CONTACT_PLAN_RECORD_SIZE = 25;  //8+1+4+4+4+4
+const uint32_t WPPP_CONTACT_PLAN_BUFFER_SIZE = 1 << 20;
+
+void
+PutU32 (uint8_t *buf, uint32_t v)
+{
+  buf[0] = v & 0xff;
+  buf[1] = (v >> 8) & 0xff;
+  buf[2] = (v >> 16) & 0xff;
+  buf[3] = (v >> 24) & 0xff;
+}
+
+uint32_t
+GetU32 (const uint8_t *buf)
+{
+  return uint32_t (buf[0]) | (uint32_t (buf[1]) << 8) |
+    (uint32_t (buf[2]) << 16) | (uint32_t (buf[3]) << 24);
+}
+
+} // anonymous namespace
+
+WpppContactPlanReader::WpppContactPlanReader ()
+  : m_binary (false),
+    m_line (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+WpppContactPlanReader::~WpppContactPlanReader ()
+{
+  NS_LOG_FUNCTION (this);
+  Close ();
+}
+
+bool
+WpppContactPlanReader::Open (std::string filename)
+{
+  NS_LOG_FUNCTION (this << filename);
+  Close ();
+  m_buffer.resize (WPPP_CONTACT_PLAN_BUFFER_SIZE);
+  //the buffer has to be installed before the file is opened to take effect
+  m_file.rdbuf ()->pubsetbuf (&m_buffer[0], m_buffer.size ());
+  m_file.open (filename.c_str (), std::ios::in | std::ios::binary);
+  if (!m_file.is_open ())
+    {
+      return false;
+    }
+
+  char magic[sizeof (WPPP_CONTACT_PLAN_MAGIC)];
+  m_file.read (magic, sizeof (magic));
+  if (m_file.gcount () == sizeof (magic) &&
+      std::memcmp (magic, WPPP_CONTACT_PLAN_MAGIC, sizeof (magic)) == 0)
+    {
+      m_binary = true;
+    }
+  else
+    {
+      m_binary = false;
+      m_file.clear ();
+      m_file.seekg (0, std::ios::beg);
+    }
+  m_line = 0;
+  return true;
+}
+
+bool
+WpppContactPlanReader::IsBinary (void) const
+{
+  return m_binary;
+}
+
+void
+WpppContactPlanReader::Close (void)
+{
+  if (m_file.is_open ())
+    {
+      m_file.close ();
+    }
+  m_file.clear ();
+}
+
+bool
+WpppContactPlanReader::Next (WpppContactPlanEntry &entry)
+{
+  if (!m_file.is_open ())
+    {
+      return false;
+    }
+  return m_binary ? NextBinary (entry) : NextCsv (entry);
+}
+
+bool
+WpppContactPlanReader::NextBinary (WpppContactPlanEntry &entry)
+{
+  uint8_t rec[WPPP_CONTACT_PLAN_RECORD_SIZE];
+  m_file.read (reinterpret_cast<char *> (rec), sizeof (rec));
+  if (m_file.gcount () != sizeof (rec))
+    {
+      NS_ABORT_MSG_IF (m_file.gcount () != 0,
+                       "Truncated record at the end of the contact plan");
+      return false;
+    }
+  uint64_t t = uint64_t (GetU32 (rec)) | (uint64_t (GetU32 (rec + 4)) << 32);
+  entry.time = static_cast<int64_t> (t);
+  entry.action = rec[8];
+  entry.nodeA = GetU32 (rec + 9);
+  entry.devA = GetU32 (rec + 13);
+  entry.nodeB = GetU32 (rec + 17);
+  entry.devB = GetU32 (rec + 21);
+  return true;
+}
+
+bool
+WpppContactPlanReader::NextCsv (WpppContactPlanEntry &entry)
+{
+  std::string line;
+  while (std::getline (m_file, line))
+    {
+      m_line++;
+      std::string::size_type start = line.find_first_not_of (" \t\r");
+      if (start == std::string::npos || line[start] == '#')
+        {
+          continue;
+        }
+
+      std::vector<std::string> fields;
+      std::istringstream iss (line.substr (start));
+      std::string field;
+      while (std::getline (iss, field, ','))
+        {
+          std::string::size_type b = field.find_first_not_of (" \t\r");
+          std::string::size_type e = field.find_last_not_of (" \t\r");
+          fields.push_back (b == std::string::npos ? "" : field.substr (b, e - b + 1));
+        }
+      NS_ABORT_MSG_IF (fields.size () != 5 && fields.size () != 6,
+                       "Malformed contact plan line " << m_line << ": " << line);
+
+      entry.time = static_cast<int64_t> (std::floor (std::atof (fields[0].c_str ()) * 1e9 + 0.5));
+      const std::string &action = fields[1];
+      if (action == "connect" || action == "up" || action == "1")
+        {
+          entry.action = WpppContactPlanEntry::CONNECT;
+        }
+      else if (action == "disconnect" || action == "down" || action == "0")
+        {
+          entry.action = WpppContactPlanEntry::DISCONNECT;
+        }
+      else
+        {
+          NS_FATAL_ERROR ("Unknown action '" << action << "' on contact plan line " << m_line);
+        }
+      entry.nodeA = std::strtoul (fields[2].c_str (), 0, 10);
+      entry.devA = std::strtoul (fields[3].c_str (), 0, 10);
+      entry.nodeB = std::strtoul (fields[4].c_str (), 0, 10);
+      entry.devB = WpppContactPlanEntry::NO_DEVICE;
+      if (fields.size () == 6 && !fields[5].empty ())
+        {
+          entry.devB = std::strtoul (fields[5].c_str (), 0, 10);
+        }
+      return true;
+    }
+  return false;
+}
+
+WpppContactPlanWriter::WpppContactPlanWriter ()
+  : m_binary (false),
+    m_lastTime (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+WpppContactPlanWriter::~WpppContactPlanWriter ()
+{
+  NS_LOG_FUNCTION (this);
+  Close ();
+}
+
+bool
+WpppContactPlanWriter::Open (std::string filename, bool binary)
+{
+  NS_LOG_FUNCTION (this << filename << binary);
+  Close ();
+  m_buffer.resize (WPPP_CONTACT_PLAN_BUFFER_SIZE);
+  m_file.rdbuf ()->pubsetbuf (&m_buffer[0], m_buffer.size ());
+  m_file.open (filename.c_str (), std::ios::out | std::ios::trunc | std::ios::binary);
+  if (!m_file.is_open ())
+    {
+      return false;
+    }
+  m_binary = binary;
+  m_lastTime = 0;
+  if (m_binary)
+    {
+      m_file.write (WPPP_CONTACT_PLAN_MAGIC, sizeof (WPPP_CONTACT_PLAN_MAGIC));
+    }
+  else
+    {
+      m_file << "# time_s,action,nodeA,devA,nodeB,devB" << std::endl;
+    }
+  return true;
+}
+
+void
+WpppContactPlanWriter::Write (const WpppContactPlanEntry &entry)
+{
+  NS_ASSERT_MSG (m_file.is_open (), "Contact plan writer is not open");
+  NS_ASSERT_MSG (entry.time >= m_lastTime, "Contact plan entries must be time ordered");
+  m_lastTime = entry.time;
+
+  if (m_binary)
+    {
+      uint8_t rec[WPPP_CONTACT_PLAN_RECORD_SIZE];
+      uint64_t t = static_cast<uint64_t> (entry.time);
+      PutU32 (rec, t & 0xffffffff);
+      PutU32 (rec + 4, t >> 32);
+      rec[8] = entry.action;
+      PutU32 (rec + 9, entry.nodeA);
+      PutU32 (rec + 13, entry.devA);
+      PutU32 (rec + 17, entry.nodeB);
+      PutU32 (rec + 21, entry.devB);
+      m_file.write (reinterpret_cast<const char *> (rec), sizeof (rec));
+      return;
+    }
+
+  //nanosecond resolution so a CSV round trip is exact
+  int64_t secs = entry.time / 1000000000;
+  int64_t nanos = entry.time % 1000000000;
+  char frac[16];
+  std::sprintf (frac, "%09ld", static_cast<long> (nanos));
+  m_file << secs << "." << frac << ","
+         << (entry.action == WpppContactPlanEntry::CONNECT ? "connect" : "disconnect")
+         << "," << entry.nodeA << "," << entry.devA << "," << entry.nodeB << ",";
+  if (entry.devB != WpppContactPlanEntry::NO_DEVICE)
+    {
+      m_file << entry.devB;
+    }
+  m_file << "\n";
+}
+
+void
+WpppContactPlanWriter::Close (void)
+{
+  if (m_file.is_open ())
+    {
+      m_file.close ();
+    }
+  m_file.clear ();
+}
+
+} // namespace ns3
@@ -0,0 +1,148 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 University of North Carolina at Chapel Hill
+ * Author: Ben Newton
+ */
+
+#ifndef WPPP_CONTACT_PLAN_H
+#define WPPP_CONTACT_PLAN_H
+
+#include <stdint.h>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "ns3/simple-ref-count.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup wireless-point-to-point
+ * \brief One entry of a contact plan
+ *
+ * A contact plan is a time ordered list of alignment changes between pairs
+ * of WirelessPointToPointNetDevices.  Devices are identified by node id and
+ * the index of the device on its node (the index accepted by
+ * Node::GetDevice).  A CONNECT entry points devA on nodeA at nodeB and devB
+ * on nodeB at nodeA; a DISCONNECT entry undoes it.  If devB is NO_DEVICE
+ * only the nodeA side is changed, which leaves a one way connection.
+ */
+struct WpppContactPlanEntry
+{
+  /**
+   * Kind of alignment change
+   */
+  enum Action
+  {
+    CONNECT = 0,    /**< Align the two devices */
+    DISCONNECT = 1  /**< Break the alignment between the two devices */
+  };
+
+  static const uint32_t NO_DEVICE = 0xffffffff; //!< Only change the A side
+
+  int64_t time;      //!< Time of the change in nanoseconds
+  uint8_t action;    //!< One of Action
+  uint32_t nodeA;    //!< Node id of the first endpoint
+  uint32_t devA;     //!< Device index of the first endpoint on nodeA
+  uint32_t nodeB;    //!< Node id of the second endpoint
+  uint32_t devB;     //!< Device index of the second endpoint on nodeB
+};
+
+/**
+ * \ingroup wireless-point-to-point
+ * \brief Streaming reader for contact plan files
+ *
+ * Two formats are understood.  The binary format starts with the eight byte
+ * magic "WPPPCP1\n" followed by fixed size little endian records of 25 bytes
+ * (int64 time in ns, uint8 action, then nodeA, devA, nodeB and devB as
+ * uint32).  Anything else is parsed as CSV with one entry per line:
+ *
+ *   time_seconds,action,nodeA,devA,nodeB[,devB]
+ *
+ * where action is "connect"/"up"/"1" or "disconnect"/"down"/"0".  Blank
+ * lines and lines starting with '#' are ignored.
+ *
+ * The file is read sequentially through a large buffer, so only the entry
+ * being returned is held in memory regardless of the plan size.
+ */
+class WpppContactPlanReader : public SimpleRefCount<WpppContactPlanReader>
+{
+public:
+  WpppContactPlanReader ();
+  ~WpppContactPlanReader ();
+
+  /**
+   * \brief Open a contact plan file, detecting its format
+   * \param filename path of the plan
+   * \return true if the file could be opened
+   */
+  bool Open (std::string filename);
+
+  /**
+   * \brief Read the next entry of the plan
+   * \param entry filled with the next entry
+   * \return false once the end of the plan is reached
+   */
+  bool Next (WpppContactPlanEntry &entry);
+
+  /**
+   * \return true if the opened plan is in the binary format
+   */
+  bool IsBinary (void) const;
+
+  /**
+   * \brief Close the underlying file
+   */
+  void Close (void);
+
+private:
+  bool NextBinary (WpppContactPlanEntry &entry);
+  bool NextCsv (WpppContactPlanEntry &entry);
+
+  std::ifstream m_file;             //!< Plan being read
+  std::vector<char> m_buffer;       //!< Stream buffer for m_file
+  bool m_binary;                    //!< Format of the plan
+  uint64_t m_line;                  //!< Current line, for CSV diagnostics
+};
+
+/**
+ * \ingroup wireless-point-to-point
+ * \brief Writer for contact plan files
+ *
+ * Produces either of the formats understood by WpppContactPlanReader.
+ * Entries must be written in non-decreasing time order.
+ */
+class WpppContactPlanWriter : public SimpleRefCount<WpppContactPlanWriter>
+{
+public:
+  WpppContactPlanWriter ();
+  ~WpppContactPlanWriter ();
+
+  /**
+   * \brief Create (truncate) a contact plan file
+   * \param filename path of the plan
+   * \param binary write the compact binary format if true, CSV otherwise
+   * \return true if the file could be opened
+   */
+  bool Open (std::string filename, bool binary);
+
+  /**
+   * \brief Append one entry to the plan
+   * \param entry the entry to write
+   */
+  void Write (const WpppContactPlanEntry &entry);
+
+  /**
+   * \brief Flush and close the underlying file
+   */
+  void Close (void);
+
+private:
+  std::ofstream m_file;             //!< Plan being written
+  std::vector<char> m_buffer;       //!< Stream buffer for m_file
+  bool m_binary;                    //!< Format of the plan
+  int64_t m_lastTime;               //!< Time of the last written entry
+};
+
+} // namespace ns3
+
+#endif /* WPPP_CONTACT_PLAN_H */
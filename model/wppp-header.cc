@@ -18,7 +18,14 @@ NS_LOG_COMPONENT_DEFINE ("WpppHeader");
 
 NS_OBJECT_ENSURE_REGISTERED (WpppHeader);
 
+const uint16_t WpppHeader::LABEL_PROTOCOL;
+const uint16_t WpppHeader::SOURCE_ROUTE_PROTOCOL;
+
 WpppHeader::WpppHeader ()
+  : m_protocol (0),
+    m_label (0),
+    m_labelTtl (0),
+    m_payloadProtocol (0)
 {
 }
 
@@ -56,16 +63,50 @@ WpppHeader::Print (std::ostream &os) const
     case 0x0057: /* IPv6 */
       proto = "IPv6 (0x0057)";
       break;
+    case LABEL_PROTOCOL:
+      proto = "MPLS (0x0281)";
+      break;
+    case SOURCE_ROUTE_PROTOCOL:
+      proto = "Source route (0x4303)";
+      break;
+    case ARP_PROTOCOL:
+      proto = "ARP (0x4301)";
+      break;
     default:
       NS_ASSERT_MSG (false, "PPP Protocol number not defined!");
     }
   os << "Point-to-Point Protocol: " << proto; 
+  if (IsLabeled ())
+    {
+      os << " label " << m_label << " ttl " << uint32_t (m_labelTtl);
+    }
+  if (IsSourceRouted ())
+    {
+      os << " hops";
+      for (uint32_t i = 0; i < m_hops.size (); i++)
+        {
+          os << " " << uint32_t (m_hops[i]);
+        }
+    }
+  if (IsLabeled () || IsSourceRouted ())
+    {
+      os << " payload 0x" << std::hex << m_payloadProtocol << std::dec;
+    }
 }
 
 uint32_t
 WpppHeader::GetSerializedSize (void) const
 {
-  return 14; //2+6+6;
+  //2+6+6, and a label stack entry or the hops, and the payload protocol
+  if (IsLabeled ())
+    {
+      return 20;
+    }
+  if (IsSourceRouted ())
+    {
+      return 17 + m_hops.size ();
+    }
+  return 14;
 }
 
 void
@@ -74,6 +115,21 @@ WpppHeader::Serialize (Buffer::Iterator start) const
   start.WriteHtonU16 (m_protocol);
   WriteTo (start, m_addr1);
   WriteTo (start, m_addr2);
+  if (IsLabeled ())
+    {
+      //label, traffic class 0, bottom of stack, ttl
+      start.WriteHtonU32 ((m_label << 12) | 0x100 | m_labelTtl);
+      start.WriteHtonU16 (m_payloadProtocol);
+    }
+  else if (IsSourceRouted ())
+    {
+      start.WriteU8 (m_hops.size ());
+      for (uint32_t i = 0; i < m_hops.size (); i++)
+        {
+          start.WriteU8 (m_hops[i]);
+        }
+      start.WriteHtonU16 (m_payloadProtocol);
+    }
 }
 
 uint32_t
@@ -82,6 +138,22 @@ WpppHeader::Deserialize (Buffer::Iterator start)
   m_protocol = start.ReadNtohU16 ();
   ReadFrom (start, m_addr1);
   ReadFrom (start, m_addr2);
+  if (IsLabeled ())
+    {
+      uint32_t entry = start.ReadNtohU32 ();
+      m_label = entry >> 12;
+      m_labelTtl = entry & 0xff;
+      m_payloadProtocol = start.ReadNtohU16 ();
+    }
+  else if (IsSourceRouted ())
+    {
+      m_hops.resize (start.ReadU8 ());
+      for (uint32_t i = 0; i < m_hops.size (); i++)
+        {
+          m_hops[i] = start.ReadU8 ();
+        }
+      m_payloadProtocol = start.ReadNtohU16 ();
+    }
   return GetSerializedSize ();
 }
 
@@ -97,6 +169,70 @@ WpppHeader::GetProtocol (void)
   return m_protocol;
 }
 
+void
+WpppHeader::SetLabel (uint32_t label, uint8_t ttl, uint16_t protocol)
+{
+  NS_ASSERT_MSG (label < (1 << 20), "Labels have 20 bits");
+  m_protocol = LABEL_PROTOCOL;
+  m_label = label;
+  m_labelTtl = ttl;
+  m_payloadProtocol = protocol;
+}
+
+bool
+WpppHeader::IsLabeled (void) const
+{
+  return m_protocol == LABEL_PROTOCOL;
+}
+
+uint32_t
+WpppHeader::GetLabel (void) const
+{
+  return m_label;
+}
+
+uint8_t
+WpppHeader::GetLabelTtl (void) const
+{
+  return m_labelTtl;
+}
+
+void
+WpppHeader::SetSourceRoute (const std::vector<uint8_t> &hops, uint16_t protocol)
+{
+  NS_ASSERT_MSG (hops.size () < 256, "At most 255 hops");
+  m_protocol = SOURCE_ROUTE_PROTOCOL;
+  m_hops = hops;
+  m_payloadProtocol = protocol;
+}
+
+bool
+WpppHeader::IsSourceRouted (void) const
+{
+  return m_protocol == SOURCE_ROUTE_PROTOCOL;
+}
+
+const std::vector<uint8_t> &
+WpppHeader::GetSourceRoute (void) const
+{
+  return m_hops;
+}
+
+uint8_t
+WpppHeader::PopHop (void)
+{
+  NS_ASSERT (!m_hops.empty ());
+  uint8_t hop = m_hops.front ();
+  m_hops.erase (m_hops.begin ());
+  return hop;
+}
+
+uint16_t
+WpppHeader::GetPayloadProtocol (void) const
+{
+  return IsLabeled () || IsSourceRouted () ? m_payloadProtocol : m_protocol;
+}
+
 void
 WpppHeader::SetAddr1 (Mac48Address address)
 {
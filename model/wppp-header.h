@@ -7,6 +7,7 @@
 #ifndef WPPP_HEADER_H
 #define WPPP_HEADER_H
 
+#include <vector>
 #include "ns3/header.h"
 #include "ns3/mac48-address.h"
 
@@ -86,6 +87,87 @@ public:
    */
   uint16_t GetProtocol (void);
 
+  /**
+   * PPP protocol number of a labeled frame, that of MPLS unicast
+   */
+  static const uint16_t LABEL_PROTOCOL = 0x0281;
+
+  /**
+   * \brief Label the frame for switching by WpppLabelTable
+   *
+   * Sets the protocol to LABEL_PROTOCOL and adds a label stack entry in the
+   * format of \RFC{3032}, followed by the protocol of the payload, to the
+   * header.
+   *
+   * \param label the label, of 20 bits
+   * \param ttl hops the frame may still be switched
+   * \param protocol the PPP protocol type of the payload
+   */
+  void SetLabel (uint32_t label, uint8_t ttl, uint16_t protocol);
+
+  /**
+   * \return true if the frame is labeled
+   */
+  bool IsLabeled (void) const;
+
+  /**
+   * \return the label of a labeled frame
+   */
+  uint32_t GetLabel (void) const;
+
+  /**
+   * \return the hops a labeled frame may still be switched
+   */
+  uint8_t GetLabelTtl (void) const;
+
+  /**
+   * PPP protocol number of a source routed frame, from the range left to
+   * low volume protocols; like every PPP protocol number, its low octet is
+   * odd and its high octet even
+   */
+  static const uint16_t SOURCE_ROUTE_PROTOCOL = 0x4303;
+
+  /**
+   * PPP protocol number of ARP frames, next to SOURCE_ROUTE_PROTOCOL; PPP
+   * itself has no ARP, but a WpppMultiBeamNetDevice reaches several
+   * neighbors through one interface and resolves them with ARP
+   */
+  static const uint16_t ARP_PROTOCOL = 0x4301;
+
+  /**
+   * \brief Give the frame the route it is to follow
+   *
+   * Sets the protocol to SOURCE_ROUTE_PROTOCOL and adds the number of hops,
+   * the hops, one byte each, and the protocol of the payload to the header.
+   *
+   * \param hops interface index of the device each relay sends the frame
+   *        on, the next relay first; at most 255
+   * \param protocol the PPP protocol type of the payload
+   */
+  void SetSourceRoute (const std::vector<uint8_t> &hops, uint16_t protocol);
+
+  /**
+   * \return true if the frame is source routed
+   */
+  bool IsSourceRouted (void) const;
+
+  /**
+   * \return the hops left of a source routed frame, the next first
+   */
+  const std::vector<uint8_t> &GetSourceRoute (void) const;
+
+  /**
+   * \brief Remove the next hop of a source routed frame
+   * \return the interface index the frame is to be sent on
+   */
+  uint8_t PopHop (void);
+
+  /**
+   * \return the PPP protocol type of the payload: that of the frame, or
+   *          the one carried after the label or the route
+   */
+  uint16_t GetPayloadProtocol (void) const;
+
   /**
    * Fill the Address 1 field with the given address.
    *
@@ -120,6 +202,10 @@ private:
   uint16_t m_protocol;
   Mac48Address m_addr1;
   Mac48Address m_addr2;
+  uint32_t m_label;            //!< Label of a labeled frame
+  uint8_t m_labelTtl;          //!< TTL of a labeled frame
+  uint16_t m_payloadProtocol;  //!< PPP protocol type of the payload of a labeled or source routed frame
+  std::vector<uint8_t> m_hops; //!< Hops left of a source routed frame
 };
 
 } // namespace ns3
@@ -0,0 +1,159 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 University of North Carolina at Chapel Hill
+ * Author: Ben Newton
+ */
+
+#include <algorithm>
+#include "ns3/log.h"
+#include "ns3/uinteger.h"
+#include "wppp-label-table.h"
+#include "wireless-point-to-point-net-device.h"
+#include "wppp-multi-beam-net-device.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("WpppLabelTable");
+
+NS_OBJECT_ENSURE_REGISTERED (WpppLabelTable);
+
+TypeId
+WpppLabelTable::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::WpppLabelTable")
+    .SetParent<Object> ()
+    .SetGroupName ("WirelessPointToPoint")
+    .AddConstructor<WpppLabelTable> ()
+    .AddAttribute ("Ttl",
+                   "Hops a frame labeled by Send may be switched before it is "
+                   "dropped, against loops in the tables.",
+                   UintegerValue (64),
+                   MakeUintegerAccessor (&WpppLabelTable::m_ttl),
+                   MakeUintegerChecker<uint8_t> (1))
+  ;
+  return tid;
+}
+
+WpppLabelTable::WpppLabelTable ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+WpppLabelTable::~WpppLabelTable ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+WpppLabelTable::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_entries.clear ();
+  Object::DoDispose ();
+}
+
+Ptr<WpppLabelTable>
+WpppLabelTable::Install (Ptr<Node> node)
+{
+  Ptr<WpppLabelTable> table = node->GetObject<WpppLabelTable> ();
+  if (table != 0)
+    {
+      return table;
+    }
+  table = CreateObject<WpppLabelTable> ();
+  node->AggregateObject (table);
+  //called at once for the devices already there
+  node->RegisterDeviceAdditionListener (MakeCallback (&WpppLabelTable::DeviceAdded, table));
+  return table;
+}
+
+void
+WpppLabelTable::DeviceAdded (Ptr<NetDevice> device)
+{
+  NS_LOG_FUNCTION (this << device);
+  Ptr<WirelessPointToPointNetDevice> wppp = DynamicCast<WirelessPointToPointNetDevice> (device);
+  if (wppp != 0)
+    {
+      wppp->SetLabelTable (this);
+    }
+  //beams added later look the table up on the node themselves
+  Ptr<WpppMultiBeamNetDevice> multiBeam = DynamicCast<WpppMultiBeamNetDevice> (device);
+  if (multiBeam != 0)
+    {
+      for (uint32_t j = 0; j < multiBeam->GetNBeams (); j++)
+        {
+          multiBeam->GetBeam (j)->SetLabelTable (this);
+        }
+    }
+}
+
+WpppLabelTable::Entry &
+WpppLabelTable::GetEntry (uint32_t inLabel)
+{
+  NS_ASSERT_MSG (inLabel < (1 << 20), "Labels have 20 bits");
+  std::vector<Entry>::iterator it = std::lower_bound (m_entries.begin (), m_entries.end (), inLabel);
+  if (it == m_entries.end () || it->inLabel != inLabel)
+    {
+      it = m_entries.insert (it, Entry (inLabel));
+    }
+  return *it;
+}
+
+void
+WpppLabelTable::AddRoute (uint32_t inLabel, Ptr<WirelessPointToPointNetDevice> device, uint32_t outLabel)
+{
+  NS_LOG_FUNCTION (this << inLabel << device << outLabel);
+  NS_ASSERT (device != 0);
+  Entry &entry = GetEntry (inLabel);
+  entry.device = device;
+  entry.outLabel = outLabel;
+}
+
+void
+WpppLabelTable::AddLocal (uint32_t inLabel)
+{
+  NS_LOG_FUNCTION (this << inLabel);
+  Entry &entry = GetEntry (inLabel);
+  entry.device = 0;
+  entry.outLabel = 0;
+}
+
+void
+WpppLabelTable::RemoveRoute (uint32_t inLabel)
+{
+  NS_LOG_FUNCTION (this << inLabel);
+  std::vector<Entry>::iterator it = std::lower_bound (m_entries.begin (), m_entries.end (), inLabel);
+  if (it != m_entries.end () && it->inLabel == inLabel)
+    {
+      m_entries.erase (it);
+    }
+}
+
+bool
+WpppLabelTable::Lookup (uint32_t inLabel, Ptr<WirelessPointToPointNetDevice> &device,
+                        uint32_t &outLabel) const
+{
+  std::vector<Entry>::const_iterator it = std::lower_bound (m_entries.begin (), m_entries.end (), inLabel);
+  if (it == m_entries.end () || it->inLabel != inLabel)
+    {
+      return false;
+    }
+  device = it->device;
+  outLabel = it->outLabel;
+  return true;
+}
+
+bool
+WpppLabelTable::Send (Ptr<Packet> packet, uint32_t label, uint16_t protocolNumber)
+{
+  NS_LOG_FUNCTION (this << packet << label << protocolNumber);
+  Ptr<WirelessPointToPointNetDevice> device;
+  uint32_t outLabel;
+  if (!Lookup (label, device, outLabel) || device == 0)
+    {
+      return false;
+    }
+  return device->SendLabeled (packet, outLabel, m_ttl, protocolNumber);
+}
+
+} // namespace ns3
@@ -0,0 +1,150 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 University of North Carolina at Chapel Hill
+ * Author: Ben Newton
+ */
+
+#ifndef WPPP_LABEL_TABLE_H
+#define WPPP_LABEL_TABLE_H
+
+#include <vector>
+#include "ns3/object.h"
+#include "ns3/ptr.h"
+#include "ns3/node.h"
+#include "ns3/packet.h"
+
+namespace ns3 {
+
+class WirelessPointToPointNetDevice;
+
+/**
+ * \ingroup wireless-point-to-point
+ * \brief Label switching table of a node
+ *
+ * Maps the label of an incoming frame to the device it leaves on and the
+ * label it leaves with, or to local delivery.  The wppp devices of a node
+ * with a table switch labeled frames between themselves as they are
+ * received, without handing them up to the node: a relay costs one table
+ * lookup per frame and no IP processing.  Frames are labeled where they
+ * enter a path with Send.
+ *
+ * Labels are any 20-bit values chosen by whoever sets up the paths; the
+ * table keeps its entries sorted by label and looks them up by binary
+ * search, so its size follows the number of routes, not the largest label.
+ */
+class WpppLabelTable : public Object
+{
+public:
+  /**
+   * \brief Get the TypeId
+   *
+   * \return The TypeId for this class
+   */
+  static TypeId GetTypeId (void);
+
+  WpppLabelTable ();
+  virtual ~WpppLabelTable ();
+
+  /**
+   * \brief Get the table of a node, creating it and handing it to the wppp
+   * devices and beams of the node if it has none
+   *
+   * Devices added to the node later get the table too, and so do beams
+   * added later to a multi-beam device of the node.
+   *
+   * \param node the node
+   * \returns the table of the node
+   */
+  static Ptr<WpppLabelTable> Install (Ptr<Node> node);
+
+  /**
+   * \brief Switch the frames labeled inLabel to a device
+   * \param inLabel label of the incoming frames
+   * \param device device of this node the frames leave on
+   * \param outLabel label the frames leave with
+   */
+  void AddRoute (uint32_t inLabel, Ptr<WirelessPointToPointNetDevice> device, uint32_t outLabel);
+
+  /**
+   * \brief Hand the frames labeled inLabel up to this node, unlabeled
+   * \param inLabel label of the incoming frames
+   */
+  void AddLocal (uint32_t inLabel);
+
+  /**
+   * \brief Forget what to do with the frames labeled inLabel; they are
+   * dropped from then on
+   * \param inLabel label of the incoming frames
+   */
+  void RemoveRoute (uint32_t inLabel);
+
+  /**
+   * \brief Send a packet along the path of a label
+   * \param packet the packet
+   * \param label the label of the path, looked up in this table
+   * \param protocolNumber Ethernet protocol number of the packet
+   * \returns false if the label leads nowhere or the device refused the
+   *          packet
+   */
+  bool Send (Ptr<Packet> packet, uint32_t label, uint16_t protocolNumber);
+
+  /**
+   * \brief Look up the label of an incoming frame
+   * \param inLabel the label
+   * \param device set to the device the frame leaves on, or 0 if the frame
+   *        is for this node
+   * \param outLabel set to the label the frame leaves with
+   * \returns false if there is no entry for the label
+   */
+  bool Lookup (uint32_t inLabel, Ptr<WirelessPointToPointNetDevice> &device, uint32_t &outLabel) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /**
+   * Where frames with a given label go
+   */
+  struct Entry
+  {
+    /**
+     * \param label incoming label
+     */
+    Entry (uint32_t label)
+      : inLabel (label),
+        outLabel (0)
+    {
+    }
+
+    /**
+     * \param label an incoming label
+     * \returns true if this entry sorts before the label
+     */
+    bool operator< (uint32_t label) const
+    {
+      return inLabel < label;
+    }
+
+    uint32_t inLabel;                            //!< Incoming label
+    Ptr<WirelessPointToPointNetDevice> device;   //!< Outgoing device, or 0 for local delivery
+    uint32_t outLabel;                           //!< Outgoing label
+  };
+
+  /**
+   * \returns the entry of a label, inserted into the table if needed
+   */
+  Entry &GetEntry (uint32_t inLabel);
+
+  /**
+   * \brief Hand this table to a device added to the node, or to its beams
+   * \param device the device
+   */
+  void DeviceAdded (Ptr<NetDevice> device);
+
+  std::vector<Entry> m_entries;  //!< Entries sorted by incoming label
+  uint8_t m_ttl;                 //!< TTL of the frames labeled by Send
+};
+
+} // namespace ns3
+
+#endif /* WPPP_LABEL_TABLE_H */
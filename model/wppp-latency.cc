@@ -0,0 +1,260 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 University of North Carolina at Chapel Hill
+ * Author: Ben Newton
+ */
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include "wppp-latency.h"
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (WpppTimestampTag);
+
+WpppTimestampTag::WpppTimestampTag ()
+  : srcNode (0),
+    srcIfIndex (0),
+    enqueueTime (0),
+    txStartTime (0),
+    txTime (0)
+{
+}
+
+TypeId
+WpppTimestampTag::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::WpppTimestampTag")
+    .SetParent<Tag> ()
+    .SetGroupName ("WirelessPointToPoint")
+    .AddConstructor<WpppTimestampTag> ()
+  ;
+  return tid;
+}
+
+TypeId
+WpppTimestampTag::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+
+uint32_t
+WpppTimestampTag::GetSerializedSize (void) const
+{
+  return 4 + 4 + 8 + 8 + 8;
+}
+
+void
+WpppTimestampTag::Serialize (TagBuffer i) const
+{
+  i.WriteU32 (srcNode);
+  i.WriteU32 (srcIfIndex);
+  i.WriteU64 (enqueueTime);
+  i.WriteU64 (txStartTime);
+  i.WriteU64 (txTime);
+}
+
+void
+WpppTimestampTag::Deserialize (TagBuffer i)
+{
+  srcNode = i.ReadU32 ();
+  srcIfIndex = i.ReadU32 ();
+  enqueueTime = i.ReadU64 ();
+  txStartTime = i.ReadU64 ();
+  txTime = i.ReadU64 ();
+}
+
+void
+WpppTimestampTag::Print (std::ostream &os) const
+{
+  os << "src=" << srcNode << "/" << srcIfIndex
+     << " enqueue=" << enqueueTime << "ns txStart=" << txStartTime
+     << "ns txTime=" << txTime << "ns";
+}
+
+WpppLatencyHistogram::WpppLatencyHistogram ()
+  : m_count (0),
+    m_sum (0),
+    m_max (0)
+{
+}
+
+uint32_t
+WpppLatencyHistogram::GetIndex (uint64_t value)
+{
+  if (value < (1u << SUB_BUCKET_BITS))
+    {
+      return value;
+    }
+  //position of the leading one
+  uint32_t bit = 0;
+  uint64_t x = value;
+  for (uint32_t step = 32; step > 0; step >>= 1)
+    {
+      if (x >> step)
+        {
+          x >>= step;
+          bit += step;
+        }
+    }
+  uint32_t shift = bit - (SUB_BUCKET_BITS - 1);
+  return (shift << (SUB_BUCKET_BITS - 1)) + (value >> shift);
+}
+
+uint64_t
+WpppLatencyHistogram::GetUpperEdge (uint32_t index)
+{
+  if (index < (1u << SUB_BUCKET_BITS))
+    {
+      return index;
+    }
+  uint32_t shift = (index >> (SUB_BUCKET_BITS - 1)) - 1;
+  uint64_t mantissa = index - (shift << (SUB_BUCKET_BITS - 1));
+  return ((mantissa + 1) << shift) - 1;
+}
+
+void
+WpppLatencyHistogram::Record (int64_t ns)
+{
+  uint64_t value = ns > 0 ? ns : 0;
+  uint32_t index = GetIndex (value);
+  if (index >= m_buckets.size ())
+    {
+      m_buckets.resize (index + 1, 0);
+    }
+  m_buckets[index]++;
+  m_count++;
+  m_sum += value;
+  m_max = std::max (m_max, value);
+}
+
+void
+WpppLatencyHistogram::Merge (const WpppLatencyHistogram &other)
+{
+  if (other.m_buckets.size () > m_buckets.size ())
+    {
+      m_buckets.resize (other.m_buckets.size (), 0);
+    }
+  for (uint32_t i = 0; i < other.m_buckets.size (); i++)
+    {
+      m_buckets[i] += other.m_buckets[i];
+    }
+  m_count += other.m_count;
+  m_sum += other.m_sum;
+  m_max = std::max (m_max, other.m_max);
+}
+
+void
+WpppLatencyHistogram::Reset (void)
+{
+  m_buckets.clear ();
+  m_count = 0;
+  m_sum = 0;
+  m_max = 0;
+}
+
+uint64_t
+WpppLatencyHistogram::GetCount (void) const
+{
+  return m_count;
+}
+
+uint64_t
+WpppLatencyHistogram::GetMax (void) const
+{
+  return m_max;
+}
+
+double
+WpppLatencyHistogram::GetMean (void) const
+{
+  if (m_count == 0)
+    {
+      return 0;
+    }
+  return double (m_sum) / m_count;
+}
+
+uint64_t
+WpppLatencyHistogram::GetPercentile (double q) const
+{
+  if (m_count == 0)
+    {
+      return 0;
+    }
+  //rank of the value, counting from 1
+  uint64_t rank = std::max<uint64_t> (1, uint64_t (q * m_count + 0.5));
+  uint64_t seen = 0;
+  for (uint32_t i = 0; i < m_buckets.size (); i++)
+    {
+      seen += m_buckets[i];
+      if (seen >= rank)
+        {
+          return std::min (GetUpperEdge (i), m_max);
+        }
+    }
+  return m_max;
+}
+
+uint64_t
+WpppLatencyHistogram::GetMemoryUsage (void) const
+{
+  return m_buckets.capacity () * sizeof (uint64_t);
+}
+
+void
+WpppLatencyHistogram::Write (std::ostream &os) const
+{
+  os << m_count << " " << m_sum << " " << m_max;
+  for (uint32_t i = 0; i < m_buckets.size (); i++)
+    {
+      if (m_buckets[i] != 0)
+        {
+          os << " " << i << ":" << m_buckets[i];
+        }
+    }
+}
+
+bool
+WpppLatencyHistogram::Read (std::istream &is)
+{
+  Reset ();
+  std::string line;
+  if (!std::getline (is, line))
+    {
+      return false;
+    }
+  std::istringstream in (line);
+  if (!(in >> m_count >> m_sum >> m_max))
+    {
+      Reset ();
+      return false;
+    }
+  uint32_t index;
+  char colon;
+  uint64_t count;
+  uint64_t total = 0;
+  while (in >> index >> colon >> count)
+    {
+      if (colon != ':' || index > GetIndex (~uint64_t (0)))
+        {
+          Reset ();
+          return false;
+        }
+      if (index >= m_buckets.size ())
+        {
+          m_buckets.resize (index + 1, 0);
+        }
+      m_buckets[index] += count;
+      total += count;
+    }
+  if (!in.eof () || total != m_count)
+    {
+      Reset ();
+      return false;
+    }
+  return true;
+}
+
+} // namespace ns3
@@ -0,0 +1,165 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 University of North Carolina at Chapel Hill
+ * Author: Ben Newton
+ */
+
+#ifndef WPPP_LATENCY_H
+#define WPPP_LATENCY_H
+
+#include <stdint.h>
+#include <istream>
+#include <ostream>
+#include <vector>
+#include "ns3/tag.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup wireless-point-to-point
+ * \brief Packet tag carrying the send times of a frame across one link
+ *
+ * Added when the sending device queues the frame and completed when it
+ * starts transmitting; the receiving device removes it, so it never
+ * travels further than one hop.
+ */
+class WpppTimestampTag : public Tag
+{
+public:
+  WpppTimestampTag ();
+
+  /**
+   * \brief Get the TypeId
+   *
+   * \return The TypeId for this class
+   */
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual uint32_t GetSerializedSize (void) const;
+  virtual void Serialize (TagBuffer i) const;
+  virtual void Deserialize (TagBuffer i);
+  virtual void Print (std::ostream &os) const;
+
+  uint32_t srcNode;      //!< Node id of the sending device
+  uint32_t srcIfIndex;   //!< Interface index of the sending device
+  int64_t enqueueTime;   //!< When the frame was queued, in ns
+  int64_t txStartTime;   //!< When the transmission started, in ns
+  int64_t txTime;        //!< Duration of the transmission, in ns
+};
+
+/**
+ * \ingroup wireless-point-to-point
+ * \brief Log-linear histogram of nanosecond latencies
+ *
+ * Values below 2^SUB_BUCKET_BITS have a bucket each; above that every
+ * power of two is split into 2^(SUB_BUCKET_BITS - 1) buckets, so any
+ * percentile is within about 3% of the recorded value whatever the range.
+ * Recording is a few shifts and an increment, and buckets are allocated up
+ * to the largest value seen only.
+ *
+ * Histograms of the same link recorded on different ranks or runs are
+ * combined with Merge; Write and Read carry the bucket counts through a
+ * text file for that.
+ */
+class WpppLatencyHistogram
+{
+public:
+  WpppLatencyHistogram ();
+
+  /**
+   * \brief Record one value
+   * \param ns the latency in nanoseconds; negative values count as 0
+   */
+  void Record (int64_t ns);
+
+  /**
+   * \brief Add the counts of another histogram to this one
+   */
+  void Merge (const WpppLatencyHistogram &other);
+
+  /**
+   * \brief Forget every recorded value
+   */
+  void Reset (void);
+
+  /**
+   * \return the number of values recorded
+   */
+  uint64_t GetCount (void) const;
+
+  /**
+   * \return the largest value recorded, exact, in ns
+   */
+  uint64_t GetMax (void) const;
+
+  /**
+   * \return the mean of the recorded values, exact, in ns
+   */
+  double GetMean (void) const;
+
+  /**
+   * \brief Get the value below which a fraction of the recorded values lie
+   * \param q the fraction, e.g. 0.999 for the 99.9th percentile
+   * \return the upper edge of the bucket holding that value, capped at
+   *         GetMax, in ns; 0 if nothing was recorded
+   */
+  uint64_t GetPercentile (double q) const;
+
+  /**
+   * \return the bytes allocated for the buckets
+   */
+  uint64_t GetMemoryUsage (void) const;
+
+  /**
+   * \brief Write the histogram as one line of text that Read accepts
+   *
+   * The line holds the count, sum and maximum followed by the non-empty
+   * buckets as index:count pairs.
+   */
+  void Write (std::ostream &os) const;
+
+  /**
+   * \brief Replace the histogram by one written by Write
+   * \return false if the input is malformed
+   */
+  bool Read (std::istream &is);
+
+  /**
+   * \brief Number of bits of the values kept below the leading one
+   */
+  static const uint32_t SUB_BUCKET_BITS = 5;
+
+private:
+  /**
+   * \return the bucket holding a value
+   */
+  static uint32_t GetIndex (uint64_t value);
+
+  /**
+   * \return the largest value a bucket holds
+   */
+  static uint64_t GetUpperEdge (uint32_t index);
+
+  std::vector<uint64_t> m_buckets;  //!< Count of values per bucket
+  uint64_t m_count;                 //!< Number of values recorded
+  uint64_t m_sum;                   //!< Sum of the values recorded
+  uint64_t m_max;                   //!< Largest value recorded
+};
+
+/**
+ * \ingroup wireless-point-to-point
+ * \brief Latency of the frames received over one link, split in parts
+ */
+struct WpppLinkLatency
+{
+  uint32_t srcNode;                    //!< Node id of the sending device
+  uint32_t srcIfIndex;                 //!< Interface index of the sending device
+  WpppLatencyHistogram queueing;       //!< Queued until the transmission started
+  WpppLatencyHistogram transmission;   //!< Serialization at the data rate
+  WpppLatencyHistogram propagation;    //!< End of transmission to reception
+  WpppLatencyHistogram total;          //!< Queued to received
+};
+
+} // namespace ns3
+
+#endif /* WPPP_LATENCY_H */
@@ -0,0 +1,441 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 University of North Carolina at Chapel Hill
+ * Author: Ben Newton
+ */
+
+#include <algorithm>
+#include "ns3/log.h"
+#include "ns3/assert.h"
+#include "wppp-link-matching.h"
+#include "wppp-parallel.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("WpppLinkMatching");
+
+WpppLinkMatching::WpppLinkMatching ()
+  : m_threads (0),
+    m_lastSolveSize (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+WpppLinkMatching::SetThreads (uint32_t threads)
+{
+  m_threads = threads;
+}
+
+void
+WpppLinkMatching::Grow (uint32_t node)
+{
+  if (node >= m_capacity.size ())
+    {
+      m_candidates.resize (node + 1);
+      m_matched.resize (node + 1);
+      m_capacity.resize (node + 1, 0);
+      m_proposals.resize (node + 1);
+      m_isActive.resize (node + 1, 0);
+    }
+}
+
+uint32_t
+WpppLinkMatching::GetNNodes (void) const
+{
+  return m_capacity.size ();
+}
+
+void
+WpppLinkMatching::Activate (uint32_t node)
+{
+  if (!m_isActive[node])
+    {
+      m_isActive[node] = 1;
+      m_active.push_back (node);
+    }
+}
+
+void
+WpppLinkMatching::SetCapacity (uint32_t node, uint32_t capacity)
+{
+  NS_LOG_FUNCTION (this << node << capacity);
+  Grow (node);
+  m_capacity[node] = capacity;
+  //drop the lightest links of a node that lost terminals
+  while (m_matched[node].size () > capacity)
+    {
+      uint32_t lightest;
+      double lightestWeight;
+      Lightest (node, lightest, lightestWeight);
+      Unmatch (node, lightest);
+    }
+  Activate (node);
+}
+
+bool
+WpppLinkMatching::Heavier (uint32_t a, uint32_t b, double wa,
+                           uint32_t c, uint32_t d, double wc)
+{
+  if (wa != wc)
+    {
+      return wa > wc;
+    }
+  std::pair<uint32_t, uint32_t> l (std::min (a, b), std::max (a, b));
+  std::pair<uint32_t, uint32_t> r (std::min (c, d), std::max (c, d));
+  return l < r;
+}
+
+bool
+WpppLinkMatching::HasMatch (uint32_t a, uint32_t b) const
+{
+  const std::vector<uint32_t> &m = m_matched[a];
+  return std::find (m.begin (), m.end (), b) != m.end ();
+}
+
+bool
+WpppLinkMatching::Lightest (uint32_t u, uint32_t &peer, double &weight) const
+{
+  bool have = false;
+  const std::vector<Candidate> &cands = m_candidates[u];
+  for (uint32_t i = 0; i < cands.size (); i++)
+    {
+      const Candidate &c = cands[i];
+      if (HasMatch (u, c.peer) &&
+          (!have || Heavier (u, peer, weight, u, c.peer, c.weight)))
+        {
+          have = true;
+          peer = c.peer;
+          weight = c.weight;
+        }
+    }
+  return have;
+}
+
+bool
+WpppLinkMatching::IsOpen (uint32_t u, uint32_t v, double weight) const
+{
+  if (m_matched[u].size () < m_capacity[u])
+    {
+      return true;
+    }
+  uint32_t lightest;
+  double lightestWeight;
+  return Lightest (u, lightest, lightestWeight) &&
+         Heavier (u, v, weight, u, lightest, lightestWeight);
+}
+
+bool
+WpppLinkMatching::IsMatched (uint32_t a, uint32_t b) const
+{
+  return a < m_matched.size () && HasMatch (a, b);
+}
+
+void
+WpppLinkMatching::RecordChange (uint32_t a, uint32_t b, int delta)
+{
+  uint64_t key = (uint64_t (std::min (a, b)) << 32) | std::max (a, b);
+  int &net = m_changes[key];
+  net += delta;
+  if (net == 0)
+    {
+      m_changes.erase (key);
+    }
+}
+
+void
+WpppLinkMatching::Match (uint32_t a, uint32_t b)
+{
+  NS_LOG_LOGIC ("match " << a << "<->" << b);
+  m_matched[a].push_back (b);
+  m_matched[b].push_back (a);
+  RecordChange (a, b, 1);
+}
+
+void
+WpppLinkMatching::Unmatch (uint32_t a, uint32_t b)
+{
+  NS_LOG_LOGIC ("unmatch " << a << "<->" << b);
+  m_matched[a].erase (std::find (m_matched[a].begin (), m_matched[a].end (), b));
+  m_matched[b].erase (std::find (m_matched[b].begin (), m_matched[b].end (), a));
+  RecordChange (a, b, -1);
+  Activate (a);
+  Activate (b);
+}
+
+void
+WpppLinkMatching::SetLink (uint32_t a, uint32_t b, double weight)
+{
+  NS_LOG_FUNCTION (this << a << b << weight);
+  NS_ASSERT_MSG (a != b, "A node cannot link to itself");
+  Grow (std::max (a, b));
+
+  bool found = false;
+  for (uint32_t i = 0; i < m_candidates[a].size (); i++)
+    {
+      if (m_candidates[a][i].peer == b)
+        {
+          if (m_candidates[a][i].weight == weight)
+            {
+              return;
+            }
+          m_candidates[a][i].weight = weight;
+          found = true;
+          break;
+        }
+    }
+  if (found)
+    {
+      for (uint32_t i = 0; i < m_candidates[b].size (); i++)
+        {
+          if (m_candidates[b][i].peer == a)
+            {
+              m_candidates[b][i].weight = weight;
+              break;
+            }
+        }
+    }
+  else
+    {
+      Candidate c;
+      c.weight = weight;
+      c.peer = b;
+      m_candidates[a].push_back (c);
+      c.peer = a;
+      m_candidates[b].push_back (c);
+    }
+  //only the ranks at a and b changed, so any link that now belongs in the
+  //matching, or whose place did, is at a or b; Solve follows the evictions
+  Activate (a);
+  Activate (b);
+}
+
+void
+WpppLinkMatching::RemoveLink (uint32_t a, uint32_t b)
+{
+  NS_LOG_FUNCTION (this << a << b);
+  if (std::max (a, b) >= m_capacity.size ())
+    {
+      return;
+    }
+  uint32_t ends[2][2] = { { a, b }, { b, a } };
+  for (uint32_t e = 0; e < 2; e++)
+    {
+      std::vector<Candidate> &cands = m_candidates[ends[e][0]];
+      for (uint32_t i = 0; i < cands.size (); i++)
+        {
+          if (cands[i].peer == ends[e][1])
+            {
+              cands[i] = cands.back ();
+              cands.pop_back ();
+              break;
+            }
+        }
+    }
+  if (HasMatch (a, b))
+    {
+      Unmatch (a, b);
+    }
+}
+
+void
+WpppLinkMatching::Propose (uint32_t begin, uint32_t end)
+{
+  for (uint32_t k = begin; k < end; k++)
+    {
+      uint32_t u = m_active[k];
+      std::vector<uint32_t> &proposals = m_proposals[u];
+      proposals.clear ();
+      uint32_t capacity = m_capacity[u];
+      if (capacity == 0)
+        {
+          continue;
+        }
+
+      //the 'capacity' heaviest of the matched links and the links whose
+      //other end would take them, heaviest first
+      std::vector<Candidate> best;
+      const std::vector<Candidate> &cands = m_candidates[u];
+      for (uint32_t i = 0; i < cands.size (); i++)
+        {
+          const Candidate &c = cands[i];
+          if (best.size () == capacity &&
+              !Heavier (u, c.peer, c.weight, u, best.back ().peer, best.back ().weight))
+            {
+              continue;
+            }
+          if (!HasMatch (u, c.peer) && !IsOpen (c.peer, u, c.weight))
+            {
+              continue;
+            }
+          std::vector<Candidate>::iterator pos = best.begin ();
+          while (pos != best.end () && Heavier (u, pos->peer, pos->weight, u, c.peer, c.weight))
+            {
+              ++pos;
+            }
+          best.insert (pos, c);
+          if (best.size () > capacity)
+            {
+              best.pop_back ();
+            }
+        }
+      for (uint32_t i = 0; i < best.size (); i++)
+        {
+          if (!HasMatch (u, best[i].peer))
+            {
+              proposals.push_back (best[i].peer);
+            }
+        }
+    }
+}
+
+void
+WpppLinkMatching::Evict (uint32_t u)
+{
+  uint32_t lightest;
+  double lightestWeight;
+  Lightest (u, lightest, lightestWeight);
+  Unmatch (u, lightest);
+  //both ends may now have a link that belongs in the matching
+  uint32_t ends[2] = { u, lightest };
+  for (uint32_t e = 0; e < 2; e++)
+    {
+      if (m_isActive[ends[e]] == 1)
+        {
+          m_isActive[ends[e]] = 3;
+        }
+    }
+}
+
+void
+WpppLinkMatching::Solve (void)
+{
+  NS_LOG_FUNCTION (this << m_active.size ());
+  m_lastSolveSize = m_active.size ();
+  uint32_t rounds = 0;
+  while (!m_active.empty ())
+    {
+      rounds++;
+      WpppParallel::For (m_active.size (), m_threads,
+                         MakeCallback (&WpppLinkMatching::Propose, this));
+
+      //links proposed by both ends are locally dominant, match them all,
+      //evicting the lightest link of a saturated end; evicted ends join
+      //m_active past the nodes of this round
+      bool progress = false;
+      uint32_t visited = m_active.size ();
+      std::vector<uint32_t> joining;
+      for (uint32_t k = 0; k < visited; k++)
+        {
+          uint32_t u = m_active[k];
+          const std::vector<uint32_t> &proposals = m_proposals[u];
+          for (uint32_t i = 0; i < proposals.size (); i++)
+            {
+              uint32_t v = proposals[i];
+              if (!m_isActive[v])
+                {
+                  //v would take the link but was not visited; it has to
+                  //propose next round for this link to be considered
+                  m_isActive[v] = 2;
+                  joining.push_back (v);
+                }
+              else if (m_isActive[v] != 2 && u < v)
+                {
+                  const std::vector<uint32_t> &back = m_proposals[v];
+                  if (std::find (back.begin (), back.end (), u) != back.end ())
+                    {
+                      if (m_matched[u].size () >= m_capacity[u])
+                        {
+                          Evict (u);
+                        }
+                      if (m_matched[v].size () >= m_capacity[v])
+                        {
+                          Evict (v);
+                        }
+                      Match (u, v);
+                      progress = true;
+                    }
+                }
+            }
+        }
+
+      //nodes with nothing left to propose drop out, unless they lost a link
+      std::vector<uint32_t> next;
+      for (uint32_t k = 0; k < m_active.size (); k++)
+        {
+          uint32_t u = m_active[k];
+          if (k >= visited || m_isActive[u] == 3 || !m_proposals[u].empty ())
+            {
+              m_isActive[u] = 1;
+              next.push_back (u);
+            }
+          else
+            {
+              m_isActive[u] = 0;
+            }
+          m_proposals[u].clear ();
+        }
+      for (uint32_t k = 0; k < joining.size (); k++)
+        {
+          m_isActive[joining[k]] = 1;
+          next.push_back (joining[k]);
+        }
+      m_lastSolveSize += joining.size () + m_active.size () - visited;
+      m_active.swap (next);
+
+      if (!progress && joining.empty ())
+        {
+          for (uint32_t k = 0; k < m_active.size (); k++)
+            {
+              m_isActive[m_active[k]] = 0;
+            }
+          m_active.clear ();
+        }
+    }
+  NS_LOG_LOGIC ("solved in " << rounds << " rounds, " << m_lastSolveSize << " nodes visited");
+}
+
+void
+WpppLinkMatching::GetMatched (std::vector<std::pair<uint32_t, uint32_t> > &links) const
+{
+  links.clear ();
+  for (uint32_t a = 0; a < m_matched.size (); a++)
+    {
+      for (uint32_t i = 0; i < m_matched[a].size (); i++)
+        {
+          if (a < m_matched[a][i])
+            {
+              links.push_back (std::make_pair (a, m_matched[a][i]));
+            }
+        }
+    }
+}
+
+void
+WpppLinkMatching::TakeChanges (std::vector<std::pair<uint32_t, uint32_t> > &added,
+                               std::vector<std::pair<uint32_t, uint32_t> > &removed)
+{
+  added.clear ();
+  removed.clear ();
+  for (std::map<uint64_t, int>::const_iterator i = m_changes.begin (); i != m_changes.end (); ++i)
+    {
+      std::pair<uint32_t, uint32_t> link (i->first >> 32, i->first & 0xffffffff);
+      if (i->second > 0)
+        {
+          added.push_back (link);
+        }
+      else
+        {
+          removed.push_back (link);
+        }
+    }
+  m_changes.clear ();
+}
+
+uint32_t
+WpppLinkMatching::GetLastSolveSize (void) const
+{
+  return m_lastSolveSize;
+}
+
+} // namespace ns3
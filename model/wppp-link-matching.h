@@ -0,0 +1,166 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 University of North Carolina at Chapel Hill
+ * Author: Ben Newton
+ */
+
+#ifndef WPPP_LINK_MATCHING_H
+#define WPPP_LINK_MATCHING_H
+
+#include <stdint.h>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup wireless-point-to-point
+ * \brief Weighted degree-constrained matching of candidate links
+ *
+ * Chooses a set of candidate links so that no node is in more links than
+ * its capacity (its number of directional terminals), preferring heavy
+ * links.  The solver repeatedly matches locally dominant links: every node
+ * proposes the links that rank among its heaviest, as many as it has
+ * terminals, counting its matched links and the links the other end would
+ * take, and links proposed by both ends are matched.  A saturated end gives
+ * up its lightest link for the new one.  The proposals of a round are
+ * computed in parallel.  Ties are broken on the node indices, which makes
+ * the result identical to the sequential greedy algorithm (a 1/2
+ * approximation of the optimum) and independent of the number of threads.
+ *
+ * Solving is incremental.  Changing or removing a candidate link only
+ * marks its ends, and the next Solve starts from them, following the links
+ * given up along the way until no link is left that the greedy algorithm
+ * would match differently.
+ *
+ * Nodes are dense indices in [0, GetNNodes ()).
+ */
+class WpppLinkMatching
+{
+public:
+  WpppLinkMatching ();
+
+  /**
+   * \param threads number of threads used by Solve, 0 for one per processor
+   */
+  void SetThreads (uint32_t threads);
+
+  /**
+   * \brief Set the number of links a node can take part in
+   * \param node node index, the node set grows as needed
+   * \param capacity number of terminals of the node
+   */
+  void SetCapacity (uint32_t node, uint32_t capacity);
+
+  /**
+   * \return number of nodes known to the solver
+   */
+  uint32_t GetNNodes (void) const;
+
+  /**
+   * \brief Add or reweight a candidate link
+   * \param a one end of the link
+   * \param b the other end of the link
+   * \param weight value of the link, larger is better
+   */
+  void SetLink (uint32_t a, uint32_t b, double weight);
+
+  /**
+   * \brief Remove a candidate link, unmatching it if needed
+   * \param a one end of the link
+   * \param b the other end of the link
+   */
+  void RemoveLink (uint32_t a, uint32_t b);
+
+  /**
+   * \brief Bring the matching up to date with the candidate links
+   */
+  void Solve (void);
+
+  /**
+   * \return true if the link between a and b is matched
+   */
+  bool IsMatched (uint32_t a, uint32_t b) const;
+
+  /**
+   * \param links filled with the matched links as (a, b) with a < b
+   */
+  void GetMatched (std::vector<std::pair<uint32_t, uint32_t> > &links) const;
+
+  /**
+   * \brief Take the net changes to the matching since the last call
+   * \param added filled with the newly matched links, (a, b) with a < b
+   * \param removed filled with the links no longer matched, (a, b) with a < b
+   */
+  void TakeChanges (std::vector<std::pair<uint32_t, uint32_t> > &added,
+                    std::vector<std::pair<uint32_t, uint32_t> > &removed);
+
+  /**
+   * \return number of nodes visited by the last Solve
+   */
+  uint32_t GetLastSolveSize (void) const;
+
+private:
+  /**
+   * A candidate link as seen from one of its ends
+   */
+  struct Candidate
+  {
+    uint32_t peer;   //!< Other end of the link
+    double weight;   //!< Weight of the link
+  };
+
+  /**
+   * \brief Compute the proposals of the active nodes in [begin, end).
+   * Runs on the worker threads.
+   */
+  void Propose (uint32_t begin, uint32_t end);
+
+  /**
+   * \return true if link (a, b, wa) ranks before link (c, d, wc)
+   */
+  static bool Heavier (uint32_t a, uint32_t b, double wa,
+                       uint32_t c, uint32_t d, double wc);
+
+  /**
+   * \brief Find the lightest matched link of a node
+   * \param u the node
+   * \param peer set to the other end of the link
+   * \param weight set to the weight of the link
+   * \returns false if the node has no matched link
+   */
+  bool Lightest (uint32_t u, uint32_t &peer, double &weight) const;
+
+  /**
+   * \returns true if node u would take the link to v of the given weight:
+   *          it has a spare terminal or a lighter matched link
+   */
+  bool IsOpen (uint32_t u, uint32_t v, double weight) const;
+
+  /**
+   * \brief Unmatch the lightest link of a node and revisit both its ends
+   */
+  void Evict (uint32_t u);
+
+  void Grow (uint32_t node);
+  void Activate (uint32_t node);
+  bool HasMatch (uint32_t a, uint32_t b) const;
+  void Match (uint32_t a, uint32_t b);
+  void Unmatch (uint32_t a, uint32_t b);
+  void RecordChange (uint32_t a, uint32_t b, int delta);
+
+  std::vector<std::vector<Candidate> > m_candidates;  //!< Candidate links per node
+  std::vector<std::vector<uint32_t> > m_matched;      //!< Matched peers per node
+  std::vector<uint32_t> m_capacity;                   //!< Terminals per node
+  std::vector<std::vector<uint32_t> > m_proposals;    //!< Proposals of the round
+  std::vector<uint8_t> m_isActive;                    //!< Membership of m_active: 1, 2 if joining, 3 if it lost a link this round
+  std::vector<uint32_t> m_active;                     //!< Nodes to revisit
+  std::map<uint64_t, int> m_changes;                  //!< Net matching changes
+  uint32_t m_threads;                                 //!< Threads used by Solve
+  uint32_t m_lastSolveSize;                           //!< Nodes visited last Solve
+};
+
+} // namespace ns3
+
+#endif /* WPPP_LINK_MATCHING_H */
@@ -0,0 +1,79 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 University of North Carolina at Chapel Hill
+ * Author: Ben Newton
+ */
+
+#include <iomanip>
+#include "wppp-memory-usage.h"
+
+namespace ns3 {
+
+WpppMemoryUsage::WpppMemoryUsage ()
+  : devices (0),
+    channels (0),
+    deviceObjects (0),
+    traceSources (0),
+    queues (0),
+    queuedPackets (0),
+    latencyStats (0),
+    mpiReceivers (0),
+    channelObjects (0),
+    channelMaps (0),
+    delayState (0),
+    uncountedQueues (0),
+    uncountedDelayModels (0)
+{
+}
+
+uint64_t
+WpppMemoryUsage::GetTotal (void) const
+{
+  return deviceObjects + traceSources + queues + queuedPackets + latencyStats +
+         mpiReceivers + channelObjects + channelMaps + delayState;
+}
+
+void
+WpppMemoryUsage::Print (std::ostream &os) const
+{
+  const char *names[] = {
+    "device objects", "trace sources", "queues", "queued packets",
+    "latency stats", "mpi receivers", "channel objects", "channel maps",
+    "delay state"
+  };
+  uint64_t bytes[] = {
+    deviceObjects, traceSources, queues, queuedPackets,
+    latencyStats, mpiReceivers, channelObjects, channelMaps,
+    delayState
+  };
+  uint64_t total = GetTotal ();
+
+  std::ios::fmtflags flags = os.flags ();
+  std::streamsize precision = os.precision ();
+  os << std::fixed;
+  os << "wppp memory: " << devices << " devices, " << channels << " channels" << std::endl;
+  os << std::left << std::setw (18) << "subsystem" << std::right
+     << std::setw (14) << "bytes" << std::setw (8) << "%"
+     << std::setw (12) << "per device" << std::endl;
+  for (uint32_t i = 0; i < sizeof (bytes) / sizeof (bytes[0]); i++)
+    {
+      os << std::left << std::setw (18) << names[i] << std::right
+         << std::setw (14) << bytes[i]
+         << std::setw (8) << std::setprecision (1) << (total > 0 ? 100.0 * bytes[i] / total : 0.0)
+         << std::setw (12) << std::setprecision (0) << (devices > 0 ? double (bytes[i]) / devices : 0.0)
+         << std::endl;
+    }
+  os << std::left << std::setw (18) << "total" << std::right
+     << std::setw (14) << total << std::setw (8) << "100.0"
+     << std::setw (12) << std::setprecision (0) << (devices > 0 ? double (total) / devices : 0.0)
+     << std::endl;
+  if (uncountedQueues > 0 || uncountedDelayModels > 0)
+    {
+      os << "not counted: " << uncountedQueues << " queues and " << uncountedDelayModels
+         << " delay models of unknown types" << std::endl;
+    }
+  os.flags (flags);
+  os.precision (precision);
+}
+
+} // namespace ns3
@@ -0,0 +1,70 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 University of North Carolina at Chapel Hill
+ * Author: Ben Newton
+ */
+
+#ifndef WPPP_MEMORY_USAGE_H
+#define WPPP_MEMORY_USAGE_H
+
+#include <stdint.h>
+#include <ostream>
+
+namespace ns3 {
+
+/**
+ * \ingroup wireless-point-to-point
+ * \brief Estimated heap bytes of the module, by subsystem
+ *
+ * The figures are computed from the sizes of the objects and the number of
+ * entries in the containers, with a fixed allowance for the allocator and
+ * container node headers, so they are estimates of the memory the module
+ * holds rather than measurements.  Memory referenced by the module but
+ * owned by others (nodes, mobility models, trace sinks) is not counted.
+ * Queues and propagation delay models are only counted when their exact
+ * type is one whose size is known; the others are listed as uncounted.
+ */
+struct WpppMemoryUsage
+{
+  WpppMemoryUsage ();
+
+  /**
+   * \return the sum of all subsystems, in bytes
+   */
+  uint64_t GetTotal (void) const;
+
+  /**
+   * \brief Write one line per subsystem with its bytes, share of the total
+   * and bytes per device
+   */
+  void Print (std::ostream &os) const;
+
+  /**
+   * Bytes of a std::map or std::set node besides its value
+   */
+  static const uint32_t TREE_NODE_OVERHEAD = 32;
+
+  /**
+   * Bytes of a packet besides its data: Packet, QueueItem and buffer
+   * headers
+   */
+  static const uint32_t PACKET_OVERHEAD = 160;
+
+  uint32_t devices;           //!< Number of devices counted
+  uint32_t channels;          //!< Number of channels counted
+  uint64_t deviceObjects;     //!< Device objects with their inline trace sources
+  uint64_t traceSources;      //!< Trace sources allocated on first connection
+  uint64_t queues;            //!< Queue objects
+  uint64_t queuedPackets;     //!< Frames waiting in the queues
+  uint64_t latencyStats;      //!< Latency and sojourn histograms
+  uint64_t mpiReceivers;      //!< MpiReceiver objects aggregated to devices
+  uint64_t channelObjects;    //!< Channel objects
+  uint64_t channelMaps;       //!< Alignment and connection tables, device lists
+  uint64_t delayState;        //!< Propagation delay models
+  uint32_t uncountedQueues;   //!< Queues of a type whose size is unknown
+  uint32_t uncountedDelayModels;  //!< Delay models of a type whose size is unknown
+};
+
+} // namespace ns3
+
+#endif /* WPPP_MEMORY_USAGE_H */
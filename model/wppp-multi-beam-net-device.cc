@@ -0,0 +1,539 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 University of North Carolina at Chapel Hill
+ * Author: Ben Newton
+ */
+
+#include "ns3/abort.h"
+#include "ns3/log.h"
+#include "ns3/uinteger.h"
+#include "ns3/simulator.h"
+#include "ns3/queue-disc.h"
+#include "wppp-multi-beam-net-device.h"
+#include "wireless-point-to-point-channel.h"
+#include "wppp-header.h"
+#include "wppp-label-table.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("WpppMultiBeamNetDevice");
+
+NS_OBJECT_ENSURE_REGISTERED (WpppMultiBeamNetDevice);
+
+TypeId
+WpppMultiBeamNetDevice::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::WpppMultiBeamNetDevice")
+    .SetParent<NetDevice> ()
+    .SetGroupName ("WirelessPointToPoint")
+    .AddConstructor<WpppMultiBeamNetDevice> ()
+    .AddAttribute ("Mtu", "The MAC-level Maximum Transmission Unit of every beam",
+                   UintegerValue (1500),
+                   MakeUintegerAccessor (&WpppMultiBeamNetDevice::SetMtu,
+                                         &WpppMultiBeamNetDevice::GetMtu),
+                   MakeUintegerChecker<uint16_t> ())
+    .AddAttribute ("HoppingSlot",
+                   "Time each beam in turn may transmit, guard included; 0 lets "
+                   "every beam transmit at any time",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&WpppMultiBeamNetDevice::m_hoppingSlot),
+                   MakeTimeChecker ())
+    .AddAttribute ("HoppingGuard",
+                   "Time at the start of each slot spent retargeting, during "
+                   "which nothing is transmitted",
+                   TimeValue (MicroSeconds (100)),
+                   MakeTimeAccessor (&WpppMultiBeamNetDevice::m_hoppingGuard),
+                   MakeTimeChecker ())
+  ;
+  return tid;
+}
+
+WpppMultiBeamNetDevice::WpppMultiBeamNetDevice ()
+  : m_alignedBeams (0),
+    m_ifIndex (0),
+    m_mtu (1500),
+    m_slot (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+WpppMultiBeamNetDevice::~WpppMultiBeamNetDevice ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+WpppMultiBeamNetDevice::DoInitialize (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_hoppingSlot.IsStrictlyPositive () && !m_beams.empty ())
+    {
+      NS_ABORT_MSG_UNLESS (m_hoppingGuard < m_hoppingSlot, "HoppingGuard must be shorter than HoppingSlot");
+      for (uint32_t i = 0; i < m_beams.size (); i++)
+        {
+          m_beams[i]->SetTransmitWindow (Seconds (0));
+        }
+      m_slotEvent = Simulator::Schedule (m_hoppingGuard, &WpppMultiBeamNetDevice::StartSlot, this);
+    }
+  NetDevice::DoInitialize ();
+}
+
+void
+WpppMultiBeamNetDevice::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_slotEvent.Cancel ();
+  for (uint32_t i = 0; i < m_beams.size (); i++)
+    {
+      m_beams[i]->Dispose ();
+    }
+  m_beams.clear ();
+  m_peers.clear ();
+  m_node = 0;
+  m_queueInterface = 0;
+  NetDevice::DoDispose ();
+}
+
+void
+WpppMultiBeamNetDevice::NotifyNewAggregate (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_queueInterface == 0)
+    {
+      Ptr<NetDeviceQueueInterface> ndqi = this->GetObject<NetDeviceQueueInterface> ();
+      if (ndqi != 0)
+        {
+          NS_ABORT_MSG_IF (m_beams.empty () || m_beams.size () > 255,
+                           "A multi-beam device needs 1 to 255 beams before its queue interface");
+          m_queueInterface = ndqi;
+          ndqi->SetTxQueuesN (m_beams.size ());
+          ndqi->SetSelectQueueCallback (MakeCallback (&WpppMultiBeamNetDevice::SelectQueue, this));
+          for (uint32_t i = 0; i < m_beams.size (); i++)
+            {
+              m_beams[i]->SetQueueInterface (ndqi, i);
+            }
+        }
+    }
+  NetDevice::NotifyNewAggregate ();
+}
+
+void
+WpppMultiBeamNetDevice::AddBeam (Ptr<WirelessPointToPointNetDevice> beam)
+{
+  NS_LOG_FUNCTION (this << beam);
+  NS_ASSERT_MSG (beam->GetBeamOwner () == 0, "The device is already a beam");
+  NS_ABORT_MSG_IF (m_queueInterface != 0, "Beams must be added before the queue interface");
+  beam->SetAddress (m_address);
+  beam->SetNode (m_node);
+  beam->SetIfIndex (m_ifIndex);
+  beam->SetMtu (m_mtu);
+  beam->SetReceiveCallback (MakeCallback (&WpppMultiBeamNetDevice::ReceiveFromBeam, this));
+  if (!m_promiscCallback.IsNull ())
+    {
+      beam->SetPromiscReceiveCallback (MakeCallback (&WpppMultiBeamNetDevice::PromiscReceiveFromBeam, this));
+    }
+  beam->SetBeamOwner (this, MakeCallback (&WpppMultiBeamNetDevice::BeamAlignmentChanged, this));
+  if (m_node != 0)
+    {
+      Ptr<WpppLabelTable> table = m_node->GetObject<WpppLabelTable> ();
+      if (table != 0)
+        {
+          beam->SetLabelTable (table);
+        }
+    }
+  m_beams.push_back (beam);
+  m_peers.push_back (Mac48Address::GetBroadcast ());
+  if (m_beams.size () == 1 && beam->IsLinkUp ())
+    {
+      m_linkChangeCallbacks ();
+    }
+}
+
+uint32_t
+WpppMultiBeamNetDevice::GetNBeams (void) const
+{
+  return m_beams.size ();
+}
+
+Ptr<WirelessPointToPointNetDevice>
+WpppMultiBeamNetDevice::GetBeam (uint32_t i) const
+{
+  NS_ASSERT (i < m_beams.size ());
+  return m_beams[i];
+}
+
+void
+WpppMultiBeamNetDevice::SetHoppingSchedule (const std::vector<uint32_t> &schedule)
+{
+  NS_LOG_FUNCTION (this);
+  for (uint32_t i = 0; i < schedule.size (); i++)
+    {
+      NS_ABORT_MSG_UNLESS (schedule[i] < m_beams.size (), "No beam " << schedule[i]);
+    }
+  m_schedule = schedule;
+}
+
+uint64_t
+WpppMultiBeamNetDevice::GetNSlots (void) const
+{
+  return m_slot;
+}
+
+void
+WpppMultiBeamNetDevice::StartSlot (void)
+{
+  uint32_t beam = m_schedule.empty () ? m_slot % m_beams.size () :
+    m_schedule[m_slot % m_schedule.size ()];
+  m_slot++;
+  NS_LOG_LOGIC ("Slot " << m_slot << " goes to beam " << beam);
+  //the window of the previous beam has already closed, at the end of its slot
+  m_beams[beam]->SetTransmitWindow (Simulator::Now () - m_hoppingGuard + m_hoppingSlot);
+  m_slotEvent = Simulator::Schedule (m_hoppingSlot, &WpppMultiBeamNetDevice::StartSlot, this);
+}
+
+uint32_t
+WpppMultiBeamNetDevice::GetNAlignedBeams (void) const
+{
+  return m_alignedBeams;
+}
+
+void
+WpppMultiBeamNetDevice::Connect (uint32_t beam, Ptr<Node> remoteNode)
+{
+  NS_LOG_FUNCTION (this << beam << remoteNode);
+  NS_ASSERT (beam < m_beams.size ());
+  m_beams[beam]->Connect (m_node, m_beams[beam], remoteNode);
+}
+
+void
+WpppMultiBeamNetDevice::Disconnect (uint32_t beam, Ptr<Node> remoteNode)
+{
+  NS_LOG_FUNCTION (this << beam << remoteNode);
+  NS_ASSERT (beam < m_beams.size ());
+  m_beams[beam]->Disconnect (m_node, m_beams[beam], remoteNode);
+}
+
+void
+WpppMultiBeamNetDevice::BeamAlignmentChanged (Ptr<WirelessPointToPointNetDevice> beam, bool aligned)
+{
+  NS_LOG_FUNCTION (this << beam << aligned);
+  for (uint32_t i = 0; i < m_beams.size (); i++)
+    {
+      if (m_beams[i] != beam)
+        {
+          continue;
+        }
+      bool wasAligned = m_peers[i] != Mac48Address::GetBroadcast ();
+      Ptr<WirelessPointToPointNetDevice> peer = beam->GetAlignedPeer ();
+      if (aligned && peer != 0)
+        {
+          m_peers[i] = Mac48Address::ConvertFrom (peer->GetAddress ());
+        }
+      else
+        {
+          m_peers[i] = Mac48Address::GetBroadcast ();
+        }
+      bool isAligned = m_peers[i] != Mac48Address::GetBroadcast ();
+      if (isAligned == wasAligned)
+        {
+          return;
+        }
+      if (isAligned)
+        {
+          if (++m_alignedBeams == 1)
+            {
+              NotifyInterface (beam, true);
+            }
+        }
+      else if (--m_alignedBeams == 0)
+        {
+          NotifyInterface (beam, false);
+        }
+      return;
+    }
+  NS_FATAL_ERROR ("WpppMultiBeamNetDevice::BeamAlignmentChanged(): not one of the beams");
+}
+
+void
+WpppMultiBeamNetDevice::NotifyInterface (Ptr<WirelessPointToPointNetDevice> beam, bool up)
+{
+  NS_LOG_FUNCTION (this << beam << up);
+  Ptr<WirelessPointToPointChannel> channel = DynamicCast<WirelessPointToPointChannel> (beam->GetChannel ());
+  NS_ASSERT (channel != 0);
+  channel->NotifyAlignment (this, up);
+}
+
+uint32_t
+WpppMultiBeamNetDevice::FindBeam (Mac48Address peer) const
+{
+  for (uint32_t i = 0; i < m_peers.size (); i++)
+    {
+      if (m_peers[i] == peer)
+        {
+          return i;
+        }
+    }
+  return m_peers.size ();
+}
+
+uint8_t
+WpppMultiBeamNetDevice::SelectQueue (Ptr<QueueItem> item) const
+{
+  Ptr<QueueDiscItem> qdItem = DynamicCast<QueueDiscItem> (item);
+  if (qdItem == 0 || !Mac48Address::IsMatchingType (qdItem->GetAddress ()))
+    {
+      return 0;
+    }
+  Mac48Address to = Mac48Address::ConvertFrom (qdItem->GetAddress ());
+  //unaligned beams have the broadcast address as peer
+  uint32_t i = to.IsGroup () ? m_beams.size () : FindBeam (to);
+  return i < m_beams.size () ? i : 0;
+}
+
+bool
+WpppMultiBeamNetDevice::CanSend (uint32_t beam) const
+{
+  return m_queueInterface == 0 || !m_queueInterface->GetTxQueue (beam)->IsStopped ();
+}
+
+bool
+WpppMultiBeamNetDevice::ReceiveFromBeam (Ptr<NetDevice> beam, Ptr<const Packet> packet,
+                                         uint16_t protocol, const Address &from)
+{
+  if (m_rxCallback.IsNull ())
+    {
+      return false;
+    }
+  return m_rxCallback (this, packet, protocol, from);
+}
+
+bool
+WpppMultiBeamNetDevice::PromiscReceiveFromBeam (Ptr<NetDevice> beam, Ptr<const Packet> packet,
+                                                uint16_t protocol, const Address &from,
+                                                const Address &to, PacketType packetType)
+{
+  return m_promiscCallback (this, packet, protocol, from, to, packetType);
+}
+
+void
+WpppMultiBeamNetDevice::Receive (Ptr<Packet> p)
+{
+  NS_LOG_FUNCTION (this << p);
+  NS_ASSERT (!m_beams.empty ());
+  WpppHeader ppp;
+  p->PeekHeader (ppp);
+  uint32_t i = FindBeam (ppp.GetAddr2 ());
+  m_beams[i < m_beams.size () ? i : 0]->Receive (p);
+}
+
+bool
+WpppMultiBeamNetDevice::Send (Ptr<Packet> packet, const Address &dest,
+                              uint16_t protocolNumber)
+{
+  NS_LOG_FUNCTION (this << packet << dest << protocolNumber);
+  Mac48Address to = Mac48Address::ConvertFrom (dest);
+  if (to.IsGroup ())
+    {
+      bool sent = false;
+      for (uint32_t i = 0; i < m_beams.size (); i++)
+        {
+          if (m_peers[i] != Mac48Address::GetBroadcast () && CanSend (i))
+            {
+              sent |= m_beams[i]->Send (packet->Copy (), dest, protocolNumber);
+            }
+        }
+      return sent;
+    }
+  uint32_t i = FindBeam (to);
+  if (i == m_beams.size ())
+    {
+      NS_LOG_LOGIC ("No beam is aligned with " << to);
+      return false;
+    }
+  if (!CanSend (i))
+    {
+      //the next hop moved to this beam after the upper layers checked the
+      //queue they selected for it
+      NS_LOG_LOGIC ("The queue of beam " << i << " is stopped");
+      return false;
+    }
+  return m_beams[i]->Send (packet, dest, protocolNumber);
+}
+
+bool
+WpppMultiBeamNetDevice::SendFrom (Ptr<Packet> packet, const Address &source,
+                                  const Address &dest, uint16_t protocolNumber)
+{
+  NS_LOG_FUNCTION (this << packet << source << dest << protocolNumber);
+  return false;
+}
+
+void
+WpppMultiBeamNetDevice::SetIfIndex (const uint32_t index)
+{
+  NS_LOG_FUNCTION (this << index);
+  m_ifIndex = index;
+  for (uint32_t i = 0; i < m_beams.size (); i++)
+    {
+      m_beams[i]->SetIfIndex (index);
+    }
+}
+
+uint32_t
+WpppMultiBeamNetDevice::GetIfIndex (void) const
+{
+  return m_ifIndex;
+}
+
+Ptr<Channel>
+WpppMultiBeamNetDevice::GetChannel (void) const
+{
+  return m_beams.empty () ? Ptr<Channel> () : m_beams[0]->GetChannel ();
+}
+
+void
+WpppMultiBeamNetDevice::SetAddress (Address address)
+{
+  NS_LOG_FUNCTION (this << address);
+  m_address = Mac48Address::ConvertFrom (address);
+  for (uint32_t i = 0; i < m_beams.size (); i++)
+    {
+      m_beams[i]->SetAddress (address);
+    }
+}
+
+Address
+WpppMultiBeamNetDevice::GetAddress (void) const
+{
+  return m_address;
+}
+
+bool
+WpppMultiBeamNetDevice::SetMtu (const uint16_t mtu)
+{
+  NS_LOG_FUNCTION (this << mtu);
+  m_mtu = mtu;
+  for (uint32_t i = 0; i < m_beams.size (); i++)
+    {
+      m_beams[i]->SetMtu (mtu);
+    }
+  return true;
+}
+
+uint16_t
+WpppMultiBeamNetDevice::GetMtu (void) const
+{
+  return m_mtu;
+}
+
+bool
+WpppMultiBeamNetDevice::IsLinkUp (void) const
+{
+  for (uint32_t i = 0; i < m_beams.size (); i++)
+    {
+      if (m_beams[i]->IsLinkUp ())
+        {
+          return true;
+        }
+    }
+  return false;
+}
+
+void
+WpppMultiBeamNetDevice::AddLinkChangeCallback (Callback<void> callback)
+{
+  m_linkChangeCallbacks.ConnectWithoutContext (callback);
+}
+
+bool
+WpppMultiBeamNetDevice::IsBroadcast (void) const
+{
+  return true;
+}
+
+Address
+WpppMultiBeamNetDevice::GetBroadcast (void) const
+{
+  return Mac48Address::GetBroadcast ();
+}
+
+bool
+WpppMultiBeamNetDevice::IsMulticast (void) const
+{
+  return true;
+}
+
+Address
+WpppMultiBeamNetDevice::GetMulticast (Ipv4Address multicastGroup) const
+{
+  return Mac48Address::GetMulticast (multicastGroup);
+}
+
+Address
+WpppMultiBeamNetDevice::GetMulticast (Ipv6Address addr) const
+{
+  return Mac48Address::GetMulticast (addr);
+}
+
+//
+// Frames to different neighbors leave on different beams, so unlike a single
+// beam this device is not a point-to-point link.
+//
+bool
+WpppMultiBeamNetDevice::IsPointToPoint (void) const
+{
+  return false;
+}
+
+bool
+WpppMultiBeamNetDevice::IsBridge (void) const
+{
+  return false;
+}
+
+Ptr<Node>
+WpppMultiBeamNetDevice::GetNode (void) const
+{
+  return m_node;
+}
+
+void
+WpppMultiBeamNetDevice::SetNode (Ptr<Node> node)
+{
+  NS_LOG_FUNCTION (this << node);
+  m_node = node;
+  for (uint32_t i = 0; i < m_beams.size (); i++)
+    {
+      m_beams[i]->SetNode (node);
+    }
+}
+
+bool
+WpppMultiBeamNetDevice::NeedsArp (void) const
+{
+  return true;
+}
+
+void
+WpppMultiBeamNetDevice::SetReceiveCallback (NetDevice::ReceiveCallback cb)
+{
+  m_rxCallback = cb;
+}
+
+void
+WpppMultiBeamNetDevice::SetPromiscReceiveCallback (NetDevice::PromiscReceiveCallback cb)
+{
+  m_promiscCallback = cb;
+  for (uint32_t i = 0; i < m_beams.size (); i++)
+    {
+      m_beams[i]->SetPromiscReceiveCallback (MakeCallback (&WpppMultiBeamNetDevice::PromiscReceiveFromBeam, this));
+    }
+}
+
+bool
+WpppMultiBeamNetDevice::SupportsSendFrom (void) const
+{
+  return false;
+}
+
+} // namespace ns3
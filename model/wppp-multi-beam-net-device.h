@@ -0,0 +1,264 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 University of North Carolina at Chapel Hill
+ * Author: Ben Newton
+ */
+
+#ifndef WPPP_MULTI_BEAM_NET_DEVICE_H
+#define WPPP_MULTI_BEAM_NET_DEVICE_H
+
+#include <vector>
+#include "ns3/net-device.h"
+#include "ns3/node.h"
+#include "ns3/packet.h"
+#include "ns3/traced-callback.h"
+#include "ns3/mac48-address.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include "wireless-point-to-point-net-device.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup wireless-point-to-point
+ * \brief A device with several beams behind one interface
+ *
+ * Each beam is a WirelessPointToPointNetDevice with its own queue and
+ * transmit state machine, attached to the channel and aligned on its own
+ * with Connect and Disconnect.  Only this device is added to the node, so
+ * a node with K terminals has one interface, one address and one set of
+ * routes instead of K.
+ *
+ * Send picks the beam aligned with the device owning the destination
+ * address; the next hop is carried in addr1 of the WpppHeader and resolved
+ * by ARP, which is why this device, unlike a single beam, needs it.
+ * Broadcast frames go out on every aligned beam.  Frames received by any
+ * beam are passed up as received by this device.
+ *
+ * The routing protocol sees the interface go up when the first beam
+ * becomes aligned and down when the last one stops being aligned.
+ * Traces, statistics and queues are those of the beams, see GetBeam.
+ * A NetDeviceQueueInterface aggregated to this device gets one
+ * transmission queue per beam, selected by next hop, and each beam stops
+ * and wakes its own.  The beams must be added before the queue interface
+ * is.
+ *
+ * Beams are not devices of the node, so a source route cannot name one:
+ * a hop naming this device drops the frame, see
+ * WirelessPointToPointNetDevice::SendSourceRouted.  Label switching has no
+ * such limit, labels name beams directly.
+ *
+ * With a HoppingSlot, the beams model one terminal that hops between the
+ * peers instead: each slot belongs to one beam, given by the hopping
+ * schedule, and only that beam transmits, after a HoppingGuard spent
+ * retargeting and only frames that end, interframe gap included, within
+ * the slot; a frame longer than that is dropped.  The other beams keep
+ * their frames queued, which makes them per-peer queues.  Only
+ * transmission is slotted: a beam receives whatever its peer sends, in any
+ * slot, so both ends should follow matching schedules or the results will
+ * be optimistic.
+ */
+class WpppMultiBeamNetDevice : public NetDevice
+{
+public:
+  /**
+   * \brief Get the TypeId
+   *
+   * \return The TypeId for this class
+   */
+  static TypeId GetTypeId (void);
+
+  WpppMultiBeamNetDevice ();
+  virtual ~WpppMultiBeamNetDevice ();
+
+  /**
+   * \brief Add a beam to this device
+   *
+   * The beam takes the address, node and interface index of this device.
+   * It should have a queue and be attached to a channel, and must not be
+   * added to the node.
+   *
+   * \param beam the beam
+   */
+  void AddBeam (Ptr<WirelessPointToPointNetDevice> beam);
+
+  /**
+   * \returns the number of beams
+   */
+  uint32_t GetNBeams (void) const;
+
+  /**
+   * \param i index of the beam, in the order of AddBeam
+   * \returns the beam
+   */
+  Ptr<WirelessPointToPointNetDevice> GetBeam (uint32_t i) const;
+
+  /**
+   * \returns the number of beams currently aligned
+   */
+  uint32_t GetNAlignedBeams (void) const;
+
+  /**
+   * \brief Point a beam at a remote node
+   * \param beam index of the beam
+   * \param remoteNode the node to align with
+   */
+  void Connect (uint32_t beam, Ptr<Node> remoteNode);
+
+  /**
+   * \brief Stop pointing a beam at a remote node
+   * \param beam index of the beam
+   * \param remoteNode the node the beam was pointed at
+   */
+  void Disconnect (uint32_t beam, Ptr<Node> remoteNode);
+
+  /**
+   * \brief Set the order in which the beams get the slots when hopping
+   *
+   * Slot k goes to beam schedule[k % schedule.size ()]; a beam may appear
+   * several times to get a larger share.  By default each beam gets one
+   * slot per round, in order.
+   *
+   * \param schedule indices of beams
+   */
+  void SetHoppingSchedule (const std::vector<uint32_t> &schedule);
+
+  /**
+   * \returns the number of slots started since hopping began
+   */
+  uint64_t GetNSlots (void) const;
+
+  /**
+   * \brief Receive a frame delivered through MPI
+   *
+   * The frame is handed to the beam aligned with its sender.
+   *
+   * \param p the frame, with its WpppHeader
+   */
+  void Receive (Ptr<Packet> p);
+
+  // The remaining methods are documented in ns3::NetDevice*
+
+  virtual void SetIfIndex (const uint32_t index);
+  virtual uint32_t GetIfIndex (void) const;
+
+  virtual Ptr<Channel> GetChannel (void) const;
+
+  virtual void SetAddress (Address address);
+  virtual Address GetAddress (void) const;
+
+  virtual bool SetMtu (const uint16_t mtu);
+  virtual uint16_t GetMtu (void) const;
+
+  virtual bool IsLinkUp (void) const;
+
+  virtual void AddLinkChangeCallback (Callback<void> callback);
+
+  virtual bool IsBroadcast (void) const;
+  virtual Address GetBroadcast (void) const;
+
+  virtual bool IsMulticast (void) const;
+  virtual Address GetMulticast (Ipv4Address multicastGroup) const;
+  virtual Address GetMulticast (Ipv6Address addr) const;
+
+  virtual bool IsPointToPoint (void) const;
+  virtual bool IsBridge (void) const;
+
+  virtual bool Send (Ptr<Packet> packet, const Address &dest,
+                     uint16_t protocolNumber);
+  virtual bool SendFrom (Ptr<Packet> packet, const Address& source,
+                         const Address& dest, uint16_t protocolNumber);
+
+  virtual Ptr<Node> GetNode (void) const;
+  virtual void SetNode (Ptr<Node> node);
+
+  virtual bool NeedsArp (void) const;
+
+  virtual void SetReceiveCallback (NetDevice::ReceiveCallback cb);
+  virtual void SetPromiscReceiveCallback (PromiscReceiveCallback cb);
+  virtual bool SupportsSendFrom (void) const;
+
+protected:
+  virtual void DoInitialize (void);
+  virtual void DoDispose (void);
+  virtual void NotifyNewAggregate (void);
+
+private:
+  /**
+   * \brief Called by the channel, through a beam, when the beam gains or
+   * loses its peer
+   */
+  void BeamAlignmentChanged (Ptr<WirelessPointToPointNetDevice> beam, bool aligned);
+
+  /**
+   * \brief Open the transmit window of the beam of the current slot
+   *
+   * Runs once per slot, at the end of the guard time.
+   */
+  void StartSlot (void);
+
+  /**
+   * \brief Tell the alignment listeners the interface went up or down,
+   * through the channel of the beam that changed so that it is damped like
+   * any other interface
+   */
+  void NotifyInterface (Ptr<WirelessPointToPointNetDevice> beam, bool up);
+
+  /**
+   * \brief Select the transmission queue of a packet, that of the beam
+   * aligned with its next hop
+   *
+   * \param item the packet, with the next hop if it is a QueueDiscItem
+   * \returns the index of the beam, or 0 if no beam is aligned with the
+   *          next hop
+   */
+  uint8_t SelectQueue (Ptr<QueueItem> item) const;
+
+  /**
+   * \returns true if a beam may be given a frame, false if its
+   *          transmission queue is stopped
+   */
+  bool CanSend (uint32_t beam) const;
+
+  /**
+   * \returns the index of the beam aligned with the device of an address,
+   *          or the number of beams if there is none
+   */
+  uint32_t FindBeam (Mac48Address peer) const;
+
+  /**
+   * \brief Pass a frame received by a beam up as received by this device
+   */
+  bool ReceiveFromBeam (Ptr<NetDevice> beam, Ptr<const Packet> packet,
+                        uint16_t protocol, const Address &from);
+
+  /**
+   * \brief Pass a frame received by a beam up the promiscuous callback
+   */
+  bool PromiscReceiveFromBeam (Ptr<NetDevice> beam, Ptr<const Packet> packet,
+                               uint16_t protocol, const Address &from,
+                               const Address &to, PacketType packetType);
+
+  std::vector<Ptr<WirelessPointToPointNetDevice> > m_beams;  //!< The beams
+  std::vector<Mac48Address> m_peers;  //!< Address of the peer of each beam, broadcast if not aligned
+  uint32_t m_alignedBeams;            //!< Number of beams aligned
+  Ptr<NetDeviceQueueInterface> m_queueInterface;  //!< Queue interface, one transmission queue per beam
+
+  Ptr<Node> m_node;         //!< Node owning this NetDevice
+  Mac48Address m_address;   //!< Mac48Address of this NetDevice and its beams
+  uint32_t m_ifIndex;       //!< Index of the interface
+  uint16_t m_mtu;           //!< MTU of the beams
+  NetDevice::ReceiveCallback m_rxCallback;              //!< Receive callback
+  NetDevice::PromiscReceiveCallback m_promiscCallback;  //!< Promiscuous receive callback
+  TracedCallback<> m_linkChangeCallbacks;  //!< Callback for the link change event
+
+  Time m_hoppingSlot;       //!< Length of a slot, guard included; 0 when not hopping
+  Time m_hoppingGuard;      //!< Retargeting time at the start of each slot
+  std::vector<uint32_t> m_schedule;  //!< Beam of each slot of a round; empty for round robin
+  uint64_t m_slot;          //!< Slots started
+  EventId m_slotEvent;      //!< Start of the next slot
+};
+
+} // namespace ns3
+
+#endif /* WPPP_MULTI_BEAM_NET_DEVICE_H */
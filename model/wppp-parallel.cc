@@ -0,0 +1,274 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 University of North Carolina at Chapel Hill
+ * Author: Ben Newton
+ */
+
+#include <unistd.h>
+#include <algorithm>
+#include <vector>
+#include "ns3/log.h"
+#include "wppp-parallel.h"
+
+#ifndef WPPP_NO_THREADS
+#include "ns3/system-thread.h"
+#include "ns3/system-mutex.h"
+#include "ns3/system-condition.h"
+#endif
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("WpppParallel");
+
+#ifndef WPPP_NO_THREADS
+namespace {
+
+//SystemCondition::Wait can miss a Signal sent just before it, so waits are
+//bounded; the conditions are reset before the state is checked, so a wake
+//up sent after the check is not missed and the bound is only a safety net
+const uint64_t WPPP_POOL_POLL_NS = 100000000;
+
+/**
+ * State shared by the threads of one WpppParallel::For call.  Chunks are
+ * handed out dynamically so uneven chunks do not leave threads idle.
+ */
+struct ParallelForJob
+{
+  const Callback<void, uint32_t, uint32_t> *body;
+  SystemMutex mutex;
+  uint32_t next;
+  uint32_t n;
+  uint32_t chunk;
+
+  void Run (void)
+  {
+    while (true)
+      {
+        uint32_t begin;
+        {
+          CriticalSection cs (mutex);
+          begin = next;
+          next = (n - next > chunk) ? next + chunk : n;
+        }
+        if (begin >= n)
+          {
+            return;
+          }
+        uint32_t end = (n - begin > chunk) ? begin + chunk : n;
+        (*body) (begin, end);
+      }
+  }
+};
+
+class ParallelPool;
+
+/**
+ * A thread of the pool, waiting for jobs on its own condition
+ */
+struct ParallelWorker
+{
+  ParallelPool *pool;        //!< Pool the thread belongs to
+  ParallelForJob *job;       //!< Job to help with, or 0; protected by the pool mutex
+  SystemCondition wake;      //!< Set when job is set or the pool stops
+  Ptr<SystemThread> thread;  //!< The thread
+
+  void Run (void);
+};
+
+/**
+ * Threads kept from one WpppParallel::For call to the next
+ */
+class ParallelPool
+{
+public:
+  ParallelPool ()
+    : m_busy (0),
+      m_running (false),
+      m_stopping (false)
+  {
+  }
+
+  ~ParallelPool ()
+  {
+    {
+      CriticalSection cs (m_mutex);
+      m_stopping = true;
+    }
+    for (uint32_t i = 0; i < m_workers.size (); i++)
+      {
+        m_workers[i]->wake.SetCondition (true);
+        m_workers[i]->wake.Signal ();
+      }
+    for (uint32_t i = 0; i < m_workers.size (); i++)
+      {
+        m_workers[i]->thread->Join ();
+        delete m_workers[i];
+      }
+  }
+
+  /**
+   * \brief Run a job on the calling thread and helpers threads of the pool
+   * \returns false, without running the job, if the pool is already running
+   *          one
+   */
+  bool Run (ParallelForJob &job, uint32_t helpers)
+  {
+    {
+      CriticalSection cs (m_mutex);
+      if (m_running)
+        {
+          return false;
+        }
+      m_running = true;
+      while (m_workers.size () < helpers)
+        {
+          ParallelWorker *worker = new ParallelWorker;
+          worker->pool = this;
+          worker->job = 0;
+          worker->thread = Create<SystemThread> (MakeCallback (&ParallelWorker::Run, worker));
+          worker->thread->Start ();
+          m_workers.push_back (worker);
+        }
+      m_busy = helpers;
+      for (uint32_t i = 0; i < helpers; i++)
+        {
+          m_workers[i]->job = &job;
+        }
+    }
+    for (uint32_t i = 0; i < helpers; i++)
+      {
+        m_workers[i]->wake.SetCondition (true);
+        m_workers[i]->wake.Signal ();
+      }
+
+    job.Run ();
+
+    while (true)
+      {
+        {
+          CriticalSection cs (m_mutex);
+          m_done.SetCondition (false);
+          if (m_busy == 0)
+            {
+              m_running = false;
+              return true;
+            }
+        }
+        m_done.TimedWait (WPPP_POOL_POLL_NS);
+      }
+  }
+
+  /**
+   * \brief Wait for a job or the end of the pool
+   * \returns the job, or 0 if the pool stops
+   */
+  ParallelForJob *Wait (ParallelWorker *worker)
+  {
+    while (true)
+      {
+        {
+          CriticalSection cs (m_mutex);
+          worker->wake.SetCondition (false);
+          if (worker->job != 0)
+            {
+              return worker->job;
+            }
+          if (m_stopping)
+            {
+              return 0;
+            }
+        }
+        worker->wake.TimedWait (WPPP_POOL_POLL_NS);
+      }
+  }
+
+  /**
+   * \brief Record that a worker is done with its job
+   */
+  void Done (ParallelWorker *worker)
+  {
+    {
+      CriticalSection cs (m_mutex);
+      worker->job = 0;
+      m_busy--;
+    }
+    m_done.SetCondition (true);
+    m_done.Signal ();
+  }
+
+private:
+  std::vector<ParallelWorker *> m_workers;  //!< Threads started so far
+  SystemMutex m_mutex;                      //!< Protects the jobs of the workers and the counters
+  SystemCondition m_done;                   //!< Set when a worker finishes its job
+  uint32_t m_busy;                          //!< Workers still running the current job
+  bool m_running;                           //!< A job is running
+  bool m_stopping;                          //!< The program is exiting
+};
+
+void
+ParallelWorker::Run (void)
+{
+  ParallelForJob *current;
+  while ((current = pool->Wait (this)) != 0)
+    {
+      current->Run ();
+      pool->Done (this);
+    }
+}
+
+/**
+ * \return the pool of the program, created on first use and stopped at exit
+ */
+ParallelPool &
+GetParallelPool (void)
+{
+  static ParallelPool pool;
+  return pool;
+}
+
+} // anonymous namespace
+#endif
+
+uint32_t
+WpppParallel::GetDefaultThreads (void)
+{
+  long n = sysconf (_SC_NPROCESSORS_ONLN);
+  return n > 0 ? static_cast<uint32_t> (n) : 1;
+}
+
+void
+WpppParallel::For (uint32_t n, uint32_t threads,
+                   Callback<void, uint32_t, uint32_t> body)
+{
+  NS_LOG_FUNCTION (n << threads);
+  if (threads == 0)
+    {
+      threads = GetDefaultThreads ();
+    }
+  threads = std::min (threads, n);
+
+#ifndef WPPP_NO_THREADS
+  if (threads > 1)
+    {
+      ParallelForJob job;
+      job.body = &body;
+      job.next = 0;
+      job.n = n;
+      //a few chunks per thread for load balancing
+      job.chunk = std::max<uint32_t> (1, n / (threads * 4));
+
+      if (GetParallelPool ().Run (job, threads - 1))
+        {
+          return;
+        }
+      //nested or concurrent call, the pool is taken
+    }
+#endif
+
+  if (n > 0)
+    {
+      body (0, n);
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,51 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 University of North Carolina at Chapel Hill
+ * Author: Ben Newton
+ */
+
+#ifndef WPPP_PARALLEL_H
+#define WPPP_PARALLEL_H
+
+#include <stdint.h>
+#include "ns3/callback.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup wireless-point-to-point
+ * \brief Minimal fork/join helper for the offline tools of this module
+ *
+ * Splits an index range into chunks and runs them on a pool of
+ * SystemThreads, the calling thread included, returning once every chunk is
+ * done.  The threads are started by the first call that needs them and wait
+ * for the next call until the program exits, so calling For once per
+ * simulated sample costs no thread creation.  The body must only touch plain
+ * data: Ptr reference counts, logging and the simulator are not thread safe.
+ * A For called from a body, or while another For runs, runs on the calling
+ * thread alone.  Without threading support in the ns-3 build everything runs
+ * on the calling thread.
+ */
+class WpppParallel
+{
+public:
+  /**
+   * \return the number of online processors, at least 1
+   */
+  static uint32_t GetDefaultThreads (void);
+
+  /**
+   * \brief Run body over [0, n)
+   *
+   * \param n size of the index range
+   * \param threads number of threads to use, 0 for GetDefaultThreads ()
+   * \param body called as body (begin, end) for disjoint chunks covering
+   *        the range, possibly concurrently
+   */
+  static void For (uint32_t n, uint32_t threads,
+                   Callback<void, uint32_t, uint32_t> body);
+};
+
+} // namespace ns3
+
+#endif /* WPPP_PARALLEL_H */
@@ -0,0 +1,204 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 University of North Carolina at Chapel Hill
+ * Author: Ben Newton
+ */
+
+#include <algorithm>
+#include <cstring>
+#include "ns3/log.h"
+#include "ns3/assert.h"
+#include "wppp-pcap-writer.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("WpppPcapWriter");
+
+namespace {
+
+const uint32_t WPPP_PCAP_MAGIC = 0xa1b2c3d4;
+const uint32_t WPPP_PCAPNG_SHB = 0x0a0d0d0a;
+const uint32_t WPPP_PCAPNG_IDB = 0x00000001;
+const uint32_t WPPP_PCAPNG_EPB = 0x00000006;
+const uint32_t WPPP_PCAPNG_BYTE_ORDER = 0x1a2b3c4d;
+const uint16_t WPPP_LINKTYPE_PPP = 9;
+const uint16_t WPPP_PCAPNG_OPT_END = 0;
+const uint16_t WPPP_PCAPNG_OPT_IF_NAME = 2;
+const uint16_t WPPP_PCAPNG_OPT_IF_TSRESOL = 9;
+
+void
+PutU16 (uint8_t *buf, uint16_t v)
+{
+  buf[0] = v & 0xff;
+  buf[1] = (v >> 8) & 0xff;
+}
+
+void
+PutU32 (uint8_t *buf, uint32_t v)
+{
+  buf[0] = v & 0xff;
+  buf[1] = (v >> 8) & 0xff;
+  buf[2] = (v >> 16) & 0xff;
+  buf[3] = (v >> 24) & 0xff;
+}
+
+uint32_t
+Pad4 (uint32_t n)
+{
+  return (n + 3) & ~3u;
+}
+
+} // anonymous namespace
+
+WpppPcapWriter::WpppPcapWriter ()
+  : m_format (PCAP),
+    m_snapLen (0),
+    m_bufferSize (0),
+    m_interfaces (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+WpppPcapWriter::~WpppPcapWriter ()
+{
+  NS_LOG_FUNCTION (this);
+  Close ();
+}
+
+bool
+WpppPcapWriter::Open (std::string filename, Format format, uint32_t snapLen, uint32_t bufferSize)
+{
+  NS_LOG_FUNCTION (this << filename << format << snapLen << bufferSize);
+  Close ();
+  m_writer = Create<WpppBackgroundWriter> ();
+  if (!m_writer->Open (filename))
+    {
+      m_writer = 0;
+      return false;
+    }
+  m_format = format;
+  m_snapLen = snapLen;
+  m_bufferSize = std::max<uint32_t> (bufferSize, 4096);
+  m_interfaces = 0;
+  m_buffer.clear ();
+  m_buffer.reserve (m_bufferSize);
+
+  if (m_format == PCAP)
+    {
+      uint8_t *h = Reserve (24);
+      PutU32 (h, WPPP_PCAP_MAGIC);
+      PutU16 (h + 4, 2);              //version 2.4
+      PutU16 (h + 6, 4);
+      PutU32 (h + 8, 0);              //thiszone
+      PutU32 (h + 12, 0);             //sigfigs
+      PutU32 (h + 16, m_snapLen);
+      PutU32 (h + 20, WPPP_LINKTYPE_PPP);
+      m_interfaces = 1;
+    }
+  else
+    {
+      uint8_t *h = Reserve (28);
+      PutU32 (h, WPPP_PCAPNG_SHB);
+      PutU32 (h + 4, 28);
+      PutU32 (h + 8, WPPP_PCAPNG_BYTE_ORDER);
+      PutU16 (h + 12, 1);             //version 1.0
+      PutU16 (h + 14, 0);
+      PutU32 (h + 16, 0xffffffff);    //section length unknown
+      PutU32 (h + 20, 0xffffffff);
+      PutU32 (h + 24, 28);
+    }
+  return true;
+}
+
+uint8_t *
+WpppPcapWriter::Reserve (uint32_t size)
+{
+  if (m_buffer.size () + size > m_bufferSize && !m_buffer.empty ())
+    {
+      m_writer->Write (m_buffer);
+      m_buffer.reserve (m_bufferSize);
+    }
+  uint32_t offset = m_buffer.size ();
+  m_buffer.resize (offset + size);
+  return &m_buffer[offset];
+}
+
+uint32_t
+WpppPcapWriter::AddInterface (std::string name)
+{
+  NS_LOG_FUNCTION (this << name);
+  NS_ASSERT_MSG (m_writer != 0, "Pcap writer is not open");
+  NS_ASSERT_MSG (m_format == PCAPNG, "Only pcapng files hold several interfaces");
+  uint32_t nameLen = name.size ();
+  //block header, if_name, if_tsresol, opt_endofopt and the trailing length
+  uint32_t size = 16 + 4 + Pad4 (nameLen) + 8 + 4 + 4;
+  uint8_t *b = Reserve (size);
+  std::memset (b, 0, size);
+  PutU32 (b, WPPP_PCAPNG_IDB);
+  PutU32 (b + 4, size);
+  PutU16 (b + 8, WPPP_LINKTYPE_PPP);
+  PutU32 (b + 12, m_snapLen);
+  uint8_t *o = b + 16;
+  PutU16 (o, WPPP_PCAPNG_OPT_IF_NAME);
+  PutU16 (o + 2, nameLen);
+  std::memcpy (o + 4, name.data (), nameLen);
+  o += 4 + Pad4 (nameLen);
+  PutU16 (o, WPPP_PCAPNG_OPT_IF_TSRESOL);
+  PutU16 (o + 2, 1);
+  o[4] = 9;                           //nanoseconds
+  o += 8;
+  PutU16 (o, WPPP_PCAPNG_OPT_END);
+  PutU16 (o + 2, 0);
+  PutU32 (b + size - 4, size);
+  return m_interfaces++;
+}
+
+void
+WpppPcapWriter::Write (uint32_t interface, Time time, Ptr<const Packet> p)
+{
+  NS_ASSERT_MSG (m_writer != 0, "Pcap writer is not open");
+  NS_ASSERT_MSG (interface < m_interfaces, "Unknown interface " << interface);
+  uint32_t size = p->GetSize ();
+  uint32_t captured = std::min (size, m_snapLen);
+  uint64_t ns = time.GetNanoSeconds ();
+
+  if (m_format == PCAP)
+    {
+      uint8_t *b = Reserve (16 + captured);
+      uint64_t us = ns / 1000;
+      PutU32 (b, us / 1000000);
+      PutU32 (b + 4, us % 1000000);
+      PutU32 (b + 8, captured);
+      PutU32 (b + 12, size);
+      p->CopyData (b + 16, captured);
+      return;
+    }
+
+  uint32_t blockSize = 28 + Pad4 (captured) + 4;
+  uint8_t *b = Reserve (blockSize);
+  PutU32 (b, WPPP_PCAPNG_EPB);
+  PutU32 (b + 4, blockSize);
+  PutU32 (b + 8, interface);
+  PutU32 (b + 12, ns >> 32);
+  PutU32 (b + 16, ns & 0xffffffff);
+  PutU32 (b + 20, captured);
+  PutU32 (b + 24, size);
+  p->CopyData (b + 28, captured);
+  std::memset (b + 28 + captured, 0, Pad4 (captured) - captured);
+  PutU32 (b + blockSize - 4, blockSize);
+}
+
+void
+WpppPcapWriter::Close (void)
+{
+  if (m_writer == 0)
+    {
+      return;
+    }
+  NS_LOG_FUNCTION (this);
+  m_writer->Write (m_buffer);
+  m_writer->Close ();
+  m_writer = 0;
+}
+
+} // namespace ns3
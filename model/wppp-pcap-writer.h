@@ -0,0 +1,99 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 University of North Carolina at Chapel Hill
+ * Author: Ben Newton
+ */
+
+#ifndef WPPP_PCAP_WRITER_H
+#define WPPP_PCAP_WRITER_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "ns3/simple-ref-count.h"
+#include "ns3/ptr.h"
+#include "ns3/nstime.h"
+#include "ns3/packet.h"
+#include "wppp-background-writer.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup wireless-point-to-point
+ * \brief Buffered pcap and pcapng writer drained by a background thread
+ *
+ * Captured frames are copied, truncated to the snap length, into a large
+ * buffer on the simulation thread.  Full buffers are handed to a
+ * WpppBackgroundWriter, so the simulation thread never waits on the disk
+ * unless the writer thread falls several buffers behind.
+ *
+ * In pcap mode the file is a classic libpcap file with one interface.  In
+ * pcapng mode any number of interfaces can share the file, each described
+ * by its own Interface Description Block, which keeps the number of open
+ * files independent of the number of captured devices.  Both formats use
+ * link type PPP, like PcapHelper::DLT_PPP.
+ */
+class WpppPcapWriter : public SimpleRefCount<WpppPcapWriter>
+{
+public:
+  /**
+   * File formats
+   */
+  enum Format
+  {
+    PCAP,   /**< Classic libpcap format, microsecond timestamps */
+    PCAPNG  /**< pcapng with nanosecond timestamps, many interfaces */
+  };
+
+  WpppPcapWriter ();
+  ~WpppPcapWriter ();
+
+  /**
+   * \brief Create (truncate) a capture file
+   * \param filename path of the file
+   * \param format PCAP or PCAPNG
+   * \param snapLen maximum number of bytes kept of each frame
+   * \param bufferSize bytes collected before a buffer is handed to the
+   *        writer thread
+   * \return true if the file could be opened
+   */
+  bool Open (std::string filename, Format format, uint32_t snapLen, uint32_t bufferSize);
+
+  /**
+   * \brief Describe a new interface of a pcapng file
+   * \param name name recorded in the interface block
+   * \return the interface id to pass to Write
+   */
+  uint32_t AddInterface (std::string name);
+
+  /**
+   * \brief Record a frame
+   * \param interface id returned by AddInterface, 0 in PCAP mode
+   * \param time capture time
+   * \param p the frame; at most the snap length is copied
+   */
+  void Write (uint32_t interface, Time time, Ptr<const Packet> p);
+
+  /**
+   * \brief Write out the frames buffered so far and close the file
+   */
+  void Close (void);
+
+private:
+  /**
+   * \brief Make room for size more bytes, handing a full buffer over
+   * \return pointer to the reserved bytes
+   */
+  uint8_t *Reserve (uint32_t size);
+
+  Ptr<WpppBackgroundWriter> m_writer;  //!< Writer thread
+  Format m_format;                     //!< Format of the file
+  uint32_t m_snapLen;                  //!< Bytes kept of each frame
+  uint32_t m_bufferSize;               //!< Size at which buffers are handed over
+  uint32_t m_interfaces;               //!< Interfaces described so far
+  std::vector<uint8_t> m_buffer;       //!< Buffer being filled
+};
+
+} // namespace ns3
+
+#endif /* WPPP_PCAP_WRITER_H */
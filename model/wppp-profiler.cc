@@ -0,0 +1,142 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 University of North Carolina at Chapel Hill
+ * Author: Ben Newton
+ */
+
+#include <time.h>
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+#include "ns3/simulator.h"
+#include "wppp-profiler.h"
+
+namespace ns3 {
+
+bool WpppProfiler::s_started = false;
+uint64_t WpppProfiler::s_startTicks = 0;
+uint64_t WpppProfiler::s_startNs = 0;
+uint64_t WpppProfiler::s_calls[WpppProfiler::SITES];
+uint64_t WpppProfiler::s_ticks[WpppProfiler::SITES];
+const char *WpppProfiler::s_names[WpppProfiler::SITES] = {
+  "Device::Send",
+  "Device::TransmitStart",
+  "Device::TransmitComplete",
+  "Device::Receive",
+  "Device::Receive (stack)",
+  "Channel::TransmitStart",
+  "Channel::Connect",
+  "Channel::Disconnect"
+};
+
+WpppProfileScope *WpppProfileScope::s_current = 0;
+
+namespace {
+
+/**
+ * \brief Orders sites by decreasing self time
+ */
+struct WpppBySelfTime
+{
+  explicit WpppBySelfTime (const uint64_t *ticks)
+    : m_ticks (ticks)
+  {
+  }
+  bool operator() (uint32_t a, uint32_t b) const
+  {
+    return m_ticks[a] > m_ticks[b];
+  }
+  const uint64_t *m_ticks;  //!< Self time per site
+};
+
+} // anonymous namespace
+
+uint64_t
+WpppProfiler::GetNanoSeconds (void)
+{
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return uint64_t (ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+void
+WpppProfiler::Start (void)
+{
+  std::fill (s_calls, s_calls + SITES, 0);
+  std::fill (s_ticks, s_ticks + SITES, 0);
+  s_startTicks = GetTicks ();
+  s_startNs = GetNanoSeconds ();
+  s_started = true;
+  Simulator::ScheduleDestroy (&WpppProfiler::ReportAtDestroy);
+}
+
+void
+WpppProfiler::Reset (void)
+{
+  s_started = false;
+}
+
+void
+WpppProfiler::ReportAtDestroy (void)
+{
+  if (s_started)
+    {
+      Report (std::clog);
+      Reset ();
+    }
+}
+
+void
+WpppProfiler::Report (std::ostream &os)
+{
+  if (!s_started)
+    {
+      os << "wppp profile: nothing recorded" << std::endl;
+      return;
+    }
+  uint64_t runTicks = std::max<uint64_t> (GetTicks () - s_startTicks, 1);
+  uint64_t runNs = GetNanoSeconds () - s_startNs;
+  double nsPerTick = double (runNs) / runTicks;
+
+  std::vector<uint32_t> order;
+  uint64_t moduleTicks = 0;
+  for (uint32_t i = 0; i < SITES; i++)
+    {
+      order.push_back (i);
+      moduleTicks += s_ticks[i];
+    }
+  std::sort (order.begin (), order.end (), WpppBySelfTime (s_ticks));
+
+  std::ios::fmtflags flags = os.flags ();
+  os << std::fixed;
+  os << "wppp profile: " << std::setprecision (3) << runNs / 1e9 << " s run" << std::endl;
+  os << std::left << std::setw (26) << "site" << std::right
+     << std::setw (14) << "calls" << std::setw (12) << "self ms"
+     << std::setw (10) << "ns/call" << std::setw (8) << "%run" << std::endl;
+  for (uint32_t j = 0; j < order.size (); j++)
+    {
+      uint32_t i = order[j];
+      if (s_calls[i] == 0)
+        {
+          continue;
+        }
+      double ns = s_ticks[i] * nsPerTick;
+      os << std::left << std::setw (26) << s_names[i] << std::right
+         << std::setw (14) << s_calls[i]
+         << std::setw (12) << std::setprecision (1) << ns / 1e6
+         << std::setw (10) << std::setprecision (0) << ns / s_calls[i]
+         << std::setw (8) << std::setprecision (1) << 100.0 * s_ticks[i] / runTicks
+         << std::endl;
+    }
+  double outside = runTicks > moduleTicks ? (runTicks - moduleTicks) * nsPerTick : 0;
+  os << std::left << std::setw (26) << "(outside the module)" << std::right
+     << std::setw (14) << "-"
+     << std::setw (12) << std::setprecision (1) << outside / 1e6
+     << std::setw (10) << "-"
+     << std::setw (8) << std::setprecision (1) << 100.0 * outside / std::max<uint64_t> (runNs, 1)
+     << std::endl;
+  os.flags (flags);
+}
+
+} // namespace ns3
@@ -0,0 +1,178 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 University of North Carolina at Chapel Hill
+ * Author: Ben Newton
+ */
+
+#ifndef WPPP_PROFILER_H
+#define WPPP_PROFILER_H
+
+#include <stdint.h>
+#include <ostream>
+
+/**
+ * \ingroup wireless-point-to-point
+ * \brief Time the enclosing block as a WpppProfiler site
+ *
+ * Expands to nothing unless the module is configured with
+ * --enable-wppp-profiler, which defines WPPP_PROFILE.
+ */
+#ifdef WPPP_PROFILE
+#define WPPP_PROFILE_SCOPE(site) \
+  ns3::WpppProfileScope wpppProfileScope_ (ns3::WpppProfiler::site)
+#else
+#define WPPP_PROFILE_SCOPE(site)
+#endif
+
+namespace ns3 {
+
+/**
+ * \ingroup wireless-point-to-point
+ * \brief Call counts and self time of the hot paths of the module
+ *
+ * Each site is timed with the time stamp counter (or a monotonic clock on
+ * other processors) by a WpppProfileScope.  The time of a site excludes the
+ * sites it calls, so channel lookups in WirelessPointToPointChannel::
+ * TransmitStart are not charged to the device.  The report, written to
+ * std::clog at Simulator::Destroy, also shows the run time spent outside
+ * the module: the scheduler, the protocol stacks and the trace sinks other
+ * than those called from a timed site.
+ *
+ * The profiler keeps global counters and is meant for the simulation
+ * thread only.
+ */
+class WpppProfiler
+{
+public:
+  /**
+   * Timed code paths
+   */
+  enum Site
+  {
+    DEVICE_SEND = 0,            /**< WirelessPointToPointNetDevice::Send */
+    DEVICE_TRANSMIT_START,      /**< WirelessPointToPointNetDevice::TransmitStart */
+    DEVICE_TRANSMIT_COMPLETE,   /**< WirelessPointToPointNetDevice::TransmitComplete */
+    DEVICE_RECEIVE,             /**< WirelessPointToPointNetDevice::Receive */
+    DEVICE_RECEIVE_UP,          /**< Receive callbacks into the protocol stack */
+    CHANNEL_TRANSMIT_START,     /**< WirelessPointToPointChannel::TransmitStart */
+    CHANNEL_CONNECT,            /**< WirelessPointToPointChannel::Connect */
+    CHANNEL_DISCONNECT,         /**< WirelessPointToPointChannel::Disconnect */
+    SITES                       /**< Number of sites */
+  };
+
+  /**
+   * \return the current value of the profiling clock, in ticks
+   */
+  static inline uint64_t GetTicks (void);
+
+  /**
+   * \brief Count a call of a site
+   * \param site the site
+   * \param ticks time spent in the site, excluding the sites it called
+   */
+  static inline void Add (Site site, uint64_t ticks);
+
+  /**
+   * \brief Write the sites sorted by self time
+   * \param os stream to write to
+   */
+  static void Report (std::ostream &os);
+
+  /**
+   * \brief Forget the counts; the run time is measured from the next call
+   */
+  static void Reset (void);
+
+private:
+  /**
+   * \brief Note the start of the run and arrange the report at
+   * Simulator::Destroy
+   */
+  static void Start (void);
+
+  /**
+   * \brief Write the report to std::clog and reset
+   */
+  static void ReportAtDestroy (void);
+
+  /**
+   * \return the monotonic clock, in ns
+   */
+  static uint64_t GetNanoSeconds (void);
+
+  static bool s_started;            //!< Start has run since the last Reset
+  static uint64_t s_startTicks;     //!< Profiling clock at Start
+  static uint64_t s_startNs;        //!< Monotonic clock at Start
+  static uint64_t s_calls[SITES];   //!< Calls per site
+  static uint64_t s_ticks[SITES];   //!< Self time per site
+  static const char *s_names[SITES];  //!< Printed name of each site
+};
+
+/**
+ * \ingroup wireless-point-to-point
+ * \brief Charges the time until it goes out of scope to a WpppProfiler site
+ */
+class WpppProfileScope
+{
+public:
+  /**
+   * \param site the site the enclosing block belongs to
+   */
+  explicit inline WpppProfileScope (WpppProfiler::Site site);
+  inline ~WpppProfileScope ();
+
+private:
+  WpppProfiler::Site m_site;     //!< Site being timed
+  uint64_t m_start;              //!< Clock when the scope was entered
+  uint64_t m_children;           //!< Time spent in nested scopes
+  WpppProfileScope *m_parent;    //!< Enclosing scope, if any
+  static WpppProfileScope *s_current;  //!< Innermost open scope
+};
+
+uint64_t
+WpppProfiler::GetTicks (void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+  uint32_t lo;
+  uint32_t hi;
+  __asm__ __volatile__ ("rdtsc" : "=a" (lo), "=d" (hi));
+  return (uint64_t (hi) << 32) | lo;
+#else
+  return GetNanoSeconds ();
+#endif
+}
+
+void
+WpppProfiler::Add (Site site, uint64_t ticks)
+{
+  if (!s_started)
+    {
+      Start ();
+    }
+  s_calls[site]++;
+  s_ticks[site] += ticks;
+}
+
+WpppProfileScope::WpppProfileScope (WpppProfiler::Site site)
+  : m_site (site),
+    m_start (WpppProfiler::GetTicks ()),
+    m_children (0),
+    m_parent (s_current)
+{
+  s_current = this;
+}
+
+WpppProfileScope::~WpppProfileScope ()
+{
+  uint64_t elapsed = WpppProfiler::GetTicks () - m_start;
+  s_current = m_parent;
+  if (m_parent != 0)
+    {
+      m_parent->m_children += elapsed;
+    }
+  WpppProfiler::Add (m_site, elapsed - m_children);
+}
+
+} // namespace ns3
+
+#endif /* WPPP_PROFILER_H */
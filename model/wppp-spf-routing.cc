@@ -0,0 +1,369 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 University of North Carolina at Chapel Hill
+ * Author: Ben Newton
+ */
+
+#include "ns3/log.h"
+#include "ns3/node.h"
+#include "ns3/simulator.h"
+#include "ns3/ipv4-route.h"
+#include "ns3/output-stream-wrapper.h"
+#include "wppp-spf-routing.h"
+#include "wireless-point-to-point-net-device.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("WpppSpfRouting");
+
+NS_OBJECT_ENSURE_REGISTERED (WpppSpfTopology);
+NS_OBJECT_ENSURE_REGISTERED (WpppSpfRouting);
+
+TypeId
+WpppSpfTopology::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::WpppSpfTopology")
+    .SetParent<Object> ()
+    .SetGroupName ("WirelessPointToPoint")
+    .AddConstructor<WpppSpfTopology> ()
+  ;
+  return tid;
+}
+
+WpppSpfTopology::WpppSpfTopology ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+WpppSpfTopology::~WpppSpfTopology ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+WpppSpfTopology::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_links.clear ();
+  m_peers.clear ();
+  Object::DoDispose ();
+}
+
+void
+WpppSpfTopology::LinkUp (Ptr<WirelessPointToPointNetDevice> a, Ptr<WirelessPointToPointNetDevice> b)
+{
+  NS_LOG_FUNCTION (this << a << b);
+  std::map<Ptr<WirelessPointToPointNetDevice>, Ptr<WirelessPointToPointNetDevice> >::iterator i;
+  i = m_peers.find (a);
+  if (i != m_peers.end ())
+    {
+      if (i->second == b)
+        {
+          return;
+        }
+      LinkDown (a, i->second);
+    }
+  i = m_peers.find (b);
+  if (i != m_peers.end ())
+    {
+      LinkDown (b, i->second);
+    }
+  uint32_t na = a->GetNode ()->GetId ();
+  uint32_t nb = b->GetNode ()->GetId ();
+  m_peers[a] = b;
+  m_peers[b] = a;
+  m_links[std::make_pair (na, nb)].push_back (std::make_pair (a, b));
+  m_links[std::make_pair (nb, na)].push_back (std::make_pair (b, a));
+  m_spf.AddLink (na, nb);
+}
+
+void
+WpppSpfTopology::RemoveDirected (Ptr<WirelessPointToPointNetDevice> device, Ptr<WirelessPointToPointNetDevice> peer)
+{
+  std::pair<uint32_t, uint32_t> key (device->GetNode ()->GetId (), peer->GetNode ()->GetId ());
+  std::map<std::pair<uint32_t, uint32_t>, Links>::iterator i = m_links.find (key);
+  if (i == m_links.end ())
+    {
+      return;
+    }
+  Links &links = i->second;
+  for (uint32_t j = 0; j < links.size (); j++)
+    {
+      if (links[j].first == device)
+        {
+          links[j] = links.back ();
+          links.pop_back ();
+          break;
+        }
+    }
+  if (links.empty ())
+    {
+      m_links.erase (i);
+    }
+}
+
+void
+WpppSpfTopology::LinkDown (Ptr<WirelessPointToPointNetDevice> a, Ptr<WirelessPointToPointNetDevice> b)
+{
+  NS_LOG_FUNCTION (this << a << b);
+  std::map<Ptr<WirelessPointToPointNetDevice>, Ptr<WirelessPointToPointNetDevice> >::iterator i = m_peers.find (a);
+  if (i == m_peers.end () || i->second != b)
+    {
+      return;
+    }
+  m_peers.erase (i);
+  m_peers.erase (b);
+  RemoveDirected (a, b);
+  RemoveDirected (b, a);
+  m_spf.RemoveLink (a->GetNode ()->GetId (), b->GetNode ()->GetId ());
+}
+
+void
+WpppSpfTopology::AddAddress (Ipv4Address address, uint32_t node)
+{
+  NS_LOG_FUNCTION (this << address << node);
+  m_addresses[address] = node;
+}
+
+void
+WpppSpfTopology::RemoveAddress (Ipv4Address address)
+{
+  NS_LOG_FUNCTION (this << address);
+  m_addresses.erase (address);
+}
+
+bool
+WpppSpfTopology::Lookup (uint32_t node, Ipv4Address destination,
+                         Ptr<WirelessPointToPointNetDevice> &device,
+                         Ptr<WirelessPointToPointNetDevice> &peer)
+{
+  std::map<Ipv4Address, uint32_t>::const_iterator i = m_addresses.find (destination);
+  if (i == m_addresses.end () || i->second == node)
+    {
+      return false;
+    }
+  uint32_t next = m_spf.GetNextHop (node, i->second);
+  if (next == WpppSpf::UNREACHABLE)
+    {
+      return false;
+    }
+  std::map<std::pair<uint32_t, uint32_t>, Links>::const_iterator j = m_links.find (std::make_pair (node, next));
+  NS_ASSERT_MSG (j != m_links.end (), "Next hop without a link");
+  device = j->second.front ().first;
+  peer = j->second.front ().second;
+  return true;
+}
+
+uint32_t
+WpppSpfTopology::GetDistance (uint32_t node, Ipv4Address destination)
+{
+  std::map<Ipv4Address, uint32_t>::const_iterator i = m_addresses.find (destination);
+  if (i == m_addresses.end ())
+    {
+      return WpppSpf::UNREACHABLE;
+    }
+  return m_spf.GetDistance (node, i->second);
+}
+
+const WpppSpf &
+WpppSpfTopology::GetSpf (void) const
+{
+  return m_spf;
+}
+
+TypeId
+WpppSpfRouting::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::WpppSpfRouting")
+    .SetParent<Ipv4RoutingProtocol> ()
+    .SetGroupName ("WirelessPointToPoint")
+    .AddConstructor<WpppSpfRouting> ()
+  ;
+  return tid;
+}
+
+WpppSpfRouting::WpppSpfRouting ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+WpppSpfRouting::~WpppSpfRouting ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+WpppSpfRouting::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_ipv4 = 0;
+  m_topology = 0;
+  Ipv4RoutingProtocol::DoDispose ();
+}
+
+void
+WpppSpfRouting::SetTopology (Ptr<WpppSpfTopology> topology)
+{
+  NS_LOG_FUNCTION (this << topology);
+  m_topology = topology;
+}
+
+//
+// The interface a beam belongs to is that of its owner
+//
+static Ptr<NetDevice>
+GetInterfaceDevice (Ptr<WirelessPointToPointNetDevice> device)
+{
+  Ptr<NetDevice> owner = device->GetBeamOwner ();
+  return owner != 0 ? owner : Ptr<NetDevice> (device);
+}
+
+Ptr<Ipv4Route>
+WpppSpfRouting::Lookup (Ipv4Address destination, Ptr<NetDevice> oif)
+{
+  Ptr<WirelessPointToPointNetDevice> device;
+  Ptr<WirelessPointToPointNetDevice> peer;
+  if (m_topology == 0 ||
+      !m_topology->Lookup (m_ipv4->GetObject<Node> ()->GetId (), destination, device, peer))
+    {
+      return 0;
+    }
+  Ptr<NetDevice> out = GetInterfaceDevice (device);
+  if (oif != 0 && oif != out)
+    {
+      return 0;
+    }
+  int32_t interface = m_ipv4->GetInterfaceForDevice (out);
+  if (interface < 0 || m_ipv4->GetNAddresses (interface) == 0)
+    {
+      return 0;
+    }
+
+  //the gateway only matters to devices that resolve it with ARP
+  Ipv4Address gateway = Ipv4Address::GetZero ();
+  Ptr<NetDevice> peerOut = GetInterfaceDevice (peer);
+  Ptr<Ipv4> peerIpv4 = peerOut->GetNode ()->GetObject<Ipv4> ();
+  if (peerIpv4 != 0)
+    {
+      int32_t peerInterface = peerIpv4->GetInterfaceForDevice (peerOut);
+      if (peerInterface >= 0 && peerIpv4->GetNAddresses (peerInterface) > 0)
+        {
+          gateway = peerIpv4->GetAddress (peerInterface, 0).GetLocal ();
+        }
+    }
+
+  Ptr<Ipv4Route> route = Create<Ipv4Route> ();
+  route->SetDestination (destination);
+  route->SetGateway (gateway);
+  route->SetSource (m_ipv4->GetAddress (interface, 0).GetLocal ());
+  route->SetOutputDevice (out);
+  return route;
+}
+
+Ptr<Ipv4Route>
+WpppSpfRouting::RouteOutput (Ptr<Packet> p, const Ipv4Header &header,
+                             Ptr<NetDevice> oif, Socket::SocketErrno &sockerr)
+{
+  NS_LOG_FUNCTION (this << p << header.GetDestination () << oif);
+  Ptr<Ipv4Route> route = Lookup (header.GetDestination (), oif);
+  sockerr = route != 0 ? Socket::ERROR_NOTERROR : Socket::ERROR_NOROUTETOHOST;
+  return route;
+}
+
+bool
+WpppSpfRouting::RouteInput (Ptr<const Packet> p, const Ipv4Header &header,
+                            Ptr<const NetDevice> idev, UnicastForwardCallback ucb,
+                            MulticastForwardCallback mcb, LocalDeliverCallback lcb,
+                            ErrorCallback ecb)
+{
+  NS_LOG_FUNCTION (this << p << header.GetDestination () << idev);
+  NS_ASSERT (m_ipv4 != 0);
+  uint32_t iif = m_ipv4->GetInterfaceForDevice (idev);
+
+  if (m_ipv4->IsDestinationAddress (header.GetDestination (), iif))
+    {
+      if (lcb.IsNull ())
+        {
+          return false;
+        }
+      lcb (p, header, iif);
+      return true;
+    }
+  if (header.GetDestination ().IsMulticast () || header.GetDestination ().IsBroadcast ())
+    {
+      return false;
+    }
+  if (!m_ipv4->IsForwarding (iif))
+    {
+      ecb (p, header, Socket::ERROR_NOROUTETOHOST);
+      return true;
+    }
+  Ptr<Ipv4Route> route = Lookup (header.GetDestination (), 0);
+  if (route == 0)
+    {
+      return false;
+    }
+  ucb (route, p, header);
+  return true;
+}
+
+void
+WpppSpfRouting::NotifyInterfaceUp (uint32_t interface)
+{
+}
+
+void
+WpppSpfRouting::NotifyInterfaceDown (uint32_t interface)
+{
+}
+
+void
+WpppSpfRouting::NotifyAddAddress (uint32_t interface, Ipv4InterfaceAddress address)
+{
+  NS_LOG_FUNCTION (this << interface << address);
+  if (m_topology != 0 && m_ipv4 != 0 && !address.GetLocal ().IsLocalhost ())
+    {
+      m_topology->AddAddress (address.GetLocal (), m_ipv4->GetObject<Node> ()->GetId ());
+    }
+}
+
+void
+WpppSpfRouting::NotifyRemoveAddress (uint32_t interface, Ipv4InterfaceAddress address)
+{
+  NS_LOG_FUNCTION (this << interface << address);
+  if (m_topology != 0)
+    {
+      m_topology->RemoveAddress (address.GetLocal ());
+    }
+}
+
+void
+WpppSpfRouting::SetIpv4 (Ptr<Ipv4> ipv4)
+{
+  NS_LOG_FUNCTION (this << ipv4);
+  NS_ASSERT (m_ipv4 == 0 && ipv4 != 0);
+  m_ipv4 = ipv4;
+  for (uint32_t i = 0; i < m_ipv4->GetNInterfaces (); i++)
+    {
+      for (uint32_t j = 0; j < m_ipv4->GetNAddresses (i); j++)
+        {
+          NotifyAddAddress (i, m_ipv4->GetAddress (i, j));
+        }
+    }
+}
+
+void
+WpppSpfRouting::PrintRoutingTable (Ptr<OutputStreamWrapper> stream) const
+{
+  std::ostream *os = stream->GetStream ();
+  *os << "Node: " << m_ipv4->GetObject<Node> ()->GetId ()
+      << ", Time: " << Simulator::Now ().GetSeconds () << "s"
+      << ", WpppSpfRouting" << std::endl;
+  if (m_topology != 0)
+    {
+      *os << "Routes follow the shortest aligned paths, " << m_topology->GetSpf ().GetNNodes ()
+          << " nodes known" << std::endl;
+    }
+}
+
+} // namespace ns3
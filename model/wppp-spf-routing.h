@@ -0,0 +1,170 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 University of North Carolina at Chapel Hill
+ * Author: Ben Newton
+ */
+
+#ifndef WPPP_SPF_ROUTING_H
+#define WPPP_SPF_ROUTING_H
+
+#include <map>
+#include <utility>
+#include <vector>
+#include "ns3/object.h"
+#include "ns3/ptr.h"
+#include "ns3/ipv4.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/ipv4-routing-protocol.h"
+#include "wppp-spf.h"
+
+namespace ns3 {
+
+class WirelessPointToPointNetDevice;
+
+/**
+ * \ingroup wireless-point-to-point
+ * \brief The aligned links and node addresses WpppSpfRouting routes over
+ *
+ * Fed by the channels it is set on (WirelessPointToPointChannel::SetSpfTopology)
+ * each time a pair of devices is aligned or broken, and by the routing
+ * protocols of the nodes with their addresses.  Paths are kept by a WpppSpf
+ * shared by all the nodes, so a link change repairs the trees that it
+ * affects and nothing else.
+ */
+class WpppSpfTopology : public Object
+{
+public:
+  /**
+   * \brief Get the TypeId
+   *
+   * \return The TypeId for this class
+   */
+  static TypeId GetTypeId (void);
+
+  WpppSpfTopology ();
+  virtual ~WpppSpfTopology ();
+
+  /**
+   * \brief Record that two devices are aligned with each other
+   *
+   * A device aligned with another peer before is first unlinked from it.
+   */
+  void LinkUp (Ptr<WirelessPointToPointNetDevice> a, Ptr<WirelessPointToPointNetDevice> b);
+
+  /**
+   * \brief Record that two devices are no longer aligned
+   */
+  void LinkDown (Ptr<WirelessPointToPointNetDevice> a, Ptr<WirelessPointToPointNetDevice> b);
+
+  /**
+   * \brief Record that an address belongs to a node
+   */
+  void AddAddress (Ipv4Address address, uint32_t node);
+
+  /**
+   * \brief Forget an address recorded by AddAddress
+   */
+  void RemoveAddress (Ipv4Address address);
+
+  /**
+   * \brief Find the first link of a shortest path
+   * \param node the node the path starts from
+   * \param destination address of the node the path goes to
+   * \param device set to the device of node the path leaves through
+   * \param peer set to the device of the next hop
+   * \returns false if the destination is unknown, the node itself or
+   *          unreachable
+   */
+  bool Lookup (uint32_t node, Ipv4Address destination,
+               Ptr<WirelessPointToPointNetDevice> &device,
+               Ptr<WirelessPointToPointNetDevice> &peer);
+
+  /**
+   * \return the hops from a node to the node owning an address, or
+   *         WpppSpf::UNREACHABLE
+   */
+  uint32_t GetDistance (uint32_t node, Ipv4Address destination);
+
+  /**
+   * \return the shortest paths
+   */
+  const WpppSpf &GetSpf (void) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /// Devices of the links from one node to another, local device first
+  typedef std::vector<std::pair<Ptr<WirelessPointToPointNetDevice>, Ptr<WirelessPointToPointNetDevice> > > Links;
+
+  /**
+   * \brief Forget the link of a device from its node to the peer's node
+   */
+  void RemoveDirected (Ptr<WirelessPointToPointNetDevice> device, Ptr<WirelessPointToPointNetDevice> peer);
+
+  WpppSpf m_spf;                                          //!< Shortest paths between node ids
+  std::map<std::pair<uint32_t, uint32_t>, Links> m_links; //!< Devices of the links between two nodes
+  std::map<Ptr<WirelessPointToPointNetDevice>, Ptr<WirelessPointToPointNetDevice> > m_peers; //!< Peer of each linked device
+  std::map<Ipv4Address, uint32_t> m_addresses;            //!< Node of each address
+};
+
+/**
+ * \ingroup wireless-point-to-point
+ * \brief IPv4 routing along shortest paths over aligned wppp links
+ *
+ * Routes to the addresses of other nodes through the first link of a
+ * shortest path in hops, as kept by a WpppSpfTopology shared by every node.
+ * The channels feed the topology directly, so NotifyInterfaceUp and
+ * NotifyInterfaceDown do nothing and no routing table is rebuilt when a
+ * link changes.  Only host routes to node addresses are known; combine it
+ * with Ipv4StaticRouting in an Ipv4ListRouting for anything else.
+ */
+class WpppSpfRouting : public Ipv4RoutingProtocol
+{
+public:
+  /**
+   * \brief Get the TypeId
+   *
+   * \return The TypeId for this class
+   */
+  static TypeId GetTypeId (void);
+
+  WpppSpfRouting ();
+  virtual ~WpppSpfRouting ();
+
+  /**
+   * \brief Set the topology shared by the nodes
+   */
+  void SetTopology (Ptr<WpppSpfTopology> topology);
+
+  // Inherited from Ipv4RoutingProtocol
+  virtual Ptr<Ipv4Route> RouteOutput (Ptr<Packet> p, const Ipv4Header &header,
+                                      Ptr<NetDevice> oif, Socket::SocketErrno &sockerr);
+  virtual bool RouteInput (Ptr<const Packet> p, const Ipv4Header &header,
+                           Ptr<const NetDevice> idev, UnicastForwardCallback ucb,
+                           MulticastForwardCallback mcb, LocalDeliverCallback lcb,
+                           ErrorCallback ecb);
+  virtual void NotifyInterfaceUp (uint32_t interface);
+  virtual void NotifyInterfaceDown (uint32_t interface);
+  virtual void NotifyAddAddress (uint32_t interface, Ipv4InterfaceAddress address);
+  virtual void NotifyRemoveAddress (uint32_t interface, Ipv4InterfaceAddress address);
+  virtual void SetIpv4 (Ptr<Ipv4> ipv4);
+  virtual void PrintRoutingTable (Ptr<OutputStreamWrapper> stream) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /**
+   * \brief Build the route to a destination
+   * \returns the route, or 0 if there is none
+   */
+  Ptr<Ipv4Route> Lookup (Ipv4Address destination, Ptr<NetDevice> oif);
+
+  Ptr<Ipv4> m_ipv4;                   //!< Stack of the node
+  Ptr<WpppSpfTopology> m_topology;    //!< Links and addresses of every node
+};
+
+} // namespace ns3
+
+#endif /* WPPP_SPF_ROUTING_H */
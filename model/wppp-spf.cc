@@ -0,0 +1,358 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 University of North Carolina at Chapel Hill
+ * Author: Ben Newton
+ */
+
+#include <algorithm>
+#include <functional>
+#include "wppp-spf.h"
+
+namespace ns3 {
+
+const uint32_t WpppSpf::UNREACHABLE;
+const uint32_t WpppSpf::NONE;
+
+WpppSpf::WpppSpf ()
+  : m_work (0)
+{
+}
+
+WpppSpf::~WpppSpf ()
+{
+  for (uint32_t i = 0; i < m_trees.size (); i++)
+    {
+      delete m_trees[i];
+    }
+}
+
+void
+WpppSpf::Grow (uint32_t n)
+{
+  if (n < m_adj.size ())
+    {
+      return;
+    }
+  uint32_t size = std::max<uint32_t> (n + 1, 2 * m_adj.size ());
+  m_adj.resize (size);
+  m_trees.resize (size, 0);
+  m_inSubtree.resize (size, false);
+  for (uint32_t s = 0; s < m_trees.size (); s++)
+    {
+      Tree *tree = m_trees[s];
+      if (tree != 0)
+        {
+          tree->dist.resize (size, UNREACHABLE);
+          tree->parent.resize (size, NONE);
+          tree->firstHop.resize (size, NONE);
+          tree->child.resize (size, NONE);
+          tree->next.resize (size, NONE);
+          tree->prev.resize (size, NONE);
+        }
+    }
+}
+
+uint32_t
+WpppSpf::GetNNodes (void) const
+{
+  return m_adj.size ();
+}
+
+uint64_t
+WpppSpf::GetWork (void) const
+{
+  return m_work;
+}
+
+bool
+WpppSpf::HasLink (uint32_t a, uint32_t b) const
+{
+  if (a >= m_adj.size ())
+    {
+      return false;
+    }
+  for (uint32_t i = 0; i < m_adj[a].size (); i++)
+    {
+      if (m_adj[a][i].first == b)
+        {
+          return true;
+        }
+    }
+  return false;
+}
+
+void
+WpppSpf::Attach (Tree &tree, uint32_t v, uint32_t p, uint32_t d)
+{
+  tree.dist[v] = d;
+  tree.parent[v] = p;
+  tree.prev[v] = NONE;
+  tree.next[v] = tree.child[p];
+  if (tree.child[p] != NONE)
+    {
+      tree.prev[tree.child[p]] = v;
+    }
+  tree.child[p] = v;
+}
+
+void
+WpppSpf::Detach (Tree &tree, uint32_t v)
+{
+  uint32_t p = tree.parent[v];
+  if (p == NONE)
+    {
+      return;
+    }
+  if (tree.prev[v] != NONE)
+    {
+      tree.next[tree.prev[v]] = tree.next[v];
+    }
+  else
+    {
+      tree.child[p] = tree.next[v];
+    }
+  if (tree.next[v] != NONE)
+    {
+      tree.prev[tree.next[v]] = tree.prev[v];
+    }
+  tree.parent[v] = NONE;
+  tree.next[v] = NONE;
+  tree.prev[v] = NONE;
+}
+
+void
+WpppSpf::Propagate (Tree &tree, uint32_t src, std::vector<HeapEntry> &heap)
+{
+  std::greater<HeapEntry> cmp;
+  std::make_heap (heap.begin (), heap.end (), cmp);
+  while (!heap.empty ())
+    {
+      std::pop_heap (heap.begin (), heap.end (), cmp);
+      HeapEntry top = heap.back ();
+      heap.pop_back ();
+      uint32_t v = top.second;
+      if (top.first != tree.dist[v])
+        {
+          //stale entry, v was settled closer since
+          continue;
+        }
+      m_work++;
+      //the parent of v was settled before v, or did not move
+      uint32_t p = tree.parent[v];
+      tree.firstHop[v] = p == src ? v : tree.firstHop[p];
+      uint32_t d = tree.dist[v] + 1;
+      const std::vector<Edge> &edges = m_adj[v];
+      for (uint32_t i = 0; i < edges.size (); i++)
+        {
+          uint32_t w = edges[i].first;
+          if (d < tree.dist[w])
+            {
+              Detach (tree, w);
+              Attach (tree, w, v, d);
+              heap.push_back (HeapEntry (d, w));
+              std::push_heap (heap.begin (), heap.end (), cmp);
+            }
+        }
+    }
+}
+
+WpppSpf::Tree &
+WpppSpf::GetTree (uint32_t src)
+{
+  Grow (src);
+  if (m_trees[src] == 0)
+    {
+      uint32_t size = m_adj.size ();
+      Tree *tree = new Tree;
+      tree->dist.assign (size, UNREACHABLE);
+      tree->parent.assign (size, NONE);
+      tree->firstHop.assign (size, NONE);
+      tree->child.assign (size, NONE);
+      tree->next.assign (size, NONE);
+      tree->prev.assign (size, NONE);
+      tree->dist[src] = 0;
+      tree->firstHop[src] = src;
+      m_trees[src] = tree;
+
+      //settle the neighbors of the source by hand, the root has no first hop
+      m_work++;
+      std::vector<HeapEntry> heap;
+      for (uint32_t i = 0; i < m_adj[src].size (); i++)
+        {
+          uint32_t w = m_adj[src][i].first;
+          Attach (*tree, w, src, 1);
+          heap.push_back (HeapEntry (1, w));
+        }
+      Propagate (*tree, src, heap);
+    }
+  return *m_trees[src];
+}
+
+void
+WpppSpf::AddLink (uint32_t a, uint32_t b)
+{
+  if (a == b)
+    {
+      return;
+    }
+  Grow (std::max (a, b));
+  for (uint32_t i = 0; i < m_adj[a].size (); i++)
+    {
+      if (m_adj[a][i].first == b)
+        {
+          //parallel link, the paths do not change
+          m_adj[a][i].second++;
+          for (uint32_t j = 0; j < m_adj[b].size (); j++)
+            {
+              if (m_adj[b][j].first == a)
+                {
+                  m_adj[b][j].second++;
+                }
+            }
+          return;
+        }
+    }
+  m_adj[a].push_back (Edge (b, 1));
+  m_adj[b].push_back (Edge (a, 1));
+
+  std::vector<HeapEntry> heap;
+  for (uint32_t s = 0; s < m_trees.size (); s++)
+    {
+      Tree *tree = m_trees[s];
+      if (tree == 0)
+        {
+          continue;
+        }
+      //at most one end gets closer to the source
+      uint32_t u = tree->dist[a] <= tree->dist[b] ? a : b;
+      uint32_t v = u == a ? b : a;
+      if (tree->dist[u] == UNREACHABLE || tree->dist[u] + 1 >= tree->dist[v])
+        {
+          continue;
+        }
+      Detach (*tree, v);
+      Attach (*tree, v, u, tree->dist[u] + 1);
+      heap.clear ();
+      heap.push_back (HeapEntry (tree->dist[v], v));
+      Propagate (*tree, s, heap);
+    }
+}
+
+void
+WpppSpf::RemoveLink (uint32_t a, uint32_t b)
+{
+  if (a == b || !HasLink (a, b))
+    {
+      return;
+    }
+  bool last = false;
+  for (uint32_t end = 0; end < 2; end++)
+    {
+      std::vector<Edge> &edges = m_adj[end == 0 ? a : b];
+      uint32_t other = end == 0 ? b : a;
+      for (uint32_t i = 0; i < edges.size (); i++)
+        {
+          if (edges[i].first == other)
+            {
+              if (--edges[i].second == 0)
+                {
+                  edges[i] = edges.back ();
+                  edges.pop_back ();
+                  last = true;
+                }
+              break;
+            }
+        }
+    }
+  if (!last)
+    {
+      return;
+    }
+
+  for (uint32_t s = 0; s < m_trees.size (); s++)
+    {
+      Tree *tree = m_trees[s];
+      if (tree == 0)
+        {
+          continue;
+        }
+      if (tree->parent[b] == a)
+        {
+          Cut (*tree, s, a, b);
+        }
+      else if (tree->parent[a] == b)
+        {
+          Cut (*tree, s, b, a);
+        }
+    }
+}
+
+void
+WpppSpf::Cut (Tree &tree, uint32_t src, uint32_t u, uint32_t v)
+{
+  //collect the subtree hanging from v
+  m_subtree.clear ();
+  m_subtree.push_back (v);
+  for (uint32_t i = 0; i < m_subtree.size (); i++)
+    {
+      for (uint32_t c = tree.child[m_subtree[i]]; c != NONE; c = tree.next[c])
+        {
+          m_subtree.push_back (c);
+        }
+    }
+  for (uint32_t i = 0; i < m_subtree.size (); i++)
+    {
+      m_inSubtree[m_subtree[i]] = true;
+    }
+  for (uint32_t i = 0; i < m_subtree.size (); i++)
+    {
+      uint32_t x = m_subtree[i];
+      Detach (tree, x);
+      tree.dist[x] = UNREACHABLE;
+      tree.firstHop[x] = NONE;
+    }
+
+  //reattach each node through its best neighbor outside the subtree
+  std::vector<HeapEntry> heap;
+  for (uint32_t i = 0; i < m_subtree.size (); i++)
+    {
+      uint32_t x = m_subtree[i];
+      uint32_t best = NONE;
+      const std::vector<Edge> &edges = m_adj[x];
+      for (uint32_t j = 0; j < edges.size (); j++)
+        {
+          uint32_t y = edges[j].first;
+          if (!m_inSubtree[y] && tree.dist[y] != UNREACHABLE &&
+              (best == NONE || tree.dist[y] < tree.dist[best]))
+            {
+              best = y;
+            }
+        }
+      if (best != NONE)
+        {
+          Attach (tree, x, best, tree.dist[best] + 1);
+          heap.push_back (HeapEntry (tree.dist[x], x));
+        }
+    }
+  for (uint32_t i = 0; i < m_subtree.size (); i++)
+    {
+      m_inSubtree[m_subtree[i]] = false;
+    }
+  Propagate (tree, src, heap);
+}
+
+uint32_t
+WpppSpf::GetDistance (uint32_t src, uint32_t dst)
+{
+  Tree &tree = GetTree (src);
+  return dst < tree.dist.size () ? tree.dist[dst] : UNREACHABLE;
+}
+
+uint32_t
+WpppSpf::GetNextHop (uint32_t src, uint32_t dst)
+{
+  Tree &tree = GetTree (src);
+  return dst < tree.firstHop.size () ? tree.firstHop[dst] : UNREACHABLE;
+}
+
+} // namespace ns3
@@ -0,0 +1,153 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 University of North Carolina at Chapel Hill
+ * Author: Ben Newton
+ */
+
+#ifndef WPPP_SPF_H
+#define WPPP_SPF_H
+
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup wireless-point-to-point
+ * \brief Shortest paths from every source, kept up to date as links change
+ *
+ * Links are undirected and cost one hop.  A shortest path tree is built
+ * for a source the first time a path from it is asked for, with Dijkstra,
+ * and is then repaired on each link change instead of being rebuilt:
+ *
+ * - a new link lowers the distance of some nodes; Dijkstra is run from the
+ *   end of the link that got closer, visiting only the nodes whose
+ *   distance drops;
+ * - a broken link that is in the tree cuts off the subtree below it; the
+ *   nodes of that subtree are reattached through their best neighbor
+ *   outside it and Dijkstra is run over the subtree only.  A broken link
+ *   outside the tree costs nothing.
+ *
+ * So a link flap costs work proportional to the nodes whose path changes,
+ * in each tree that was built, rather than a rebuild of every tree.
+ * Several links between the same pair of nodes count as one until the
+ * last of them is removed.
+ *
+ * Nodes are dense indices; the node set grows as needed.
+ */
+class WpppSpf
+{
+public:
+  WpppSpf ();
+  ~WpppSpf ();
+
+  /**
+   * \brief Value of GetDistance and GetNextHop for an unreachable node
+   */
+  static const uint32_t UNREACHABLE = 0xffffffff;
+
+  /**
+   * \brief Add a link between two nodes
+   */
+  void AddLink (uint32_t a, uint32_t b);
+
+  /**
+   * \brief Remove a link added by AddLink
+   */
+  void RemoveLink (uint32_t a, uint32_t b);
+
+  /**
+   * \return true if at least one link joins a and b
+   */
+  bool HasLink (uint32_t a, uint32_t b) const;
+
+  /**
+   * \return the number of nodes known
+   */
+  uint32_t GetNNodes (void) const;
+
+  /**
+   * \return the number of hops from src to dst, or UNREACHABLE
+   */
+  uint32_t GetDistance (uint32_t src, uint32_t dst);
+
+  /**
+   * \return the neighbor of src on a shortest path to dst, or UNREACHABLE;
+   *         src itself if dst is src
+   */
+  uint32_t GetNextHop (uint32_t src, uint32_t dst);
+
+  /**
+   * \return the number of nodes settled by Dijkstra so far, a measure of
+   *         the work spent on building and repairing trees
+   */
+  uint64_t GetWork (void) const;
+
+private:
+  /**
+   * Shortest path tree of one source; children are kept as doubly linked
+   * lists so that a subtree is found and detached in time proportional to
+   * its size
+   */
+  struct Tree
+  {
+    std::vector<uint32_t> dist;      //!< Hops from the source
+    std::vector<uint32_t> parent;    //!< Parent in the tree, or NONE
+    std::vector<uint32_t> firstHop;  //!< Neighbor of the source on the path, or NONE
+    std::vector<uint32_t> child;     //!< First child, or NONE
+    std::vector<uint32_t> next;      //!< Next sibling, or NONE
+    std::vector<uint32_t> prev;      //!< Previous sibling, or NONE
+  };
+
+  /**
+   * A neighbor and the number of links to it
+   */
+  typedef std::pair<uint32_t, uint32_t> Edge;
+
+  /// Min-heap entries of Dijkstra: distance and node
+  typedef std::pair<uint32_t, uint32_t> HeapEntry;
+
+  static const uint32_t NONE = 0xffffffff;  //!< No node
+
+  /**
+   * \brief Make room for node n in the adjacency and every tree
+   */
+  void Grow (uint32_t n);
+
+  /**
+   * \return the tree of a source, built if needed
+   */
+  Tree &GetTree (uint32_t src);
+
+  /**
+   * \brief Make p the parent of v, at distance d
+   */
+  void Attach (Tree &tree, uint32_t v, uint32_t p, uint32_t d);
+
+  /**
+   * \brief Remove v from the children of its parent
+   */
+  void Detach (Tree &tree, uint32_t v);
+
+  /**
+   * \brief Run Dijkstra from the nodes in the heap, settling nodes whose
+   * distance drops
+   */
+  void Propagate (Tree &tree, uint32_t src, std::vector<HeapEntry> &heap);
+
+  /**
+   * \brief Repair a tree after the link from u to v is gone
+   */
+  void Cut (Tree &tree, uint32_t src, uint32_t u, uint32_t v);
+
+  std::vector<std::vector<Edge> > m_adj;  //!< Neighbors of each node
+  std::vector<Tree *> m_trees;            //!< Tree of each source, or 0
+  std::vector<uint32_t> m_subtree;        //!< Scratch list of the nodes of a cut subtree
+  std::vector<bool> m_inSubtree;          //!< Scratch marks of the nodes of a cut subtree
+  uint64_t m_work;                        //!< Nodes settled
+};
+
+} // namespace ns3
+
+#endif /* WPPP_SPF_H */
@@ -0,0 +1,108 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 University of North Carolina at Chapel Hill
+ * Author: Ben Newton
+ */
+
+#ifndef WPPP_STATS_H
+#define WPPP_STATS_H
+
+#include <stdint.h>
+#include <cstring>
+
+namespace ns3 {
+
+/**
+ * \ingroup wireless-point-to-point
+ * \brief Counters kept by every WirelessPointToPointNetDevice
+ *
+ * The counters are plain integers updated inline on the packet path, so
+ * reading them costs nothing while the simulation runs, unlike connecting
+ * sinks to the trace sources.  Byte counts include the WpppHeader.
+ */
+struct WpppDeviceStats
+{
+  /**
+   * Why a packet was dropped
+   */
+  enum DropReason
+  {
+    DROP_LINK_DOWN = 0,   /**< Send on a device that is not attached */
+    DROP_QUEUE_FULL,      /**< Send found the device queue full */
+    DROP_NOT_ALIGNED,     /**< Transmitted while not aligned with a peer */
+    DROP_RX_ERROR,        /**< Corrupted according to the receive error model */
+    DROP_AQM,             /**< Dropped by the active queue management */
+    DROP_NO_ROUTE,        /**< Labeled frame with no entry in the label table or out of TTL */
+    DROP_TOO_LONG,        /**< Longer than a whole transmit window, see SetTransmitWindow */
+    DROP_REASONS          /**< Number of drop reasons */
+  };
+
+  WpppDeviceStats ()
+  {
+    Reset ();
+  }
+
+  /**
+   * \brief Set all counters to zero
+   */
+  void Reset (void)
+  {
+    std::memset (this, 0, sizeof (*this));
+  }
+
+  uint64_t txPackets;              //!< Packets put on the channel
+  uint64_t txBytes;                //!< Bytes put on the channel
+  uint64_t rxPackets;              //!< Packets received from the channel
+  uint64_t rxBytes;                //!< Bytes received from the channel
+  uint64_t drops[DROP_REASONS];    //!< Dropped packets by reason
+  int64_t busyTime;                //!< Nanoseconds spent transmitting
+  uint32_t queueHighWaterPackets;  //!< Most packets seen in the queue
+  uint32_t queueHighWaterBytes;    //!< Most bytes seen in the queue
+  uint64_t forwardedPackets;       //!< Received frames switched to another device of the node
+  uint64_t largeSendFrames;        //!< Frames on the wire the super-segments sent stood for
+  uint64_t coalescedSegments;      //!< Received segments merged into the one before them
+};
+
+/**
+ * \ingroup wireless-point-to-point
+ * \brief Counters of one direction of an aligned pair of devices
+ *
+ * The channel keeps these from the moment two devices become aligned until
+ * the alignment is broken.  Devices are identified by node id and interface
+ * index.
+ */
+struct WpppLinkStats
+{
+  uint32_t srcNode;     //!< Node id of the transmitting device
+  uint32_t srcIfIndex;  //!< Interface index of the transmitting device
+  uint32_t dstNode;     //!< Node id of the receiving device
+  uint32_t dstIfIndex;  //!< Interface index of the receiving device
+  int64_t alignedSince; //!< Time the pair was aligned, in nanoseconds
+  uint64_t txPackets;   //!< Packets sent from src to dst
+  uint64_t txBytes;     //!< Bytes sent from src to dst
+  int64_t busyTime;     //!< Nanoseconds spent transmitting from src to dst
+};
+
+/**
+ * \ingroup wireless-point-to-point
+ * \brief Counters of the interface notifications a channel damped
+ *
+ * Every change counted is, once its hold-down or suppression ends, either
+ * passed on to routing or cancelled by a later change back.
+ */
+struct WpppDampingStats
+{
+  WpppDampingStats ()
+  {
+    std::memset (this, 0, sizeof (*this));
+  }
+
+  uint64_t changes;       //!< Interface up and down changes
+  uint64_t notified;      //!< Changes passed on to routing
+  uint64_t suppressed;    //!< Changes cancelled by a change back before being passed on
+  uint64_t suppressions;  //!< Times an interface was suppressed for flapping
+};
+
+} // namespace ns3
+
+#endif /* WPPP_STATS_H */
@@ -4,11 +4,46 @@
  * Author: Ben Newton (adapted from point-to-point-test.cc)
  */
 
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <set>
+#include <sstream>
 #include "ns3/test.h"
 #include "ns3/drop-tail-queue.h"
 #include "ns3/simulator.h"
+#include "ns3/double.h"
+#include "ns3/boolean.h"
+#include "ns3/uinteger.h"
+#include "ns3/enum.h"
+#include "ns3/data-rate.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/ipv4-queue-disc-item.h"
+#include "ns3/tcp-header.h"
 #include "ns3/wireless-point-to-point-net-device.h"
 #include "ns3/wireless-point-to-point-channel.h"
+#include "ns3/wppp-contact-plan.h"
+#include "ns3/wppp-contact-plan-helper.h"
+#include "ns3/wppp-contact-plan-generator.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/propagation-delay-model.h"
+#include "ns3/wppp-telemetry-sampler.h"
+#include "ns3/wireless-point-to-point-helper.h"
+#include "ns3/wppp-background-writer.h"
+#include "ns3/config.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/udp-socket-factory.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/wppp-link-matching.h"
+#include "ns3/wppp-latency.h"
+#include "ns3/wppp-multi-beam-net-device.h"
+#include "ns3/wppp-spf.h"
+#include "ns3/wppp-alignment-listener.h"
+#include "ns3/wppp-label-table.h"
+#include "ns3/wppp-header.h"
 
 using namespace ns3;
 
@@ -90,6 +125,2631 @@ WirelessPointToPointTest::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * \brief Test the contact plan reader, writer and streaming player
+ *
+ * Writes a small plan in both formats, reads it back and replays the CSV
+ * version with a window of one entry, checking that the one way connection
+ * it describes is made and broken at the planned times.
+ */
+class WirelessPointToPointContactPlanTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   */
+  WirelessPointToPointContactPlanTest ();
+
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Record whether the two nodes are currently one way connected
+   *
+   * \param channel channel to query
+   * \param index slot of m_connected to fill
+   */
+  void CheckConnection (Ptr<WirelessPointToPointChannel> channel, uint32_t index);
+
+  uint32_t m_nodeA;     //!< Id of the first node
+  uint32_t m_nodeB;     //!< Id of the second node
+  bool m_connected[2];  //!< Connection state sampled during the run
+};
+
+WirelessPointToPointContactPlanTest::WirelessPointToPointContactPlanTest ()
+  : TestCase ("WirelessPointToPoint contact plan")
+{
+}
+
+void
+WirelessPointToPointContactPlanTest::CheckConnection (Ptr<WirelessPointToPointChannel> channel,
+                                                      uint32_t index)
+{
+  m_connected[index] = channel->IsOneWayConnection (m_nodeA, m_nodeB);
+}
+
+void
+WirelessPointToPointContactPlanTest::DoRun (void)
+{
+  Ptr<Node> a = CreateObject<Node> ();
+  Ptr<Node> b = CreateObject<Node> ();
+  Ptr<WirelessPointToPointNetDevice> devA = 
+    CreateObject<WirelessPointToPointNetDevice> ();
+  Ptr<WirelessPointToPointChannel> channel = 
+    CreateObject<WirelessPointToPointChannel> ();
+
+  devA->Attach (channel);
+  devA->SetAddress (Mac48Address::Allocate ());
+  devA->SetQueue (CreateObject<DropTailQueue> ());
+  a->AddDevice (devA);
+  m_nodeA = a->GetId ();
+  m_nodeB = b->GetId ();
+
+  WpppContactPlanEntry entries[2];
+  entries[0].time = 1000000000;
+  entries[0].action = WpppContactPlanEntry::CONNECT;
+  entries[1].time = 2000000000;
+  entries[1].action = WpppContactPlanEntry::DISCONNECT;
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      entries[i].nodeA = m_nodeA;
+      entries[i].devA = 0;
+      entries[i].nodeB = m_nodeB;
+      entries[i].devB = WpppContactPlanEntry::NO_DEVICE;
+    }
+
+  std::string binFile = CreateTempDirFilename ("wppp-plan.bin");
+  std::string csvFile = CreateTempDirFilename ("wppp-plan.csv");
+  WpppContactPlanWriter writer;
+  for (uint32_t format = 0; format < 2; format++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (writer.Open (format ? binFile : csvFile, format), true, "cannot create plan");
+      writer.Write (entries[0]);
+      writer.Write (entries[1]);
+      writer.Close ();
+
+      WpppContactPlanReader reader;
+      NS_TEST_ASSERT_MSG_EQ (reader.Open (format ? binFile : csvFile), true, "cannot open plan");
+      NS_TEST_ASSERT_MSG_EQ (reader.IsBinary (), format == 1, "format not detected");
+      for (uint32_t i = 0; i < 2; i++)
+        {
+          WpppContactPlanEntry e;
+          NS_TEST_ASSERT_MSG_EQ (reader.Next (e), true, "entry missing");
+          NS_TEST_ASSERT_MSG_EQ (e.time, entries[i].time, "time not preserved");
+          NS_TEST_ASSERT_MSG_EQ ((uint32_t)e.action, (uint32_t)entries[i].action, "action not preserved");
+          NS_TEST_ASSERT_MSG_EQ (e.nodeB, m_nodeB, "node not preserved");
+          NS_TEST_ASSERT_MSG_EQ (e.devB, WpppContactPlanEntry::NO_DEVICE, "device not preserved");
+        }
+      WpppContactPlanEntry e;
+      NS_TEST_ASSERT_MSG_EQ (reader.Next (e), false, "unexpected entry");
+    }
+
+  WirelessPointToPointContactPlanHelper planHelper;
+  planHelper.SetWindow (1);
+  planHelper.Install (csvFile);
+  Simulator::Schedule (Seconds (1.5), &WirelessPointToPointContactPlanTest::CheckConnection,
+                       this, channel, 0);
+  Simulator::Schedule (Seconds (2.5), &WirelessPointToPointContactPlanTest::CheckConnection,
+                       this, channel, 1);
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_connected[0], true, "planned connection not made");
+  NS_TEST_ASSERT_MSG_EQ (m_connected[1], false, "planned disconnection not made");
+}
+
+/**
+ * \brief Test the contact plan generator
+ *
+ * Nodes scattered around an occluding sphere are sampled once with the grid
+ * and four threads, and the contacts of the plan are compared with the
+ * pairs a brute force check of every pair finds visible.  Then a pair left
+ * without a device has to be connected once a device is freed.
+ */
+class WirelessPointToPointContactPlanGeneratorTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   */
+  WirelessPointToPointContactPlanGeneratorTest ();
+
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Create a node at a position with a number of devices
+   */
+  static Ptr<Node> CreateNode (Vector position, uint32_t devices);
+
+  /**
+   * \return the CONNECT entries of a plan, as (time in s, node a, node b)
+   */
+  static std::set<std::pair<int64_t, std::pair<uint32_t, uint32_t> > > ReadConnections (std::string filename);
+};
+
+WirelessPointToPointContactPlanGeneratorTest::WirelessPointToPointContactPlanGeneratorTest ()
+  : TestCase ("WirelessPointToPoint contact plan generator")
+{
+}
+
+Ptr<Node>
+WirelessPointToPointContactPlanGeneratorTest::CreateNode (Vector position, uint32_t devices)
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  Ptr<ConstantPositionMobilityModel> mobility = CreateObject<ConstantPositionMobilityModel> ();
+  mobility->SetPosition (position);
+  node->AggregateObject (mobility);
+  for (uint32_t i = 0; i < devices; i++)
+    {
+      node->AddDevice (CreateObject<WirelessPointToPointNetDevice> ());
+    }
+  return node;
+}
+
+std::set<std::pair<int64_t, std::pair<uint32_t, uint32_t> > >
+WirelessPointToPointContactPlanGeneratorTest::ReadConnections (std::string filename)
+{
+  std::set<std::pair<int64_t, std::pair<uint32_t, uint32_t> > > connections;
+  WpppContactPlanReader reader;
+  reader.Open (filename);
+  WpppContactPlanEntry e;
+  while (reader.Next (e))
+    {
+      if (e.action == WpppContactPlanEntry::CONNECT)
+        {
+          connections.insert (std::make_pair (e.time / 1000000000,
+                                              std::make_pair (std::min (e.nodeA, e.nodeB),
+                                                              std::max (e.nodeA, e.nodeB))));
+        }
+    }
+  return connections;
+}
+
+void
+WirelessPointToPointContactPlanGeneratorTest::DoRun (void)
+{
+  const uint32_t n = 40;
+  const double radius = 1000;
+  const double range = 1500;
+  NodeContainer nodes;
+  std::vector<Vector> positions;
+  uint32_t seed = 12345;
+  while (positions.size () < n)
+    {
+      double c[3];
+      for (uint32_t k = 0; k < 3; k++)
+        {
+          seed = seed * 1103515245 + 12345;
+          c[k] = ((seed >> 8) % 4001) - 2000.0;
+        }
+      Vector v (c[0], c[1], c[2]);
+      if (v.x * v.x + v.y * v.y + v.z * v.z > radius * radius)
+        {
+          positions.push_back (v);
+          nodes.Add (CreateNode (v, n - 1));
+        }
+    }
+
+  //reference: every pair in range whose segment has no point inside the
+  //sphere, from the roots of |p + t d| = radius
+  std::set<std::pair<int64_t, std::pair<uint32_t, uint32_t> > > expected;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      for (uint32_t j = i + 1; j < n; j++)
+        {
+          Vector p = positions[i];
+          Vector d (positions[j].x - p.x, positions[j].y - p.y, positions[j].z - p.z);
+          double a = d.x * d.x + d.y * d.y + d.z * d.z;
+          double b = 2 * (p.x * d.x + p.y * d.y + p.z * d.z);
+          double c = p.x * p.x + p.y * p.y + p.z * p.z - radius * radius;
+          double disc = b * b - 4 * a * c;
+          bool blocked = false;
+          if (disc > 0)
+            {
+              double t1 = (-b - std::sqrt (disc)) / (2 * a);
+              double t2 = (-b + std::sqrt (disc)) / (2 * a);
+              blocked = t1 < 1 && t2 > 0;
+            }
+          if (a <= range * range && !blocked)
+            {
+              expected.insert (std::make_pair (0, std::make_pair (nodes.Get (i)->GetId (),
+                                                                  nodes.Get (j)->GetId ())));
+            }
+        }
+    }
+
+  std::string planFile = CreateTempDirFilename ("wppp-generated.bin");
+  WirelessPointToPointContactPlanGenerator generator;
+  generator.SetRange (range);
+  generator.SetOcclusionRadius (radius);
+  generator.SetThreads (4);
+  generator.Install (nodes, Seconds (0), Seconds (0), Seconds (1), planFile, true);
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_ASSERT_MSG_GT (expected.size (), 0, "no visible pair to compare");
+  NS_TEST_ASSERT_MSG_EQ (ReadConnections (planFile) == expected, true,
+                         "grid and occlusion differ from the brute force reference");
+  NS_TEST_ASSERT_MSG_EQ (generator.GetUnservedContacts (), 0, "contact left without a device");
+
+  //a and c wait for the device of a until b leaves
+  Ptr<Node> a = CreateNode (Vector (0, 0, 0), 1);
+  Ptr<Node> b = CreateNode (Vector (10, 0, 0), 1);
+  Ptr<Node> c = CreateNode (Vector (-10, 0, 0), 1);
+  Simulator::Schedule (Seconds (0.5), &MobilityModel::SetPosition, b->GetObject<MobilityModel> (),
+                       Vector (1000, 0, 0));
+  std::string retryFile = CreateTempDirFilename ("wppp-retry.csv");
+  WirelessPointToPointContactPlanGenerator retry;
+  retry.SetRange (15);
+  retry.Install (NodeContainer (a, b, c), Seconds (0), Seconds (2), Seconds (1), retryFile, false);
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  std::set<std::pair<int64_t, std::pair<uint32_t, uint32_t> > > connections = ReadConnections (retryFile);
+  NS_TEST_ASSERT_MSG_EQ (connections.size (), 2, "waiting pair not connected");
+  NS_TEST_ASSERT_MSG_EQ (connections.count (std::make_pair (1, std::make_pair (a->GetId (), c->GetId ()))), 1,
+                         "waiting pair not connected once the device was freed");
+  NS_TEST_ASSERT_MSG_EQ (retry.GetUnservedContacts (), 1, "unserved contact not counted");
+}
+
+/**
+ * \brief Test the degree-constrained link matching
+ *
+ * A square of four nodes with one terminal each and a heavy diagonal: the
+ * diagonal and the opposite side are matched.  Removing the diagonal has to
+ * rematch its two nodes through the incremental solve.
+ */
+class WirelessPointToPointLinkMatchingTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   */
+  WirelessPointToPointLinkMatchingTest ();
+
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+};
+
+WirelessPointToPointLinkMatchingTest::WirelessPointToPointLinkMatchingTest ()
+  : TestCase ("WirelessPointToPoint link matching")
+{
+}
+
+void
+WirelessPointToPointLinkMatchingTest::DoRun (void)
+{
+  WpppLinkMatching matching;
+  matching.SetThreads (2);
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      matching.SetCapacity (i, 1);
+    }
+  matching.SetLink (0, 1, 1.0);
+  matching.SetLink (1, 2, 2.0);
+  matching.SetLink (2, 3, 1.0);
+  matching.SetLink (3, 0, 2.0);
+  matching.SetLink (0, 2, 5.0);
+  matching.Solve ();
+
+  NS_TEST_ASSERT_MSG_EQ (matching.IsMatched (0, 2), true, "heaviest link not matched");
+  NS_TEST_ASSERT_MSG_EQ (matching.IsMatched (1, 3), false, "not a candidate");
+  std::vector<std::pair<uint32_t, uint32_t> > added;
+  std::vector<std::pair<uint32_t, uint32_t> > removed;
+  matching.TakeChanges (added, removed);
+  NS_TEST_ASSERT_MSG_EQ (added.size (), 1, "only one link fits the terminals");
+  NS_TEST_ASSERT_MSG_EQ (removed.size (), 0, "nothing to remove");
+
+  matching.RemoveLink (2, 0);
+  matching.Solve ();
+  matching.TakeChanges (added, removed);
+  NS_TEST_ASSERT_MSG_EQ (removed.size (), 1, "removed link still matched");
+  NS_TEST_ASSERT_MSG_EQ (added.size (), 2, "freed terminals not reused");
+  NS_TEST_ASSERT_MSG_EQ (matching.IsMatched (1, 2), true, "heavier side not matched");
+  NS_TEST_ASSERT_MSG_EQ (matching.IsMatched (3, 0), true, "heavier side not matched");
+}
+
+/**
+ * \brief Test the incremental link matching against solving from scratch
+ *
+ * A reweighted link has to cascade: with one terminal each, lightening ab
+ * in the path ab, bc, cd has bc replace both ab and cd.  Then random
+ * changes to random graphs, solved incrementally, must give the matching
+ * a new solver finds for the same links.
+ */
+class WirelessPointToPointLinkMatchingIncrementalTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   */
+  WirelessPointToPointLinkMatchingIncrementalTest ();
+
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \returns the next number of a fixed pseudo-random sequence
+   */
+  uint32_t Next (void);
+
+  uint32_t m_seed;  //!< State of the sequence
+};
+
+WirelessPointToPointLinkMatchingIncrementalTest::WirelessPointToPointLinkMatchingIncrementalTest ()
+  : TestCase ("WirelessPointToPoint incremental link matching"),
+    m_seed (1)
+{
+}
+
+uint32_t
+WirelessPointToPointLinkMatchingIncrementalTest::Next (void)
+{
+  m_seed = m_seed * 1103515245 + 12345;
+  return (m_seed >> 16) & 0x7fff;
+}
+
+void
+WirelessPointToPointLinkMatchingIncrementalTest::DoRun (void)
+{
+  WpppLinkMatching path;
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      path.SetCapacity (i, 1);
+    }
+  path.SetLink (0, 1, 10.0);
+  path.SetLink (1, 2, 5.0);
+  path.SetLink (2, 3, 3.0);
+  path.Solve ();
+  NS_TEST_ASSERT_MSG_EQ (path.IsMatched (0, 1) && path.IsMatched (2, 3), true, "greedy matching not found");
+  path.SetLink (0, 1, 1.0);
+  path.Solve ();
+  std::vector<std::pair<uint32_t, uint32_t> > matched;
+  path.GetMatched (matched);
+  NS_TEST_ASSERT_MSG_EQ (matched.size (), 1, "lightened link did not cascade");
+  NS_TEST_ASSERT_MSG_EQ (path.IsMatched (1, 2), true, "lightened link did not cascade");
+
+  typedef std::map<std::pair<uint32_t, uint32_t>, double> Links;
+  for (uint32_t graph = 0; graph < 50; graph++)
+    {
+      uint32_t n = 5 + Next () % 20;
+      WpppLinkMatching incremental;
+      incremental.SetThreads (1 + graph % 3);
+      std::vector<uint32_t> capacity (n);
+      Links links;
+      for (uint32_t i = 0; i < n; i++)
+        {
+          capacity[i] = Next () % 4;
+          incremental.SetCapacity (i, capacity[i]);
+        }
+      for (uint32_t step = 0; step < 100; step++)
+        {
+          uint32_t op = Next () % 10;
+          uint32_t a = Next () % n;
+          uint32_t b = Next () % n;
+          if (a == b)
+            {
+              continue;
+            }
+          std::pair<uint32_t, uint32_t> link (std::min (a, b), std::max (a, b));
+          if (op < 6)
+            {
+              //few distinct weights, so ties are broken too
+              double weight = Next () % 10;
+              links[link] = weight;
+              incremental.SetLink (a, b, weight);
+            }
+          else if (op < 9)
+            {
+              links.erase (link);
+              incremental.RemoveLink (a, b);
+            }
+          else
+            {
+              capacity[a] = Next () % 4;
+              incremental.SetCapacity (a, capacity[a]);
+            }
+          if (step % 5 != 4)
+            {
+              continue;
+            }
+          incremental.Solve ();
+
+          WpppLinkMatching scratch;
+          for (uint32_t i = 0; i < n; i++)
+            {
+              scratch.SetCapacity (i, capacity[i]);
+            }
+          for (Links::const_iterator i = links.begin (); i != links.end (); ++i)
+            {
+              scratch.SetLink (i->first.first, i->first.second, i->second);
+            }
+          scratch.Solve ();
+          std::vector<std::pair<uint32_t, uint32_t> > expected;
+          scratch.GetMatched (expected);
+          incremental.GetMatched (matched);
+          std::sort (expected.begin (), expected.end ());
+          std::sort (matched.begin (), matched.end ());
+          NS_TEST_ASSERT_MSG_EQ (matched == expected, true,
+                                 "incremental matching differs in graph " << graph << " at step " << step);
+        }
+    }
+}
+
+/**
+ * \brief Test the device and link statistics
+ *
+ * Two devices aligned half a second into the run exchange frames of known
+ * sizes; the per-link counters of each direction and the device counters
+ * at both ends must account for every byte, and a frame sent before the
+ * alignment is counted as a drop only.
+ */
+class WirelessPointToPointStatsTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   */
+  WirelessPointToPointStatsTest ();
+
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Accept a packet handed up
+   */
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from);
+};
+
+WirelessPointToPointStatsTest::WirelessPointToPointStatsTest ()
+  : TestCase ("WirelessPointToPoint statistics")
+{
+}
+
+bool
+WirelessPointToPointStatsTest::Receive (Ptr<NetDevice> device, Ptr<const Packet> packet,
+                                        uint16_t protocol, const Address &from)
+{
+  return true;
+}
+
+void
+WirelessPointToPointStatsTest::DoRun (void)
+{
+  Ptr<WirelessPointToPointChannel> channel = CreateObject<WirelessPointToPointChannel> ();
+  Ptr<Node> a = CreateObject<Node> ();
+  Ptr<Node> b = CreateObject<Node> ();
+  Ptr<WirelessPointToPointNetDevice> devA = CreateObject<WirelessPointToPointNetDevice> ();
+  Ptr<WirelessPointToPointNetDevice> devB = CreateObject<WirelessPointToPointNetDevice> ();
+  Ptr<WirelessPointToPointNetDevice> devs[2] = { devA, devB };
+  Ptr<Node> nodes[2] = { a, b };
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      devs[i]->SetAttribute ("DataRate", DataRateValue (DataRate ("8Mbps")));
+      devs[i]->SetAddress (Mac48Address::Allocate ());
+      devs[i]->SetQueue (CreateObject<DropTailQueue> ());
+      devs[i]->Attach (channel);
+      nodes[i]->AddDevice (devs[i]);
+      devs[i]->SetReceiveCallback (MakeCallback (&WirelessPointToPointStatsTest::Receive, this));
+    }
+
+  //dropped, the devices are not aligned yet
+  Simulator::Schedule (Seconds (0.1), &WirelessPointToPointNetDevice::Send, devA,
+                       Create<Packet> (500), devB->GetAddress (), 0x800);
+  Simulator::Schedule (Seconds (0.5), &WirelessPointToPointChannel::Connect, channel, a, devA, b);
+  Simulator::Schedule (Seconds (0.5), &WirelessPointToPointChannel::Connect, channel, b, devB, a);
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      Simulator::Schedule (Seconds (1.0), &WirelessPointToPointNetDevice::Send, devA,
+                           Create<Packet> (100), devB->GetAddress (), 0x800);
+    }
+  Simulator::Schedule (Seconds (1.0), &WirelessPointToPointNetDevice::Send, devB,
+                       Create<Packet> (50), devA->GetAddress (), 0x800);
+  Simulator::Run ();
+
+  //frames carry a 14 byte header and take 1 us a byte
+  const WpppDeviceStats &statsA = devA->GetStats ();
+  const WpppDeviceStats &statsB = devB->GetStats ();
+  NS_TEST_ASSERT_MSG_EQ (statsA.drops[WpppDeviceStats::DROP_NOT_ALIGNED], 1, "unaligned drop not counted");
+  NS_TEST_ASSERT_MSG_EQ (statsA.txPackets, 3, "unaligned frame counted as sent");
+  NS_TEST_ASSERT_MSG_EQ (statsA.txBytes, 342, "sent bytes wrong");
+  NS_TEST_ASSERT_MSG_EQ (statsA.queueHighWaterPackets, 2, "queue high water wrong");
+  NS_TEST_ASSERT_MSG_EQ (statsA.rxPackets, 1, "received frames wrong");
+  NS_TEST_ASSERT_MSG_EQ (statsA.rxBytes, 64, "received bytes wrong");
+  NS_TEST_ASSERT_MSG_EQ (statsB.txPackets, 1, "sent frames wrong");
+  NS_TEST_ASSERT_MSG_EQ (statsB.rxPackets, 3, "received frames wrong");
+  NS_TEST_ASSERT_MSG_EQ (statsB.rxBytes, 342, "received bytes wrong");
+
+  std::vector<WpppDeviceStats> snapshot;
+  channel->GetDeviceStats (snapshot);
+  NS_TEST_ASSERT_MSG_EQ (snapshot.size (), 2, "snapshot does not cover every device");
+  NS_TEST_ASSERT_MSG_EQ (snapshot[0].txBytes, statsA.txBytes, "snapshot differs from the device");
+  NS_TEST_ASSERT_MSG_EQ (snapshot[1].rxBytes, statsB.rxBytes, "snapshot differs from the device");
+
+  std::vector<WpppLinkStats> links;
+  channel->GetLinkStats (links);
+  NS_TEST_ASSERT_MSG_EQ (links.size (), 2, "one entry per direction expected");
+  for (uint32_t i = 0; i < links.size (); i++)
+    {
+      const WpppLinkStats &link = links[i];
+      bool fromA = link.srcNode == a->GetId ();
+      NS_TEST_ASSERT_MSG_EQ (link.dstNode, fromA ? b->GetId () : a->GetId (), "wrong peer");
+      NS_TEST_ASSERT_MSG_EQ (link.srcIfIndex, 0, "wrong source interface");
+      NS_TEST_ASSERT_MSG_EQ (link.dstIfIndex, 0, "wrong destination interface");
+      NS_TEST_ASSERT_MSG_EQ (link.alignedSince, Seconds (0.5).GetNanoSeconds (), "wrong alignment time");
+      NS_TEST_ASSERT_MSG_EQ (link.txPackets, fromA ? 3 : 1, "link frames wrong");
+      NS_TEST_ASSERT_MSG_EQ (link.txBytes, fromA ? 342 : 64, "link bytes wrong");
+      NS_TEST_ASSERT_MSG_EQ (link.busyTime, MicroSeconds (fromA ? 342 : 64).GetNanoSeconds (),
+                             "link airtime wrong");
+    }
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \brief Test the log-linear latency histogram
+ *
+ * Percentiles of a uniform range stay within the bucket resolution, and a
+ * histogram read back from its text form merges into the original.
+ */
+class WirelessPointToPointLatencyHistogramTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   */
+  WirelessPointToPointLatencyHistogramTest ();
+
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+};
+
+WirelessPointToPointLatencyHistogramTest::WirelessPointToPointLatencyHistogramTest ()
+  : TestCase ("WirelessPointToPoint latency histogram")
+{
+}
+
+void
+WirelessPointToPointLatencyHistogramTest::DoRun (void)
+{
+  WpppLatencyHistogram h;
+  for (int64_t ns = 1; ns <= 100000; ns++)
+    {
+      h.Record (ns);
+    }
+  NS_TEST_ASSERT_MSG_EQ (h.GetCount (), 100000, "values lost");
+  NS_TEST_ASSERT_MSG_EQ (h.GetMax (), 100000, "wrong maximum");
+  NS_TEST_ASSERT_MSG_EQ_TOL (double (h.GetPercentile (0.5)), 50000.0, 50000.0 * 0.04, "p50 off");
+  NS_TEST_ASSERT_MSG_EQ_TOL (double (h.GetPercentile (0.99)), 99000.0, 99000.0 * 0.04, "p99 off");
+  NS_TEST_ASSERT_MSG_EQ (h.GetPercentile (0.0001), 10, "small values are exact");
+
+  std::ostringstream os;
+  h.Write (os);
+  std::istringstream is (os.str ());
+  WpppLatencyHistogram copy;
+  NS_TEST_ASSERT_MSG_EQ (copy.Read (is), true, "histogram not read back");
+  copy.Record (1000000);
+  h.Merge (copy);
+  NS_TEST_ASSERT_MSG_EQ (h.GetCount (), 200001, "merge lost values");
+  NS_TEST_ASSERT_MSG_EQ (h.GetMax (), 1000000, "merge lost the maximum");
+  NS_TEST_ASSERT_MSG_EQ_TOL (double (h.GetPercentile (0.5)), 50000.0, 50000.0 * 0.04, "merged p50 off");
+}
+
+/**
+ * \brief A queue of a type whose size memory accounting does not know
+ */
+class WpppUncountedTestQueue : public DropTailQueue
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void)
+  {
+    static TypeId tid = TypeId ("ns3::WpppUncountedTestQueue")
+      .SetParent<DropTailQueue> ()
+      .SetGroupName ("WirelessPointToPoint")
+      .AddConstructor<WpppUncountedTestQueue> ()
+    ;
+    return tid;
+  }
+};
+
+/**
+ * \brief Test the rarely used trace sources and memory accounting
+ *
+ * Trace sources connected after the device is built are allocated on the
+ * first connection and fire like any other; memory accounting counts the
+ * trace sources only once allocated, and counts only queues and delay
+ * models of a known type.
+ */
+class WirelessPointToPointRareTracesTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   */
+  WirelessPointToPointRareTracesTest ();
+
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Count a frame starting transmission
+   */
+  void TxBegin (Ptr<const Packet> packet);
+
+  /**
+   * \brief Count a frame dropped during transmission
+   */
+  void TxDrop (Ptr<const Packet> packet);
+
+  /**
+   * \brief Accept a packet handed up
+   */
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from);
+
+  uint32_t m_txBegin;  //!< Frames that started transmission
+  uint32_t m_txDrop;   //!< Frames dropped during transmission
+};
+
+WirelessPointToPointRareTracesTest::WirelessPointToPointRareTracesTest ()
+  : TestCase ("WirelessPointToPoint rare traces and memory usage"),
+    m_txBegin (0),
+    m_txDrop (0)
+{
+}
+
+void
+WirelessPointToPointRareTracesTest::TxBegin (Ptr<const Packet> packet)
+{
+  m_txBegin++;
+}
+
+void
+WirelessPointToPointRareTracesTest::TxDrop (Ptr<const Packet> packet)
+{
+  m_txDrop++;
+}
+
+bool
+WirelessPointToPointRareTracesTest::Receive (Ptr<NetDevice> device, Ptr<const Packet> packet,
+                                             uint16_t protocol, const Address &from)
+{
+  return true;
+}
+
+void
+WirelessPointToPointRareTracesTest::DoRun (void)
+{
+  Ptr<WirelessPointToPointChannel> channel = CreateObject<WirelessPointToPointChannel> ();
+  channel->SetPropagationDelayModel (CreateObject<ConstantSpeedPropagationDelayModel> ());
+  Ptr<Node> a = CreateObject<Node> ();
+  Ptr<Node> b = CreateObject<Node> ();
+  Ptr<WirelessPointToPointNetDevice> devA = CreateObject<WirelessPointToPointNetDevice> ();
+  Ptr<WirelessPointToPointNetDevice> devB = CreateObject<WirelessPointToPointNetDevice> ();
+  Ptr<MobilityModel> mobA = CreateObject<ConstantPositionMobilityModel> ();
+  Ptr<MobilityModel> mobB = CreateObject<ConstantPositionMobilityModel> ();
+  a->AggregateObject (mobA);
+  b->AggregateObject (mobB);
+  devA->SetAddress (Mac48Address::Allocate ());
+  devA->SetQueue (CreateObject<DropTailQueue> ());
+  devA->Attach (channel);
+  a->AddDevice (devA);
+  devB->SetAddress (Mac48Address::Allocate ());
+  devB->SetQueue (CreateObject<WpppUncountedTestQueue> ());
+  devB->Attach (channel);
+  b->AddDevice (devB);
+  devB->SetReceiveCallback (MakeCallback (&WirelessPointToPointRareTracesTest::Receive, this));
+
+  WpppMemoryUsage before;
+  channel->AddMemoryUsage (before);
+  NS_TEST_ASSERT_MSG_EQ (before.devices, 2, "devices not counted");
+  NS_TEST_ASSERT_MSG_EQ (before.channels, 1, "channel not counted");
+  NS_TEST_ASSERT_MSG_EQ (before.traceSources, 0, "trace sources allocated before any connection");
+  NS_TEST_ASSERT_MSG_EQ (before.queues, sizeof (DropTailQueue), "only the drop tail queue has a known size");
+  NS_TEST_ASSERT_MSG_EQ (before.uncountedQueues, 1, "queue of unknown type counted");
+  NS_TEST_ASSERT_MSG_EQ (before.delayState, sizeof (ConstantSpeedPropagationDelayModel),
+                         "constant speed delay model not counted");
+  NS_TEST_ASSERT_MSG_EQ (before.uncountedDelayModels, 0, "known delay model listed as uncounted");
+
+  NS_TEST_ASSERT_MSG_EQ (devA->TraceConnectWithoutContext ("PhyTxBegin",
+                                                           MakeCallback (&WirelessPointToPointRareTracesTest::TxBegin, this)),
+                         true, "PhyTxBegin not connected");
+  NS_TEST_ASSERT_MSG_EQ (devA->TraceConnectWithoutContext ("PhyTxDrop",
+                                                           MakeCallback (&WirelessPointToPointRareTracesTest::TxDrop, this)),
+                         true, "PhyTxDrop not connected");
+
+  //the first frame finds no peer, the second is sent once aligned
+  Simulator::Schedule (Seconds (1.0), &WirelessPointToPointNetDevice::Send, devA,
+                       Create<Packet> (100), devB->GetAddress (), 0x800);
+  Simulator::Schedule (Seconds (2.0), &WirelessPointToPointChannel::Connect, channel, a, devA, b);
+  Simulator::Schedule (Seconds (2.0), &WirelessPointToPointChannel::Connect, channel, b, devB, a);
+  Simulator::Schedule (Seconds (3.0), &WirelessPointToPointNetDevice::Send, devA,
+                       Create<Packet> (100), devB->GetAddress (), 0x800);
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_txBegin, 2, "PhyTxBegin connected after construction did not fire");
+  NS_TEST_ASSERT_MSG_EQ (m_txDrop, 1, "PhyTxDrop connected after construction did not fire");
+  NS_TEST_ASSERT_MSG_EQ (devB->GetStats ().rxPackets, 1, "aligned frame not received");
+
+  channel->SetPropagationDelayModel (CreateObject<RandomPropagationDelayModel> ());
+  WpppMemoryUsage after;
+  channel->AddMemoryUsage (after);
+  NS_TEST_ASSERT_MSG_EQ (after.traceSources > 0, true, "allocated trace sources not counted");
+  NS_TEST_ASSERT_MSG_EQ (after.uncountedQueues, 1, "queue of unknown type counted");
+  NS_TEST_ASSERT_MSG_EQ (after.delayState, 0, "delay model of unknown type counted");
+  NS_TEST_ASSERT_MSG_EQ (after.uncountedDelayModels, 1, "delay model of unknown type not listed");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \brief Test the multi-beam device
+ *
+ * One node points two beams at two neighbors; a frame sent to one of them
+ * leaves on the beam aligned with it and reaches that neighbor only.  With
+ * a queue interface, packets are queued for the beam of their next hop,
+ * and a beam whose queue fills stops its transmission queue only.
+ */
+class WirelessPointToPointMultiBeamTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   */
+  WirelessPointToPointMultiBeamTest ();
+
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Create a node with a multi-beam device on a channel
+   * \param channel channel the beams are attached to
+   * \param beams number of beams
+   * \returns the device
+   */
+  Ptr<WpppMultiBeamNetDevice> CreateDevice (Ptr<WirelessPointToPointChannel> channel, uint32_t beams);
+
+  /**
+   * \brief Count a frame received by a device
+   */
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from);
+
+  /**
+   * \brief Send frames to a peer until the queue of its beam is full
+   * \param device the multi-beam device, whose beam 0 holds two frames
+   * \param to the peer of beam 0
+   */
+  void FillBeam (Ptr<WpppMultiBeamNetDevice> device, Address to);
+
+  Ptr<NetDevice> m_lastReceiver;  //!< Device that received the last frame
+  Address m_lastFrom;             //!< Sender of the last frame
+  uint32_t m_received;            //!< Frames received by any device
+};
+
+WirelessPointToPointMultiBeamTest::WirelessPointToPointMultiBeamTest ()
+  : TestCase ("WirelessPointToPoint multi-beam"),
+    m_received (0)
+{
+}
+
+Ptr<WpppMultiBeamNetDevice>
+WirelessPointToPointMultiBeamTest::CreateDevice (Ptr<WirelessPointToPointChannel> channel, uint32_t beams)
+{
+  Ptr<WpppMultiBeamNetDevice> device = CreateObject<WpppMultiBeamNetDevice> ();
+  device->SetAddress (Mac48Address::Allocate ());
+  for (uint32_t i = 0; i < beams; i++)
+    {
+      Ptr<WirelessPointToPointNetDevice> beam = CreateObject<WirelessPointToPointNetDevice> ();
+      beam->SetQueue (CreateObject<DropTailQueue> ());
+      beam->Attach (channel);
+      device->AddBeam (beam);
+    }
+  CreateObject<Node> ()->AddDevice (device);
+  device->SetReceiveCallback (MakeCallback (&WirelessPointToPointMultiBeamTest::Receive, this));
+  return device;
+}
+
+bool
+WirelessPointToPointMultiBeamTest::Receive (Ptr<NetDevice> device, Ptr<const Packet> packet,
+                                            uint16_t protocol, const Address &from)
+{
+  m_lastReceiver = device;
+  m_lastFrom = from;
+  m_received++;
+  return true;
+}
+
+void
+WirelessPointToPointMultiBeamTest::FillBeam (Ptr<WpppMultiBeamNetDevice> device, Address to)
+{
+  Ptr<NetDeviceQueueInterface> ndqi = device->GetObject<NetDeviceQueueInterface> ();
+  //the first frame is transmitted at once, the other two fill the queue
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (device->Send (Create<Packet> (100), to, 0x800), true, "frame not queued");
+    }
+  NS_TEST_EXPECT_MSG_EQ (ndqi->GetTxQueue (0)->IsStopped (), true, "full beam did not stop its queue");
+  NS_TEST_EXPECT_MSG_EQ (ndqi->GetTxQueue (1)->IsStopped (), false, "other beam stopped");
+  NS_TEST_EXPECT_MSG_EQ (device->Send (Create<Packet> (100), to, 0x800), false,
+                         "frame given to a stopped beam");
+}
+
+void
+WirelessPointToPointMultiBeamTest::DoRun (void)
+{
+  Ptr<WirelessPointToPointChannel> channel = CreateObject<WirelessPointToPointChannel> ();
+  Ptr<WpppMultiBeamNetDevice> a = CreateDevice (channel, 2);
+  Ptr<WpppMultiBeamNetDevice> b = CreateDevice (channel, 1);
+  Ptr<WpppMultiBeamNetDevice> c = CreateDevice (channel, 1);
+
+  a->Connect (0, b->GetNode ());
+  b->Connect (0, a->GetNode ());
+  a->Connect (1, c->GetNode ());
+  c->Connect (0, a->GetNode ());
+  NS_TEST_ASSERT_MSG_EQ (a->GetNAlignedBeams (), 2, "both beams should be aligned");
+  NS_TEST_ASSERT_MSG_EQ (a->GetBeam (1)->GetAlignedPeer (), c->GetBeam (0), "beam aligned with the wrong peer");
+  uint32_t nodeA = a->GetNode ()->GetId ();
+  NS_TEST_ASSERT_MSG_EQ (channel->GetNeighbors (nodeA).size (), 2, "neighbors not listed");
+  NS_TEST_ASSERT_MSG_EQ (channel->GetNeighbors (b->GetNode ()->GetId ())[0].peerNode, nodeA, "wrong neighbor");
+  std::vector<uint32_t> offsets;
+  std::vector<uint32_t> neighbors;
+  channel->GetAdjacencySnapshot (offsets, neighbors);
+  NS_TEST_ASSERT_MSG_EQ (neighbors.size (), 4, "snapshot does not hold both directions of each pair");
+  NS_TEST_ASSERT_MSG_EQ (offsets[nodeA + 1] - offsets[nodeA], 2, "snapshot row of the wrong length");
+  uint64_t version = channel->GetTopologyVersion ();
+
+  Simulator::Schedule (Seconds (1.0), &WpppMultiBeamNetDevice::Send, a,
+                       Create<Packet> (100), c->GetAddress (), 0x800);
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_received, 1, "frame not received once");
+  NS_TEST_ASSERT_MSG_EQ (m_lastReceiver, Ptr<NetDevice> (c), "frame reached the wrong neighbor");
+  NS_TEST_ASSERT_MSG_EQ (m_lastFrom, a->GetAddress (), "sender address not carried");
+  NS_TEST_ASSERT_MSG_EQ (a->GetBeam (0)->GetStats ().txPackets, 0, "frame left on the wrong beam");
+  NS_TEST_ASSERT_MSG_EQ (a->GetBeam (1)->GetStats ().txPackets, 1, "frame did not leave on its beam");
+
+  a->Disconnect (1, c->GetNode ());
+  NS_TEST_ASSERT_MSG_EQ (a->GetNAlignedBeams (), 1, "beam still counted as aligned");
+  NS_TEST_ASSERT_MSG_EQ (channel->GetNeighbors (nodeA).size (), 1, "broken pair still listed");
+  NS_TEST_ASSERT_MSG_EQ (channel->GetTopologyVersion () > version, true, "version not bumped");
+  NS_TEST_ASSERT_MSG_EQ (a->Send (Create<Packet> (100), c->GetAddress (), 0x800), false,
+                         "frame sent to a neighbor no beam points at");
+
+  Ptr<NetDeviceQueueInterface> ndqi = CreateObject<NetDeviceQueueInterface> ();
+  a->AggregateObject (ndqi);
+  ndqi->CreateTxQueues ();
+  NS_TEST_ASSERT_MSG_EQ (ndqi->GetNTxQueues (), 2, "not one transmission queue per beam");
+  a->Connect (1, c->GetNode ());
+  Ipv4Header ipv4;
+  Ptr<QueueItem> toB = Create<Ipv4QueueDiscItem> (Create<Packet> (100), b->GetAddress (), 0x800, ipv4);
+  Ptr<QueueItem> toC = Create<Ipv4QueueDiscItem> (Create<Packet> (100), c->GetAddress (), 0x800, ipv4);
+  NS_TEST_ASSERT_MSG_EQ (uint32_t (ndqi->GetSelectedQueue (toB)), 0, "packet to b not queued for beam 0");
+  NS_TEST_ASSERT_MSG_EQ (uint32_t (ndqi->GetSelectedQueue (toC)), 1, "packet to c not queued for beam 1");
+
+  Ptr<DropTailQueue> queue = CreateObject<DropTailQueue> ();
+  queue->SetAttribute ("MaxPackets", UintegerValue (2));
+  a->GetBeam (0)->SetQueue (queue);
+  m_received = 0;
+  Simulator::Schedule (Seconds (1.0), &WirelessPointToPointMultiBeamTest::FillBeam, this,
+                       a, b->GetAddress ());
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_received, 3, "queued frames not received");
+  NS_TEST_ASSERT_MSG_EQ (ndqi->GetTxQueue (0)->IsStopped (), false, "drained beam still stopped");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \brief Test the incremental shortest paths
+ *
+ * A shortcut added to a line shortens the paths across it, and removing it
+ * restores the line; a cut link leaves the far side unreachable.
+ */
+class WirelessPointToPointSpfTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   */
+  WirelessPointToPointSpfTest ();
+
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+};
+
+WirelessPointToPointSpfTest::WirelessPointToPointSpfTest ()
+  : TestCase ("WirelessPointToPoint incremental shortest paths")
+{
+}
+
+void
+WirelessPointToPointSpfTest::DoRun (void)
+{
+  WpppSpf spf;
+  for (uint32_t i = 0; i < 5; i++)
+    {
+      spf.AddLink (i, i + 1);
+    }
+  NS_TEST_ASSERT_MSG_EQ (spf.GetDistance (0, 5), 5, "wrong distance along the line");
+  NS_TEST_ASSERT_MSG_EQ (spf.GetNextHop (0, 5), 1, "wrong next hop along the line");
+  NS_TEST_ASSERT_MSG_EQ (spf.GetNextHop (5, 0), 4, "wrong next hop back along the line");
+
+  spf.AddLink (0, 4);
+  NS_TEST_ASSERT_MSG_EQ (spf.GetDistance (0, 5), 2, "shortcut not taken");
+  NS_TEST_ASSERT_MSG_EQ (spf.GetNextHop (0, 5), 4, "wrong next hop through the shortcut");
+  NS_TEST_ASSERT_MSG_EQ (spf.GetNextHop (5, 0), 4, "wrong next hop back through the shortcut");
+
+  spf.AddLink (0, 4);
+  spf.RemoveLink (0, 4);
+  NS_TEST_ASSERT_MSG_EQ (spf.GetDistance (0, 5), 2, "parallel link removed with its twin");
+
+  spf.RemoveLink (0, 4);
+  NS_TEST_ASSERT_MSG_EQ (spf.GetDistance (0, 5), 5, "line not restored");
+  NS_TEST_ASSERT_MSG_EQ (spf.GetNextHop (0, 5), 1, "next hop not restored");
+
+  spf.RemoveLink (2, 3);
+  NS_TEST_ASSERT_MSG_EQ (spf.GetDistance (0, 5), WpppSpf::UNREACHABLE, "cut off node still reachable");
+  NS_TEST_ASSERT_MSG_EQ (spf.GetNextHop (5, 0), WpppSpf::UNREACHABLE, "cut off node still has a next hop");
+  NS_TEST_ASSERT_MSG_EQ (spf.GetDistance (5, 3), 2, "wrong distance on the far side");
+}
+
+/**
+ * \brief Alignment listener counting the notifications it gets
+ */
+class WpppCountingAlignmentListener : public WpppAlignmentListener
+{
+public:
+  WpppCountingAlignmentListener ()
+    : m_up (0),
+      m_down (0)
+  {
+  }
+
+  virtual void NotifyAlignment (Ptr<NetDevice> device, bool up)
+  {
+    up ? m_up++ : m_down++;
+  }
+
+  uint32_t m_up;   //!< Up notifications
+  uint32_t m_down; //!< Down notifications
+};
+
+/**
+ * \brief Test the link events and the damping of interface notifications
+ *
+ * Every connection and disconnection fires its link event at once, on
+ * nodes without an internet stack.  A link that breaks within the
+ * hold-down is never reported to the listeners; a link that keeps flapping
+ * is suppressed until its penalty decays, while its alignment follows
+ * every change at once.
+ */
+class WirelessPointToPointDampingTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   */
+  WirelessPointToPointDampingTest ();
+
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Count a link event, by the name of its trace source
+   */
+  void LinkEvent (std::string context, uint32_t nodeA, Ptr<NetDevice> devA,
+                  uint32_t nodeB, Ptr<NetDevice> devB, Time time);
+
+  std::map<std::string, uint32_t> m_linkEvents; //!< Events fired per trace source
+  Ptr<NetDevice> m_lastPeer;                    //!< devB of the last event
+};
+
+WirelessPointToPointDampingTest::WirelessPointToPointDampingTest ()
+  : TestCase ("WirelessPointToPoint link events and damping")
+{
+}
+
+void
+WirelessPointToPointDampingTest::LinkEvent (std::string context, uint32_t nodeA, Ptr<NetDevice> devA,
+                                            uint32_t nodeB, Ptr<NetDevice> devB, Time time)
+{
+  m_linkEvents[context]++;
+  m_lastPeer = devB;
+}
+
+void
+WirelessPointToPointDampingTest::DoRun (void)
+{
+  Ptr<WirelessPointToPointChannel> channel = CreateObject<WirelessPointToPointChannel> ();
+  channel->SetAttribute ("HoldDown", TimeValue (MilliSeconds (10)));
+  channel->SetAttribute ("DampingHalfLife", TimeValue (Seconds (1)));
+  channel->SetAttribute ("DampingSuppress", DoubleValue (2.5));
+  channel->SetAttribute ("Ipv4Notifications", BooleanValue (false));
+  Ptr<WpppCountingAlignmentListener> listener = CreateObject<WpppCountingAlignmentListener> ();
+  channel->AddAlignmentListener (listener);
+  Ptr<Node> a = CreateObject<Node> ();
+  Ptr<Node> b = CreateObject<Node> ();
+  Ptr<WirelessPointToPointNetDevice> devA = CreateObject<WirelessPointToPointNetDevice> ();
+  Ptr<WirelessPointToPointNetDevice> devB = CreateObject<WirelessPointToPointNetDevice> ();
+  devA->Attach (channel);
+  devB->Attach (channel);
+  a->AddDevice (devA);
+  b->AddDevice (devB);
+  const char *events[] = { "LinkHalfOpen", "LinkAligned", "LinkBroken" };
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      channel->TraceConnect (events[i], events[i],
+                             MakeCallback (&WirelessPointToPointDampingTest::LinkEvent, this));
+    }
+
+  Simulator::Schedule (Seconds (0), &WirelessPointToPointChannel::Connect, channel, b, devB, a);
+  Simulator::Schedule (MilliSeconds (1), &WirelessPointToPointChannel::Connect, channel, a, devA, b);
+  Simulator::Stop (MicroSeconds (1500));
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (channel->GetAlignedPeer (devA), devB, "alignment held down");
+  NS_TEST_ASSERT_MSG_EQ (channel->GetDampingStats ().changes, 2, "changes not counted");
+  NS_TEST_ASSERT_MSG_EQ (channel->GetDampingStats ().notified, 0, "change passed on within the hold-down");
+  Simulator::Stop (MilliSeconds (10));
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (channel->GetDampingStats ().notified, 2, "change not passed on after the hold-down");
+
+  //flap every millisecond, ending down
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      Simulator::Schedule (MilliSeconds (2 * i + 1), &WirelessPointToPointChannel::Disconnect, channel, a, devA, b);
+    }
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      Simulator::Schedule (MilliSeconds (2 * i + 2), &WirelessPointToPointChannel::Connect, channel, a, devA, b);
+    }
+  Simulator::Stop (Seconds (1));
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (channel->GetAlignedPeer (devA) == 0, true, "alignment not broken at once");
+  NS_TEST_ASSERT_MSG_EQ (channel->IsSuppressed (devA), true, "flapping interface not suppressed");
+  NS_TEST_ASSERT_MSG_EQ (channel->GetDampingStats ().suppressions, 2, "suppressions not counted");
+  NS_TEST_ASSERT_MSG_EQ (channel->GetDampingStats ().notified, 2, "suppressed change passed on");
+  Simulator::Stop (Seconds (2));
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (channel->IsSuppressed (devA), false, "interface not released");
+  NS_TEST_ASSERT_MSG_EQ (channel->GetDampingStats ().notified, 4, "change not passed on after release");
+
+  //disconnecting again, or a device that never pointed anywhere, breaks
+  //no link
+  Ptr<WirelessPointToPointNetDevice> idle = CreateObject<WirelessPointToPointNetDevice> ();
+  idle->Attach (channel);
+  a->AddDevice (idle);
+  channel->Disconnect (a, devA, b);
+  channel->Disconnect (a, idle, b);
+  NS_TEST_ASSERT_MSG_EQ (channel->GetAlignedPeer (devB) == 0, true, "peer of a stale link aligned");
+  NS_TEST_ASSERT_MSG_EQ (channel->GetDampingStats ().suppressed, 12, "cancelled changes not counted");
+  NS_TEST_ASSERT_MSG_EQ (channel->GetDampingStats ().changes, 16, "changes not counted");
+  NS_TEST_ASSERT_MSG_EQ (listener->m_up, 2, "listener not told of the damped up changes");
+  NS_TEST_ASSERT_MSG_EQ (listener->m_down, 2, "listener not told of the damped down changes");
+  NS_TEST_ASSERT_MSG_EQ (m_linkEvents["LinkHalfOpen"], 5, "half open links not traced");
+  NS_TEST_ASSERT_MSG_EQ (m_linkEvents["LinkAligned"], 4, "alignments not traced");
+  NS_TEST_ASSERT_MSG_EQ (m_linkEvents["LinkBroken"], 4, "breaks not traced");
+  NS_TEST_ASSERT_MSG_EQ (m_lastPeer == 0, true, "half open link traced with a peer");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \brief Test label switching and source routing
+ *
+ * A frame labeled at one end of a line of three nodes is switched by the
+ * middle node without reaching its stack, and delivered at the other end;
+ * a frame with a label the middle node does not know is dropped there.
+ * The same goes for a source routed frame and one whose hop names no
+ * device of the middle node.
+ */
+class WirelessPointToPointLabelSwitchingTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   */
+  WirelessPointToPointLabelSwitchingTest ();
+
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Create a device on a new or existing node
+   * \param channel channel the device is attached to
+   * \param node node the device is added to
+   * \returns the device
+   */
+  Ptr<WirelessPointToPointNetDevice> CreateDevice (Ptr<WirelessPointToPointChannel> channel,
+                                                   Ptr<Node> node);
+
+  /**
+   * \brief Count the frames handed up by a device
+   */
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from);
+
+  std::map<Ptr<NetDevice>, uint32_t> m_received; //!< Frames handed up per device
+  uint16_t m_lastProtocol;                       //!< Protocol of the last frame handed up
+};
+
+WirelessPointToPointLabelSwitchingTest::WirelessPointToPointLabelSwitchingTest ()
+  : TestCase ("WirelessPointToPoint label switching and source routing"),
+    m_lastProtocol (0)
+{
+}
+
+Ptr<WirelessPointToPointNetDevice>
+WirelessPointToPointLabelSwitchingTest::CreateDevice (Ptr<WirelessPointToPointChannel> channel,
+                                                      Ptr<Node> node)
+{
+  Ptr<WirelessPointToPointNetDevice> device = CreateObject<WirelessPointToPointNetDevice> ();
+  device->SetAddress (Mac48Address::Allocate ());
+  device->SetQueue (CreateObject<DropTailQueue> ());
+  device->Attach (channel);
+  node->AddDevice (device);
+  device->SetReceiveCallback (MakeCallback (&WirelessPointToPointLabelSwitchingTest::Receive, this));
+  return device;
+}
+
+bool
+WirelessPointToPointLabelSwitchingTest::Receive (Ptr<NetDevice> device, Ptr<const Packet> packet,
+                                                 uint16_t protocol, const Address &from)
+{
+  m_received[device]++;
+  m_lastProtocol = protocol;
+  return true;
+}
+
+void
+WirelessPointToPointLabelSwitchingTest::DoRun (void)
+{
+  Ptr<WirelessPointToPointChannel> channel = CreateObject<WirelessPointToPointChannel> ();
+  Ptr<Node> a = CreateObject<Node> ();
+  Ptr<Node> b = CreateObject<Node> ();
+  Ptr<Node> c = CreateObject<Node> ();
+  Ptr<WirelessPointToPointNetDevice> a0 = CreateDevice (channel, a);
+  Ptr<WirelessPointToPointNetDevice> b0 = CreateDevice (channel, b);
+  Ptr<WirelessPointToPointNetDevice> b1 = CreateDevice (channel, b);
+  //a device added after the table gets it too
+  Ptr<WpppLabelTable> cTable = WpppLabelTable::Install (c);
+  Ptr<WirelessPointToPointNetDevice> c0 = CreateDevice (channel, c);
+  channel->Connect (a, a0, b);
+  channel->Connect (b, b0, a);
+  channel->Connect (b, b1, c);
+  channel->Connect (c, c0, b);
+
+  WpppLabelTable::Install (a)->AddRoute (5, a0, 7);
+  WpppLabelTable::Install (b)->AddRoute (7, b1, 1000000);
+  cTable->AddLocal (1000000);
+  NS_TEST_ASSERT_MSG_EQ (WpppLabelTable::Install (c), cTable, "second table installed");
+
+  Ptr<WpppLabelTable> bTable = b->GetObject<WpppLabelTable> ();
+  Ptr<WirelessPointToPointNetDevice> outDevice;
+  uint32_t outLabel;
+  bTable->AddLocal (3);
+  bTable->AddRoute (900, b0, 4);
+  bTable->RemoveRoute (3);
+  NS_TEST_ASSERT_MSG_EQ (bTable->Lookup (3, outDevice, outLabel), false, "removed label still found");
+  NS_TEST_ASSERT_MSG_EQ (bTable->Lookup (8, outDevice, outLabel), false, "unknown label found");
+  NS_TEST_ASSERT_MSG_EQ (bTable->Lookup (7, outDevice, outLabel), true, "label lost among others");
+  NS_TEST_ASSERT_MSG_EQ (outDevice, b1, "wrong device for the label");
+  NS_TEST_ASSERT_MSG_EQ (outLabel, 1000000, "wrong outgoing label");
+  bTable->RemoveRoute (900);
+
+  Simulator::Schedule (Seconds (1.0), &WpppLabelTable::Send, a->GetObject<WpppLabelTable> (),
+                       Create<Packet> (100), 5, 0x800);
+  Simulator::Schedule (Seconds (2.0), &WirelessPointToPointNetDevice::SendLabeled, a0,
+                       Create<Packet> (100), 8, 64, 0x800);
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_received[c0], 1, "labeled frame not delivered at the end of the path");
+  NS_TEST_ASSERT_MSG_EQ (m_lastProtocol, 0x800, "payload protocol not restored");
+  NS_TEST_ASSERT_MSG_EQ (m_received[b0] + m_received[b1], 0, "relay handed a labeled frame up");
+  NS_TEST_ASSERT_MSG_EQ (b0->GetStats ().forwardedPackets, 1, "relay did not switch the frame");
+  NS_TEST_ASSERT_MSG_EQ (b1->GetStats ().txPackets, 1, "frame did not leave on the labeled device");
+  NS_TEST_ASSERT_MSG_EQ (b0->GetStats ().drops[WpppDeviceStats::DROP_NO_ROUTE], 1, "unknown label not dropped");
+
+  b0->SetAttribute ("SourceRouting", BooleanValue (true));
+  std::vector<uint8_t> route (1, b1->GetIfIndex ());
+  std::vector<uint8_t> badRoute (1, 7);
+  Simulator::Schedule (Seconds (3.0), &WirelessPointToPointNetDevice::SendSourceRouted, a0,
+                       Create<Packet> (100), route, 0x86DD);
+  Simulator::Schedule (Seconds (4.0), &WirelessPointToPointNetDevice::SendSourceRouted, a0,
+                       Create<Packet> (100), badRoute, 0x800);
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_received[c0], 2, "source routed frame not delivered at the end of the route");
+  NS_TEST_ASSERT_MSG_EQ (m_lastProtocol, 0x86DD, "payload protocol of the route not restored");
+  NS_TEST_ASSERT_MSG_EQ (m_received[b0] + m_received[b1], 0, "relay handed a source routed frame up");
+  NS_TEST_ASSERT_MSG_EQ (b0->GetStats ().forwardedPackets, 2, "relay did not send the frame on");
+  NS_TEST_ASSERT_MSG_EQ (b1->GetStats ().txPackets, 2, "frame did not leave on the device of the hop");
+  NS_TEST_ASSERT_MSG_EQ (b0->GetStats ().drops[WpppDeviceStats::DROP_NO_ROUTE], 2, "bad hop not dropped");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \brief Test large send
+ *
+ * A super-segment of three MTUs crosses the link as one packet, in the
+ * airtime of three frames each with its own header.
+ */
+class WirelessPointToPointLargeSendTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   */
+  WirelessPointToPointLargeSendTest ();
+
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Record the size of a packet handed up
+   */
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from);
+
+  uint32_t m_received;     //!< Packets handed up
+  uint32_t m_receivedSize; //!< Size of the last packet handed up
+};
+
+WirelessPointToPointLargeSendTest::WirelessPointToPointLargeSendTest ()
+  : TestCase ("WirelessPointToPoint large send"),
+    m_received (0),
+    m_receivedSize (0)
+{
+}
+
+bool
+WirelessPointToPointLargeSendTest::Receive (Ptr<NetDevice> device, Ptr<const Packet> packet,
+                                            uint16_t protocol, const Address &from)
+{
+  m_received++;
+  m_receivedSize = packet->GetSize ();
+  return true;
+}
+
+void
+WirelessPointToPointLargeSendTest::DoRun (void)
+{
+  Ptr<WirelessPointToPointChannel> channel = CreateObject<WirelessPointToPointChannel> ();
+  Ptr<Node> a = CreateObject<Node> ();
+  Ptr<Node> b = CreateObject<Node> ();
+  Ptr<WirelessPointToPointNetDevice> devA = CreateObject<WirelessPointToPointNetDevice> ();
+  Ptr<WirelessPointToPointNetDevice> devB = CreateObject<WirelessPointToPointNetDevice> ();
+  devA->SetAttribute ("LargeSendMtu", UintegerValue (9000));
+  devA->SetAttribute ("DataRate", DataRateValue (DataRate ("8Mbps")));
+  devA->SetAddress (Mac48Address::Allocate ());
+  devA->SetQueue (CreateObject<DropTailQueue> ());
+  devA->Attach (channel);
+  a->AddDevice (devA);
+  devB->SetAddress (Mac48Address::Allocate ());
+  devB->SetQueue (CreateObject<DropTailQueue> ());
+  devB->Attach (channel);
+  b->AddDevice (devB);
+  devB->SetReceiveCallback (MakeCallback (&WirelessPointToPointLargeSendTest::Receive, this));
+  channel->Connect (a, devA, b);
+  channel->Connect (b, devB, a);
+
+  NS_TEST_ASSERT_MSG_EQ (devA->GetMtu (), 9000, "large MTU not advertised");
+  NS_TEST_ASSERT_MSG_EQ (devA->GetFrameMtu (), 1500, "frame MTU changed");
+
+  Simulator::Schedule (Seconds (1.0), &WirelessPointToPointNetDevice::Send, devA,
+                       Create<Packet> (4500), devB->GetAddress (), 0x800);
+  Simulator::Run ();
+
+  //4500 bytes of payload in three frames of 14 byte headers, 1 us a byte
+  NS_TEST_ASSERT_MSG_EQ (m_received, 1, "super-segment not delivered as one packet");
+  NS_TEST_ASSERT_MSG_EQ (m_receivedSize, 4500, "super-segment size changed");
+  NS_TEST_ASSERT_MSG_EQ (devA->GetStats ().busyTime, MicroSeconds (4542).GetNanoSeconds (),
+                         "airtime not that of three frames");
+  NS_TEST_ASSERT_MSG_EQ (devA->GetStats ().largeSendFrames, 3, "frames of the super-segment not counted");
+  NS_TEST_ASSERT_MSG_EQ (devA->GetStats ().txPackets, 1, "super-segment not sent as one packet");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \brief Test receive coalescing
+ *
+ * Three in-order segments of a flow are handed up as one packet; a segment
+ * after a gap in the sequence is handed up on its own.
+ */
+class WirelessPointToPointCoalesceTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   */
+  WirelessPointToPointCoalesceTest ();
+
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Send a TCP segment of 100 bytes
+   * \param device the device to send it on
+   * \param to the device to send it to
+   * \param seq its sequence number
+   */
+  static void SendSegment (Ptr<WirelessPointToPointNetDevice> device, Address to, uint32_t seq);
+
+  /**
+   * \brief Record the size of a packet handed up
+   */
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from);
+
+  std::vector<uint32_t> m_sizes; //!< Size of each packet handed up
+};
+
+WirelessPointToPointCoalesceTest::WirelessPointToPointCoalesceTest ()
+  : TestCase ("WirelessPointToPoint receive coalescing")
+{
+}
+
+void
+WirelessPointToPointCoalesceTest::SendSegment (Ptr<WirelessPointToPointNetDevice> device, Address to,
+                                               uint32_t seq)
+{
+  Ptr<Packet> packet = Create<Packet> (100);
+  TcpHeader tcp;
+  tcp.SetSourcePort (49153);
+  tcp.SetDestinationPort (9);
+  tcp.SetSequenceNumber (SequenceNumber32 (seq));
+  tcp.SetFlags (TcpHeader::ACK);
+  packet->AddHeader (tcp);
+  Ipv4Header ip;
+  ip.SetSource (Ipv4Address ("10.0.0.1"));
+  ip.SetDestination (Ipv4Address ("10.0.0.2"));
+  ip.SetProtocol (6);
+  ip.SetPayloadSize (packet->GetSize ());
+  packet->AddHeader (ip);
+  device->Send (packet, to, 0x800);
+}
+
+bool
+WirelessPointToPointCoalesceTest::Receive (Ptr<NetDevice> device, Ptr<const Packet> packet,
+                                           uint16_t protocol, const Address &from)
+{
+  m_sizes.push_back (packet->GetSize ());
+  return true;
+}
+
+void
+WirelessPointToPointCoalesceTest::DoRun (void)
+{
+  Ptr<WirelessPointToPointChannel> channel = CreateObject<WirelessPointToPointChannel> ();
+  Ptr<Node> a = CreateObject<Node> ();
+  Ptr<Node> b = CreateObject<Node> ();
+  Ptr<WirelessPointToPointNetDevice> devA = CreateObject<WirelessPointToPointNetDevice> ();
+  Ptr<WirelessPointToPointNetDevice> devB = CreateObject<WirelessPointToPointNetDevice> ();
+  devA->SetAttribute ("DataRate", DataRateValue (DataRate ("100Mbps")));
+  devA->SetAddress (Mac48Address::Allocate ());
+  devA->SetQueue (CreateObject<DropTailQueue> ());
+  devA->Attach (channel);
+  a->AddDevice (devA);
+  devB->SetAttribute ("RxCoalesceWindow", TimeValue (MilliSeconds (10)));
+  devB->SetAddress (Mac48Address::Allocate ());
+  devB->SetQueue (CreateObject<DropTailQueue> ());
+  devB->Attach (channel);
+  b->AddDevice (devB);
+  devB->SetReceiveCallback (MakeCallback (&WirelessPointToPointCoalesceTest::Receive, this));
+  channel->Connect (a, devA, b);
+  channel->Connect (b, devB, a);
+
+  uint32_t seqs[] = { 1, 101, 201, 401 };
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      Simulator::Schedule (Seconds (1.0), &WirelessPointToPointCoalesceTest::SendSegment, devA,
+                           devB->GetAddress (), seqs[i]);
+    }
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_sizes.size (), 2, "segments not coalesced");
+  NS_TEST_ASSERT_MSG_EQ (m_sizes[0], 340, "in-order segments not merged into one packet");
+  NS_TEST_ASSERT_MSG_EQ (m_sizes[1], 140, "segment after a gap merged");
+  NS_TEST_ASSERT_MSG_EQ (devB->GetStats ().coalescedSegments, 2, "merged segments not counted");
+  NS_TEST_ASSERT_MSG_EQ (devB->GetStats ().rxPackets, 4, "frames not counted one by one");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \brief Test the telemetry sampler
+ *
+ * Samples a pair of aligned devices three times, reads the file back and
+ * checks the header, the block layout and the columns of the middle block.
+ */
+class WirelessPointToPointTelemetrySamplerTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   */
+  WirelessPointToPointTelemetrySamplerTest ();
+
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Read a little endian value from the file contents
+   * \param data file contents
+   * \param offset offset of the value
+   * \param size size of the value in bytes
+   * \returns the value
+   */
+  static uint64_t ReadLe (const std::string &data, uint64_t offset, uint32_t size);
+};
+
+WirelessPointToPointTelemetrySamplerTest::WirelessPointToPointTelemetrySamplerTest ()
+  : TestCase ("WirelessPointToPoint telemetry sampler")
+{
+}
+
+uint64_t
+WirelessPointToPointTelemetrySamplerTest::ReadLe (const std::string &data, uint64_t offset, uint32_t size)
+{
+  uint64_t value = 0;
+  for (uint32_t i = 0; i < size; i++)
+    {
+      value |= uint64_t (uint8_t (data[offset + i])) << (8 * i);
+    }
+  return value;
+}
+
+void
+WirelessPointToPointTelemetrySamplerTest::DoRun (void)
+{
+  Ptr<WirelessPointToPointChannel> channel = CreateObject<WirelessPointToPointChannel> ();
+  Ptr<PropagationDelayModel> delayModel = CreateObject<ConstantSpeedPropagationDelayModel> ();
+  channel->SetPropagationDelayModel (delayModel);
+  Ptr<Node> a = CreateObject<Node> ();
+  Ptr<Node> b = CreateObject<Node> ();
+  Ptr<ConstantPositionMobilityModel> mobilityA = CreateObject<ConstantPositionMobilityModel> ();
+  a->AggregateObject (mobilityA);
+  Ptr<ConstantPositionMobilityModel> mobilityB = CreateObject<ConstantPositionMobilityModel> ();
+  mobilityB->SetPosition (Vector (300000, 0, 0));
+  b->AggregateObject (mobilityB);
+  Ptr<WirelessPointToPointNetDevice> devA = CreateObject<WirelessPointToPointNetDevice> ();
+  Ptr<WirelessPointToPointNetDevice> devB = CreateObject<WirelessPointToPointNetDevice> ();
+  devA->SetAddress (Mac48Address::Allocate ());
+  devA->SetQueue (CreateObject<DropTailQueue> ());
+  devA->Attach (channel);
+  a->AddDevice (devA);
+  devB->SetAddress (Mac48Address::Allocate ());
+  devB->SetQueue (CreateObject<DropTailQueue> ());
+  devB->Attach (channel);
+  b->AddDevice (devB);
+  channel->Connect (a, devA, b);
+  channel->Connect (b, devB, a);
+
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      Simulator::Schedule (Seconds (0.5), &WirelessPointToPointNetDevice::Send, devA,
+                           Create<Packet> (100), devB->GetAddress (), 0x800);
+    }
+
+  std::string filename = CreateTempDirFilename ("wppp-telemetry.bin");
+  WirelessPointToPointTelemetrySampler sampler;
+  sampler.SetInterval (Seconds (1));
+  NS_TEST_ASSERT_MSG_EQ (sampler.Install (channel, filename, Seconds (0), Seconds (2)), true,
+                         "file not created");
+  Simulator::Run ();
+
+  //the file is closed after the last sample
+  std::ifstream in (filename.c_str (), std::ios::binary);
+  std::string data ((std::istreambuf_iterator<char> (in)), std::istreambuf_iterator<char> ());
+  NS_TEST_ASSERT_MSG_EQ (data.substr (0, 8), std::string ("WPPPTS1\n"), "wrong magic");
+  uint32_t deviceColumns = ReadLe (data, 8, 4);
+  uint32_t linkColumns = ReadLe (data, 12, 4);
+  NS_TEST_ASSERT_MSG_EQ (deviceColumns, 10, "wrong number of device columns");
+  NS_TEST_ASSERT_MSG_EQ (linkColumns, 9, "wrong number of link columns");
+  NS_TEST_ASSERT_MSG_EQ (std::string (data.c_str () + 16 + 2 * 16), "txPackets", "wrong device column name");
+  NS_TEST_ASSERT_MSG_EQ (std::string (data.c_str () + 16 + (10 + 8) * 16), "delay", "wrong link column name");
+
+  uint64_t offset = 16 + 16 * (deviceColumns + linkColumns);
+  uint64_t middle = 0;
+  uint32_t blocks = 0;
+  while (offset + 24 <= data.size ())
+    {
+      uint64_t size = ReadLe (data, offset, 8);
+      NS_TEST_ASSERT_MSG_EQ (size, 24 + 8 * (2 * deviceColumns + 2 * linkColumns), "wrong block size");
+      NS_TEST_ASSERT_MSG_EQ (ReadLe (data, offset + 8, 8), uint64_t (Seconds (blocks).GetNanoSeconds ()),
+                             "block taken at the wrong time");
+      if (blocks == 1)
+        {
+          middle = offset;
+        }
+      blocks++;
+      offset += size;
+    }
+  NS_TEST_ASSERT_MSG_EQ (blocks, 3, "wrong number of blocks");
+  NS_TEST_ASSERT_MSG_EQ (offset, data.size (), "file does not end on a block");
+
+  uint64_t devices = ReadLe (data, middle + 16, 4);
+  uint64_t links = ReadLe (data, middle + 20, 4);
+  NS_TEST_ASSERT_MSG_EQ (devices, 2, "devices missing from the block");
+  NS_TEST_ASSERT_MSG_EQ (links, 2, "aligned pairs missing from the block");
+  uint64_t column = middle + 24;
+  NS_TEST_ASSERT_MSG_EQ (ReadLe (data, column, 8), a->GetId (), "wrong node column");
+  NS_TEST_ASSERT_MSG_EQ (ReadLe (data, column + 8, 8), b->GetId (), "wrong node column");
+  column += 2 * 8 * devices;
+  NS_TEST_ASSERT_MSG_EQ (ReadLe (data, column, 8), 3, "sent frames not in the txPackets column");
+  NS_TEST_ASSERT_MSG_EQ (ReadLe (data, column + 8, 8), 0, "frames counted on the silent device");
+  column = middle + 24 + 8 * devices * deviceColumns;
+  uint64_t delay = delayModel->GetDelay (mobilityA, mobilityB).GetNanoSeconds ();
+  uint64_t linkPackets = 0;
+  for (uint32_t i = 0; i < links; i++)
+    {
+      linkPackets += ReadLe (data, column + 8 * (5 * links + i), 8);
+      NS_TEST_ASSERT_MSG_EQ (ReadLe (data, column + 8 * (8 * links + i), 8), delay, "wrong delay column");
+    }
+  NS_TEST_ASSERT_MSG_EQ (linkPackets, 3, "sent frames not in the link txPackets column");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \brief Test the buffered pcap and merged pcapng captures
+ *
+ * Captures two frames into a per-device pcap file and into a pcapng file
+ * shared by both devices, then parses both files after Simulator::Destroy
+ * has closed them.
+ */
+class WirelessPointToPointPcapTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   */
+  WirelessPointToPointPcapTest ();
+
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Read a whole file
+   * \param filename the file
+   * \returns its contents
+   */
+  static std::string ReadFile (std::string filename);
+
+  /**
+   * \brief Read a little endian value from the file contents
+   * \param data file contents
+   * \param offset offset of the value
+   * \param size size of the value in bytes
+   * \returns the value
+   */
+  static uint64_t ReadLe (const std::string &data, uint64_t offset, uint32_t size);
+};
+
+WirelessPointToPointPcapTest::WirelessPointToPointPcapTest ()
+  : TestCase ("WirelessPointToPoint pcap")
+{
+}
+
+std::string
+WirelessPointToPointPcapTest::ReadFile (std::string filename)
+{
+  std::ifstream in (filename.c_str (), std::ios::binary);
+  return std::string ((std::istreambuf_iterator<char> (in)), std::istreambuf_iterator<char> ());
+}
+
+uint64_t
+WirelessPointToPointPcapTest::ReadLe (const std::string &data, uint64_t offset, uint32_t size)
+{
+  uint64_t value = 0;
+  for (uint32_t i = 0; i < size; i++)
+    {
+      value |= uint64_t (uint8_t (data[offset + i])) << (8 * i);
+    }
+  return value;
+}
+
+void
+WirelessPointToPointPcapTest::DoRun (void)
+{
+  Ptr<WirelessPointToPointChannel> channel = CreateObject<WirelessPointToPointChannel> ();
+  Ptr<Node> a = CreateObject<Node> ();
+  Ptr<Node> b = CreateObject<Node> ();
+  Ptr<WirelessPointToPointNetDevice> devA = CreateObject<WirelessPointToPointNetDevice> ();
+  Ptr<WirelessPointToPointNetDevice> devB = CreateObject<WirelessPointToPointNetDevice> ();
+  devA->SetAddress (Mac48Address::Allocate ());
+  devA->SetQueue (CreateObject<DropTailQueue> ());
+  devA->Attach (channel);
+  a->AddDevice (devA);
+  devB->SetAddress (Mac48Address::Allocate ());
+  devB->SetQueue (CreateObject<DropTailQueue> ());
+  devB->Attach (channel);
+  b->AddDevice (devB);
+  channel->Connect (a, devA, b);
+  channel->Connect (b, devB, a);
+
+  std::string pcapFile = CreateTempDirFilename ("wppp-buffered.pcap");
+  std::string pcapngFile = CreateTempDirFilename ("wppp-merged.pcapng");
+  WirelessPointToPointHelper wppp;
+  wppp.SetPcapBuffering (4096, 64);
+  wppp.EnablePcap (pcapFile, devA, false, true);
+  NetDeviceContainer devices;
+  devices.Add (devA);
+  devices.Add (devB);
+  wppp.EnablePcapMerged (pcapngFile, devices);
+
+  Simulator::Schedule (Seconds (1.0), &WirelessPointToPointNetDevice::Send, devA,
+                       Create<Packet> (100), devB->GetAddress (), 0x800);
+  Simulator::Schedule (Seconds (2.0), &WirelessPointToPointNetDevice::Send, devA,
+                       Create<Packet> (100), devB->GetAddress (), 0x800);
+  Simulator::Run ();
+  uint64_t frameSize = devA->GetStats ().txBytes / 2;
+  std::ostringstream nameA;
+  nameA << "node" << a->GetId () << "-dev" << devA->GetIfIndex ();
+  std::ostringstream nameB;
+  nameB << "node" << b->GetId () << "-dev" << devB->GetIfIndex ();
+  //the files are complete once Destroy has closed them
+  Simulator::Destroy ();
+
+  std::string pcap = ReadFile (pcapFile);
+  NS_TEST_ASSERT_MSG_EQ (pcap.size (), 24 + 2 * (16 + 64), "wrong pcap file size");
+  NS_TEST_ASSERT_MSG_EQ (ReadLe (pcap, 0, 4), 0xa1b2c3d4, "wrong pcap magic");
+  NS_TEST_ASSERT_MSG_EQ (ReadLe (pcap, 16, 4), 64, "wrong snap length");
+  NS_TEST_ASSERT_MSG_EQ (ReadLe (pcap, 20, 4), 9, "wrong link type");
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      uint64_t record = 24 + i * (16 + 64);
+      NS_TEST_ASSERT_MSG_EQ (ReadLe (pcap, record, 4), i + 1, "wrong capture time");
+      NS_TEST_ASSERT_MSG_EQ (ReadLe (pcap, record + 4, 4), 0, "wrong capture time");
+      NS_TEST_ASSERT_MSG_EQ (ReadLe (pcap, record + 8, 4), 64, "frame not cut at the snap length");
+      NS_TEST_ASSERT_MSG_EQ (ReadLe (pcap, record + 12, 4), frameSize, "wrong frame length");
+    }
+
+  std::string pcapng = ReadFile (pcapngFile);
+  NS_TEST_ASSERT_MSG_EQ (ReadLe (pcapng, 0, 4), 0x0a0d0d0a, "no section header block");
+  NS_TEST_ASSERT_MSG_EQ (ReadLe (pcapng, 8, 4), 0x1a2b3c4d, "wrong byte order magic");
+  std::vector<std::string> interfaces;
+  std::vector<uint32_t> frames;
+  uint64_t offset = ReadLe (pcapng, 4, 4);
+  while (offset + 12 <= pcapng.size ())
+    {
+      uint32_t type = ReadLe (pcapng, offset, 4);
+      uint32_t length = ReadLe (pcapng, offset + 4, 4);
+      NS_TEST_ASSERT_MSG_EQ (length % 4, 0, "block length not a multiple of 4");
+      NS_TEST_ASSERT_MSG_EQ (offset + length <= pcapng.size (), true, "block runs past the end of the file");
+      NS_TEST_ASSERT_MSG_EQ (ReadLe (pcapng, offset + length - 4, 4), length, "trailing block length differs");
+      if (type == 1)
+        {
+          NS_TEST_ASSERT_MSG_EQ (ReadLe (pcapng, offset + 8, 2), 9, "wrong link type");
+          NS_TEST_ASSERT_MSG_EQ (ReadLe (pcapng, offset + 12, 4), 64, "wrong snap length");
+          //the options must end right before the trailing length
+          uint64_t option = offset + 16;
+          std::string name;
+          while (ReadLe (pcapng, option, 2) != 0)
+            {
+              uint32_t optionLength = ReadLe (pcapng, option + 2, 2);
+              if (ReadLe (pcapng, option, 2) == 2)
+                {
+                  name = pcapng.substr (option + 4, optionLength);
+                }
+              option += 4 + ((optionLength + 3) & ~3u);
+            }
+          NS_TEST_ASSERT_MSG_EQ (option + 4 + 4, offset + length, "interface block of the wrong length");
+          interfaces.push_back (name);
+          frames.push_back (0);
+        }
+      else if (type == 6)
+        {
+          uint32_t interface = ReadLe (pcapng, offset + 8, 4);
+          NS_TEST_ASSERT_MSG_EQ (interface < interfaces.size (), true, "frame of an undescribed interface");
+          uint64_t ns = (ReadLe (pcapng, offset + 12, 4) << 32) | ReadLe (pcapng, offset + 16, 4);
+          if (interface == 0)
+            {
+              NS_TEST_ASSERT_MSG_EQ (ns, uint64_t (Seconds (frames[0] + 1).GetNanoSeconds ()),
+                                     "wrong capture time");
+            }
+          NS_TEST_ASSERT_MSG_EQ (ReadLe (pcapng, offset + 20, 4), 64, "frame not cut at the snap length");
+          NS_TEST_ASSERT_MSG_EQ (ReadLe (pcapng, offset + 24, 4), frameSize, "wrong frame length");
+          frames[interface]++;
+        }
+      offset += length;
+    }
+  NS_TEST_ASSERT_MSG_EQ (offset, pcapng.size (), "file does not end on a block");
+  NS_TEST_ASSERT_MSG_EQ (interfaces.size (), 2, "wrong number of interfaces");
+  NS_TEST_ASSERT_MSG_EQ (interfaces[0], nameA.str (), "wrong interface name");
+  NS_TEST_ASSERT_MSG_EQ (interfaces[1], nameB.str (), "wrong interface name");
+  NS_TEST_ASSERT_MSG_EQ (frames[0], 2, "sent frames not captured");
+  NS_TEST_ASSERT_MSG_EQ (frames[1], 2, "received frames not captured");
+}
+
+/**
+ * \brief Test the ASCII traces
+ *
+ * The direct hooks of EnableAscii with a shared stream must produce the
+ * same lines, context strings included, as connecting the default sinks
+ * with Config::Connect.  Buffered and compressed files must be complete
+ * once Simulator::Destroy has run.
+ */
+class WirelessPointToPointAsciiTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   */
+  WirelessPointToPointAsciiTest ();
+
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Read a whole file
+   * \param filename the file
+   * \returns its contents
+   */
+  static std::string ReadFile (std::string filename);
+};
+
+WirelessPointToPointAsciiTest::WirelessPointToPointAsciiTest ()
+  : TestCase ("WirelessPointToPoint ASCII traces")
+{
+}
+
+std::string
+WirelessPointToPointAsciiTest::ReadFile (std::string filename)
+{
+  std::ifstream in (filename.c_str (), std::ios::binary);
+  return std::string ((std::istreambuf_iterator<char> (in)), std::istreambuf_iterator<char> ());
+}
+
+void
+WirelessPointToPointAsciiTest::DoRun (void)
+{
+  std::ostringstream hooked;
+  std::ostringstream connected;
+
+  Ptr<WirelessPointToPointChannel> channel = CreateObject<WirelessPointToPointChannel> ();
+  Ptr<Node> a = CreateObject<Node> ();
+  Ptr<Node> b = CreateObject<Node> ();
+  Ptr<WirelessPointToPointNetDevice> devA = CreateObject<WirelessPointToPointNetDevice> ();
+  Ptr<WirelessPointToPointNetDevice> devB = CreateObject<WirelessPointToPointNetDevice> ();
+  Ptr<DropTailQueue> queueA = CreateObject<DropTailQueue> ();
+  queueA->SetAttribute ("MaxPackets", UintegerValue (1));
+  devA->SetAddress (Mac48Address::Allocate ());
+  devA->SetQueue (queueA);
+  devA->Attach (channel);
+  a->AddDevice (devA);
+  devB->SetAddress (Mac48Address::Allocate ());
+  devB->SetQueue (CreateObject<DropTailQueue> ());
+  devB->Attach (channel);
+  b->AddDevice (devB);
+  channel->Connect (a, devA, b);
+  channel->Connect (b, devB, a);
+  NetDeviceContainer devices;
+  devices.Add (devA);
+  devices.Add (devB);
+
+  WirelessPointToPointHelper wppp;
+  wppp.EnableAscii (Create<OutputStreamWrapper> (&hooked), devices);
+
+  Ptr<OutputStreamWrapper> reference = Create<OutputStreamWrapper> (&connected);
+  for (uint32_t i = 0; i < devices.GetN (); i++)
+    {
+      Ptr<NetDevice> device = devices.Get (i);
+      std::ostringstream oss;
+      oss << "/NodeList/" << device->GetNode ()->GetId () << "/DeviceList/" << device->GetIfIndex ()
+          << "/$ns3::WirelessPointToPointNetDevice/";
+      Config::Connect (oss.str () + "MacRx",
+                       MakeBoundCallback (&AsciiTraceHelper::DefaultReceiveSinkWithContext, reference));
+      Config::Connect (oss.str () + "TxQueue/Enqueue",
+                       MakeBoundCallback (&AsciiTraceHelper::DefaultEnqueueSinkWithContext, reference));
+      Config::Connect (oss.str () + "TxQueue/Dequeue",
+                       MakeBoundCallback (&AsciiTraceHelper::DefaultDequeueSinkWithContext, reference));
+      Config::Connect (oss.str () + "TxQueue/Drop",
+                       MakeBoundCallback (&AsciiTraceHelper::DefaultDropSinkWithContext, reference));
+      Config::Connect (oss.str () + "PhyRxDrop",
+                       MakeBoundCallback (&AsciiTraceHelper::DefaultDropSinkWithContext, reference));
+    }
+
+  std::string plainFile = CreateTempDirFilename ("wppp-plain.tr");
+  std::string bufferedFile = CreateTempDirFilename ("wppp-buffered.tr");
+  std::string compressedFile = CreateTempDirFilename ("wppp-compressed.tr");
+  wppp.EnableAscii (plainFile, devA, true);
+  WirelessPointToPointHelper buffered;
+  buffered.SetAsciiBuffering (1 << 20, false);
+  buffered.EnableAscii (bufferedFile, devA, true);
+  bool compress = WpppBackgroundWriter::IsCompressionSupported ();
+  if (compress)
+    {
+      WirelessPointToPointHelper compressed;
+      compressed.SetAsciiBuffering (1 << 20, true);
+      compressed.EnableAscii (compressedFile, devA, true);
+    }
+
+  //the third frame finds the one packet queue full and is dropped
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      Simulator::Schedule (Seconds (1.0), &WirelessPointToPointNetDevice::Send, devA,
+                           Create<Packet> (100), devB->GetAddress (), 0x800);
+    }
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (hooked.str ().empty (), false, "nothing traced");
+  NS_TEST_ASSERT_MSG_EQ (hooked.str (), connected.str (), "direct hooks differ from Config::Connect");
+  NS_TEST_ASSERT_MSG_NE (hooked.str ().find ("TxQueue/Drop"), std::string::npos, "drop not traced");
+  NS_TEST_ASSERT_MSG_NE (hooked.str ().find ("/MacRx"), std::string::npos, "reception not traced");
+
+  //the buffered files are only written out by the destroy events
+  Simulator::Destroy ();
+
+  std::string plain = ReadFile (plainFile);
+  NS_TEST_ASSERT_MSG_EQ (plain.empty (), false, "nothing traced to the file");
+  NS_TEST_ASSERT_MSG_EQ (ReadFile (bufferedFile), plain, "buffered file incomplete");
+  if (compress)
+    {
+      //a gzip stream ends with the size of the uncompressed data, so a
+      //stream cut short cannot end with the size of the plain file
+      std::string gz = ReadFile (compressedFile + ".gz");
+      NS_TEST_ASSERT_MSG_EQ (gz.size () > 18, true, "compressed file empty");
+      NS_TEST_ASSERT_MSG_EQ (uint8_t (gz[0]), 0x1f, "not a gzip file");
+      NS_TEST_ASSERT_MSG_EQ (uint8_t (gz[1]), 0x8b, "not a gzip file");
+      uint32_t size = 0;
+      for (uint32_t i = 0; i < 4; i++)
+        {
+          size |= uint32_t (uint8_t (gz[gz.size () - 4 + i])) << (8 * i);
+        }
+      NS_TEST_ASSERT_MSG_EQ (size, plain.size (), "compressed stream not finished");
+    }
+}
+
+/**
+ * \brief Test the capture filter of the pcap and ASCII traces
+ *
+ * Node A has one device aligned with B and one aligned with C.  The filter
+ * keeps the IPv4 frames exchanged with B between 1 s and 5 s of one in two
+ * packets; frames outside the window, of another protocol or on the link
+ * to C must reach neither the pcap file nor the ASCII stream, and a kept
+ * packet is traced when enqueued, dequeued and received.
+ */
+class WirelessPointToPointCaptureFilterTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   */
+  WirelessPointToPointCaptureFilterTest ();
+
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Create a device on a node and a channel
+   * \param node the node
+   * \param channel the channel
+   * \returns the device
+   */
+  static Ptr<WirelessPointToPointNetDevice> CreateDevice (Ptr<Node> node,
+                                                          Ptr<WirelessPointToPointChannel> channel);
+
+  /**
+   * \brief Read the capture times of a pcap file
+   * \param filename the file
+   * \returns the capture time of each record in seconds
+   */
+  static std::vector<uint32_t> ReadPcapTimes (std::string filename);
+};
+
+WirelessPointToPointCaptureFilterTest::WirelessPointToPointCaptureFilterTest ()
+  : TestCase ("WirelessPointToPoint capture filter")
+{
+}
+
+Ptr<WirelessPointToPointNetDevice>
+WirelessPointToPointCaptureFilterTest::CreateDevice (Ptr<Node> node, Ptr<WirelessPointToPointChannel> channel)
+{
+  Ptr<WirelessPointToPointNetDevice> device = CreateObject<WirelessPointToPointNetDevice> ();
+  device->SetAddress (Mac48Address::Allocate ());
+  device->SetQueue (CreateObject<DropTailQueue> ());
+  device->Attach (channel);
+  node->AddDevice (device);
+  return device;
+}
+
+std::vector<uint32_t>
+WirelessPointToPointCaptureFilterTest::ReadPcapTimes (std::string filename)
+{
+  std::ifstream in (filename.c_str (), std::ios::binary);
+  std::string data ((std::istreambuf_iterator<char> (in)), std::istreambuf_iterator<char> ());
+  std::vector<uint32_t> times;
+  uint64_t offset = 24;
+  while (offset + 16 <= data.size ())
+    {
+      uint32_t seconds = 0;
+      uint32_t captured = 0;
+      for (uint32_t i = 0; i < 4; i++)
+        {
+          seconds |= uint32_t (uint8_t (data[offset + i])) << (8 * i);
+          captured |= uint32_t (uint8_t (data[offset + 8 + i])) << (8 * i);
+        }
+      times.push_back (seconds);
+      offset += 16 + captured;
+    }
+  return times;
+}
+
+void
+WirelessPointToPointCaptureFilterTest::DoRun (void)
+{
+  std::ostringstream ascii;
+
+  Ptr<WirelessPointToPointChannel> channel = CreateObject<WirelessPointToPointChannel> ();
+  Ptr<Node> a = CreateObject<Node> ();
+  Ptr<Node> b = CreateObject<Node> ();
+  Ptr<Node> c = CreateObject<Node> ();
+  Ptr<WirelessPointToPointNetDevice> toB = CreateDevice (a, channel);
+  Ptr<WirelessPointToPointNetDevice> toC = CreateDevice (a, channel);
+  Ptr<WirelessPointToPointNetDevice> devB = CreateDevice (b, channel);
+  Ptr<WirelessPointToPointNetDevice> devC = CreateDevice (c, channel);
+  channel->Connect (a, toB, b);
+  channel->Connect (b, devB, a);
+  channel->Connect (a, toC, c);
+  channel->Connect (c, devC, a);
+
+  WpppCaptureFilter filter;
+  filter.AddPeerPair (b->GetId (), a->GetId ());
+  filter.AddProtocol (0x0021);
+  filter.SetTimeWindow (Seconds (1), Seconds (5));
+  filter.SetSampling (2);
+  WirelessPointToPointHelper wppp;
+  wppp.SetCaptureFilter (filter);
+  wppp.SetPcapBuffering (4096);
+  std::string toBFile = CreateTempDirFilename ("wppp-filter-b.pcap");
+  std::string toCFile = CreateTempDirFilename ("wppp-filter-c.pcap");
+  wppp.EnablePcap (toBFile, toB, false, true);
+  wppp.EnablePcap (toCFile, toC, false, true);
+  NetDeviceContainer devices;
+  devices.Add (toB);
+  devices.Add (toC);
+  devices.Add (devB);
+  wppp.EnableAscii (Create<OutputStreamWrapper> (&ascii), devices);
+
+  //IPv4 to B at 0.5 s and 6 s falls outside the window and the IPv6 frame
+  //has the wrong protocol; of the IPv4 frames at 1, 2, 3 and 4 s, those of
+  //the packets with an even uid are kept, every other one as the uids are
+  //consecutive
+  double ipv4Times[] = { 0.5, 1, 2, 3, 4, 6 };
+  std::vector<uint32_t> kept;
+  for (uint32_t i = 0; i < 6; i++)
+    {
+      Ptr<Packet> packet = Create<Packet> (100);
+      if (ipv4Times[i] >= 1 && ipv4Times[i] < 5 && packet->GetUid () % 2 == 0)
+        {
+          kept.push_back (uint32_t (ipv4Times[i]));
+        }
+      Simulator::Schedule (Seconds (ipv4Times[i]), &WirelessPointToPointNetDevice::Send, toB,
+                           packet, devB->GetAddress (), 0x800);
+    }
+  NS_TEST_ASSERT_MSG_EQ (kept.size (), 2, "uids not consecutive");
+  Simulator::Schedule (Seconds (1.5), &WirelessPointToPointNetDevice::Send, toB,
+                       Create<Packet> (100), devB->GetAddress (), 0x86DD);
+  Simulator::Schedule (Seconds (1), &WirelessPointToPointNetDevice::Send, toC,
+                       Create<Packet> (100), devC->GetAddress (), 0x800);
+  Simulator::Schedule (Seconds (2), &WirelessPointToPointNetDevice::Send, toC,
+                       Create<Packet> (100), devC->GetAddress (), 0x800);
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (toB->GetStats ().txPackets, 7, "frames not sent");
+  NS_TEST_ASSERT_MSG_EQ (toC->GetStats ().txPackets, 2, "frames not sent");
+  std::ostringstream toCContext;
+  toCContext << "/NodeList/" << a->GetId () << "/DeviceList/" << toC->GetIfIndex () << "/";
+  Simulator::Destroy ();
+
+  std::vector<uint32_t> times = ReadPcapTimes (toBFile);
+  NS_TEST_ASSERT_MSG_EQ (times == kept, true, "filter kept the wrong frames");
+  NS_TEST_ASSERT_MSG_EQ (ReadPcapTimes (toCFile).size (), 0, "frames of another peer captured");
+
+  //every hook samples the same packets: each kept packet is enqueued and
+  //dequeued on A and received on B, within the second it was sent in
+  std::istringstream lines (ascii.str ());
+  std::string line;
+  std::map<std::string, std::vector<uint32_t> > events;
+  while (std::getline (lines, line))
+    {
+      NS_TEST_ASSERT_MSG_EQ (line.find (toCContext.str ()), std::string::npos,
+                             "ASCII event of another peer traced");
+      std::istringstream fields (line);
+      std::string event;
+      double time;
+      fields >> event >> time;
+      events[event].push_back (uint32_t (time));
+    }
+  NS_TEST_ASSERT_MSG_EQ (events.size (), 3, "ASCII events of rejected frames traced");
+  NS_TEST_ASSERT_MSG_EQ (events["+"] == kept, true, "enqueues of other packets traced");
+  NS_TEST_ASSERT_MSG_EQ (events["-"] == kept, true, "dequeues of other packets traced");
+  NS_TEST_ASSERT_MSG_EQ (events["r"] == kept, true, "receptions of other packets traced");
+}
+
+/**
+ * \brief Test sojourn time recording and CoDel
+ *
+ * Two saturated 8 Mbps links get the same burst of frames, one with CoDel
+ * and one without.  The link without AQM records a sojourn time for every
+ * frame and drops nothing; CoDel drops frames once the queue has stayed
+ * above its target for an interval and keeps the delay lower.
+ */
+class WirelessPointToPointCoDelTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   */
+  WirelessPointToPointCoDelTest ();
+
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Create two devices aligned with each other
+   * \param channel the channel
+   * \param aqm active queue management of the sending device
+   * \returns the sending device
+   */
+  Ptr<WirelessPointToPointNetDevice> CreateLink (Ptr<WirelessPointToPointChannel> channel,
+                                                 WirelessPointToPointNetDevice::AqmMode aqm);
+
+  /**
+   * \brief Send a burst of frames
+   * \param device the sending device
+   * \param frames number of frames
+   */
+  static void SendBurst (Ptr<WirelessPointToPointNetDevice> device, uint32_t frames);
+
+  /**
+   * \brief Record a sojourn time reported by the CoDel device
+   */
+  void Sojourn (Time sojourn);
+
+  /**
+   * \brief Record the time of the first frame the CoDel device dropped
+   */
+  void Drop (Ptr<const Packet> packet);
+
+  uint32_t m_traced;    //!< Sojourn times reported by the trace
+  Time m_tracedMax;     //!< Largest sojourn time reported
+  Time m_firstDrop;     //!< Time of the first drop
+};
+
+WirelessPointToPointCoDelTest::WirelessPointToPointCoDelTest ()
+  : TestCase ("WirelessPointToPoint CoDel"),
+    m_traced (0),
+    m_firstDrop (Seconds (-1))
+{
+}
+
+Ptr<WirelessPointToPointNetDevice>
+WirelessPointToPointCoDelTest::CreateLink (Ptr<WirelessPointToPointChannel> channel,
+                                           WirelessPointToPointNetDevice::AqmMode aqm)
+{
+  Ptr<Node> a = CreateObject<Node> ();
+  Ptr<Node> b = CreateObject<Node> ();
+  Ptr<WirelessPointToPointNetDevice> devA = CreateObject<WirelessPointToPointNetDevice> ();
+  Ptr<WirelessPointToPointNetDevice> devB = CreateObject<WirelessPointToPointNetDevice> ();
+  Ptr<DropTailQueue> queue = CreateObject<DropTailQueue> ();
+  queue->SetAttribute ("MaxPackets", UintegerValue (1000));
+  devA->SetAttribute ("DataRate", DataRateValue (DataRate ("8Mbps")));
+  devA->SetAttribute ("Aqm", EnumValue (aqm));
+  devA->SetAttribute ("CoDelTarget", TimeValue (MilliSeconds (5)));
+  devA->SetAttribute ("CoDelInterval", TimeValue (MilliSeconds (100)));
+  devA->SetAddress (Mac48Address::Allocate ());
+  devA->SetQueue (queue);
+  devA->Attach (channel);
+  a->AddDevice (devA);
+  devB->SetAddress (Mac48Address::Allocate ());
+  devB->SetQueue (CreateObject<DropTailQueue> ());
+  devB->Attach (channel);
+  b->AddDevice (devB);
+  channel->Connect (a, devA, b);
+  channel->Connect (b, devB, a);
+  return devA;
+}
+
+void
+WirelessPointToPointCoDelTest::SendBurst (Ptr<WirelessPointToPointNetDevice> device, uint32_t frames)
+{
+  Address dest = device->GetAlignedPeer ()->GetAddress ();
+  for (uint32_t i = 0; i < frames; i++)
+    {
+      device->Send (Create<Packet> (1000), dest, 0x800);
+    }
+}
+
+void
+WirelessPointToPointCoDelTest::Sojourn (Time sojourn)
+{
+  m_traced++;
+  m_tracedMax = Max (m_tracedMax, sojourn);
+}
+
+void
+WirelessPointToPointCoDelTest::Drop (Ptr<const Packet> packet)
+{
+  if (m_firstDrop.IsNegative ())
+    {
+      m_firstDrop = Simulator::Now ();
+    }
+}
+
+void
+WirelessPointToPointCoDelTest::DoRun (void)
+{
+  Ptr<WirelessPointToPointChannel> channel = CreateObject<WirelessPointToPointChannel> ();
+  Ptr<WirelessPointToPointNetDevice> plain = CreateLink (channel, WirelessPointToPointNetDevice::AQM_NONE);
+  Ptr<WirelessPointToPointNetDevice> codel = CreateLink (channel, WirelessPointToPointNetDevice::AQM_CODEL);
+  codel->TraceConnectWithoutContext ("Sojourn", MakeCallback (&WirelessPointToPointCoDelTest::Sojourn, this));
+  codel->TraceConnectWithoutContext ("MacTxDrop", MakeCallback (&WirelessPointToPointCoDelTest::Drop, this));
+
+  //about 1 ms a frame, so the last of 400 frames waits about 400 ms; the
+  //drops cannot shorten a burst that is already queued by much
+  Simulator::Schedule (Seconds (1), &WirelessPointToPointCoDelTest::SendBurst, plain, 400);
+  Simulator::Schedule (Seconds (1), &WirelessPointToPointCoDelTest::SendBurst, codel, 400);
+  Simulator::Run ();
+
+  const WpppDeviceStats &plainStats = plain->GetStats ();
+  NS_TEST_ASSERT_MSG_EQ (plainStats.txPackets, 400, "frames lost without AQM");
+  NS_TEST_ASSERT_MSG_EQ (plainStats.drops[WpppDeviceStats::DROP_AQM], 0, "AQM drop without AQM");
+  NS_TEST_ASSERT_MSG_EQ (plain->GetSojournStats ().GetCount (), 400, "sojourn times not recorded");
+  NS_TEST_ASSERT_MSG_GT (plain->GetSojournStats ().GetMax (), uint64_t (MilliSeconds (390).GetNanoSeconds ()),
+                         "burst did not build a standing queue");
+
+  const WpppDeviceStats &codelStats = codel->GetStats ();
+  uint64_t aqmDrops = codelStats.drops[WpppDeviceStats::DROP_AQM];
+  NS_TEST_ASSERT_MSG_GT (aqmDrops, 0, "CoDel dropped nothing");
+  NS_TEST_ASSERT_MSG_EQ (codelStats.txPackets + aqmDrops, 400, "frames neither sent nor dropped");
+  NS_TEST_ASSERT_MSG_EQ (codelStats.drops[WpppDeviceStats::DROP_QUEUE_FULL], 0, "queue overflowed");
+  NS_TEST_ASSERT_MSG_EQ (codel->GetSojournStats ().GetCount (), codelStats.txPackets,
+                         "sojourn recorded for dropped frames");
+  NS_TEST_ASSERT_MSG_EQ (m_traced, codelStats.txPackets, "Sojourn trace not fired once per frame sent");
+  NS_TEST_ASSERT_MSG_LT (uint64_t (m_tracedMax.GetNanoSeconds ()), plain->GetSojournStats ().GetMax (),
+                         "CoDel did not shorten the queue delay");
+  //the delay passes the 5 ms target about 5 ms into the burst, and the
+  //first drop waits for it to stay there for the 100 ms interval
+  NS_TEST_ASSERT_MSG_GT (m_firstDrop, MilliSeconds (1100), "CoDel dropped before the interval");
+  NS_TEST_ASSERT_MSG_LT (m_firstDrop, MilliSeconds (1115), "CoDel dropped late");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \brief Test IPv4 over multi-beam devices
+ *
+ * A has one beam aligned with B and one with C, all on one subnet.  A UDP
+ * datagram from A to C needs an ARP exchange first; the request goes out on
+ * both beams, C replies, and the datagram follows on C's beam only.
+ */
+class WirelessPointToPointMultiBeamIpv4Test : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   */
+  WirelessPointToPointMultiBeamIpv4Test ();
+
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Create a node with a multi-beam device on a channel
+   * \param channel channel the beams are attached to
+   * \param beams number of beams
+   * \returns the device
+   */
+  static Ptr<WpppMultiBeamNetDevice> CreateDevice (Ptr<WirelessPointToPointChannel> channel, uint32_t beams);
+
+  /**
+   * \brief Send a datagram on a connected socket
+   */
+  static void SendDatagram (Ptr<Socket> socket);
+
+  /**
+   * \brief Count the datagrams a socket received
+   */
+  void ReceiveUdp (Ptr<Socket> socket);
+
+  std::map<uint32_t, uint32_t> m_received;  //!< Datagrams received by node id
+};
+
+WirelessPointToPointMultiBeamIpv4Test::WirelessPointToPointMultiBeamIpv4Test ()
+  : TestCase ("WirelessPointToPoint multi-beam IPv4")
+{
+}
+
+Ptr<WpppMultiBeamNetDevice>
+WirelessPointToPointMultiBeamIpv4Test::CreateDevice (Ptr<WirelessPointToPointChannel> channel, uint32_t beams)
+{
+  Ptr<WpppMultiBeamNetDevice> device = CreateObject<WpppMultiBeamNetDevice> ();
+  device->SetAddress (Mac48Address::Allocate ());
+  for (uint32_t i = 0; i < beams; i++)
+    {
+      Ptr<WirelessPointToPointNetDevice> beam = CreateObject<WirelessPointToPointNetDevice> ();
+      beam->SetQueue (CreateObject<DropTailQueue> ());
+      beam->Attach (channel);
+      device->AddBeam (beam);
+    }
+  CreateObject<Node> ()->AddDevice (device);
+  return device;
+}
+
+void
+WirelessPointToPointMultiBeamIpv4Test::SendDatagram (Ptr<Socket> socket)
+{
+  socket->Send (Create<Packet> (100));
+}
+
+void
+WirelessPointToPointMultiBeamIpv4Test::ReceiveUdp (Ptr<Socket> socket)
+{
+  Ptr<Packet> packet;
+  while ((packet = socket->Recv ()))
+    {
+      m_received[socket->GetNode ()->GetId ()]++;
+    }
+}
+
+void
+WirelessPointToPointMultiBeamIpv4Test::DoRun (void)
+{
+  Ptr<WirelessPointToPointChannel> channel = CreateObject<WirelessPointToPointChannel> ();
+  Ptr<WpppMultiBeamNetDevice> a = CreateDevice (channel, 2);
+  Ptr<WpppMultiBeamNetDevice> b = CreateDevice (channel, 1);
+  Ptr<WpppMultiBeamNetDevice> c = CreateDevice (channel, 1);
+  NetDeviceContainer devices;
+  devices.Add (a);
+  devices.Add (b);
+  devices.Add (c);
+  NodeContainer nodes;
+  nodes.Add (a->GetNode ());
+  nodes.Add (b->GetNode ());
+  nodes.Add (c->GetNode ());
+
+  InternetStackHelper internet;
+  internet.Install (nodes);
+  Ipv4AddressHelper addresses ("10.1.1.0", "255.255.255.0");
+  Ipv4InterfaceContainer interfaces = addresses.Assign (devices);
+
+  a->Connect (0, b->GetNode ());
+  b->Connect (0, a->GetNode ());
+  a->Connect (1, c->GetNode ());
+  c->Connect (0, a->GetNode ());
+
+  for (uint32_t i = 1; i < nodes.GetN (); i++)
+    {
+      Ptr<Socket> sink = Socket::CreateSocket (nodes.Get (i), UdpSocketFactory::GetTypeId ());
+      sink->Bind (InetSocketAddress (Ipv4Address::GetAny (), 9));
+      sink->SetRecvCallback (MakeCallback (&WirelessPointToPointMultiBeamIpv4Test::ReceiveUdp, this));
+    }
+  Ptr<Socket> source = Socket::CreateSocket (nodes.Get (0), UdpSocketFactory::GetTypeId ());
+  source->Connect (InetSocketAddress (interfaces.GetAddress (2), 9));
+  Simulator::Schedule (Seconds (1.0), &WirelessPointToPointMultiBeamIpv4Test::SendDatagram, source);
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_received[c->GetNode ()->GetId ()], 1, "datagram not delivered over IPv4");
+  NS_TEST_ASSERT_MSG_EQ (m_received[b->GetNode ()->GetId ()], 0, "datagram reached the wrong neighbor");
+  //ARP request on both beams, then the datagram on C's beam alone
+  NS_TEST_ASSERT_MSG_EQ (a->GetBeam (0)->GetStats ().txPackets, 1, "ARP request not broadcast");
+  NS_TEST_ASSERT_MSG_EQ (a->GetBeam (1)->GetStats ().txPackets, 2, "datagram left on the wrong beam");
+  NS_TEST_ASSERT_MSG_EQ (c->GetBeam (0)->GetStats ().txPackets, 1, "ARP reply not sent");
+  NS_TEST_ASSERT_MSG_EQ (b->GetBeam (0)->GetStats ().txPackets, 0, "ARP request answered by the wrong node");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \brief Test beam hopping
+ *
+ * A hub hops between two peers with the schedule 1, 0, 0.  Every frame
+ * leaves on the beam of its slot, after the guard, and ends with its
+ * interframe gap before the slot does; a frame longer than a slot is
+ * dropped instead of holding its queue.
+ */
+class WirelessPointToPointBeamHoppingTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   */
+  WirelessPointToPointBeamHoppingTest ();
+
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Create a node with a multi-beam device on a channel
+   * \param channel channel the beams are attached to
+   * \param beams number of beams
+   * \returns the device
+   */
+  static Ptr<WpppMultiBeamNetDevice> CreateDevice (Ptr<WirelessPointToPointChannel> channel, uint32_t beams);
+
+  /**
+   * \brief Record a frame starting on a beam of the hub
+   * \param context index of the beam
+   * \param packet the frame
+   */
+  void TxBegin (std::string context, Ptr<const Packet> packet);
+
+  /**
+   * \brief A frame started on the hub
+   */
+  struct Transmission
+  {
+    uint32_t beam;  //!< Beam of the hub
+    int64_t start;  //!< Start, in ns
+    uint32_t size;  //!< Bytes, header included
+  };
+
+  std::vector<Transmission> m_transmissions;  //!< Frames started, in order
+};
+
+WirelessPointToPointBeamHoppingTest::WirelessPointToPointBeamHoppingTest ()
+  : TestCase ("WirelessPointToPoint beam hopping")
+{
+}
+
+Ptr<WpppMultiBeamNetDevice>
+WirelessPointToPointBeamHoppingTest::CreateDevice (Ptr<WirelessPointToPointChannel> channel, uint32_t beams)
+{
+  Ptr<WpppMultiBeamNetDevice> device = CreateObject<WpppMultiBeamNetDevice> ();
+  device->SetAddress (Mac48Address::Allocate ());
+  for (uint32_t i = 0; i < beams; i++)
+    {
+      Ptr<WirelessPointToPointNetDevice> beam = CreateObject<WirelessPointToPointNetDevice> ();
+      beam->SetAttribute ("DataRate", DataRateValue (DataRate ("8Mbps")));
+      beam->SetAttribute ("InterframeGap", TimeValue (MicroSeconds (30)));
+      beam->SetQueue (CreateObject<DropTailQueue> ());
+      beam->Attach (channel);
+      device->AddBeam (beam);
+    }
+  CreateObject<Node> ()->AddDevice (device);
+  return device;
+}
+
+void
+WirelessPointToPointBeamHoppingTest::TxBegin (std::string context, Ptr<const Packet> packet)
+{
+  Transmission t;
+  t.beam = std::atoi (context.c_str ());
+  t.start = Simulator::Now ().GetNanoSeconds ();
+  t.size = packet->GetSize ();
+  m_transmissions.push_back (t);
+}
+
+void
+WirelessPointToPointBeamHoppingTest::DoRun (void)
+{
+  Ptr<WirelessPointToPointChannel> channel = CreateObject<WirelessPointToPointChannel> ();
+  Ptr<WpppMultiBeamNetDevice> hub = CreateDevice (channel, 2);
+  Ptr<WpppMultiBeamNetDevice> b = CreateDevice (channel, 1);
+  Ptr<WpppMultiBeamNetDevice> c = CreateDevice (channel, 1);
+  hub->Connect (0, b->GetNode ());
+  b->Connect (0, hub->GetNode ());
+  hub->Connect (1, c->GetNode ());
+  c->Connect (0, hub->GetNode ());
+
+  const int64_t slot = 1000000;
+  const int64_t guard = 100000;
+  hub->SetAttribute ("HoppingSlot", TimeValue (NanoSeconds (slot)));
+  hub->SetAttribute ("HoppingGuard", TimeValue (NanoSeconds (guard)));
+  std::vector<uint32_t> schedule;
+  schedule.push_back (1);
+  schedule.push_back (0);
+  schedule.push_back (0);
+  hub->SetHoppingSchedule (schedule);
+  hub->GetBeam (0)->TraceConnect ("PhyTxBegin", "0", MakeCallback (&WirelessPointToPointBeamHoppingTest::TxBegin, this));
+  hub->GetBeam (1)->TraceConnect ("PhyTxBegin", "1", MakeCallback (&WirelessPointToPointBeamHoppingTest::TxBegin, this));
+
+  //280 bytes take 280us, so with the 30us gaps two fit in the 900us of a
+  //slot; without the gap after the last one, three would
+  Simulator::Schedule (MicroSeconds (10), &WpppMultiBeamNetDevice::Send, hub,
+                       Create<Packet> (1000), b->GetAddress (), 0x800);
+  for (uint32_t i = 0; i < 5; i++)
+    {
+      Simulator::Schedule (MicroSeconds (10), &WpppMultiBeamNetDevice::Send, hub,
+                           Create<Packet> (266), b->GetAddress (), 0x800);
+      Simulator::Schedule (MicroSeconds (10), &WpppMultiBeamNetDevice::Send, hub,
+                           Create<Packet> (266), c->GetAddress (), 0x800);
+    }
+  Simulator::Stop (MilliSeconds (10));
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_transmissions.size (), 10, "frames not all sent");
+  NS_TEST_ASSERT_MSG_EQ (hub->GetBeam (0)->GetStats ().drops[WpppDeviceStats::DROP_TOO_LONG], 1,
+                         "frame longer than a slot not dropped");
+  NS_TEST_ASSERT_MSG_EQ (b->GetBeam (0)->GetStats ().rxPackets, 5, "frames to the first peer lost");
+  NS_TEST_ASSERT_MSG_EQ (c->GetBeam (0)->GetStats ().rxPackets, 5, "frames to the second peer lost");
+  for (uint32_t i = 0; i < m_transmissions.size (); i++)
+    {
+      const Transmission &t = m_transmissions[i];
+      int64_t k = t.start / slot;
+      int64_t end = t.start + t.size * 1000 + 30000;
+      NS_TEST_ASSERT_MSG_EQ (t.beam, schedule[k % schedule.size ()], "frame sent out of its slot");
+      NS_TEST_ASSERT_MSG_EQ (t.start - k * slot >= guard, true, "frame sent within the guard");
+      NS_TEST_ASSERT_MSG_EQ (end <= (k + 1) * slot, true, "frame overran its slot");
+    }
+  //slots 0, 3 and 6 go to beam 1, and slots 1, 2 and 4 to beam 0
+  NS_TEST_ASSERT_MSG_EQ (m_transmissions[0].beam, 1, "schedule not followed");
+  NS_TEST_ASSERT_MSG_EQ (m_transmissions[0].start, guard, "first slot not used at once");
+  NS_TEST_ASSERT_MSG_EQ (m_transmissions[1].start, guard + 310000, "frames not back to back");
+  NS_TEST_ASSERT_MSG_EQ (m_transmissions[2].beam, 0, "schedule not followed");
+  NS_TEST_ASSERT_MSG_EQ (m_transmissions[2].start, slot + guard, "second slot not used at once");
+  NS_TEST_ASSERT_MSG_EQ (m_transmissions[9].start, 6 * slot + guard, "last frame not in slot 6");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \brief Test the PPP protocol numbers of the WpppHeader
+ *
+ * Every protocol number the header uses is a valid PPP one, a source
+ * routed header survives serialization, and an ARP payload crosses a
+ * source routed link under its own Ethernet protocol number.
+ */
+class WirelessPointToPointHeaderTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   */
+  WirelessPointToPointHeaderTest ();
+
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Record the protocol of a received frame
+   */
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from);
+
+  uint16_t m_lastProtocol;  //!< Protocol of the last frame handed up
+};
+
+WirelessPointToPointHeaderTest::WirelessPointToPointHeaderTest ()
+  : TestCase ("WirelessPointToPoint header"),
+    m_lastProtocol (0)
+{
+}
+
+bool
+WirelessPointToPointHeaderTest::Receive (Ptr<NetDevice> device, Ptr<const Packet> packet,
+                                         uint16_t protocol, const Address &from)
+{
+  m_lastProtocol = protocol;
+  return true;
+}
+
+void
+WirelessPointToPointHeaderTest::DoRun (void)
+{
+  //PPP protocol numbers have an odd low octet and an even high octet
+  const uint16_t protocols[] = { 0x0021, 0x0057, WpppHeader::LABEL_PROTOCOL,
+                                 WpppHeader::SOURCE_ROUTE_PROTOCOL, WpppHeader::ARP_PROTOCOL };
+  for (uint32_t i = 0; i < sizeof (protocols) / sizeof (protocols[0]); i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (protocols[i] & 0x0101, 0x0001, "invalid PPP protocol number " << protocols[i]);
+      for (uint32_t j = 0; j < i; j++)
+        {
+          NS_TEST_ASSERT_MSG_NE (protocols[i], protocols[j], "PPP protocol number used twice");
+        }
+    }
+
+  std::vector<uint8_t> hops;
+  hops.push_back (3);
+  hops.push_back (1);
+  WpppHeader sent;
+  sent.SetSourceRoute (hops, WpppHeader::ARP_PROTOCOL);
+  sent.SetAddr1 (Mac48Address::GetBroadcast ());
+  sent.SetAddr2 (Mac48Address::Allocate ());
+  Ptr<Packet> packet = Create<Packet> (10);
+  packet->AddHeader (sent);
+  uint8_t first[2];
+  packet->CopyData (first, 2);
+  NS_TEST_ASSERT_MSG_EQ ((first[0] << 8) | first[1], WpppHeader::SOURCE_ROUTE_PROTOCOL, "wrong protocol on the wire");
+  WpppHeader received;
+  packet->RemoveHeader (received);
+  NS_TEST_ASSERT_MSG_EQ (received.IsSourceRouted (), true, "source route not recognized");
+  NS_TEST_ASSERT_MSG_EQ (received.GetProtocol (), WpppHeader::SOURCE_ROUTE_PROTOCOL, "protocol not carried");
+  NS_TEST_ASSERT_MSG_EQ (received.GetPayloadProtocol (), WpppHeader::ARP_PROTOCOL, "payload protocol not carried");
+  NS_TEST_ASSERT_MSG_EQ (received.GetSourceRoute ().size (), 2, "hops not carried");
+  NS_TEST_ASSERT_MSG_EQ (received.PopHop (), 3, "hops out of order");
+  NS_TEST_ASSERT_MSG_EQ (received.GetAddr2 (), sent.GetAddr2 (), "sender not carried");
+  NS_TEST_ASSERT_MSG_EQ (packet->GetSize (), 10, "header of the wrong size");
+
+  Ptr<WirelessPointToPointChannel> channel = CreateObject<WirelessPointToPointChannel> ();
+  Ptr<Node> a = CreateObject<Node> ();
+  Ptr<Node> b = CreateObject<Node> ();
+  Ptr<WirelessPointToPointNetDevice> devA = CreateObject<WirelessPointToPointNetDevice> ();
+  Ptr<WirelessPointToPointNetDevice> devB = CreateObject<WirelessPointToPointNetDevice> ();
+  devA->SetAddress (Mac48Address::Allocate ());
+  devB->SetAddress (Mac48Address::Allocate ());
+  devA->SetQueue (CreateObject<DropTailQueue> ());
+  devB->SetQueue (CreateObject<DropTailQueue> ());
+  devA->Attach (channel);
+  devB->Attach (channel);
+  a->AddDevice (devA);
+  b->AddDevice (devB);
+  devB->SetReceiveCallback (MakeCallback (&WirelessPointToPointHeaderTest::Receive, this));
+  channel->Connect (a, devA, b);
+  channel->Connect (b, devB, a);
+
+  //no hops left, so the receiver hands the frame up
+  Simulator::Schedule (Seconds (1.0), &WirelessPointToPointNetDevice::SendSourceRouted, devA,
+                       Create<Packet> (28), std::vector<uint8_t> (), 0x0806);
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (m_lastProtocol, 0x0806, "ARP payload of a source routed frame not restored");
+
+  Simulator::Destroy ();
+}
+
 /**
  * \brief TestSuite for WirelessPointToPoint module
  */
@@ -106,6 +2766,27 @@ WirelessPointToPointTestSuite::WirelessPointToPointTestSuite ()
   : TestSuite ("wireless-point-to-point", UNIT)
 {
   AddTestCase (new WirelessPointToPointTest, TestCase::QUICK);
+  AddTestCase (new WirelessPointToPointContactPlanTest, TestCase::QUICK);
+  AddTestCase (new WirelessPointToPointContactPlanGeneratorTest, TestCase::QUICK);
+  AddTestCase (new WirelessPointToPointLinkMatchingTest, TestCase::QUICK);
+  AddTestCase (new WirelessPointToPointLinkMatchingIncrementalTest, TestCase::QUICK);
+  AddTestCase (new WirelessPointToPointStatsTest, TestCase::QUICK);
+  AddTestCase (new WirelessPointToPointLatencyHistogramTest, TestCase::QUICK);
+  AddTestCase (new WirelessPointToPointRareTracesTest, TestCase::QUICK);
+  AddTestCase (new WirelessPointToPointMultiBeamTest, TestCase::QUICK);
+  AddTestCase (new WirelessPointToPointSpfTest, TestCase::QUICK);
+  AddTestCase (new WirelessPointToPointDampingTest, TestCase::QUICK);
+  AddTestCase (new WirelessPointToPointLabelSwitchingTest, TestCase::QUICK);
+  AddTestCase (new WirelessPointToPointLargeSendTest, TestCase::QUICK);
+  AddTestCase (new WirelessPointToPointCoalesceTest, TestCase::QUICK);
+  AddTestCase (new WirelessPointToPointTelemetrySamplerTest, TestCase::QUICK);
+  AddTestCase (new WirelessPointToPointPcapTest, TestCase::QUICK);
+  AddTestCase (new WirelessPointToPointAsciiTest, TestCase::QUICK);
+  AddTestCase (new WirelessPointToPointCaptureFilterTest, TestCase::QUICK);
+  AddTestCase (new WirelessPointToPointCoDelTest, TestCase::QUICK);
+  AddTestCase (new WirelessPointToPointMultiBeamIpv4Test, TestCase::QUICK);
+  AddTestCase (new WirelessPointToPointBeamHoppingTest, TestCase::QUICK);
+  AddTestCase (new WirelessPointToPointHeaderTest, TestCase::QUICK);
 }
 
 static WirelessPointToPointTestSuite g_pointToPointTestSuite; //!< The testsuite